@@ -0,0 +1,141 @@
+// engine_config_bench.cpp
+// Connection setup time and resident memory per connection with a
+// quiche_config built per engine vs. one shared EngineConfig
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+//
+// Build: cargo build --release --features ffi && make bench
+// Run:   ./build/engine_config_bench [ca-bundle.pem]
+
+#include "quiche_engine_config_impl.h"
+#include "quiche_timer_wheel.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+extern "C" {
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <unistd.h>
+}
+
+using namespace quiche;
+
+namespace {
+
+const size_t CONNECTIONS = 1000;
+
+struct Result {
+    double us_per_conn;
+    double kb_per_conn;
+};
+
+size_t residentBytes() {
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) {
+        return 0;
+    }
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    if (fscanf(f, "%lu %lu", &size, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(f);
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+void makeAddresses(size_t i, struct sockaddr_in& local, struct sockaddr_in& peer) {
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(static_cast<uint16_t>(20000 + i % 40000));
+    inet_pton(AF_INET, "127.0.0.1", &local.sin_addr);
+    peer = local;
+    peer.sin_port = htons(443);
+}
+
+// What start() plus the first newConnection() cost before this change
+// (shared = false), or with setEngineConfig() (shared = true)
+bool run(const ConfigMap& config, bool shared, Result& result) {
+    std::vector<std::unique_ptr<EngineConfigImpl>> configs;
+    std::vector<quiche_conn*> conns;
+    conns.reserve(CONNECTIONS);
+
+    std::unique_ptr<EngineConfigImpl> common;
+    if (shared) {
+        common.reset(new EngineConfigImpl(config));
+    }
+
+    size_t rss0 = residentBytes();
+    uint64_t t0 = monotonicNowNs();
+    for (size_t i = 0; i < CONNECTIONS; i++) {
+        EngineConfigImpl* cfg = common.get();
+        if (!shared) {
+            configs.emplace_back(new EngineConfigImpl(config));
+            cfg = configs.back().get();
+        }
+        if (!cfg->isValid()) {
+            fprintf(stderr, "%s\n", cfg->lastError().c_str());
+            return false;
+        }
+
+        uint8_t scid[16];
+        for (size_t b = 0; b < sizeof(scid); b++) {
+            scid[b] = static_cast<uint8_t>(i * 31 + b);
+        }
+        struct sockaddr_in local;
+        struct sockaddr_in peer;
+        makeAddresses(i, local, peer);
+
+        quiche_conn* conn = cfg->connect("example.com", scid, sizeof(scid),
+                                         (const struct sockaddr*)&local, sizeof(local),
+                                         (const struct sockaddr*)&peer, sizeof(peer));
+        if (!conn) {
+            fprintf(stderr, "quiche_connect failed\n");
+            return false;
+        }
+
+        // Initial flight, so the TLS handshake state is built too
+        uint8_t out[1350];
+        quiche_send_info info;
+        quiche_conn_send(conn, out, sizeof(out), &info);
+        conns.push_back(conn);
+    }
+    uint64_t t1 = monotonicNowNs();
+    size_t rss1 = residentBytes();
+
+    result.us_per_conn = (t1 - t0) / 1000.0 / CONNECTIONS;
+    result.kb_per_conn = rss1 > rss0 ? (rss1 - rss0) / 1024.0 / CONNECTIONS : 0.0;
+
+    for (quiche_conn* conn : conns) {
+        quiche_conn_free(conn);
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    ConfigMap config;
+    if (argc > 1) {
+        config[ConfigKey::TLS_CA_FILE] = std::string(argv[1]);
+    }
+
+    // Shared first: the per-engine run would leave its freed pages resident
+    Result shared;
+    Result per_engine;
+    if (!run(config, true, shared) || !run(config, false, per_engine)) {
+        return 1;
+    }
+
+    printf("%zu connections, CA file: %s\n", CONNECTIONS, argc > 1 ? argv[1] : "(default store)");
+    printf("%-22s %14s %14s\n", "quiche_config", "us/connection", "KB RSS/conn");
+    printf("%-22s %14.1f %14.1f\n", "per engine (old)", per_engine.us_per_conn, per_engine.kb_per_conn);
+    printf("%-22s %14.1f %14.1f\n", "shared EngineConfig", shared.us_per_conn, shared.kb_per_conn);
+    if (shared.us_per_conn > 0) {
+        printf("setup speedup %.2fx\n", per_engine.us_per_conn / shared.us_per_conn);
+    }
+    return 0;
+}
@@ -0,0 +1,229 @@
+// message_stream_bench.cpp
+// Throughput and latency of varint-framed messages (64B, 1KB, 64KB):
+// MessageStream vs. the usual hand-rolled framing (one stream write per
+// message, receive into a staging vector, copy each message out of it)
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+//
+// Build: cargo build --release --features ffi && make bench
+// Run:   ./build/message_stream_bench
+
+#include <quiche_message_stream.h>
+#include "quiche_timer_wheel.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <quiche.h>
+}
+
+using namespace quiche;
+
+namespace {
+
+const size_t SIZES[] = {64, 1024, 65536};
+const size_t BYTES_PER_RUN = 256 * 1024 * 1024;  // Payload bytes per throughput run
+const size_t ROUND_BYTES = 512 * 1024;            // Sent before the receiver catches up
+const size_t READ_CHUNK = 65536;                  // Hand-rolled receiver's read size
+const int LATENCY_SAMPLES = 20000;
+
+// In-memory stream with the engine's contract: writes of at most 64KB,
+// each copied like a write Command; reads copy out what is buffered
+class Pipe {
+public:
+    Pipe() : mRead(0), mWrites(0) {}
+
+    ssize_t write(const uint8_t* data, size_t len, bool) {
+        if (len > 65536) {
+            return -1;
+        }
+        mCommand.assign(data, data + len);
+        mData.insert(mData.end(), mCommand.begin(), mCommand.end());
+        mWrites++;
+        return static_cast<ssize_t>(len);
+    }
+
+    ssize_t read(uint8_t* buf, size_t buf_len, bool& fin) {
+        fin = false;
+        size_t len = std::min(buf_len, mData.size() - mRead);
+        memcpy(buf, mData.data() + mRead, len);
+        mRead += len;
+        if (mRead == mData.size()) {
+            mData.clear();
+            mRead = 0;
+        }
+        return static_cast<ssize_t>(len);
+    }
+
+    size_t writes() const { return mWrites; }
+
+private:
+    std::vector<uint8_t> mData;
+    std::vector<uint8_t> mCommand;
+    size_t mRead;
+    size_t mWrites;
+};
+
+// What applications wrote before MessageStream
+class HandRolled {
+public:
+    explicit HandRolled(Pipe& pipe) : mPipe(pipe), mFill(0) {}
+
+    bool send(const uint8_t* data, size_t len) {
+        size_t header_len = len < 64 ? 1 : len < 16384 ? 2 : 4;
+        mFrame.resize(header_len + len);
+        quiche_put_varint(mFrame.data(), header_len, len);
+        memcpy(mFrame.data() + header_len, data, len);
+        for (size_t off = 0; off < mFrame.size(); off += 65536) {
+            size_t chunk = std::min(mFrame.size() - off, static_cast<size_t>(65536));
+            if (mPipe.write(mFrame.data() + off, chunk, false) < 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename Handler>
+    size_t receive(Handler handler) {
+        size_t delivered = 0;
+        for (;;) {
+            mStaging.resize(mFill + READ_CHUNK);
+            bool fin = false;
+            ssize_t len = mPipe.read(mStaging.data() + mFill, READ_CHUNK, fin);
+            mFill += static_cast<size_t>(len);
+
+            size_t pos = 0;
+            while (mFill - pos > 0) {
+                size_t header_len = static_cast<size_t>(1) << (mStaging[pos] >> 6);
+                uint64_t msg_len = 0;
+                if (mFill - pos < header_len ||
+                    quiche_get_varint(mStaging.data() + pos, header_len, &msg_len) < 0 ||
+                    mFill - pos < header_len + msg_len) {
+                    break;
+                }
+                mMessage.assign(mStaging.begin() + pos + header_len,
+                                mStaging.begin() + pos + header_len + msg_len);
+                handler(mMessage.data(), mMessage.size());
+                pos += header_len + msg_len;
+                delivered++;
+            }
+            mStaging.erase(mStaging.begin(), mStaging.begin() + pos);
+            mFill -= pos;
+            if (len == 0) {
+                return delivered;
+            }
+        }
+    }
+
+private:
+    Pipe& mPipe;
+    std::vector<uint8_t> mFrame;
+    std::vector<uint8_t> mStaging;
+    std::vector<uint8_t> mMessage;
+    size_t mFill;
+};
+
+struct Result {
+    double mb_per_s;
+    double msgs_per_s;
+    size_t writes;
+    double p50_ns;
+    double p99_ns;
+};
+
+void percentiles(std::vector<uint64_t>& samples, Result& result) {
+    std::sort(samples.begin(), samples.end());
+    result.p50_ns = static_cast<double>(samples[samples.size() / 2]);
+    result.p99_ns = static_cast<double>(samples[samples.size() * 99 / 100]);
+}
+
+template <typename Stream, typename Flush>
+bool run(Stream& stream, Pipe& pipe, size_t size, Flush flush, Result& result) {
+    std::vector<uint8_t> payload(size, 0x5a);
+    size_t per_round = std::max(ROUND_BYTES / size, static_cast<size_t>(1));
+    size_t messages = BYTES_PER_RUN / size;
+    uint64_t checksum = 0;
+    auto count = [&checksum](const uint8_t* data, size_t len) { checksum += data[len / 2] + len; };
+
+    // Throughput: bursts of messages, then the receiver catches up
+    size_t received = 0;
+    uint64_t t0 = monotonicNowNs();
+    for (size_t sent = 0; sent < messages; ) {
+        for (size_t i = 0; i < per_round && sent < messages; i++, sent++) {
+            payload[0] = static_cast<uint8_t>(sent);
+            if (!stream.send(payload.data(), size)) {
+                return false;
+            }
+        }
+        flush(stream);
+        received += stream.receive(count);
+    }
+    uint64_t t1 = monotonicNowNs();
+    if (received != messages) {
+        fprintf(stderr, "received %zu of %zu messages\n", received, messages);
+        return false;
+    }
+    double seconds = (t1 - t0) / 1e9;
+    result.mb_per_s = messages * size / seconds / (1024 * 1024);
+    result.msgs_per_s = messages / seconds;
+    result.writes = pipe.writes();
+
+    // Latency: one message from send() until its handler runs
+    std::vector<uint64_t> samples;
+    samples.reserve(LATENCY_SAMPLES);
+    for (int i = 0; i < LATENCY_SAMPLES; i++) {
+        uint64_t start = monotonicNowNs();
+        stream.send(payload.data(), size);
+        flush(stream);
+        uint64_t end = 0;
+        stream.receive([&end](const uint8_t*, size_t) { end = monotonicNowNs(); });
+        samples.push_back(end - start);
+    }
+    percentiles(samples, result);
+
+    if (checksum == 0) {
+        fprintf(stderr, "no data\n");
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    printf("%-8s %-14s %10s %12s %10s %9s %9s\n",
+           "size", "framing", "MB/s", "msgs/s", "writes", "p50 ns", "p99 ns");
+
+    for (size_t size : SIZES) {
+        Result hand;
+        {
+            Pipe pipe;
+            HandRolled stream(pipe);
+            if (!run(stream, pipe, size, [](HandRolled&) {}, hand)) {
+                return 1;
+            }
+        }
+
+        Result framed;
+        {
+            Pipe pipe;
+            MessageStream stream(
+                [&pipe](const uint8_t* data, size_t len, bool fin) { return pipe.write(data, len, fin); },
+                [&pipe](uint8_t* buf, size_t buf_len, bool& fin) { return pipe.read(buf, buf_len, fin); });
+            if (!run(stream, pipe, size, [](MessageStream& s) { s.flush(); }, framed)) {
+                fprintf(stderr, "%s\n", stream.getLastError().c_str());
+                return 1;
+            }
+        }
+
+        printf("%-8zu %-14s %10.0f %12.0f %10zu %9.0f %9.0f\n",
+               size, "hand-rolled", hand.mb_per_s, hand.msgs_per_s, hand.writes, hand.p50_ns, hand.p99_ns);
+        printf("%-8zu %-14s %10.0f %12.0f %10zu %9.0f %9.0f\n",
+               size, "MessageStream", framed.mb_per_s, framed.msgs_per_s, framed.writes,
+               framed.p50_ns, framed.p99_ns);
+    }
+    return 0;
+}
@@ -0,0 +1,178 @@
+// timer_wheel_bench.cpp
+// Per-connection timer cost: one libev ev_timer per connection vs. the
+// shared TimerWheel, at 10k and 100k connections
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+//
+// Build: make bench && ./build/timer_wheel_bench
+
+#include "quiche_timer_wheel.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include <ev.h>
+}
+
+using namespace quiche;
+
+namespace {
+
+const size_t REARMS_PER_CONN = 20;      // Flushes per connection in the re-arm test
+const uint64_t BASE_TIMEOUT_NS = 25000000ULL;  // PTO-sized deadlines (25ms)
+const unsigned CHANGED_PERCENT = 10;    // Flushes that actually move the deadline
+
+struct Workload {
+    std::vector<uint32_t> conn;        // Connection flushed at step i
+    std::vector<uint64_t> offset_ns;   // New relative deadline (0 = unchanged)
+};
+
+Workload makeWorkload(size_t conns, uint32_t seed) {
+    std::mt19937 rng(seed);
+    Workload w;
+    size_t steps = conns * REARMS_PER_CONN;
+    w.conn.resize(steps);
+    w.offset_ns.resize(steps);
+    for (size_t i = 0; i < steps; i++) {
+        w.conn[i] = rng() % conns;
+        w.offset_ns[i] = (rng() % 100) < CHANGED_PERCENT
+                             ? BASE_TIMEOUT_NS + (rng() % BASE_TIMEOUT_NS) : 0;
+    }
+    return w;
+}
+
+void nopTimer(EV_P_ ev_timer* w, int revents) {
+    (void)EV_A;
+    (void)w;
+    (void)revents;
+}
+
+void countFired(TimerNode* node) {
+    (*static_cast<size_t*>(node->data))++;
+}
+
+// Old engine path: stop/set/start on every flush (deadline recomputed
+// relative to now, so libev always sees a "new" timeout)
+double benchLibevRearm(size_t conns, const Workload& w) {
+    struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+    std::vector<ev_timer> timers(conns);
+    std::vector<uint64_t> deadline(conns);
+
+    uint64_t start = monotonicNowNs();
+    for (size_t i = 0; i < conns; i++) {
+        deadline[i] = start + BASE_TIMEOUT_NS + i % BASE_TIMEOUT_NS;
+        ev_timer_init(&timers[i], nopTimer, (double)(deadline[i] - start) / 1e9, 0.0);
+        ev_timer_start(loop, &timers[i]);
+    }
+
+    uint64_t t0 = monotonicNowNs();
+    for (size_t i = 0; i < w.conn.size(); i++) {
+        uint32_t c = w.conn[i];
+        uint64_t now = t0 + i;  // Time moves a little per flush
+        if (w.offset_ns[i] != 0) {
+            deadline[c] = now + w.offset_ns[i];
+        }
+        ev_timer_stop(loop, &timers[c]);
+        ev_timer_set(&timers[c], (double)(deadline[c] - now) / 1e9, 0.0);
+        ev_timer_start(loop, &timers[c]);
+    }
+    uint64_t elapsed = monotonicNowNs() - t0;
+
+    for (size_t i = 0; i < conns; i++) {
+        ev_timer_stop(loop, &timers[i]);
+    }
+    ev_loop_destroy(loop);
+    return (double)elapsed / w.conn.size();
+}
+
+// New engine path: LoopTimer::schedule() with the absolute deadline
+double benchWheelRearm(size_t conns, const Workload& w) {
+    struct ev_loop* loop = ev_loop_new(EVFLAG_AUTO);
+    LoopTimer timers;
+    timers.attach(loop);
+
+    std::vector<TimerNode> nodes(conns);
+    std::vector<uint64_t> deadline(conns);
+
+    uint64_t start = monotonicNowNs();
+    for (size_t i = 0; i < conns; i++) {
+        deadline[i] = start + BASE_TIMEOUT_NS + i % BASE_TIMEOUT_NS;
+        timers.schedule(&nodes[i], deadline[i]);
+    }
+
+    uint64_t t0 = monotonicNowNs();
+    for (size_t i = 0; i < w.conn.size(); i++) {
+        uint32_t c = w.conn[i];
+        if (w.offset_ns[i] != 0) {
+            deadline[c] = t0 + i + w.offset_ns[i];
+        }
+        timers.schedule(&nodes[c], deadline[c]);
+    }
+    uint64_t elapsed = monotonicNowNs() - t0;
+
+    for (size_t i = 0; i < conns; i++) {
+        timers.cancel(&nodes[i]);
+    }
+    timers.detach();
+    ev_loop_destroy(loop);
+    return (double)elapsed / w.conn.size();
+}
+
+// Expiry: every connection times out within one second, swept every 1ms
+double benchWheelSweep(size_t conns, size_t& fired) {
+    uint64_t start = 1000000000ULL;
+    TimerWheel wheel(start);
+    std::vector<TimerNode> nodes(conns);
+    std::mt19937 rng(7);
+
+    fired = 0;
+    for (size_t i = 0; i < conns; i++) {
+        nodes[i].fire = countFired;
+        nodes[i].data = &fired;
+        wheel.schedule(&nodes[i], start + rng() % 1000000000ULL);
+    }
+
+    std::vector<TimerNode*> expired;
+    expired.reserve(conns);
+
+    uint64_t t0 = monotonicNowNs();
+    // One extra step: deadlines round up to the next wheel tick
+    for (uint64_t now = start; now <= start + 1001000000ULL; now += 1000000ULL) {
+        expired.clear();
+        wheel.advance(now, expired);
+        for (TimerNode* node : expired) {
+            node->fire(node);
+        }
+    }
+    uint64_t elapsed = monotonicNowNs() - t0;
+    return (double)elapsed / conns;
+}
+
+} // namespace
+
+int main() {
+    const size_t sizes[] = { 10000, 100000 };
+
+    printf("%-12s %16s %16s %9s %16s\n",
+           "connections", "ev_timer ns/op", "wheel ns/op", "speedup", "sweep ns/timer");
+    for (size_t conns : sizes) {
+        Workload w = makeWorkload(conns, 42);
+
+        double ev_ns = benchLibevRearm(conns, w);
+        double wheel_ns = benchWheelRearm(conns, w);
+
+        size_t fired = 0;
+        double sweep_ns = benchWheelSweep(conns, fired);
+        if (fired != conns) {
+            fprintf(stderr, "sweep fired %zu of %zu timers\n", fired, conns);
+            return 1;
+        }
+
+        printf("%-12zu %16.1f %16.1f %8.1fx %16.1f\n",
+               conns, ev_ns, wheel_ns, ev_ns / wheel_ns, sweep_ns);
+    }
+    return 0;
+}
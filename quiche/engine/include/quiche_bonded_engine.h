@@ -0,0 +1,195 @@
+#ifndef __QUICHE_BONDED_ENGINE_H__
+#define __QUICHE_BONDED_ENGINE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <quiche_engine.h>
+#include <quiche_server_engine.h>
+
+namespace quiche {
+
+// Forward declarations
+class BondedEngineImpl;
+class BondedReceiverImpl;
+class EngineRuntime;
+class EngineConfig;
+
+struct BondedEngineOptions {
+    size_t connections;                        // QUIC connections the transfer is striped over (default: 4)
+    std::vector<std::string> local_addresses;  // Connection i sends from entry i % size (default: OS choice)
+    size_t chunk_size;                         // Payload bytes per chunk (default: 16KB, max 65000)
+    size_t max_buffered_bytes;                 // Unacknowledged bytes before write() blocks (default: 64MB, 0 = unlimited)
+    ConfigMap config;                          // Config of every connection (EVENT_QUEUE_SIZE is ignored)
+    std::shared_ptr<EngineRuntime> runtime;       // Run the engines on this runtime (default: own loops)
+    std::shared_ptr<EngineConfig> engine_config;  // Shared QUIC/TLS config (optional)
+
+    BondedEngineOptions()
+        : connections(4), chunk_size(16 * 1024), max_buffered_bytes(64 * 1024 * 1024) {}
+};
+
+// One connection of a bond
+struct BondedConnectionStats {
+    std::string local_address;  // LOCAL_ADDRESS it was given ("" = OS choice)
+    bool established;           // Handshake completed and not closed since
+    bool closed;
+    uint64_t bytes_sent;        // Chunk payload handed to this connection (resends included)
+    size_t outstanding_bytes;   // Of that, not yet acknowledged by the receiver
+    uint64_t rtt_ns;
+    uint64_t cwnd;
+};
+
+struct BondedEngineStats {
+    uint64_t bytes_written;     // Accepted by write()
+    uint64_t bytes_acked;       // Delivered in order by the receiver
+    size_t buffered_bytes;      // Written, not yet acknowledged (held for resending)
+    size_t chunks_sent;
+    size_t chunks_resent;       // Sent again after their connection closed
+    std::vector<BondedConnectionStats> connections;
+};
+
+/**
+ * Bonded Engine - one logical byte stream striped over N QUIC connections
+ *
+ * Opens options.connections engines to host:port, each optionally bound
+ * to its own local address (so the transfer can use several interfaces or
+ * uplinks), and splits what write() gets into sequenced chunks. Every
+ * chunk goes to the connection that should deliver it first, estimated
+ * from its RTT, congestion window and the bytes it already has in flight;
+ * a connection takes at most max(2 * cwnd, 256KB) of unacknowledged data.
+ * The peer runs a BondedReceiver, which reassembles the chunks in order
+ * and acknowledges progress; chunks of a connection that closes are sent
+ * again on the others.
+ *
+ * Data flows from this engine to the receiver only. Closed connections
+ * are not reopened: the transfer fails once all of them are gone.
+ */
+class BondedEngine {
+public:
+    BondedEngine(const std::string& host, const std::string& port,
+                 const BondedEngineOptions& options = BondedEngineOptions());
+
+    /**
+     * Destructor - shuts the connections down (unacknowledged data is lost)
+     */
+    ~BondedEngine();
+
+    // Disable copy
+    BondedEngine(const BondedEngine&) = delete;
+    BondedEngine& operator=(const BondedEngine&) = delete;
+
+    /**
+     * Start all connections (non-blocking)
+     *
+     * @return false if none of them could be started (see getLastError())
+     */
+    bool start();
+
+    /**
+     * Append data to the logical stream (thread-safe, may block)
+     *
+     * Data is buffered until the receiver acknowledges it; chunks go out as
+     * connections are established and have room. Once max_buffered_bytes
+     * are unacknowledged, write() blocks until acknowledgments make room,
+     * so a blocked write() may interleave with writes of other threads.
+     * Do not call it from a callback on the engines' loop threads.
+     *
+     * @param fin Whether this is the end of the stream
+     * @return len; the bytes accepted if the transfer failed or was shut
+     *         down while blocked; -1 after fin, on failure or when not started
+     */
+    ssize_t write(const uint8_t* data, size_t len, bool fin);
+
+    /**
+     * Wait until the receiver acknowledged everything written so far
+     *
+     * @return true when delivered, false on timeout or failure
+     */
+    bool waitDelivered(int timeout_ms = 5000);
+
+    /**
+     * Close all connections (blocking)
+     */
+    void shutdown();
+
+    /**
+     * Check if at least one connection is established
+     */
+    bool isConnected() const;
+
+    /**
+     * Get transfer and per-connection statistics (thread-safe)
+     */
+    BondedEngineStats getStats() const;
+
+    /**
+     * Get last error message
+     */
+    std::string getLastError() const;
+
+private:
+    BondedEngineImpl* mPImpl;
+};
+
+// Called with the in-order bytes of one bond (bond_id identifies the
+// sending BondedEngine); fin is set once, with the last bytes. data is
+// valid only during the call.
+using BondDataHandler = std::function<void(uint64_t bond_id, const uint8_t* data,
+                                           size_t len, bool fin)>;
+
+struct BondedReceiverOptions {
+    size_t max_held_bytes;  // Out-of-order bytes a bond may hold before it is closed (default: 64MB)
+
+    BondedReceiverOptions() : max_held_bytes(64 * 1024 * 1024) {}
+};
+
+// Receiver counters (bonds_active is a current value)
+struct BondedReceiverStats {
+    size_t bonds_active;
+    size_t bonds_completed;     // FIN delivered
+    size_t bonds_failed;        // Held too much out-of-order data
+    uint64_t bytes_delivered;
+    size_t chunks_received;
+    size_t chunks_reordered;    // Arrived ahead of a missing chunk and were held
+    size_t chunks_duplicate;    // Already delivered (resent after a connection closed)
+};
+
+/**
+ * Bonded Receiver - server side of BondedEngine
+ *
+ * Groups the connections of each bond, reassembles their chunks in order
+ * and hands the bytes to the handler. Feed it the events of the server's
+ * event callback for connections that carry bonds; it reads their
+ * streams itself. Runs on the server's loop thread.
+ */
+class BondedReceiver {
+public:
+    explicit BondedReceiver(BondDataHandler handler,
+                            const BondedReceiverOptions& options = BondedReceiverOptions());
+    ~BondedReceiver();
+
+    // Disable copy
+    BondedReceiver(const BondedReceiver&) = delete;
+    BondedReceiver& operator=(const BondedReceiver&) = delete;
+
+    /**
+     * Handle one server event (from the ServerEventCallback)
+     */
+    void onEvent(ServerConnection* conn, EngineEvent event, const EventData& event_data);
+
+    /**
+     * Get receiver counters (thread-safe)
+     */
+    BondedReceiverStats getStats() const;
+
+private:
+    BondedReceiverImpl* mPImpl;
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_BONDED_ENGINE_H__
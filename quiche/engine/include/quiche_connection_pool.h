@@ -0,0 +1,109 @@
+#ifndef __QUICHE_CONNECTION_POOL_H__
+#define __QUICHE_CONNECTION_POOL_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <quiche_engine.h>
+
+namespace quiche {
+
+// Forward declarations
+class ConnectionPoolImpl;
+class EngineRuntime;
+class EngineConfig;
+
+struct ConnectionPoolOptions {
+    size_t connections_per_origin;    // Established connections kept per host:port (default: 2)
+    uint64_t replace_before_idle_ms;  // Replace a quiet connection this long before
+                                      // MAX_IDLE_TIMEOUT would close it (default: 1000)
+    ConfigMap config;                 // Config of every pooled engine (EVENT_QUEUE_SIZE is ignored)
+    std::shared_ptr<EngineRuntime> runtime;       // Run the engines on this runtime (default: own loops)
+    std::shared_ptr<EngineConfig> engine_config;  // Shared QUIC/TLS config (optional)
+
+    ConnectionPoolOptions() : connections_per_origin(2), replace_before_idle_ms(1000) {}
+};
+
+// Pool counters (established/connecting/origins are current values)
+struct ConnectionPoolStats {
+    size_t hits;                // acquire() returned an established connection right away
+    size_t misses;              // acquire() had to wait for a handshake (or timed out)
+    size_t handshakes_avoided;  // acquire() reused a connection handed out before
+    size_t handshakes_started;  // Connections opened by the pool
+    size_t replaced_idle;       // Replaced before the idle timeout
+    size_t replaced_closed;     // Replaced after the connection closed
+    size_t start_failures;      // Engines that failed to start (see getLastError())
+    size_t established;
+    size_t connecting;
+    size_t origins;
+};
+
+/**
+ * Connection Pool - established connections per host:port, ready for use
+ *
+ * Keeps connections_per_origin engines connected to every origin it has
+ * seen (prewarm() or acquire()), and hands them out round-robin, so
+ * requests run on a connection whose handshake is already done. A
+ * connection is shared, not leased: several users may hold it at once and
+ * each works on its own streams, via QuicheEngine::call() or
+ * openStream() with writeStream()/readStream(). The default stream of
+ * write()/read() must not be used on pooled engines.
+ *
+ * A background thread replaces closed connections, and connections that
+ * stayed quiet long enough to be near their idle timeout: the replacement
+ * handshakes first, then the old connection leaves the pool (it is closed
+ * once no user holds it). The pool owns the engines' event callbacks.
+ */
+class ConnectionPool {
+public:
+    explicit ConnectionPool(const ConnectionPoolOptions& options = ConnectionPoolOptions());
+
+    /**
+     * Destructor - stops the maintenance thread and releases the pool's
+     * engines (engines still held by users stay open until released)
+     */
+    ~ConnectionPool();
+
+    // Disable copy
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    /**
+     * Start connecting to an origin ahead of its first acquire() (non-blocking)
+     */
+    void prewarm(const std::string& host, const std::string& port);
+
+    /**
+     * Get an established connection to host:port (thread-safe)
+     *
+     * Returns at once when the origin has one; otherwise connections are
+     * started as needed and the call waits up to timeout_ms for the first
+     * handshake to complete.
+     *
+     * @return Connected engine, nullptr on timeout
+     */
+    std::shared_ptr<QuicheEngine> acquire(const std::string& host, const std::string& port,
+                                          int timeout_ms = 5000);
+
+    /**
+     * Get pool counters (thread-safe)
+     */
+    ConnectionPoolStats getStats() const;
+
+    /**
+     * Get the latest connection start failure (thread-safe; empty if none)
+     *
+     * An origin whose connections fail to start or to handshake is retried
+     * with exponential backoff (100ms doubling up to 5s).
+     */
+    std::string getLastError() const;
+
+private:
+    ConnectionPoolImpl* mPImpl;
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_CONNECTION_POOL_H__
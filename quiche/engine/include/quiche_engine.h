@@ -6,11 +6,20 @@
 #include <functional>
 #include <cstdint>
 #include <cstddef>
+#include <memory>
+#include <future>
+#include <vector>
+
+#include <quiche_session_cache.h>
+#include <quiche_engine_runtime.h>
 
 extern "C" {
 #include <quiche.h>
 }
 
+// libev loop, for engines driven by the application's own loop
+struct ev_loop;
+
 namespace quiche {
 
 // Configuration keys
@@ -25,6 +34,32 @@ enum class ConfigKey {
     INITIAL_MAX_STREAMS_UNI,             // uint64_t: Initial max streams (uni)
     DISABLE_ACTIVE_MIGRATION,            // bool: Disable active migration
     ENABLE_DEBUG_LOG,                    // bool: Enable debug logging
+    ENABLE_EARLY_DATA,                   // bool: Send 0-RTT data when a session is resumed
+    SESSION_CACHE_FILE,                  // string: Persist session tickets to this file
+    TLS_CERT_FILE,                       // string: PEM certificate chain (server)
+    TLS_KEY_FILE,                        // string: PEM private key (server)
+    ENABLE_RETRY,                        // bool: Stateless retry address validation (server)
+    MAX_PACING_RATE,                     // uint64_t: Connection send rate cap in bytes/sec (0 = none)
+    ENABLE_HAPPY_EYEBALLS,               // bool: Race handshakes across resolved addresses (default: true)
+    CONNECTION_ATTEMPT_DELAY_MS,         // uint64_t: Stagger between racing attempts (default: 250)
+    DNS_CACHE_TTL_MS,                    // uint64_t: Reuse cached lookups up to this age (default: 60000)
+    LOOP_CPU_AFFINITY,                   // string: CPUs for the event loop thread, e.g. "2" or "0-1,4"
+    LOOP_SCHED_POLICY,                   // string: Event loop thread policy "other", "fifo" or "rr"
+    LOOP_SCHED_PRIORITY,                 // uint64_t: Real-time priority for "fifo"/"rr"
+    LOOP_NICE,                           // int: Nice value for "other" (-20..19)
+    KEEP_ALIVE_INTERVAL_MS,              // uint64_t: PING after this much quiet (default: 0, off)
+    IO_ARENA_HUGE_PAGES,                 // bool: Back packet I/O buffers with huge pages (default: false)
+    IO_ARENA_NUMA_NODE,                  // int: NUMA node for packet I/O buffers (default: -1, loop thread's)
+    SHARED_UDP_SOCKET,                   // bool: Share the runtime loop's UDP socket (default: false)
+    EVENT_QUEUE_SIZE,                    // uint64_t: Queue events for pollEvents() (default: 0, callbacks on the loop)
+    ALPN_PROTOCOLS,                      // string: Comma-separated ALPN list, most preferred first
+    TLS_CA_FILE,                         // string: PEM bundle of trusted CAs (client)
+    VERIFY_PEER,                         // bool: Verify the server certificate (default: true)
+    LOW_MEMORY_MODE,                     // bool: Standby profile for many idle engines (default: false)
+    POWER_SAVE_MODE,                     // bool: Coalesce timers and wakeups (default: false)
+    TIMER_SLACK_MS,                      // uint64_t: Latency traded for fewer wakeups (default: 10, POWER_SAVE_MODE)
+    LOCAL_ADDRESS,                       // string: Send from this local IP, e.g. "192.0.2.7" (default: any)
+    MAX_CONNECTIONS,                     // uint64_t: Drop new Initials beyond this many connections (server, 0 = none)
 };
 
 // Configuration value types (C++11 compatible)
@@ -44,6 +79,9 @@ struct ConfigValue {
 
     ConfigValue() : type(ConfigValueType::UINT64), uint_val(0) {}
     ConfigValue(uint64_t v) : type(ConfigValueType::UINT64), uint_val(v) {}
+    // Plain integer literals (config[key] = 30000) would otherwise be ambiguous
+    ConfigValue(int v) : type(ConfigValueType::UINT64), uint_val(static_cast<uint64_t>(v)) {}
+    ConfigValue(unsigned int v) : type(ConfigValueType::UINT64), uint_val(v) {}
     ConfigValue(bool v) : type(ConfigValueType::BOOL), bool_val(v) {}
     ConfigValue(const std::string& v) : type(ConfigValueType::STRING), uint_val(0), str_val(v) {}
     ConfigValue(const char* v) : type(ConfigValueType::STRING), uint_val(0), str_val(v) {}
@@ -56,9 +94,12 @@ enum class EngineEvent {
     CONNECTED,
     CONNECTION_CLOSED,
     STREAM_READABLE,
-    STREAM_WRITABLE,
+    STREAM_WRITABLE,     // Send backlog (send_queue_bytes) drained to quiche (uint_val = 0)
     DATAGRAM_RECEIVED,
     ERROR,
+    PATH_VALIDATED,      // Probed path usable (str_val = local "ip:port")
+    PATH_FAILED,         // Probe or migration failed (str_val = local "ip:port")
+    PEER_MIGRATED,       // Peer moved to a new address (str_val = peer "ip:port")
 };
 
 // Event data types (C++11 compatible)
@@ -78,6 +119,16 @@ struct EventData {
     EventData(uint64_t v) : type(EventDataType::UINT64), uint_val(v) {}
 };
 
+// One event of a batch (setEventBatchCallback). str_val points into engine
+// storage and is valid only during the callback.
+struct EventRecord {
+    EngineEvent event;
+    EventDataType type;
+    uint64_t uint_val;
+    const char* str_val;  // NUL-terminated; nullptr unless type is STRING
+    size_t str_len;
+};
+
 // Connection statistics
 struct EngineStats {
     size_t packets_sent;
@@ -87,11 +138,71 @@ struct EngineStats {
     size_t packets_lost;
     uint64_t rtt_ns;
     uint64_t cwnd;
+    bool session_resumed;       // TLS session was resumed (no full handshake)
+    size_t early_data_bytes;    // Stream bytes accepted as 0-RTT early data
+    size_t send_queue_bytes;    // Written but not yet accepted by quiche (command queue + scheduler backlog)
+    uint64_t connect_time_ipv4_us;  // Handshake time over IPv4 (0 = no IPv4 attempt completed)
+    uint64_t connect_time_ipv6_us;  // Handshake time over IPv6 (0 = no IPv6 attempt completed)
+    size_t connect_attempts;        // Resolved addresses a handshake was started on
+    uint64_t resolve_time_us;       // DNS lookup time (0 = cache hit or preset addresses)
+    size_t keepalives_sent;         // Keep-alive PINGs sent
+    uint64_t keepalive_interval_ms; // Current (adaptive) keep-alive interval, 0 = off
+    size_t io_arena_bytes;          // Mapped size of the packet I/O arena (0 = not yet allocated)
+    bool io_arena_huge_pages;       // I/O arena got hugetlb pages or was advised for THP
+    size_t events_coalesced;        // STREAM_READABLE folded into one still in the event queue
+    size_t event_queue_spills;      // Events queued past a full ring (EVENT_QUEUE_SIZE too small)
+    size_t writes_expired;          // Streams reset because their write deadline passed
+    size_t expired_bytes;           // Queued bytes dropped at expiry (never handed to quiche)
+    size_t resident_bytes;          // Engine memory: object, I/O arena, stream buffers, queued writes
+    size_t loop_stack_bytes;        // Stack of the engine's own loop thread (0 = shared/external loop)
+    uint64_t loop_wakeups;          // Times the loop running the engine woke up
+    double wakeups_per_sec;         // Loop wakeups per second, averaged over the last 1-2 seconds
+};
+
+// Outcome of one call()
+struct RpcResponse {
+    bool ok;                     // Complete response received (FIN)
+    std::vector<uint8_t> data;   // Response body
+    std::string error;           // Why the call failed (ok == false)
+    uint64_t stream_id;          // Stream the call ran on (valid once it got one)
+    uint64_t latency_us;         // From call() until the response or failure
+
+    RpcResponse() : ok(false), stream_id(0), latency_us(0) {}
+};
+
+// Request/response call statistics (getRpcStats())
+struct RpcStats {
+    static const size_t LATENCY_BUCKETS = 32;
+
+    size_t calls_completed;
+    size_t calls_failed;
+    size_t calls_active;    // Request on a stream, response not complete
+    size_t calls_queued;    // Waiting for the handshake or for peer stream credit
+    size_t credit_stalls;   // Times queued calls had to wait for the peer to allow more streams
+    uint64_t latency_us[LATENCY_BUCKETS];  // Completed calls, bucket i: [2^i, 2^(i+1)) us
+
+    // Latency (upper bucket bound, us) within which fraction p of the
+    // completed calls finished; 0 if none completed
+    uint64_t latencyPercentileUs(double p) const;
+};
+
+// Scheduling settings of an event loop thread, read back after they were applied
+struct LoopThreadInfo {
+    bool started;              // Loop thread is running and applied its settings
+    std::string cpus;          // CPUs the thread may run on ("0-3,6"), empty if unknown
+    std::string sched_policy;  // "other", "fifo" or "rr"
+    int sched_priority;        // Real-time priority (0 for "other")
+    int nice_value;
+    uint64_t timer_slack_ns;   // Linux timer slack of the thread (0 = unknown)
+    std::string error;         // Requested settings that could not be applied
+
+    LoopThreadInfo() : started(false), sched_priority(0), nice_value(0), timer_slack_ns(0) {}
 };
 
 // Forward declarations
 class QuicheEngine;
 class QuicheEngineImpl;
+class EngineConfig;
 
 // Event callback type
 using EventCallback = std::function<void(
@@ -101,6 +212,14 @@ using EventCallback = std::function<void(
     void* user_data
 )>;
 
+// Batched event callback type
+using EventBatchCallback = std::function<void(
+    QuicheEngine* engine,
+    const EventRecord* events,
+    size_t count,
+    void* user_data
+)>;
+
 /**
  * QUIC Engine - C++ wrapper around quiche library
  * Thread-safe design with background event loop
@@ -123,12 +242,116 @@ public:
      *   - INITIAL_MAX_STREAM_DATA_UNI (uint64_t): Bytes (default: 1000000)
      *   - INITIAL_MAX_STREAMS_BIDI (uint64_t): Stream count (default: 100)
      *   - INITIAL_MAX_STREAMS_UNI (uint64_t): Stream count (default: 100)
-     *   - DISABLE_ACTIVE_MIGRATION (bool): Disable migration (default: true)
+     *   - DISABLE_ACTIVE_MIGRATION (bool): Tell the peer not to migrate
+     *     (default: true). Set to false to allow probePath()/migrate()
      *   - ENABLE_DEBUG_LOG (bool): Enable debug logging (default: false)
+     *   - ENABLE_EARLY_DATA (bool): Send writes issued before the handshake
+     *     completes as 0-RTT when the session is resumed (default: false)
+     *   - SESSION_CACHE_FILE (string): Persist session tickets to this file,
+     *     keyed by host:port (default: "", in-memory only)
+     *   - MAX_PACING_RATE (uint64_t): Cap on connection send rate in bytes/sec,
+     *     applied to quiche's pacer and to queued stream data (default: 0, none)
+     *   - ENABLE_HAPPY_EYEBALLS (bool): When the host resolves to several
+     *     addresses, start handshakes on them alternating IPv6/IPv4 and keep
+     *     the first that completes (default: true)
+     *   - CONNECTION_ATTEMPT_DELAY_MS (uint64_t): Delay before the next
+     *     address is tried while no handshake completed (default: 250, min 10)
+     *   - DNS_CACHE_TTL_MS (uint64_t): Use a process-wide cached lookup of
+     *     host:port if it is at most this old (default: 60000, 0 = always
+     *     resolve)
+     *   - LOOP_CPU_AFFINITY (string): Pin the event loop thread to these CPUs,
+     *     e.g. next to the NIC's IRQ core (default: "", not pinned)
+     *   - LOOP_SCHED_POLICY (string): "other", "fifo" or "rr" for the event
+     *     loop thread; real-time policies need CAP_SYS_NICE or RLIMIT_RTPRIO
+     *     (default: "", inherited)
+     *   - LOOP_SCHED_PRIORITY (uint64_t): Priority for "fifo"/"rr"
+     *     (default: the policy's minimum)
+     *   - LOOP_NICE (int): Nice value of the event loop thread under "other"
+     *     (default: inherited)
+     *   The LOOP_* keys apply to the dedicated loop thread only; see
+     *   getLoopThreadInfo() for what the OS granted
+     *   - KEEP_ALIVE_INTERVAL_MS (uint64_t): Send a PING when nothing was
+     *     received for this long, and always before 70% of the idle timeout
+     *     (default: 0, disabled; min 1000)
+     *   - IO_ARENA_HUGE_PAGES (bool): Map the packet I/O buffers with
+     *     MAP_HUGETLB, falling back to transparent huge pages (default: false)
+     *   - IO_ARENA_NUMA_NODE (int): Prefer this NUMA node for the packet I/O
+     *     buffers (default: -1, the node of the loop thread that first
+     *     touches them, so pin it with LOOP_CPU_AFFINITY)
+     *   - SHARED_UDP_SOCKET (bool): On an EngineRuntime, send and receive
+     *     through one UDP socket per loop and address family shared with the
+     *     loop's other engines; packets are routed by connection ID
+     *     (default: false; ignored by engines with their own loop)
+     *   - EVENT_QUEUE_SIZE (uint64_t): Deliver events through a queue of this
+     *     many slots drained by pollEvents() instead of calling the event
+     *     callback on the loop thread (default: 0, inline callbacks)
+     *   - ALPN_PROTOCOLS (string): Application protocols to offer, comma
+     *     separated (default: "hq-interop,hq-29,hq-28,hq-27,http/0.9")
+     *   - TLS_CA_FILE (string): Trust the CAs in this PEM file (default: "",
+     *     the TLS library's default store)
+     *   - VERIFY_PEER (bool): Verify the server certificate (default: true)
+     *   - LOW_MEMORY_MODE (bool): For many mostly idle engines: packet I/O
+     *     buffers are taken from a process-wide pool on the first packet and
+     *     returned after 1s without I/O (IO_ARENA_* are ignored), stream
+     *     read buffers hold at most 16KB (quiche keeps the rest under flow
+     *     control) and the dedicated loop thread gets a 256KB stack
+     *     (default: false). See resident_bytes in getStats()
+     *   - POWER_SAVE_MODE (bool): Trade up to TIMER_SLACK_MS of latency for
+     *     fewer CPU wakeups: the loop thread gets that much timer slack
+     *     (Linux), keep-alive and other lax timers fall due on multiples of
+     *     it, and writes following one another within that window wake the
+     *     loop once (default: false). See wakeups_per_sec in getStats()
+     *   - TIMER_SLACK_MS (uint64_t): Slack of POWER_SAVE_MODE (default: 10)
+     *   - LOCAL_ADDRESS (string): Bind the UDP socket to this numeric local
+     *     IP, e.g. to use a given interface; addresses of the other family
+     *     fail to connect (default: "", chosen by the OS; ignored with
+     *     SHARED_UDP_SOCKET)
+     *   Engines sharing an EngineConfig (setEngineConfig()) take the QUIC
+     *   and TLS keys from it instead; MAX_IDLE_TIMEOUT here still overrides
+     *   the local idle timeout
      */
     QuicheEngine(const std::string& host, const std::string& port,
                  const ConfigMap& config = ConfigMap());
 
+    /**
+     * Create a QUIC engine on a shared runtime loop
+     *
+     * No dedicated event loop thread is created: the engine's socket watcher,
+     * timer and command queue run on a loop chosen by the runtime's
+     * LoopAssignment policy. Event callbacks are invoked on that loop thread
+     * and must not block, since other engines share it.
+     *
+     * @param runtime Shared runtime (kept alive by the engine)
+     * @param host Remote hostname or IP address
+     * @param port Remote port number
+     * @param config Configuration parameters (optional)
+     */
+    QuicheEngine(std::shared_ptr<EngineRuntime> runtime,
+                 const std::string& host, const std::string& port,
+                 const ConfigMap& config = ConfigMap());
+
+    /**
+     * Create a QUIC engine driven by the application's libev loop
+     *
+     * No thread is created and no command queue is involved: the engine's
+     * socket and timer watchers are started on loop, and every method
+     * (start(), write(), read(), shutdown(), the destructor, ...) must be
+     * called on the thread running that loop. Writes are handed to quiche and
+     * flushed inline; read() copies straight out of quiche, so STREAM_READABLE
+     * repeats until the stream is drained. Event callbacks run on the loop.
+     *
+     * shutdown() does not block: CONNECTION_CLOSED follows from the loop once
+     * the close completes. The engine must be destroyed before the loop.
+     *
+     * @param loop Application's libev loop (not owned)
+     * @param host Remote hostname or IP address
+     * @param port Remote port number
+     * @param config Configuration parameters (optional; LOOP_* keys are ignored)
+     */
+    QuicheEngine(struct ev_loop* loop,
+                 const std::string& host, const std::string& port,
+                 const ConfigMap& config = ConfigMap());
+
     /**
      * Destructor - automatically stops and cleans up resources
      */
@@ -145,12 +368,86 @@ public:
     /**
      * Set event callback handler
      *
+     * The callback runs on the event loop thread, or with EVENT_QUEUE_SIZE
+     * on the thread calling pollEvents(). engine is always this engine.
+     *
      * @param callback Callback function
      * @param user_data User data passed to callback (optional)
      * @return true on success, false on failure
      */
     bool setEventCallback(EventCallback callback, void* user_data = nullptr);
 
+    /**
+     * Set a callback receiving all events of one loop iteration at once
+     *
+     * Events are collected while the loop handles a wakeup (all recvmmsg
+     * batches, timers, commands) and handed over as one array before the loop
+     * waits again: at most one STREAM_READABLE per stream and one
+     * STREAM_WRITABLE per batch. CONNECTION_CLOSED is delivered right away
+     * together with what was collected before it. Replaces the per-event
+     * callback; with EVENT_QUEUE_SIZE, pollEvents() hands its events over as
+     * one batch. Set before start().
+     *
+     * @param callback Batch callback (nullptr: back to per-event callbacks)
+     * @param user_data User data passed to callback (optional)
+     * @return true on success, false if the engine is already running
+     */
+    bool setEventBatchCallback(EventBatchCallback callback, void* user_data = nullptr);
+
+    /**
+     * Deliver queued events on the calling thread (EVENT_QUEUE_SIZE > 0)
+     *
+     * Runs the event callback for up to max_events events, oldest first.
+     * The loop thread only queues them, so a slow handler never delays
+     * packet processing. STREAM_READABLE is coalesced per stream: one
+     * undelivered event stands for all data that arrived meanwhile, so read
+     * the stream until it returns 0. One thread polls at a time; a
+     * concurrent call (or one from inside a handler) returns 0.
+     *
+     * @param max_events Most events to deliver in this call
+     * @param timeout_ms Wait this long for a first event (0 = don't wait)
+     * @return Number of events delivered (0 without EVENT_QUEUE_SIZE)
+     */
+    size_t pollEvents(size_t max_events = 64, int timeout_ms = 0);
+
+    /**
+     * Use a prebuilt, possibly shared QUIC/TLS config (before start())
+     *
+     * Without one, start() builds a config from this engine's ConfigMap.
+     * See EngineConfig (quiche_engine_config.h).
+     *
+     * @param config Shared config (nullptr: build one from the ConfigMap)
+     * @return true on success, false if the engine is already running or
+     *         the config is invalid
+     */
+    bool setEngineConfig(std::shared_ptr<EngineConfig> config);
+
+    /**
+     * Set TLS session cache used for resumption (must be called before start())
+     *
+     * Without an explicit cache, SESSION_CACHE_FILE selects a process-wide
+     * file-backed cache, and ENABLE_EARLY_DATA alone selects the process-wide
+     * in-memory cache. Sessions are looked up by "host:port" when connecting
+     * and stored when the connection closes.
+     *
+     * @param cache Session cache (nullptr disables resumption)
+     * @return true on success, false if the engine is already running
+     */
+    bool setSessionCache(std::shared_ptr<SessionCache> cache);
+
+    /**
+     * Connect to this address instead of resolving the host (before start())
+     *
+     * May be called several times; addresses are tried in the order given,
+     * raced as with resolved addresses. The host name is still used for SNI
+     * and certificate verification.
+     *
+     * @param addr IPv4 or IPv6 socket address
+     * @param addr_len Length of addr
+     * @return true on success, false if the engine is already running
+     */
+    bool addPeerAddress(const struct sockaddr* addr, socklen_t addr_len);
+
     /**
      * Write data to stream (thread-safe)
      * Uses internal default stream ID
@@ -158,9 +455,104 @@ public:
      * @param data Data buffer
      * @param len Data length
      * @param fin Whether this is the final data on stream
+     * @param deadline_ms Reset the stream if not delivered within this many
+     *                    milliseconds (0 = no deadline, see writeStream())
      * @return Number of bytes written, or -1 on error
      */
-    ssize_t write(const uint8_t* data, size_t len, bool fin);
+    ssize_t write(const uint8_t* data, size_t len, bool fin, uint64_t deadline_ms = 0);
+
+    /**
+     * Write data to a specific stream (thread-safe)
+     *
+     * Data is queued on the event loop thread and handed to quiche as flow
+     * control, the stream's rate limit and its scheduling weight allow;
+     * partial acceptance by quiche never drops data. Called on the loop
+     * thread, the write runs inline: without a deadline and with nothing
+     * queued ahead it goes to quiche directly, and the packets go out once
+     * the callback returned (outside a callback, on the next loop
+     * iteration). No callback of this engine runs from inside the call.
+     *
+     * With a deadline, data that is late is worth nothing: if the peer has
+     * not acknowledged the stream up to its FIN when the deadline passes,
+     * its queued data is dropped and the stream is reset (RESET_STREAM), so
+     * no more bandwidth goes to it. Reported as writes_expired in
+     * getStats(). The deadline covers the stream, not just this write (a
+     * stream is reset as a whole); the latest write with a deadline sets
+     * it. Send one message per stream, with fin set on its last write.
+     *
+     * @param stream_id Stream ID (client-initiated bidirectional: 0, 4, 8, ...)
+     * @param data Data buffer (may be nullptr when len is 0 and fin is true)
+     * @param len Data length (at most 65536 per call)
+     * @param fin Whether this is the final data on stream
+     * @param deadline_ms Milliseconds from now until the stream is reset
+     *                    unless complete (0 = no deadline)
+     * @return Number of bytes queued, or -1 on error
+     */
+    ssize_t writeStream(uint64_t stream_id, const uint8_t* data, size_t len, bool fin,
+                        uint64_t deadline_ms = 0);
+
+    /**
+     * Read data from a specific stream (thread-safe)
+     *
+     * Called from an event callback, data not yet buffered is read from
+     * quiche directly.
+     *
+     * @return Number of bytes read, 0 if no data available, -1 on fatal error
+     */
+    ssize_t readStream(uint64_t stream_id, uint8_t* buf, size_t buf_len, bool& fin);
+
+    /**
+     * Set scheduling weight and rate limit of a stream (thread-safe)
+     *
+     * Streams with queued data share the connection by weighted round-robin
+     * (a weight-4 stream gets four times the share of a weight-1 stream when
+     * both are backlogged). max_rate caps the stream with a token bucket.
+     *
+     * @param stream_id Stream ID
+     * @param weight Relative share, >= 1 (default for unconfigured streams: 1)
+     * @param max_rate Bytes per second, 0 = unlimited
+     * @param burst Token bucket depth in bytes, 0 = 50ms of max_rate
+     * @return true if queued, false on invalid parameters
+     */
+    bool setStreamSchedule(uint64_t stream_id, uint32_t weight,
+                           uint64_t max_rate = 0, uint64_t burst = 0);
+
+    /**
+     * Reserve an unused client-initiated bidirectional stream (thread-safe)
+     *
+     * Lets several users of one connection (e.g. from a ConnectionPool)
+     * open streams without picking the same ID. Never returns the default
+     * stream of write()/read() or a stream call() uses; streams given to
+     * writeStream() directly are skipped once their first write is queued.
+     *
+     * @return Stream ID (0, 8, 12, ...)
+     */
+    uint64_t openStream();
+
+    /**
+     * Send a request on a new stream and wait for the response (thread-safe)
+     *
+     * Each call opens an unused client bidirectional stream (openStream()), sends
+     * the request with FIN and completes when the peer finishes the
+     * response, so a slow call never holds up the others. Calls made before
+     * the handshake, or while the peer allows no more streams
+     * (quiche_conn_peer_streams_left_bidi() is 0), wait in order until they
+     * can start. Responses on call streams are not reported as
+     * STREAM_READABLE. A connection that closes fails its pending calls.
+     *
+     * Do not wait on the future on the event loop thread (callbacks, or an
+     * external loop): the response is read on that thread.
+     *
+     * @param request Request body (may be nullptr when len is 0)
+     * @param len Request length
+     * @return Future of the response; check RpcResponse::ok
+     */
+    std::future<RpcResponse> call(const uint8_t* request, size_t len);
+
+    /**
+     * Get request/response call statistics and the latency histogram
+     */
+    RpcStats getRpcStats() const;
 
 
     /**
@@ -179,6 +571,10 @@ public:
      * Start the engine - begins connection and event loop (non-blocking)
      * Returns immediately after starting background thread
      *
+     * Host resolution happens off the calling thread (process-wide cache,
+     * then a resolver thread). A failed lookup is reported as an ERROR event
+     * (str_val = reason) followed by CONNECTION_CLOSED.
+     *
      * @return true on success, false on failure
      */
     bool start();
@@ -207,6 +603,15 @@ public:
      */
     EngineStats getStats() const;
 
+    /**
+     * Get the scheduling settings of the event loop thread (thread-safe)
+     *
+     * started stays false until the loop thread applied the LOOP_* config
+     * keys, and for engines on a shared runtime loop. Settings that could not
+     * be applied are listed in error; the engine keeps running either way.
+     */
+    LoopThreadInfo getLoopThreadInfo() const;
+
     /**
      * Get last error message
      */
@@ -220,6 +625,43 @@ public:
      */
     std::string getScid() const;
 
+    /**
+     * Probe a new network path from a local address (thread-safe, asynchronous)
+     *
+     * Opens a new UDP socket bound to local_host:local_port and validates the
+     * path to the same peer. Completion is reported as PATH_VALIDATED or
+     * PATH_FAILED; the connection keeps using its current path meanwhile.
+     *
+     * @param local_host Local IP address of the new interface
+     * @param local_port Local port (default: "0", any port)
+     * @return true if the probe was queued, false on error
+     */
+    bool probePath(const std::string& local_host, const std::string& local_port = "0");
+
+    /**
+     * Move the connection to the most recently validated probed path
+     * (thread-safe, asynchronous)
+     *
+     * Takes one round trip instead of a new handshake. PATH_FAILED is
+     * reported if no probed path has been validated yet.
+     *
+     * @return true if the migration was queued, false on error
+     */
+    bool migrate();
+
+    /**
+     * Change the local idle timeout of a running connection (thread-safe)
+     *
+     * Before start() this sets MAX_IDLE_TIMEOUT. Afterwards it updates the
+     * connection's own idle timer (quiche_conn_set_max_idle_timeout); the
+     * peer keeps the value advertised in the handshake, so combine a longer
+     * timeout with KEEP_ALIVE_INTERVAL_MS to hold connections over pauses.
+     *
+     * @param timeout_ms Idle timeout in milliseconds (0 = none on our side)
+     * @return true if applied or queued, false if the engine is not running
+     */
+    bool setIdleTimeout(uint64_t timeout_ms);
+
 private:
     QuicheEngineImpl* mPImpl;
 };
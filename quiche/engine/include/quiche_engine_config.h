@@ -0,0 +1,64 @@
+#ifndef __QUICHE_ENGINE_CONFIG_H__
+#define __QUICHE_ENGINE_CONFIG_H__
+
+#include <string>
+
+#include <quiche_engine.h>
+
+namespace quiche {
+
+// Forward declarations
+class EngineConfigImpl;
+
+/**
+ * Engine Config - immutable QUIC/TLS configuration shared by many engines
+ *
+ * Builds the quiche_config once from a ConfigMap: transport parameters, the
+ * ALPN list (ALPN_PROTOCOLS), trusted CAs (TLS_CA_FILE) and peer
+ * verification (VERIFY_PEER). Engines given the same EngineConfig via
+ * QuicheEngine::setEngineConfig() skip that work and share one TLS context.
+ * Share it via std::shared_ptr: every engine keeps a reference, so the
+ * config outlives the engines using it.
+ */
+class EngineConfig {
+public:
+    /**
+     * Build the configuration (check isValid() afterwards)
+     *
+     * @param config The connection keys of this map are used; the engine
+     *               keys (loop, keep-alive, racing, ...) still come from each
+     *               engine's own ConfigMap
+     */
+    explicit EngineConfig(const ConfigMap& config);
+
+    ~EngineConfig();
+
+    // Disable copy
+    EngineConfig(const EngineConfig&) = delete;
+    EngineConfig& operator=(const EngineConfig&) = delete;
+
+    /**
+     * Whether the quiche config was built (false: see getLastError())
+     */
+    bool isValid() const;
+
+    /**
+     * Why building the config failed (e.g. unreadable TLS_CA_FILE)
+     */
+    std::string getLastError() const;
+
+    /**
+     * The map the config was built from
+     */
+    const ConfigMap& getConfig() const;
+
+    // Internal accessor used by QuicheEngine
+    EngineConfigImpl* impl() const { return mPImpl; }
+
+private:
+    EngineConfigImpl* mPImpl;
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_ENGINE_CONFIG_H__
@@ -0,0 +1,349 @@
+#ifndef __QUICHE_ENGINE_CORO_H__
+#define __QUICHE_ENGINE_CORO_H__
+
+// C++20 coroutine front end for QuicheEngine (header only)
+//
+// The engine library itself stays C++11. This header adds awaitables on top
+// of the public API when the including translation unit is compiled as
+// C++20 with coroutine support; otherwise it only defines
+// QUICHE_ENGINE_HAS_COROUTINES as 0.
+
+#include <quiche_engine.h>
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+
+#define QUICHE_ENGINE_HAS_COROUTINES 1
+
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace quiche {
+
+// Where a suspended coroutine resumes. Called on the engine's loop thread;
+// nullptr resumes inline there (lowest latency, but the coroutine then runs
+// on the loop thread and must not block it).
+using CoExecutor = std::function<void(std::coroutine_handle<>)>;
+
+// Result of CoStream::read()
+struct CoReadResult {
+    ssize_t bytes;  // Bytes read; -1 if the connection closed with nothing left
+    bool fin;       // Stream finished (all data read)
+};
+
+// Fire-and-forget coroutine type for driving the awaitables below
+struct CoTask {
+    struct promise_type {
+        CoTask get_return_object() { return CoTask(); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+class CoEngine;
+
+// One stream of a CoEngine connection
+class CoStream {
+public:
+    class ReadAwaitable;
+    class WriteAwaitable;
+
+    CoStream(CoEngine& owner, uint64_t stream_id) : mOwner(&owner), mStreamId(stream_id) {}
+
+    uint64_t id() const { return mStreamId; }
+
+    // Completes with data, with FIN, or with bytes = -1 once the connection
+    // closed and nothing is left to read. One pending read per stream.
+    ReadAwaitable read(uint8_t* buf, size_t len);
+    ReadAwaitable read(std::span<uint8_t> buf);
+
+    // Queues the data (copied) and completes once the engine's send backlog
+    // is below the CoEngine's high watermark. Returns len, or -1 on error.
+    WriteAwaitable write(const uint8_t* data, size_t len, bool fin = false);
+    WriteAwaitable write(std::span<const uint8_t> data, bool fin = false);
+
+private:
+    CoEngine* mOwner;
+    uint64_t mStreamId;
+};
+
+// Coroutine adapter for a QuicheEngine
+//
+// Takes over the engine's event callback (other events are forwarded to an
+// optional callback) and resumes awaiting coroutines on the engine events.
+// The CoEngine must outlive event delivery: shut the engine down or destroy
+// it before the CoEngine.
+//
+// With an engine on an external loop (QuicheEngine(struct ev_loop*, ...))
+// every engine call must stay on that loop, so use the inline executor.
+// With EVENT_QUEUE_SIZE, coroutines only resume while some thread calls
+// pollEvents().
+class CoEngine {
+public:
+    static constexpr size_t DEFAULT_WRITE_HIGH_WATERMARK = 1024 * 1024;
+
+    explicit CoEngine(QuicheEngine& engine, CoExecutor executor = nullptr,
+                      EventCallback forward = nullptr, void* forward_user_data = nullptr)
+        : mEngine(engine), mExecutor(std::move(executor)), mForward(std::move(forward)),
+          mForwardUserData(forward_user_data), mWriteHighWatermark(DEFAULT_WRITE_HIGH_WATERMARK),
+          mConnected(false), mClosed(false), mWritableGeneration(0)
+    {
+        mEngine.setEventCallback(
+            [this](QuicheEngine* e, EngineEvent event, const EventData& data, void* ud) {
+                (void)ud;
+                onEvent(e, event, data);
+            }, nullptr);
+    }
+
+    // Disable copy
+    CoEngine(const CoEngine&) = delete;
+    CoEngine& operator=(const CoEngine&) = delete;
+
+    QuicheEngine& engine() { return mEngine; }
+
+    // Backlog (EngineStats::send_queue_bytes) above which write() waits
+    void setWriteHighWatermark(size_t bytes) { mWriteHighWatermark = bytes; }
+
+    CoStream stream(uint64_t stream_id) { return CoStream(*this, stream_id); }
+
+    // Starts the engine if needed; completes with true on CONNECTED, false
+    // if it failed to start or closed before the handshake completed
+    class ConnectAwaitable {
+    public:
+        explicit ConnectAwaitable(CoEngine& owner) : mOwner(owner) {}
+
+        bool await_ready() {
+            std::lock_guard<std::mutex> lock(mOwner.mMutex);
+            return mOwner.mConnected || mOwner.mClosed;
+        }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            // Start before registering: start() must not race our own frame
+            if (!mOwner.mEngine.isRunning() && !mOwner.mEngine.start()) {
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(mOwner.mMutex);
+            if (mOwner.mConnected || mOwner.mClosed) {
+                return false;
+            }
+            mOwner.mConnectWaiters.push_back(h);
+            return true;  // Not touched again: h may resume on another thread
+        }
+
+        bool await_resume() {
+            std::lock_guard<std::mutex> lock(mOwner.mMutex);
+            return mOwner.mConnected;
+        }
+
+    private:
+        CoEngine& mOwner;
+    };
+
+    ConnectAwaitable connect() { return ConnectAwaitable(*this); }
+
+private:
+    friend class CoStream;
+
+    struct ReadWaiter {
+        uint64_t stream_id;
+        uint8_t* buf;
+        size_t len;
+        CoReadResult* result;
+        std::coroutine_handle<> handle;
+    };
+
+    QuicheEngine& mEngine;
+    CoExecutor mExecutor;
+    EventCallback mForward;
+    void* mForwardUserData;
+    size_t mWriteHighWatermark;
+
+    std::mutex mMutex;  // Guards the state below (caller threads vs. loop thread)
+    bool mConnected;
+    bool mClosed;
+    uint64_t mWritableGeneration;  // Bumped on STREAM_WRITABLE
+    std::vector<std::coroutine_handle<>> mConnectWaiters;
+    std::list<ReadWaiter> mReadWaiters;
+    std::vector<std::coroutine_handle<>> mWriteWaiters;
+
+    // Read into w; true when w can complete (mMutex held)
+    bool tryRead(ReadWaiter& w) {
+        bool fin = false;
+        ssize_t n = mEngine.readStream(w.stream_id, w.buf, w.len, fin);
+        if (n > 0 || fin || n < 0) {
+            w.result->bytes = n;
+            w.result->fin = fin;
+            return true;
+        }
+        if (mClosed) {
+            w.result->bytes = -1;
+            w.result->fin = false;
+            return true;
+        }
+        return false;
+    }
+
+    void resume(std::vector<std::coroutine_handle<>>& ready) {
+        for (std::coroutine_handle<> h : ready) {
+            if (mExecutor) {
+                mExecutor(h);
+            } else {
+                h.resume();
+            }
+        }
+    }
+
+    void onEvent(QuicheEngine* e, EngineEvent event, const EventData& data) {
+        std::vector<std::coroutine_handle<>> ready;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            switch (event) {
+                case EngineEvent::CONNECTED:
+                    mConnected = true;
+                    ready.swap(mConnectWaiters);
+                    break;
+
+                case EngineEvent::CONNECTION_CLOSED:
+                    mClosed = true;
+                    ready.swap(mConnectWaiters);
+                    for (ReadWaiter& w : mReadWaiters) {
+                        tryRead(w);  // Always completes now
+                        ready.push_back(w.handle);
+                    }
+                    mReadWaiters.clear();
+                    ready.insert(ready.end(), mWriteWaiters.begin(), mWriteWaiters.end());
+                    mWriteWaiters.clear();
+                    break;
+
+                case EngineEvent::STREAM_READABLE:
+                    for (auto it = mReadWaiters.begin(); it != mReadWaiters.end();) {
+                        if (it->stream_id == data.uint_val && tryRead(*it)) {
+                            ready.push_back(it->handle);
+                            it = mReadWaiters.erase(it);
+                        } else {
+                            ++it;
+                        }
+                    }
+                    break;
+
+                case EngineEvent::STREAM_WRITABLE:
+                    mWritableGeneration++;
+                    ready.insert(ready.end(), mWriteWaiters.begin(), mWriteWaiters.end());
+                    mWriteWaiters.clear();
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        resume(ready);
+
+        if (mForward) {
+            mForward(e, event, data, mForwardUserData);
+        }
+    }
+};
+
+class CoStream::ReadAwaitable {
+public:
+    ReadAwaitable(CoEngine& owner, uint64_t stream_id, uint8_t* buf, size_t len)
+        : mOwner(owner), mStreamId(stream_id), mBuf(buf), mLen(len), mResult{0, false} {}
+
+    bool await_ready() { return false; }
+
+    bool await_suspend(std::coroutine_handle<> h) {
+        // Read under the lock so STREAM_READABLE cannot slip in between
+        std::lock_guard<std::mutex> lock(mOwner.mMutex);
+        CoEngine::ReadWaiter w = { mStreamId, mBuf, mLen, &mResult, h };
+        if (mOwner.tryRead(w)) {
+            return false;
+        }
+        mOwner.mReadWaiters.push_back(w);
+        return true;
+    }
+
+    CoReadResult await_resume() { return mResult; }
+
+private:
+    CoEngine& mOwner;
+    uint64_t mStreamId;
+    uint8_t* mBuf;
+    size_t mLen;
+    CoReadResult mResult;
+};
+
+class CoStream::WriteAwaitable {
+public:
+    WriteAwaitable(CoEngine& owner, uint64_t stream_id, const uint8_t* data, size_t len, bool fin)
+        : mOwner(owner), mStreamId(stream_id), mData(data), mLen(len), mFin(fin), mResult(-1) {}
+
+    bool await_ready() { return false; }
+
+    bool await_suspend(std::coroutine_handle<> h) {
+        uint64_t generation;
+        {
+            std::lock_guard<std::mutex> lock(mOwner.mMutex);
+            generation = mOwner.mWritableGeneration;
+        }
+
+        mResult = mOwner.mEngine.writeStream(mStreamId, mData, mLen, mFin);
+        if (mResult < 0 ||
+            mOwner.mEngine.getStats().send_queue_bytes < mOwner.mWriteHighWatermark) {
+            return false;
+        }
+
+        // Backlog too large: wait for it to drain unless it already did
+        std::lock_guard<std::mutex> lock(mOwner.mMutex);
+        if (mOwner.mClosed || mOwner.mWritableGeneration != generation) {
+            return false;
+        }
+        mOwner.mWriteWaiters.push_back(h);
+        return true;
+    }
+
+    ssize_t await_resume() { return mResult; }
+
+private:
+    CoEngine& mOwner;
+    uint64_t mStreamId;
+    const uint8_t* mData;
+    size_t mLen;
+    bool mFin;
+    ssize_t mResult;
+};
+
+inline CoStream::ReadAwaitable CoStream::read(uint8_t* buf, size_t len) {
+    return ReadAwaitable(*mOwner, mStreamId, buf, len);
+}
+
+inline CoStream::ReadAwaitable CoStream::read(std::span<uint8_t> buf) {
+    return ReadAwaitable(*mOwner, mStreamId, buf.data(), buf.size());
+}
+
+inline CoStream::WriteAwaitable CoStream::write(const uint8_t* data, size_t len, bool fin) {
+    return WriteAwaitable(*mOwner, mStreamId, data, len, fin);
+}
+
+inline CoStream::WriteAwaitable CoStream::write(std::span<const uint8_t> data, bool fin) {
+    return WriteAwaitable(*mOwner, mStreamId, data.data(), data.size(), fin);
+}
+
+} // namespace quiche
+
+#else
+
+#define QUICHE_ENGINE_HAS_COROUTINES 0
+
+#endif // coroutine support
+
+#endif // __QUICHE_ENGINE_CORO_H__
@@ -0,0 +1,66 @@
+#ifndef __QUICHE_ENGINE_RUNTIME_H__
+#define __QUICHE_ENGINE_RUNTIME_H__
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace quiche {
+
+// How engines are assigned to runtime loops
+enum class LoopAssignment {
+    LEAST_LOADED,   // Loop with the fewest attached engines
+    HASH,           // Hash of "host:port" (same origin -> same loop)
+};
+
+// Forward declarations
+class EngineRuntimeImpl;
+
+/**
+ * Engine Runtime - pool of shared event loop threads
+ *
+ * Engines created against a runtime do not spawn their own "QuicEventLoop"
+ * thread; their socket watcher, timers and command queue live on one of the
+ * runtime's loops instead. Share a runtime via std::shared_ptr: every engine
+ * keeps a reference, so loops outlive the engines attached to them.
+ */
+class EngineRuntime {
+public:
+    /**
+     * Create a runtime and start its loop threads
+     *
+     * @param num_loops Number of event loop threads (0 = hardware concurrency)
+     * @param assignment Loop assignment policy for new engines
+     */
+    explicit EngineRuntime(size_t num_loops = 1,
+                           LoopAssignment assignment = LoopAssignment::LEAST_LOADED);
+
+    /**
+     * Destructor - stops and joins all loop threads
+     */
+    ~EngineRuntime();
+
+    // Disable copy
+    EngineRuntime(const EngineRuntime&) = delete;
+    EngineRuntime& operator=(const EngineRuntime&) = delete;
+
+    /**
+     * Number of loop threads
+     */
+    size_t loopCount() const;
+
+    /**
+     * Number of engines attached to each loop
+     */
+    std::vector<size_t> loopLoads() const;
+
+    // Internal accessor used by QuicheEngine
+    EngineRuntimeImpl* impl() const { return mPImpl; }
+
+private:
+    EngineRuntimeImpl* mPImpl;
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_ENGINE_RUNTIME_H__
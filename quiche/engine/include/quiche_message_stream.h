@@ -0,0 +1,113 @@
+#ifndef __QUICHE_MESSAGE_STREAM_H__
+#define __QUICHE_MESSAGE_STREAM_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <quiche_engine.h>
+
+namespace quiche {
+
+// Byte stream under a MessageStream (same contract as QuicheEngine's
+// writeStream()/readStream(): writes take all data or fail, reads return
+// what is available, 0 if nothing)
+using StreamWriteFn = std::function<ssize_t(const uint8_t* data, size_t len, bool fin)>;
+using StreamReadFn = std::function<ssize_t(uint8_t* buf, size_t buf_len, bool& fin)>;
+
+// Called once per received message. data points into the receive buffer
+// (or a staging copy for messages that wrap around it) and is valid only
+// during the call.
+using MessageHandler = std::function<void(const uint8_t* data, size_t len)>;
+
+struct MessageStreamOptions {
+    size_t max_message_size;  // Longer incoming messages fail the stream (default: 16MB)
+    size_t batch_bytes;       // Queued messages are written once this much is pending (default: 32KB)
+    size_t receive_buffer;    // Initial receive ring size, grows to fit a message (default: 64KB)
+
+    MessageStreamOptions()
+        : max_message_size(16 * 1024 * 1024), batch_bytes(32 * 1024), receive_buffer(64 * 1024) {}
+};
+
+/**
+ * Message Stream - discrete messages over one QUIC stream
+ *
+ * Each message is sent as a QUIC varint length followed by the payload.
+ * send() queues messages and writes them to the stream in batches (once
+ * batch_bytes are pending, or on flush()), so many small messages cost one
+ * stream write. receive() reads the stream into a ring buffer and hands out
+ * each complete message as a span into that ring; only a message that wraps
+ * around the end of the ring is copied.
+ *
+ * Not thread-safe: use one MessageStream from one thread at a time (with
+ * an engine on an external loop, from the loop thread).
+ */
+class MessageStream {
+public:
+    // Messages on stream_id of engine
+    MessageStream(QuicheEngine& engine, uint64_t stream_id,
+                  const MessageStreamOptions& options = MessageStreamOptions());
+
+    // Messages over any byte stream
+    MessageStream(StreamWriteFn write, StreamReadFn read,
+                  const MessageStreamOptions& options = MessageStreamOptions());
+
+    // Disable copy
+    MessageStream(const MessageStream&) = delete;
+    MessageStream& operator=(const MessageStream&) = delete;
+
+    /**
+     * Queue one message (written with the batch, or right away if large)
+     *
+     * @return true if queued, false if the stream failed (see getLastError())
+     */
+    bool send(const uint8_t* data, size_t len);
+
+    /**
+     * Write all queued messages, optionally finishing the stream
+     */
+    bool flush(bool fin = false);
+
+    /**
+     * Read what the stream has and deliver complete messages
+     *
+     * @param handler Called for each message, in order
+     * @param max_messages Stop after this many messages
+     * @return Number of messages delivered (0 also when failed())
+     */
+    size_t receive(const MessageHandler& handler, size_t max_messages = SIZE_MAX);
+
+    size_t pendingBytes() const { return mBatch.size(); }  // Queued, not yet written
+    size_t bufferedBytes() const { return mTail - mHead; }  // Received, not yet delivered
+    bool finished() const { return mFin && mHead == mTail; }  // Peer's FIN reached, all delivered
+    bool failed() const { return !mLastError.empty(); }
+    std::string getLastError() const { return mLastError; }
+
+private:
+    StreamWriteFn mWrite;
+    StreamReadFn mRead;
+    MessageStreamOptions mOptions;
+
+    // Outgoing: length-prefixed messages not yet written
+    std::vector<uint8_t> mBatch;
+
+    // Incoming: ring of power-of-two size, mHead/mTail count bytes ever read
+    std::vector<uint8_t> mRing;
+    size_t mHead;
+    size_t mTail;
+    std::vector<uint8_t> mStaging;  // Messages that wrap around the ring
+    bool mFin;
+    bool mReceiving;
+    std::string mLastError;
+
+    bool writeAll(const uint8_t* data, size_t len, bool fin);
+    bool fill();
+    void grow(size_t needed);
+    void copyOut(size_t pos, uint8_t* out, size_t len) const;
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_MESSAGE_STREAM_H__
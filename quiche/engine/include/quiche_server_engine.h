@@ -0,0 +1,197 @@
+#ifndef __QUICHE_SERVER_ENGINE_H__
+#define __QUICHE_SERVER_ENGINE_H__
+
+#include <quiche_engine.h>
+
+#include <string>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace quiche {
+
+// Forward declarations
+class QuicheServerEngine;
+class QuicheServerEngineImpl;
+struct ServerConnectionImpl;
+
+/**
+ * Server-side connection handle
+ *
+ * Handles are created by the server engine when a client is accepted and
+ * passed to every event callback for that connection. The server holds a
+ * handle until the CONNECTION_CLOSED callback for it returns; to use it
+ * after that, or from another thread, keep shared_from_this() taken in a
+ * callback. A handle kept past the close stays safe to call: writes fail
+ * and reads return what was received.
+ */
+class ServerConnection : public std::enable_shared_from_this<ServerConnection> {
+public:
+    ~ServerConnection();
+
+    /**
+     * Write data to stream (thread-safe)
+     * Uses internal default stream ID
+     *
+     * @param data Data buffer (may be nullptr when len is 0)
+     * @param len Data length
+     * @param fin Whether this is the final data on stream
+     * @return Number of bytes queued, or -1 on error
+     */
+    ssize_t write(const uint8_t* data, size_t len, bool fin);
+
+    /**
+     * Read data from stream (thread-safe)
+     * Uses internal default stream ID
+     *
+     * @param buf Buffer to read into
+     * @param buf_len Buffer length
+     * @param fin Output: set to true if this is final data
+     * @return Number of bytes read, 0 if no data available, -1 on fatal error
+     */
+    ssize_t read(uint8_t* buf, size_t buf_len, bool& fin);
+
+    /**
+     * Write/read a specific stream (thread-safe), see QuicheEngine::writeStream()
+     */
+    ssize_t writeStream(uint64_t stream_id, const uint8_t* data, size_t len, bool fin);
+    ssize_t readStream(uint64_t stream_id, uint8_t* buf, size_t buf_len, bool& fin);
+
+    /**
+     * Set scheduling weight and rate limit of a stream (thread-safe),
+     * see QuicheEngine::setStreamSchedule()
+     */
+    bool setStreamSchedule(uint64_t stream_id, uint32_t weight,
+                           uint64_t max_rate = 0, uint64_t burst = 0);
+
+    /**
+     * Close this connection (thread-safe, asynchronous)
+     */
+    void close(uint64_t app_error = 0, const std::string& reason = "");
+
+    /**
+     * Check if the handshake with this client completed
+     */
+    bool isConnected() const;
+
+    /**
+     * Get connection statistics
+     */
+    EngineStats getStats() const;
+
+    /**
+     * Get peer address as "ip:port"
+     */
+    std::string getPeerAddress() const;
+
+    /**
+     * Get server-side connection ID as hex string
+     */
+    std::string getConnectionId() const;
+
+private:
+    friend class QuicheServerEngineImpl;
+
+    explicit ServerConnection(ServerConnectionImpl* impl) : mPImpl(impl) {}
+
+    // Disable copy
+    ServerConnection(const ServerConnection&) = delete;
+    ServerConnection& operator=(const ServerConnection&) = delete;
+
+    ServerConnectionImpl* mPImpl;
+};
+
+// Server event callback type
+using ServerEventCallback = std::function<void(
+    QuicheServerEngine* server,
+    ServerConnection* conn,
+    EngineEvent event,
+    const EventData& event_data,
+    void* user_data
+)>;
+
+/**
+ * QUIC Server Engine - accepts many connections on one UDP socket
+ * Thread-safe design with background event loop (same model as QuicheEngine)
+ */
+class QuicheServerEngine {
+public:
+    /**
+     * Create a new QUIC server engine
+     *
+     * @param host Local address to bind
+     * @param port Local port to bind
+     * @param config Configuration parameters (optional)
+     *
+     * Accepts the transport keys of QuicheEngine plus:
+     *   - TLS_CERT_FILE (string): PEM certificate chain (default: "./cert.crt")
+     *   - TLS_KEY_FILE (string): PEM private key (default: "./cert.key")
+     *   - ENABLE_RETRY (bool): Validate client addresses with a stateless
+     *     retry before accepting (default: true)
+     *   - MAX_CONNECTIONS (uint64_t): Silently drop Initials that would open
+     *     a connection beyond this many live ones (default: 0, no limit)
+     *   - LOOP_CPU_AFFINITY, LOOP_SCHED_POLICY, LOOP_SCHED_PRIORITY, LOOP_NICE:
+     *     scheduling of the server's event loop thread, as for QuicheEngine
+     *   - IO_ARENA_HUGE_PAGES, IO_ARENA_NUMA_NODE: backing of the server's
+     *     packet I/O buffers, as for QuicheEngine
+     */
+    QuicheServerEngine(const std::string& host, const std::string& port,
+                       const ConfigMap& config = ConfigMap());
+
+    /**
+     * Destructor - automatically stops and cleans up resources
+     */
+    ~QuicheServerEngine();
+
+    // Disable copy
+    QuicheServerEngine(const QuicheServerEngine&) = delete;
+    QuicheServerEngine& operator=(const QuicheServerEngine&) = delete;
+
+    /**
+     * Set event callback handler (called on the event loop thread)
+     *
+     * Events: CONNECTED (str_val = ALPN), STREAM_READABLE (uint_val = stream ID),
+     * PEER_MIGRATED (str_val = new peer "ip:port"), CONNECTION_CLOSED.
+     * conn is nullptr only for server-wide ERROR events.
+     */
+    bool setEventCallback(ServerEventCallback callback, void* user_data = nullptr);
+
+    /**
+     * Bind the socket and start the event loop (non-blocking)
+     */
+    bool start();
+
+    /**
+     * Close all connections and stop the event loop (blocking)
+     */
+    void shutdown(uint64_t app_error = 0, const std::string& reason = "");
+
+    /**
+     * Check if event loop is running
+     */
+    bool isRunning() const;
+
+    /**
+     * Number of live connections
+     */
+    size_t connectionCount() const;
+
+    /**
+     * Get the scheduling settings of the event loop thread (thread-safe),
+     * as applied from the LOOP_* config keys
+     */
+    LoopThreadInfo getLoopThreadInfo() const;
+
+    /**
+     * Get last error message
+     */
+    std::string getLastError() const;
+
+private:
+    QuicheServerEngineImpl* mPImpl;
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_SERVER_ENGINE_H__
@@ -0,0 +1,101 @@
+#ifndef __QUICHE_SESSION_CACHE_H__
+#define __QUICHE_SESSION_CACHE_H__
+
+#include <string>
+#include <map>
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace quiche {
+
+/**
+ * TLS session ticket cache (pluggable)
+ *
+ * The engine looks up a serialized session by "host:port" before connecting
+ * and stores the latest one when the connection closes. Implementations must
+ * be thread-safe: engines call load()/store() from their event loop threads.
+ */
+class SessionCache {
+public:
+    virtual ~SessionCache() {}
+
+    /**
+     * Look up a serialized session
+     *
+     * @param key Cache key ("host:port")
+     * @param session Output: serialized session blob
+     * @return true if a session was found
+     */
+    virtual bool load(const std::string& key, std::string& session) = 0;
+
+    /**
+     * Store (replace) a serialized session
+     *
+     * @param key Cache key ("host:port")
+     * @param session Serialized session blob from quiche_conn_session()
+     * @param len Blob length
+     */
+    virtual void store(const std::string& key, const uint8_t* session, size_t len) = 0;
+
+    /**
+     * Drop a cached session (e.g. after the server rejected it)
+     */
+    virtual void remove(const std::string& key) = 0;
+};
+
+/**
+ * In-memory session cache with optional on-disk persistence
+ *
+ * When file_path is non-empty, entries are loaded from the file on
+ * construction and the whole table is rewritten (0600 temp file + rename)
+ * so tickets survive process restarts. Rewrites are coalesced: a change is
+ * written immediately only if the previous rewrite is at least 5 seconds
+ * old; later changes are written by the next store()/remove() after that,
+ * by flush() or by the destructor.
+ */
+class MemorySessionCache : public SessionCache {
+public:
+    explicit MemorySessionCache(const std::string& file_path = "");
+    ~MemorySessionCache() override;
+
+    // Disable copy
+    MemorySessionCache(const MemorySessionCache&) = delete;
+    MemorySessionCache& operator=(const MemorySessionCache&) = delete;
+
+    bool load(const std::string& key, std::string& session) override;
+    void store(const std::string& key, const uint8_t* session, size_t len) override;
+    void remove(const std::string& key) override;
+
+    size_t size() const;
+
+    /**
+     * Write pending changes to the file now (no-op without a file path or
+     * when nothing changed since the last write)
+     */
+    void flush();
+
+    /**
+     * Process-wide cache shared by all engines using the same file
+     * (empty path = process-wide in-memory cache)
+     */
+    static std::shared_ptr<MemorySessionCache> shared(const std::string& file_path = "");
+
+private:
+    std::string mFilePath;
+    std::map<std::string, std::string> mEntries;
+    mutable std::mutex mMutex;  // C++ mutex (non-recursive)
+
+    bool mDirty;  // Entries changed since the last file write
+    std::chrono::steady_clock::time_point mLastSave;
+
+    void loadFromFile();
+    void markDirty();   // Caller must hold mMutex
+    void saveToFile();  // Caller must hold mMutex
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_SESSION_CACHE_H__
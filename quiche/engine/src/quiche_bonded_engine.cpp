@@ -0,0 +1,948 @@
+// quiche_bonded_engine.cpp
+// Bonded Engine - one logical stream striped over several QUIC connections,
+// reassembled in order by the receiver
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+
+#include "quiche_bonded_engine_impl.h"
+#include "quiche_engine_impl.h"
+
+#include <quiche_engine_config.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+namespace quiche {
+
+namespace {
+
+// Estimates for a connection that has no RTT sample yet
+const uint64_t DEFAULT_RTT_NS = 100 * 1000000ULL;
+const uint64_t MIN_CWND = 10 * MAX_DATAGRAM_SIZE;
+
+void putU64(uint8_t* out, uint64_t value) {
+    for (int i = 7; i >= 0; i--) {
+        out[i] = static_cast<uint8_t>(value);
+        value >>= 8;
+    }
+}
+
+uint64_t getU64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+void putU32(uint8_t* out, uint32_t value) {
+    for (int i = 3; i >= 0; i--) {
+        out[i] = static_cast<uint8_t>(value);
+        value >>= 8;
+    }
+}
+
+size_t varintLength(uint64_t value) {
+    if (value < 64) {
+        return 1;
+    }
+    if (value < 16384) {
+        return 2;
+    }
+    if (value < 1073741824) {
+        return 4;
+    }
+    return 8;
+}
+
+// Append the MessageStream length prefix of a message of len bytes and
+// return where its body starts
+uint8_t* appendMessage(std::vector<uint8_t>& out, size_t len) {
+    size_t header_len = varintLength(len);
+    size_t pos = out.size();
+    out.resize(pos + header_len + len);
+    quiche_put_varint(out.data() + pos, header_len, len);
+    return out.data() + pos + header_len;
+}
+
+uint64_t randomBondId() {
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) | rd();
+}
+
+} // namespace
+
+// ============================================================================
+// BondedEngineImpl Implementation
+// ============================================================================
+
+BondedEngineImpl::BondedEngineImpl(const std::string& host, const std::string& port,
+                                   const BondedEngineOptions& options)
+    : mHost(host), mPort(port), mOptions(options), mBondId(randomBondId()),
+      mWritten(0), mAcked(0), mFinWritten(false), mFinAcked(false), mFailed(false),
+      mStarted(false), mStopping(false), mPumping(false), mPumpAgain(false),
+      mChunksSent(0), mChunksResent(0)
+{
+    if (mOptions.connections == 0) {
+        mOptions.connections = 1;
+    }
+    if (mOptions.chunk_size == 0) {
+        mOptions.chunk_size = BondedEngineOptions().chunk_size;
+    } else if (mOptions.chunk_size > BOND_MAX_CHUNK) {
+        mOptions.chunk_size = BOND_MAX_CHUNK;
+    }
+
+    // ACKs are read from the event callback
+    mOptions.config.erase(ConfigKey::EVENT_QUEUE_SIZE);
+}
+
+BondedEngineImpl::~BondedEngineImpl() {
+    shutdown();
+}
+
+bool BondedEngineImpl::start() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mStarted) {
+            mLastError = "Already started";
+            return false;
+        }
+        mStarted = true;
+    }
+
+    std::vector<std::unique_ptr<BondConnection>> connections;
+    for (size_t i = 0; i < mOptions.connections; i++) {
+        std::unique_ptr<BondConnection> c(new BondConnection());
+
+        ConfigMap config = mOptions.config;
+        if (!mOptions.local_addresses.empty()) {
+            c->local_address = mOptions.local_addresses[i % mOptions.local_addresses.size()];
+            if (!c->local_address.empty()) {
+                config[ConfigKey::LOCAL_ADDRESS] = ConfigValue(c->local_address);
+            }
+        }
+
+        if (mOptions.runtime) {
+            c->engine = std::make_shared<QuicheEngine>(mOptions.runtime, mHost, mPort, config);
+        } else {
+            c->engine = std::make_shared<QuicheEngine>(mHost, mPort, config);
+        }
+        if (mOptions.engine_config) {
+            c->engine->setEngineConfig(mOptions.engine_config);
+        }
+
+        c->stream_id = c->engine->openStream();
+        c->acks.reset(new MessageStream(*c->engine, c->stream_id));
+        c->engine->setEventCallback(
+            [this, i](QuicheEngine* engine, EngineEvent event, const EventData& event_data, void*) {
+                onEngineEvent(i, engine, event, event_data);
+            });
+        connections.push_back(std::move(c));
+    }
+
+    // All listed before any callback can look them up
+    std::vector<QuicheEngine*> engines;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mConnections.swap(connections);
+        for (auto& c : mConnections) {
+            engines.push_back(c->engine.get());
+        }
+    }
+
+    size_t started = 0;
+    std::string error;
+    for (size_t i = 0; i < engines.size(); i++) {
+        if (engines[i]->start()) {
+            started++;
+            continue;
+        }
+
+        error = engines[i]->getLastError();
+        std::cerr << "[ENGINE] Bond failed to start connection " << i << " to " << mHost << ":"
+                  << mPort << ": " << error << std::endl;
+        std::lock_guard<std::mutex> lock(mMutex);
+        mConnections[i]->state = BondConnection::CLOSED;
+    }
+
+    if (started == 0) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFailed = true;
+        mLastError = "No connection could be started: " + error;
+        return false;
+    }
+    return true;
+}
+
+ssize_t BondedEngineImpl::write(const uint8_t* data, size_t len, bool fin) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!data && len > 0) {
+            mLastError = "Invalid data";
+            return -1;
+        }
+        if (!mStarted || mStopping) {
+            mLastError = "Engine not running";
+            return -1;
+        }
+        if (mFailed) {
+            return -1;
+        }
+        if (mFinWritten) {
+            mLastError = "Stream already finished";
+            return -1;
+        }
+        if (len == 0 && !fin) {
+            return 0;
+        }
+    }
+
+    // Append what fits under max_buffered_bytes, then wait for the receiver
+    // to acknowledge enough for the rest
+    size_t max = mOptions.max_buffered_bytes;
+    size_t pos = 0;
+    do {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            size_t n = len - pos;
+            if (max > 0 && n > 0) {
+                mCond.wait(lock, [this, max] {
+                    return mFailed || mStopping || mWritten - mAcked < max;
+                });
+                if (mFailed || mStopping) {
+                    if (mStopping) {
+                        mLastError = "Engine not running";
+                    }
+                    return pos > 0 ? static_cast<ssize_t>(pos) : -1;
+                }
+                size_t room = max - static_cast<size_t>(mWritten - mAcked);
+                if (n > room) {
+                    n = room;
+                }
+            }
+            appendLocked(data + pos, n, fin && pos + n == len);
+            pos += n;
+        }
+
+        pump();
+    } while (pos < len);
+
+    return static_cast<ssize_t>(len);
+}
+
+void BondedEngineImpl::appendLocked(const uint8_t* data, size_t len, bool fin) {
+    // Small writes fill up the last chunk while it waits
+    size_t pos = 0;
+    while (pos < len) {
+        if (mChunks.empty() || mChunks.back().sent ||
+            mChunks.back().data.size() >= mOptions.chunk_size) {
+            mChunks.emplace_back();
+            mChunks.back().offset = mWritten;
+        }
+
+        BondChunk& chunk = mChunks.back();
+        size_t n = mOptions.chunk_size - chunk.data.size();
+        if (n > len - pos) {
+            n = len - pos;
+        }
+        chunk.data.insert(chunk.data.end(), data + pos, data + pos + n);
+        pos += n;
+        mWritten += n;
+    }
+
+    if (fin) {
+        if (mChunks.empty() || mChunks.back().sent) {
+            mChunks.emplace_back();
+            mChunks.back().offset = mWritten;
+        }
+        mChunks.back().fin = true;
+        mFinWritten = true;
+    }
+}
+
+bool BondedEngineImpl::waitDelivered(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCond.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] {
+        return mFailed || mStopping || mChunks.empty();
+    });
+    return mChunks.empty();
+}
+
+void BondedEngineImpl::shutdown() {
+    std::vector<std::shared_ptr<QuicheEngine>> engines;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mStopping) {
+            return;
+        }
+        mStopping = true;
+        for (auto& c : mConnections) {
+            engines.push_back(c->engine);
+        }
+    }
+    mCond.notify_all();
+
+    // Destroyed with mConnections: a callback still running may use them
+    for (auto& engine : engines) {
+        engine->shutdown();
+    }
+}
+
+bool BondedEngineImpl::isConnected() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& c : mConnections) {
+        if (c->state == BondConnection::READY) {
+            return true;
+        }
+    }
+    return false;
+}
+
+BondedEngineStats BondedEngineImpl::getStats() const {
+    BondedEngineStats stats;
+    std::vector<QuicheEngine*> engines;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        stats.bytes_written = mWritten;
+        stats.bytes_acked = mAcked;
+        stats.buffered_bytes = static_cast<size_t>(mWritten - mAcked);
+        stats.chunks_sent = mChunksSent;
+        stats.chunks_resent = mChunksResent;
+
+        for (auto& c : mConnections) {
+            BondedConnectionStats cs = {};
+            cs.local_address = c->local_address;
+            cs.established = c->state == BondConnection::READY;
+            cs.closed = c->state == BondConnection::CLOSED;
+            cs.bytes_sent = c->bytes_sent;
+            cs.outstanding_bytes = c->outstanding;
+            stats.connections.push_back(cs);
+            engines.push_back(c->engine.get());
+        }
+    }
+
+    // Outside the lock: the engine's own locks are taken around its callbacks
+    for (size_t i = 0; i < engines.size(); i++) {
+        EngineStats es = engines[i]->getStats();
+        stats.connections[i].rtt_ns = es.rtt_ns;
+        stats.connections[i].cwnd = es.cwnd;
+    }
+    return stats;
+}
+
+std::string BondedEngineImpl::getLastError() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mLastError;
+}
+
+void BondedEngineImpl::onEngineEvent(size_t index, QuicheEngine* engine, EngineEvent event,
+                                     const EventData& event_data) {
+    BondConnection& c = *mConnections[index];
+
+    switch (event) {
+        case EngineEvent::CONNECTED:
+            onConnected(index, engine);
+            break;
+
+        case EngineEvent::CONNECTION_CLOSED:
+            onClosed(index);
+            break;
+
+        case EngineEvent::STREAM_READABLE: {
+            if (event_data.type != EventDataType::UINT64 || event_data.uint_val != c.stream_id) {
+                break;
+            }
+
+            // Cumulative: only the last ACK of the batch matters
+            bool acked = false;
+            uint64_t offset = 0;
+            bool fin = false;
+            c.acks->receive([&](const uint8_t* data, size_t len) {
+                if (len >= BOND_ACK_SIZE && data[0] == BOND_ACK) {
+                    acked = true;
+                    fin = (data[1] & BOND_FLAG_FIN) != 0;
+                    offset = getU64(data + 2);
+                }
+            });
+            if (acked) {
+                onAck(offset, fin);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void BondedEngineImpl::onConnected(size_t index, QuicheEngine* engine) {
+    BondConnection& c = *mConnections[index];
+
+    std::vector<uint8_t> frame;
+    uint8_t* body = appendMessage(frame, BOND_HELLO_SIZE);
+    body[0] = BOND_HELLO;
+    putU64(body + 1, mBondId);
+    putU32(body + 9, static_cast<uint32_t>(index));
+
+    if (engine->writeStream(c.stream_id, frame.data(), frame.size(), false) < 0) {
+        std::cerr << "[ENGINE] Bond failed to open stream on connection " << index << ": "
+                  << engine->getLastError() << std::endl;
+        return;  // CONNECTION_CLOSED follows
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (c.state == BondConnection::CONNECTING) {
+            c.state = BondConnection::READY;
+        }
+    }
+    pump();
+}
+
+void BondedEngineImpl::onClosed(size_t index) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        BondConnection& c = *mConnections[index];
+        c.state = BondConnection::CLOSED;
+        c.outstanding = 0;
+
+        // Its unacknowledged chunks go out again on the other connections
+        for (BondChunk& chunk : mChunks) {
+            if (chunk.conn == static_cast<int>(index)) {
+                chunk.conn = -1;
+            }
+        }
+
+        bool any_open = false;
+        for (auto& other : mConnections) {
+            if (other->state != BondConnection::CLOSED) {
+                any_open = true;
+                break;
+            }
+        }
+        if (!any_open && !mStopping) {
+            mFailed = true;
+            mLastError = "All bonded connections closed";
+        }
+    }
+    mCond.notify_all();
+    pump();
+}
+
+void BondedEngineImpl::onAck(uint64_t offset, bool fin) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (offset > mWritten || (offset < mAcked) || (offset == mAcked && (!fin || mFinAcked))) {
+            return;  // Stale (from a slower connection) or bogus
+        }
+        mAcked = offset;
+        if (fin && mFinWritten && offset == mWritten) {
+            mFinAcked = true;
+        }
+
+        while (!mChunks.empty()) {
+            BondChunk& chunk = mChunks.front();
+            uint64_t end = chunk.offset + chunk.data.size();
+            if (end > mAcked || (end == mAcked && chunk.fin && !mFinAcked)) {
+                break;
+            }
+            if (chunk.conn >= 0) {
+                mConnections[chunk.conn]->outstanding -= chunk.data.size();
+            }
+            mChunks.pop_front();
+        }
+    }
+    mCond.notify_all();
+    pump();
+}
+
+void BondedEngineImpl::pump() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mPumping) {
+            mPumpAgain = true;
+            return;
+        }
+        mPumping = true;
+    }
+
+    for (;;) {
+        pumpOnce();
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mPumpAgain) {
+            mPumping = false;
+            return;
+        }
+        mPumpAgain = false;
+    }
+}
+
+void BondedEngineImpl::pumpOnce() {
+    struct Candidate {
+        size_t index;
+        QuicheEngine* engine;
+        uint64_t stream_id;
+        uint64_t rtt_ns;
+        uint64_t cwnd;
+        std::vector<uint8_t> batch;  // Framed chunks for one writeStream()
+    };
+
+    std::vector<Candidate> ready;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mStopping) {
+            return;
+        }
+        for (size_t i = 0; i < mConnections.size(); i++) {
+            if (mConnections[i]->state == BondConnection::READY) {
+                Candidate candidate = Candidate();
+                candidate.index = i;
+                candidate.engine = mConnections[i]->engine.get();
+                candidate.stream_id = mConnections[i]->stream_id;
+                ready.push_back(std::move(candidate));
+            }
+        }
+    }
+    if (ready.empty()) {
+        return;
+    }
+
+    for (Candidate& candidate : ready) {
+        EngineStats es = candidate.engine->getStats();
+        candidate.rtt_ns = es.rtt_ns > 0 ? es.rtt_ns : DEFAULT_RTT_NS;
+        candidate.cwnd = es.cwnd > MIN_CWND ? es.cwnd : MIN_CWND;
+    }
+
+    std::vector<std::pair<size_t, std::vector<uint8_t>>> writes;  // Candidate, frames
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mStopping) {
+            return;
+        }
+
+        for (BondChunk& chunk : mChunks) {
+            if (chunk.conn >= 0) {
+                continue;
+            }
+            size_t len = chunk.data.size();
+
+            // Earliest expected delivery: half an RTT plus draining what the
+            // connection already has in flight, at one cwnd per RTT
+            int best = -1;
+            double best_cost = 0;
+            for (size_t k = 0; k < ready.size(); k++) {
+                const Candidate& candidate = ready[k];
+                const BondConnection& c = *mConnections[candidate.index];
+                if (c.state != BondConnection::READY) {
+                    continue;
+                }
+
+                uint64_t window = 2 * candidate.cwnd;
+                if (window < BOND_MIN_WINDOW) {
+                    window = BOND_MIN_WINDOW;
+                }
+                if (c.outstanding > 0 && c.outstanding + len > window) {
+                    continue;
+                }
+
+                double cost = candidate.rtt_ns *
+                              (0.5 + static_cast<double>(c.outstanding + len) / candidate.cwnd);
+                if (best < 0 || cost < best_cost) {
+                    best = static_cast<int>(k);
+                    best_cost = cost;
+                }
+            }
+            if (best < 0) {
+                break;  // All full: later chunks wait too
+            }
+
+            Candidate& target = ready[best];
+            BondConnection& c = *mConnections[target.index];
+            if (chunk.sent) {
+                mChunksResent++;
+            }
+            chunk.sent = true;
+            chunk.conn = static_cast<int>(target.index);
+            c.outstanding += len;
+            c.bytes_sent += len;
+            mChunksSent++;
+
+            size_t frame_len = varintLength(BOND_DATA_HEADER + len) + BOND_DATA_HEADER + len;
+            if (!target.batch.empty() && target.batch.size() + frame_len > MAX_WRITE_DATA_SIZE) {
+                writes.emplace_back(static_cast<size_t>(best), std::move(target.batch));
+                target.batch.clear();
+            }
+            uint8_t* body = appendMessage(target.batch, BOND_DATA_HEADER + len);
+            body[0] = BOND_DATA;
+            body[1] = chunk.fin ? BOND_FLAG_FIN : 0;
+            putU64(body + 2, chunk.offset);
+            if (len > 0) {
+                memcpy(body + BOND_DATA_HEADER, chunk.data.data(), len);
+            }
+        }
+
+        for (size_t k = 0; k < ready.size(); k++) {
+            if (!ready[k].batch.empty()) {
+                writes.emplace_back(k, std::move(ready[k].batch));
+            }
+        }
+    }
+
+    // A failed write is followed by CONNECTION_CLOSED, which resends
+    for (auto& write : writes) {
+        const Candidate& candidate = ready[write.first];
+        if (candidate.engine->writeStream(candidate.stream_id, write.second.data(),
+                                          write.second.size(), false) < 0) {
+            std::cerr << "[ENGINE] Bond write failed on connection " << candidate.index << ": "
+                      << candidate.engine->getLastError() << std::endl;
+        }
+    }
+}
+
+// ============================================================================
+// BondReassembler Implementation
+// ============================================================================
+
+BondReassembler::BondReassembler()
+    : mDelivered(0), mHaveFin(false), mFinOffset(0), mFinDelivered(false), mHeldBytes(0)
+{
+}
+
+BondReassembler::Result BondReassembler::add(uint64_t offset, const uint8_t* data, size_t len,
+                                             bool fin, const Deliver& deliver) {
+    uint64_t end = offset + len;
+    if (fin) {
+        if (mHaveFin && end != mFinOffset) {
+            return INVALID;
+        }
+        mHaveFin = true;
+        mFinOffset = end;
+    }
+    if (mHaveFin && end > mFinOffset) {
+        return INVALID;
+    }
+
+    if (offset > mDelivered) {
+        if (mHeld.count(offset)) {
+            return DUPLICATE;
+        }
+        Held& held = mHeld[offset];
+        held.data.assign(data, data + len);
+        held.fin = fin;
+        mHeldBytes += len;
+        return HELD;
+    }
+
+    // Nothing new: neither bytes nor a FIN still owed
+    if (end < mDelivered || (end == mDelivered && !(mHaveFin && !mFinDelivered && end == mFinOffset))) {
+        return DUPLICATE;
+    }
+
+    deliverFrom(offset, data, len, deliver);
+    drain(deliver);
+    return DELIVERED;
+}
+
+void BondReassembler::deliverFrom(uint64_t offset, const uint8_t* data, size_t len,
+                                  const Deliver& deliver) {
+    size_t skip = static_cast<size_t>(mDelivered - offset);
+    uint64_t end = offset + len;
+    if (end > mDelivered) {
+        mDelivered = end;
+    }
+
+    bool fin = mHaveFin && !mFinDelivered && mDelivered == mFinOffset;
+    if (fin) {
+        mFinDelivered = true;
+    }
+    deliver(data + skip, len - skip, fin);
+}
+
+void BondReassembler::drain(const Deliver& deliver) {
+    while (!mHeld.empty()) {
+        auto it = mHeld.begin();
+        if (it->first > mDelivered) {
+            break;
+        }
+
+        const std::vector<uint8_t>& data = it->second.data;
+        uint64_t end = it->first + data.size();
+        if (end > mDelivered || (mHaveFin && !mFinDelivered && end == mFinOffset)) {
+            deliverFrom(it->first, data.data(), data.size(), deliver);
+        }
+        mHeldBytes -= data.size();
+        mHeld.erase(it);
+    }
+}
+
+// ============================================================================
+// BondedReceiverImpl Implementation
+// ============================================================================
+
+BondedReceiverImpl::BondedReceiverImpl(BondDataHandler handler, const BondedReceiverOptions& options)
+    : mHandler(std::move(handler)), mOptions(options),
+      mBondsActive(0), mBondsCompleted(0), mBondsFailed(0), mBytesDelivered(0),
+      mChunksReceived(0), mChunksReordered(0), mChunksDuplicate(0)
+{
+}
+
+void BondedReceiverImpl::onEvent(ServerConnection* conn, EngineEvent event,
+                                 const EventData& event_data) {
+    if (!conn) {
+        return;
+    }
+
+    if (event == EngineEvent::STREAM_READABLE && event_data.type == EventDataType::UINT64) {
+        readStream(conn, event_data.uint_val);
+    } else if (event == EngineEvent::CONNECTION_CLOSED) {
+        closeConnection(conn);
+    }
+}
+
+BondedReceiverStats BondedReceiverImpl::getStats() const {
+    BondedReceiverStats stats;
+    stats.bonds_active = mBondsActive.load();
+    stats.bonds_completed = mBondsCompleted.load();
+    stats.bonds_failed = mBondsFailed.load();
+    stats.bytes_delivered = mBytesDelivered.load();
+    stats.chunks_received = mChunksReceived.load();
+    stats.chunks_reordered = mChunksReordered.load();
+    stats.chunks_duplicate = mChunksDuplicate.load();
+    return stats;
+}
+
+void BondedReceiverImpl::readStream(ServerConnection* conn, uint64_t stream_id) {
+    BondStreamKey key(conn, stream_id);
+    auto it = mStreams.find(key);
+    if (it == mStreams.end()) {
+        it = mStreams.emplace(key, BondStream()).first;
+        it->second.messages.reset(new MessageStream(
+            [conn, stream_id](const uint8_t* data, size_t len, bool fin) {
+                return conn->writeStream(stream_id, data, len, fin);
+            },
+            [conn, stream_id](uint8_t* buf, size_t buf_len, bool& fin) {
+                return conn->readStream(stream_id, buf, buf_len, fin);
+            }));
+    }
+    BondStream& stream = it->second;
+
+    if (stream.failed) {
+        // Drop whatever still arrives until the connection is gone
+        uint8_t discard[4096];
+        bool fin = false;
+        while (conn->readStream(stream_id, discard, sizeof(discard), fin) > 0) {
+        }
+        return;
+    }
+
+    stream.messages->receive([&](const uint8_t* data, size_t len) {
+        if (!stream.failed) {
+            onMessage(key, stream, data, len);
+        }
+    });
+    if (stream.messages->failed() && !stream.failed) {
+        std::cerr << "[ENGINE] Bond stream " << stream_id << " of " << conn->getPeerAddress()
+                  << " failed: " << stream.messages->getLastError() << std::endl;
+        stream.failed = true;
+    }
+
+    if (stream.hello) {
+        auto bond = mBonds.find(stream.bond_id);
+        if (bond != mBonds.end() && !bond->second.failed) {
+            acknowledge(key, bond->second);
+        }
+    }
+}
+
+void BondedReceiverImpl::onMessage(const BondStreamKey& key, BondStream& stream,
+                                   const uint8_t* data, size_t len) {
+    if (!stream.hello) {
+        if (len < BOND_HELLO_SIZE || data[0] != BOND_HELLO) {
+            std::cerr << "[ENGINE] Bond stream " << key.second << " of "
+                      << key.first->getPeerAddress() << " did not start with HELLO" << std::endl;
+            stream.failed = true;
+            return;
+        }
+
+        stream.hello = true;
+        stream.bond_id = getU64(data + 1);
+        auto bond = mBonds.find(stream.bond_id);
+        if (bond == mBonds.end()) {
+            bond = mBonds.emplace(stream.bond_id, Bond()).first;
+            mBondsActive++;
+        }
+        bond->second.streams.insert(key);
+        return;
+    }
+
+    if (len < BOND_DATA_HEADER || data[0] != BOND_DATA) {
+        return;  // Unknown message
+    }
+
+    auto it = mBonds.find(stream.bond_id);
+    if (it == mBonds.end() || it->second.failed) {
+        return;
+    }
+    uint64_t bond_id = it->first;
+    Bond& bond = it->second;
+
+    mChunksReceived++;
+    BondReassembler::Result result = bond.reassembler.add(
+        getU64(data + 2), data + BOND_DATA_HEADER, len - BOND_DATA_HEADER,
+        (data[1] & BOND_FLAG_FIN) != 0,
+        [&](const uint8_t* bytes, size_t count, bool fin) {
+            mBytesDelivered += count;
+            if (fin) {
+                mBondsCompleted++;
+            }
+            if (mHandler) {
+                mHandler(bond_id, bytes, count, fin);
+            }
+        });
+
+    switch (result) {
+        case BondReassembler::HELD:
+            mChunksReordered++;
+            if (bond.reassembler.heldBytes() > mOptions.max_held_bytes) {
+                failBond(bond_id, bond, "too much out-of-order data");
+            }
+            break;
+        case BondReassembler::DUPLICATE:
+            mChunksDuplicate++;
+            break;
+        case BondReassembler::INVALID:
+            failBond(bond_id, bond, "chunk past the end of the stream");
+            break;
+        default:
+            break;
+    }
+}
+
+void BondedReceiverImpl::acknowledge(const BondStreamKey& key, Bond& bond) {
+    const BondReassembler& reassembler = bond.reassembler;
+
+    // The end goes to every connection: the sender may be waiting on any
+    if (reassembler.finished()) {
+        if (!bond.fin_acked) {
+            bond.fin_acked = true;
+            bond.acked = reassembler.delivered();
+            for (const BondStreamKey& other : bond.streams) {
+                sendAck(other, bond.acked, true);
+            }
+        }
+        return;
+    }
+
+    // Every ACK_BYTES, and whenever nothing is held (caught up, possibly
+    // the sender's last write for now)
+    uint64_t delivered = reassembler.delivered();
+    if (delivered > bond.acked &&
+        (delivered - bond.acked >= BOND_ACK_BYTES || reassembler.heldBytes() == 0)) {
+        bond.acked = delivered;
+        sendAck(key, delivered, false);
+    }
+}
+
+void BondedReceiverImpl::sendAck(const BondStreamKey& key, uint64_t offset, bool fin) {
+    std::vector<uint8_t> frame;
+    uint8_t* body = appendMessage(frame, BOND_ACK_SIZE);
+    body[0] = BOND_ACK;
+    body[1] = fin ? BOND_FLAG_FIN : 0;
+    putU64(body + 2, offset);
+    key.first->writeStream(key.second, frame.data(), frame.size(), false);
+}
+
+void BondedReceiverImpl::failBond(uint64_t bond_id, Bond& bond, const std::string& reason) {
+    std::cerr << "[ENGINE] Bond " << std::hex << bond_id << std::dec << " failed: " << reason
+              << std::endl;
+    bond.failed = true;
+    bond.reassembler = BondReassembler();  // Release held chunks
+    mBondsFailed++;
+
+    // Streams and the bond go when the connections report closed
+    for (const BondStreamKey& key : bond.streams) {
+        key.first->close(BOND_CLOSE_ERROR, reason);
+    }
+}
+
+void BondedReceiverImpl::closeConnection(ServerConnection* conn) {
+    auto it = mStreams.lower_bound(BondStreamKey(conn, 0));
+    while (it != mStreams.end() && it->first.first == conn) {
+        if (it->second.hello) {
+            auto bond = mBonds.find(it->second.bond_id);
+            if (bond != mBonds.end()) {
+                bond->second.streams.erase(it->first);
+                if (bond->second.streams.empty()) {
+                    mBonds.erase(bond);
+                    mBondsActive--;
+                }
+            }
+        }
+        it = mStreams.erase(it);
+    }
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+BondedEngine::BondedEngine(const std::string& host, const std::string& port,
+                           const BondedEngineOptions& options)
+    : mPImpl(new BondedEngineImpl(host, port, options))
+{
+}
+
+BondedEngine::~BondedEngine() {
+    delete mPImpl;
+}
+
+bool BondedEngine::start() {
+    return mPImpl->start();
+}
+
+ssize_t BondedEngine::write(const uint8_t* data, size_t len, bool fin) {
+    return mPImpl->write(data, len, fin);
+}
+
+bool BondedEngine::waitDelivered(int timeout_ms) {
+    return mPImpl->waitDelivered(timeout_ms);
+}
+
+void BondedEngine::shutdown() {
+    mPImpl->shutdown();
+}
+
+bool BondedEngine::isConnected() const {
+    return mPImpl->isConnected();
+}
+
+BondedEngineStats BondedEngine::getStats() const {
+    return mPImpl->getStats();
+}
+
+std::string BondedEngine::getLastError() const {
+    return mPImpl->getLastError();
+}
+
+BondedReceiver::BondedReceiver(BondDataHandler handler, const BondedReceiverOptions& options)
+    : mPImpl(new BondedReceiverImpl(std::move(handler), options))
+{
+}
+
+BondedReceiver::~BondedReceiver() {
+    delete mPImpl;
+}
+
+void BondedReceiver::onEvent(ServerConnection* conn, EngineEvent event, const EventData& event_data) {
+    mPImpl->onEvent(conn, event, event_data);
+}
+
+BondedReceiverStats BondedReceiver::getStats() const {
+    return mPImpl->getStats();
+}
+
+} // namespace quiche
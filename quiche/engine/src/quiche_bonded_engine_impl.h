@@ -0,0 +1,241 @@
+#ifndef __QUICHE_BONDED_ENGINE_IMPL_H__
+#define __QUICHE_BONDED_ENGINE_IMPL_H__
+
+#include <quiche_bonded_engine.h>
+#include <quiche_message_stream.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace quiche {
+
+// Messages on a bond stream (MessageStream framing, big-endian fields):
+//   HELLO  type, bond ID (8), connection index (4)      sender -> receiver, first
+//   DATA   type, flags (1), offset (8), payload         sender -> receiver
+//   ACK    type, flags (1), offset (8)                  receiver -> sender
+enum BondMessageType : uint8_t {
+    BOND_HELLO = 1,
+    BOND_DATA = 2,
+    BOND_ACK = 3,
+};
+
+const uint8_t BOND_FLAG_FIN = 0x01;  // DATA: last chunk; ACK: FIN delivered too
+
+// Header bytes before a DATA payload, and size of an ACK
+constexpr size_t BOND_DATA_HEADER = 1 + 1 + 8;
+constexpr size_t BOND_ACK_SIZE = 1 + 1 + 8;
+constexpr size_t BOND_HELLO_SIZE = 1 + 8 + 4;
+
+// Application error of connections closed by the receiver
+constexpr uint64_t BOND_CLOSE_ERROR = 1;
+
+// Largest chunk payload: a framed chunk fits one writeStream() call
+constexpr size_t BOND_MAX_CHUNK = 65000;
+
+// Receiver acknowledges once it delivered this much since its last ACK
+constexpr uint64_t BOND_ACK_BYTES = 32 * 1024;
+
+// Unacknowledged bytes a connection may always take, whatever its cwnd
+constexpr size_t BOND_MIN_WINDOW = 256 * 1024;
+
+// ============================================================================
+// Sender
+// ============================================================================
+
+// A piece of the logical stream; boundaries are fixed once first sent
+struct BondChunk {
+    uint64_t offset;
+    std::vector<uint8_t> data;
+    bool fin;
+    int conn;   // Connection it was last sent on, -1 = waiting
+    bool sent;  // Sent at least once (no more appending)
+
+    BondChunk() : offset(0), fin(false), conn(-1), sent(false) {}
+};
+
+// One striped connection (fields under BondedEngineImpl::mMutex unless noted)
+struct BondConnection {
+    enum State {
+        CONNECTING,
+        READY,    // HELLO written, takes chunks
+        CLOSED,
+    };
+
+    std::shared_ptr<QuicheEngine> engine;  // Set before start, kept until destruction
+    std::string local_address;
+    uint64_t stream_id;
+    int state;
+    size_t outstanding;  // Chunk bytes sent on it, not yet acknowledged
+    uint64_t bytes_sent;
+    std::unique_ptr<MessageStream> acks;  // ACKs from the receiver (loop thread only)
+
+    BondConnection() : stream_id(0), state(CONNECTING), outstanding(0), bytes_sent(0) {}
+};
+
+// Bonded engine implementation class (PIMPL)
+class BondedEngineImpl {
+public:
+    BondedEngineImpl(const std::string& host, const std::string& port,
+                     const BondedEngineOptions& options);
+    ~BondedEngineImpl();
+
+    // Disable copy
+    BondedEngineImpl(const BondedEngineImpl&) = delete;
+    BondedEngineImpl& operator=(const BondedEngineImpl&) = delete;
+
+    bool start();
+    ssize_t write(const uint8_t* data, size_t len, bool fin);
+    bool waitDelivered(int timeout_ms);
+    void shutdown();
+    bool isConnected() const;
+    BondedEngineStats getStats() const;
+    std::string getLastError() const;
+
+private:
+    // Engines are started and shut down only outside the lock, and chunks
+    // are written outside it: the engines' callbacks take it
+
+    // Engine callbacks (loop threads)
+    void onEngineEvent(size_t index, QuicheEngine* engine, EngineEvent event,
+                       const EventData& event_data);
+    void onConnected(size_t index, QuicheEngine* engine);
+    void onClosed(size_t index);
+    void onAck(uint64_t offset, bool fin);
+
+    // Hand waiting chunks to connections with room; one pass at a time,
+    // a call during a pass makes that pass run again
+    void pump();
+    void pumpOnce();
+
+    // Append to the stream (lock held)
+    void appendLocked(const uint8_t* data, size_t len, bool fin);
+
+    std::string mHost;
+    std::string mPort;
+    BondedEngineOptions mOptions;
+    uint64_t mBondId;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCond;  // Acknowledgments and failures
+    std::vector<std::unique_ptr<BondConnection>> mConnections;  // Fixed once started
+    std::deque<BondChunk> mChunks;  // Unacknowledged, by offset
+    uint64_t mWritten;   // Stream offset of the next write()
+    uint64_t mAcked;     // Receiver has everything before this
+    bool mFinWritten;
+    bool mFinAcked;
+    bool mFailed;        // Every connection closed
+    bool mStarted;
+    bool mStopping;
+    bool mPumping;
+    bool mPumpAgain;
+    size_t mChunksSent;
+    size_t mChunksResent;
+    std::string mLastError;
+};
+
+// ============================================================================
+// Receiver
+// ============================================================================
+
+// In-order delivery of chunks arriving in any order
+class BondReassembler {
+public:
+    using Deliver = std::function<void(const uint8_t* data, size_t len, bool fin)>;
+
+    enum Result {
+        DELIVERED,  // Was next, delivered (with whatever it unblocked)
+        HELD,       // Ahead of a gap, copied until the gap fills
+        DUPLICATE,  // Already delivered or held
+        INVALID,    // Past the end of the stream, or a second, different end
+    };
+
+    BondReassembler();
+
+    Result add(uint64_t offset, const uint8_t* data, size_t len, bool fin, const Deliver& deliver);
+
+    uint64_t delivered() const { return mDelivered; }
+    size_t heldBytes() const { return mHeldBytes; }
+    bool finished() const { return mFinDelivered; }
+
+private:
+    struct Held {
+        std::vector<uint8_t> data;
+        bool fin;
+    };
+
+    // Deliver the part of a chunk past mDelivered (offset <= mDelivered)
+    void deliverFrom(uint64_t offset, const uint8_t* data, size_t len, const Deliver& deliver);
+    void drain(const Deliver& deliver);
+
+    uint64_t mDelivered;  // Bytes handed out
+    bool mHaveFin;
+    uint64_t mFinOffset;  // Length of the stream, once known
+    bool mFinDelivered;
+    std::map<uint64_t, Held> mHeld;  // By offset
+    size_t mHeldBytes;
+};
+
+// Key of a bond stream: connection and stream ID
+using BondStreamKey = std::pair<ServerConnection*, uint64_t>;
+
+struct BondStream {
+    std::unique_ptr<MessageStream> messages;
+    uint64_t bond_id;
+    bool hello;  // HELLO seen, bond_id valid
+    bool failed;
+
+    BondStream() : bond_id(0), hello(false), failed(false) {}
+};
+
+struct Bond {
+    BondReassembler reassembler;
+    std::set<BondStreamKey> streams;
+    uint64_t acked;  // Offset of the last ACK sent
+    bool fin_acked;
+    bool failed;
+
+    Bond() : acked(0), fin_acked(false), failed(false) {}
+};
+
+// Bonded receiver implementation class (PIMPL), loop thread only
+class BondedReceiverImpl {
+public:
+    BondedReceiverImpl(BondDataHandler handler, const BondedReceiverOptions& options);
+
+    void onEvent(ServerConnection* conn, EngineEvent event, const EventData& event_data);
+    BondedReceiverStats getStats() const;
+
+private:
+    void readStream(ServerConnection* conn, uint64_t stream_id);
+    void onMessage(const BondStreamKey& key, BondStream& stream, const uint8_t* data, size_t len);
+    void acknowledge(const BondStreamKey& key, Bond& bond);
+    void sendAck(const BondStreamKey& key, uint64_t offset, bool fin);
+    void failBond(uint64_t bond_id, Bond& bond, const std::string& reason);
+    void closeConnection(ServerConnection* conn);
+
+    BondDataHandler mHandler;
+    BondedReceiverOptions mOptions;
+
+    std::map<BondStreamKey, BondStream> mStreams;
+    std::map<uint64_t, Bond> mBonds;
+
+    std::atomic<size_t> mBondsActive;
+    std::atomic<size_t> mBondsCompleted;
+    std::atomic<size_t> mBondsFailed;
+    std::atomic<uint64_t> mBytesDelivered;
+    std::atomic<size_t> mChunksReceived;
+    std::atomic<size_t> mChunksReordered;
+    std::atomic<size_t> mChunksDuplicate;
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_BONDED_ENGINE_IMPL_H__
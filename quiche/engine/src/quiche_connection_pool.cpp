@@ -0,0 +1,458 @@
+// quiche_connection_pool.cpp
+// Connection Pool - established connections per host:port, replaced ahead of
+// the idle timeout
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+
+#include "quiche_connection_pool_impl.h"
+#include "quiche_timer_wheel.h"
+
+#include <quiche_engine_config.h>
+
+#include <chrono>
+
+namespace quiche {
+
+namespace {
+
+// Maintenance tick: activity sampling and replacement granularity
+const uint64_t MAINTENANCE_INTERVAL_MS = 100;
+
+// Backoff after failed starts and handshakes: 100ms doubling up to 5s
+const uint64_t RETRY_BASE_MS = 100;
+const uint64_t RETRY_MAX_MS = 5000;
+
+const uint64_t NS_PER_MS = 1000000;
+
+uint64_t configIdleTimeout(const ConfigMap& config) {
+    auto it = config.find(ConfigKey::MAX_IDLE_TIMEOUT);
+    if (it != config.end() && it->second.type == ConfigValueType::UINT64) {
+        return it->second.uint_val;
+    }
+    return 0;
+}
+
+} // namespace
+
+// ============================================================================
+// ConnectionPoolImpl Implementation
+// ============================================================================
+
+ConnectionPoolImpl::ConnectionPoolImpl(const ConnectionPoolOptions& options)
+    : mOptions(options), mIdleTimeoutMs(0),
+      mSignal(std::make_shared<PoolSignal>()), mStopping(false),
+      mHits(0), mMisses(0), mHandshakesAvoided(0), mHandshakesStarted(0),
+      mReplacedIdle(0), mReplacedClosed(0), mStartFailures(0)
+{
+    if (mOptions.connections_per_origin == 0) {
+        mOptions.connections_per_origin = 1;
+    }
+
+    // Pool callbacks run on the loop thread; a queue would never be drained
+    mOptions.config.erase(ConfigKey::EVENT_QUEUE_SIZE);
+
+    // Same precedence as the engine: own MAX_IDLE_TIMEOUT, then the shared config's
+    mIdleTimeoutMs = configIdleTimeout(mOptions.config);
+    if (mIdleTimeoutMs == 0 && mOptions.engine_config) {
+        mIdleTimeoutMs = configIdleTimeout(mOptions.engine_config->getConfig());
+    }
+    if (mIdleTimeoutMs == 0) {
+        mIdleTimeoutMs = 5000;
+    }
+
+    mThread = std::thread(&ConnectionPoolImpl::maintenanceLoop, this);
+}
+
+ConnectionPoolImpl::~ConnectionPoolImpl() {
+    {
+        std::lock_guard<std::mutex> lock(mSignal->mutex);
+        mStopping = true;
+    }
+    mSignal->cond.notify_all();
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+
+    // Engines shut down as the last reference goes, outside the lock
+    std::map<std::string, PoolOrigin> origins;
+    {
+        std::lock_guard<std::mutex> lock(mSignal->mutex);
+        origins.swap(mOrigins);
+    }
+}
+
+// ============================================================================
+// Registry
+// ============================================================================
+
+PoolOrigin& ConnectionPoolImpl::originLocked(const std::string& host, const std::string& port) {
+    PoolOrigin& origin = mOrigins[host + ":" + port];
+    if (origin.host.empty()) {
+        origin.host = host;
+        origin.port = port;
+    }
+    return origin;
+}
+
+size_t ConnectionPoolImpl::reserveStartsLocked(PoolOrigin& origin, uint64_t now_ns) {
+    if (mStopping || now_ns < origin.retry_ns) {
+        return 0;
+    }
+
+    size_t live = origin.starting;
+    for (const auto& entry : origin.entries) {
+        int state = entry->getState();
+        if (!entry->retiring && (state == PoolEntry::CONNECTING || state == PoolEntry::CONNECTED)) {
+            live++;
+        }
+    }
+
+    size_t count = live < mOptions.connections_per_origin ? mOptions.connections_per_origin - live : 0;
+    origin.starting += count;
+    return count;
+}
+
+void ConnectionPoolImpl::backoffLocked(PoolOrigin& origin, uint64_t now_ns) {
+    origin.failures++;
+    uint64_t backoff_ms = RETRY_BASE_MS << (origin.failures < 6 ? origin.failures - 1 : 5);
+    origin.retry_ns = now_ns + (backoff_ms < RETRY_MAX_MS ? backoff_ms : RETRY_MAX_MS) * NS_PER_MS;
+}
+
+void ConnectionPoolImpl::startConnections(const std::string& key, const std::string& host,
+                                          const std::string& port, size_t count) {
+    std::vector<std::shared_ptr<PoolEntry>> created;
+    std::string error;
+    for (size_t i = 0; i < count; i++) {
+        std::shared_ptr<PoolEntry> entry = createEntry(host, port, error);
+        if (!entry) {
+            // The rest would fail the same way; retry after the backoff
+            break;
+        }
+        created.push_back(entry);
+    }
+
+    std::vector<std::shared_ptr<PoolEntry>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mSignal->mutex);
+        PoolOrigin& origin = mOrigins[key];
+        origin.starting -= count;
+        if (created.size() < count) {
+            mStartFailures++;
+            mLastError = "Failed to start connection to " + key + ": " + error;
+            backoffLocked(origin, monotonicNowNs());
+        }
+        if (mStopping) {
+            dropped.swap(created);
+        } else {
+            origin.entries.insert(origin.entries.end(), created.begin(), created.end());
+        }
+    }
+    // A handshake may already have finished before the entry was listed
+    mSignal->cond.notify_all();
+}
+
+std::shared_ptr<PoolEntry> ConnectionPoolImpl::createEntry(const std::string& host,
+                                                           const std::string& port,
+                                                           std::string& error) {
+    std::shared_ptr<PoolEntry> entry = std::make_shared<PoolEntry>();
+    entry->state = std::make_shared<std::atomic<int>>(PoolEntry::CONNECTING);
+
+    if (mOptions.runtime) {
+        entry->engine = std::make_shared<QuicheEngine>(mOptions.runtime, host, port, mOptions.config);
+    } else {
+        entry->engine = std::make_shared<QuicheEngine>(host, port, mOptions.config);
+    }
+    if (mOptions.engine_config) {
+        entry->engine->setEngineConfig(mOptions.engine_config);
+    }
+
+    // Only the state and the signal are captured: users may keep the
+    // engine (and so this callback) alive after the pool is gone
+    std::shared_ptr<std::atomic<int>> state = entry->state;
+    std::shared_ptr<PoolSignal> signal = mSignal;
+    entry->engine->setEventCallback(
+        [state, signal](QuicheEngine*, EngineEvent event, const EventData&, void*) {
+            if (event == EngineEvent::CONNECTED) {
+                state->store(PoolEntry::CONNECTED);
+            } else if (event == EngineEvent::CONNECTION_CLOSED) {
+                int expected = PoolEntry::CONNECTING;
+                if (!state->compare_exchange_strong(expected, PoolEntry::FAILED)) {
+                    state->store(PoolEntry::CLOSED);
+                }
+            } else {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(signal->mutex);
+            }
+            signal->cond.notify_all();
+        });
+
+    if (!entry->engine->start()) {
+        error = entry->engine->getLastError();
+        return nullptr;
+    }
+    mHandshakesStarted++;
+    return entry;
+}
+
+std::shared_ptr<PoolEntry> ConnectionPoolImpl::pickLocked(PoolOrigin& origin) {
+    size_t count = origin.entries.size();
+    std::shared_ptr<PoolEntry> fallback;
+    for (size_t i = 0; i < count; i++) {
+        size_t index = (origin.next + i) % count;
+        const std::shared_ptr<PoolEntry>& entry = origin.entries[index];
+        if (entry->getState() != PoolEntry::CONNECTED) {
+            continue;
+        }
+        if (entry->retiring) {
+            if (!fallback) {
+                fallback = entry;
+            }
+            continue;
+        }
+        origin.next = index + 1;
+        return entry;
+    }
+    return fallback;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+void ConnectionPoolImpl::prewarm(const std::string& host, const std::string& port) {
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(mSignal->mutex);
+        count = reserveStartsLocked(originLocked(host, port), monotonicNowNs());
+    }
+    if (count > 0) {
+        startConnections(host + ":" + port, host, port, count);
+    }
+}
+
+std::shared_ptr<QuicheEngine> ConnectionPoolImpl::acquire(const std::string& host,
+                                                          const std::string& port,
+                                                          int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mSignal->mutex);
+    PoolOrigin& origin = originLocked(host, port);
+
+    std::shared_ptr<PoolEntry> entry = pickLocked(origin);
+    if (entry) {
+        mHits++;
+    } else {
+        // Start what the origin lacks and wait for the first handshake
+        mMisses++;
+        size_t count = reserveStartsLocked(origin, monotonicNowNs());
+        if (count > 0) {
+            lock.unlock();
+            startConnections(host + ":" + port, host, port, count);
+            lock.lock();
+        }
+
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(timeout_ms > 0 ? timeout_ms : 0);
+        mSignal->cond.wait_until(lock, deadline, [this, &origin, &entry]() {
+            entry = pickLocked(origin);
+            return entry || mStopping;
+        });
+        if (!entry) {
+            return nullptr;
+        }
+    }
+
+    if (entry->handed_out) {
+        mHandshakesAvoided++;
+    }
+    entry->handed_out = true;
+    return entry->engine;
+}
+
+ConnectionPoolStats ConnectionPoolImpl::getStats() const {
+    ConnectionPoolStats stats = {};
+    stats.hits = mHits.load();
+    stats.misses = mMisses.load();
+    stats.handshakes_avoided = mHandshakesAvoided.load();
+    stats.handshakes_started = mHandshakesStarted.load();
+    stats.replaced_idle = mReplacedIdle.load();
+    stats.replaced_closed = mReplacedClosed.load();
+    stats.start_failures = mStartFailures.load();
+
+    std::lock_guard<std::mutex> lock(mSignal->mutex);
+    stats.origins = mOrigins.size();
+    for (const auto& pair : mOrigins) {
+        for (const auto& entry : pair.second.entries) {
+            int state = entry->getState();
+            if (state == PoolEntry::CONNECTED) {
+                stats.established++;
+            } else if (state == PoolEntry::CONNECTING) {
+                stats.connecting++;
+            }
+        }
+    }
+    return stats;
+}
+
+std::string ConnectionPoolImpl::getLastError() const {
+    std::lock_guard<std::mutex> lock(mSignal->mutex);
+    return mLastError;
+}
+
+// ============================================================================
+// Maintenance
+// ============================================================================
+
+void ConnectionPoolImpl::maintenanceLoop() {
+    std::unique_lock<std::mutex> lock(mSignal->mutex);
+    while (!mStopping) {
+        // Engine events wake the condvar too; only the tick (or stop) counts
+        auto next = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(MAINTENANCE_INTERVAL_MS);
+        if (mSignal->cond.wait_until(lock, next, [this]() { return mStopping; })) {
+            break;
+        }
+
+        lock.unlock();
+        maintain();
+        lock.lock();
+    }
+}
+
+void ConnectionPoolImpl::maintain() {
+    uint64_t now_ns = monotonicNowNs();
+
+    std::vector<std::shared_ptr<PoolEntry>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mSignal->mutex);
+        for (const auto& pair : mOrigins) {
+            snapshot.insert(snapshot.end(), pair.second.entries.begin(), pair.second.entries.end());
+        }
+    }
+
+    // Received packets reset the idle timer. Sampled outside the lock, as
+    // every engine call is (getStats() itself does not wait for the loop)
+    for (const auto& entry : snapshot) {
+        if (entry->getState() != PoolEntry::CONNECTED) {
+            continue;
+        }
+        size_t packets = entry->engine->getStats().packets_received;
+        if (packets != entry->last_packets || entry->last_activity_ns == 0) {
+            entry->last_packets = packets;
+            entry->last_activity_ns = now_ns;
+        }
+    }
+    snapshot.clear();
+
+    uint64_t margin_ms = mOptions.replace_before_idle_ms;
+    if (margin_ms >= mIdleTimeoutMs) {
+        margin_ms = mIdleTimeoutMs / 2;
+    }
+    uint64_t idle_limit_ns = (mIdleTimeoutMs - margin_ms) * NS_PER_MS;
+
+    struct Start {
+        std::string key;
+        std::string host;
+        std::string port;
+        size_t count;
+    };
+    std::vector<Start> starts;
+    std::vector<std::shared_ptr<PoolEntry>> removed;  // Released after the lock
+    {
+        std::lock_guard<std::mutex> lock(mSignal->mutex);
+        for (auto& pair : mOrigins) {
+            PoolOrigin& origin = pair.second;
+            size_t ready = 0;
+
+            auto it = origin.entries.begin();
+            while (it != origin.entries.end()) {
+                PoolEntry& entry = **it;
+                int state = entry.getState();
+
+                if (state == PoolEntry::CLOSED || state == PoolEntry::FAILED) {
+                    if (state == PoolEntry::FAILED) {
+                        backoffLocked(origin, now_ns);
+                    } else if (!entry.retiring) {
+                        mReplacedClosed++;
+                    }
+                    removed.push_back(*it);
+                    it = origin.entries.erase(it);
+                    continue;
+                }
+
+                if (state == PoolEntry::CONNECTED) {
+                    origin.failures = 0;
+                    if (!entry.retiring && entry.last_activity_ns != 0 &&
+                        now_ns - entry.last_activity_ns >= idle_limit_ns) {
+                        entry.retiring = true;
+                        mReplacedIdle++;
+                    }
+                    if (!entry.retiring) {
+                        ready++;
+                    }
+                }
+                ++it;
+            }
+
+            // Retired connections leave once their replacements are up
+            if (ready >= mOptions.connections_per_origin) {
+                it = origin.entries.begin();
+                while (it != origin.entries.end()) {
+                    if ((*it)->retiring) {
+                        removed.push_back(*it);
+                        it = origin.entries.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+
+            size_t count = reserveStartsLocked(origin, now_ns);
+            if (count > 0) {
+                Start start = {pair.first, origin.host, origin.port, count};
+                starts.push_back(start);
+            }
+        }
+    }
+
+    // Users may still hold removed engines; the last reference closes them
+    removed.clear();
+
+    for (const Start& start : starts) {
+        startConnections(start.key, start.host, start.port, start.count);
+    }
+}
+
+// ============================================================================
+// ConnectionPool (public API)
+// ============================================================================
+
+ConnectionPool::ConnectionPool(const ConnectionPoolOptions& options)
+    : mPImpl(new ConnectionPoolImpl(options))
+{
+}
+
+ConnectionPool::~ConnectionPool() {
+    delete mPImpl;
+}
+
+void ConnectionPool::prewarm(const std::string& host, const std::string& port) {
+    mPImpl->prewarm(host, port);
+}
+
+std::shared_ptr<QuicheEngine> ConnectionPool::acquire(const std::string& host,
+                                                      const std::string& port,
+                                                      int timeout_ms) {
+    return mPImpl->acquire(host, port, timeout_ms);
+}
+
+ConnectionPoolStats ConnectionPool::getStats() const {
+    return mPImpl->getStats();
+}
+
+std::string ConnectionPool::getLastError() const {
+    return mPImpl->getLastError();
+}
+
+} // namespace quiche
@@ -0,0 +1,127 @@
+#ifndef __QUICHE_CONNECTION_POOL_IMPL_H__
+#define __QUICHE_CONNECTION_POOL_IMPL_H__
+
+#include <quiche_connection_pool.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace quiche {
+
+// Woken by the engines' event callbacks; shared with them so a late
+// callback never touches a destroyed pool
+struct PoolSignal {
+    std::mutex mutex;  // Also guards the pool's registry
+    std::condition_variable cond;
+};
+
+// One pooled connection
+struct PoolEntry {
+    enum State {
+        CONNECTING,
+        CONNECTED,
+        CLOSED,   // Closed after the handshake
+        FAILED,   // Closed before the handshake completed
+    };
+
+    std::shared_ptr<QuicheEngine> engine;
+    std::shared_ptr<std::atomic<int>> state;  // Set by the engine's event callback
+    bool handed_out;   // acquire() returned it at least once
+    bool retiring;     // Replacement started, leaves once that is established
+
+    // Idle tracking (maintenance thread only)
+    size_t last_packets;
+    uint64_t last_activity_ns;
+
+    PoolEntry() : handed_out(false), retiring(false), last_packets(0), last_activity_ns(0) {}
+
+    int getState() const { return state->load(); }
+};
+
+// Connections to one host:port
+struct PoolOrigin {
+    std::string host;
+    std::string port;
+    std::vector<std::shared_ptr<PoolEntry>> entries;
+    size_t next;       // Round-robin position among established entries
+    size_t starting;   // Engines being created outside the lock
+    size_t failures;   // Starts or handshakes failed in a row
+    uint64_t retry_ns; // No new connections before this (backoff after failures)
+
+    PoolOrigin() : next(0), starting(0), failures(0), retry_ns(0) {}
+};
+
+// Connection pool implementation class (PIMPL)
+class ConnectionPoolImpl {
+public:
+    explicit ConnectionPoolImpl(const ConnectionPoolOptions& options);
+    ~ConnectionPoolImpl();
+
+    // Disable copy
+    ConnectionPoolImpl(const ConnectionPoolImpl&) = delete;
+    ConnectionPoolImpl& operator=(const ConnectionPoolImpl&) = delete;
+
+    void prewarm(const std::string& host, const std::string& port);
+    std::shared_ptr<QuicheEngine> acquire(const std::string& host, const std::string& port,
+                                          int timeout_ms);
+    ConnectionPoolStats getStats() const;
+    std::string getLastError() const;
+
+private:
+    // Engines are started, shut down and destroyed only outside the lock:
+    // their callbacks take it from the loop thread
+
+    // Registry entry for host:port, created on first use (lock held)
+    PoolOrigin& originLocked(const std::string& host, const std::string& port);
+
+    // Connections still needed to reach connections_per_origin (lock held;
+    // the caller starts that many, counted in PoolOrigin::starting)
+    size_t reserveStartsLocked(PoolOrigin& origin, uint64_t now_ns);
+
+    // Count a failure and push the origin's next start out exponentially
+    // (lock held)
+    void backoffLocked(PoolOrigin& origin, uint64_t now_ns);
+
+    // Create and start count engines, then add them to the origin; a failed
+    // start stops the batch, backs the origin off and sets mLastError
+    void startConnections(const std::string& key, const std::string& host,
+                          const std::string& port, size_t count);
+    std::shared_ptr<PoolEntry> createEntry(const std::string& host, const std::string& port,
+                                           std::string& error);
+
+    // Established entry, round-robin, retiring ones only if nothing else is
+    // (lock held; nullptr if none)
+    std::shared_ptr<PoolEntry> pickLocked(PoolOrigin& origin);
+
+    // Maintenance thread: sample activity, drop closed and replaced
+    // connections, start replacements
+    void maintenanceLoop();
+    void maintain();
+
+    ConnectionPoolOptions mOptions;
+    uint64_t mIdleTimeoutMs;
+
+    std::shared_ptr<PoolSignal> mSignal;
+    std::map<std::string, PoolOrigin> mOrigins;  // Keyed by "host:port"
+    std::string mLastError;                      // Latest start failure
+    bool mStopping;
+    std::thread mThread;
+
+    std::atomic<size_t> mHits;
+    std::atomic<size_t> mMisses;
+    std::atomic<size_t> mHandshakesAvoided;
+    std::atomic<size_t> mHandshakesStarted;
+    std::atomic<size_t> mReplacedIdle;
+    std::atomic<size_t> mReplacedClosed;
+    std::atomic<size_t> mStartFailures;
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_CONNECTION_POOL_IMPL_H__
@@ -19,6 +19,20 @@ QuicheEngine::QuicheEngine(const std::string& host, const std::string& port, con
     mPImpl->setWrapper(this);
 }
 
+QuicheEngine::QuicheEngine(std::shared_ptr<EngineRuntime> runtime, const std::string& host,
+                           const std::string& port, const ConfigMap& config)
+    : mPImpl(new QuicheEngineImpl(host, port, config, runtime))
+{
+    mPImpl->setWrapper(this);
+}
+
+QuicheEngine::QuicheEngine(struct ev_loop* loop, const std::string& host,
+                           const std::string& port, const ConfigMap& config)
+    : mPImpl(new QuicheEngineImpl(host, port, config, nullptr, loop))
+{
+    mPImpl->setWrapper(this);
+}
+
 QuicheEngine::~QuicheEngine() {
     delete mPImpl;
 }
@@ -31,6 +45,9 @@ QuicheEngine::QuicheEngine(QuicheEngine&& other) noexcept
     : mPImpl(other.mPImpl)
 {
     other.mPImpl = nullptr;
+    if (mPImpl) {
+        mPImpl->setWrapper(this);  // Events name the engine that owns the impl now
+    }
 }
 
 QuicheEngine& QuicheEngine::operator=(QuicheEngine&& other) noexcept {
@@ -38,6 +55,9 @@ QuicheEngine& QuicheEngine::operator=(QuicheEngine&& other) noexcept {
         delete mPImpl;
         mPImpl = other.mPImpl;
         other.mPImpl = nullptr;
+        if (mPImpl) {
+            mPImpl->setWrapper(this);
+        }
     }
     return *this;
 }
@@ -50,14 +70,60 @@ bool QuicheEngine::setEventCallback(EventCallback callback, void* user_data) {
     return mPImpl->setEventCallback(callback, user_data);
 }
 
-ssize_t QuicheEngine::write(const uint8_t* data, size_t len, bool fin) {
-    return mPImpl->write(data, len, fin);
+bool QuicheEngine::setEventBatchCallback(EventBatchCallback callback, void* user_data) {
+    return mPImpl->setEventBatchCallback(callback, user_data);
+}
+
+size_t QuicheEngine::pollEvents(size_t max_events, int timeout_ms) {
+    return mPImpl->pollEvents(max_events, timeout_ms);
+}
+
+bool QuicheEngine::setEngineConfig(std::shared_ptr<EngineConfig> config) {
+    return mPImpl->setEngineConfig(config);
+}
+
+bool QuicheEngine::setSessionCache(std::shared_ptr<SessionCache> cache) {
+    return mPImpl->setSessionCache(cache);
+}
+
+bool QuicheEngine::addPeerAddress(const struct sockaddr* addr, socklen_t addr_len) {
+    return mPImpl->addPeerAddress(addr, addr_len);
+}
+
+ssize_t QuicheEngine::write(const uint8_t* data, size_t len, bool fin, uint64_t deadline_ms) {
+    return mPImpl->write(data, len, fin, deadline_ms);
 }
 
 ssize_t QuicheEngine::read(uint8_t* buf, size_t buf_len, bool& fin) {
     return mPImpl->read(buf, buf_len, fin);
 }
 
+ssize_t QuicheEngine::writeStream(uint64_t stream_id, const uint8_t* data, size_t len, bool fin,
+                                  uint64_t deadline_ms) {
+    return mPImpl->writeStream(stream_id, data, len, fin, deadline_ms);
+}
+
+ssize_t QuicheEngine::readStream(uint64_t stream_id, uint8_t* buf, size_t buf_len, bool& fin) {
+    return mPImpl->readStream(stream_id, buf, buf_len, fin);
+}
+
+bool QuicheEngine::setStreamSchedule(uint64_t stream_id, uint32_t weight,
+                                     uint64_t max_rate, uint64_t burst) {
+    return mPImpl->setStreamSchedule(stream_id, weight, max_rate, burst);
+}
+
+uint64_t QuicheEngine::openStream() {
+    return mPImpl->openStream();
+}
+
+std::future<RpcResponse> QuicheEngine::call(const uint8_t* request, size_t len) {
+    return mPImpl->call(request, len);
+}
+
+RpcStats QuicheEngine::getRpcStats() const {
+    return mPImpl->getRpcStats();
+}
+
 bool QuicheEngine::start() {
     return mPImpl->start();
 }
@@ -78,6 +144,10 @@ EngineStats QuicheEngine::getStats() const {
     return mPImpl->getStats();
 }
 
+LoopThreadInfo QuicheEngine::getLoopThreadInfo() const {
+    return mPImpl->getLoopThreadInfo();
+}
+
 std::string QuicheEngine::getLastError() const {
     return mPImpl->getLastError();
 }
@@ -86,4 +156,16 @@ std::string QuicheEngine::getScid() const {
     return mPImpl->getScid();
 }
 
+bool QuicheEngine::probePath(const std::string& local_host, const std::string& local_port) {
+    return mPImpl->probePath(local_host, local_port);
+}
+
+bool QuicheEngine::migrate() {
+    return mPImpl->migrate();
+}
+
+bool QuicheEngine::setIdleTimeout(uint64_t timeout_ms) {
+    return mPImpl->setIdleTimeout(timeout_ms);
+}
+
 } // namespace quiche
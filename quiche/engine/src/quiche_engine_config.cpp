@@ -0,0 +1,153 @@
+// quiche_engine_config.cpp
+// Engine Config - quiche_config built once and shared by many engines
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+
+#include "quiche_engine_config_impl.h"
+#include "quiche_engine_impl.h"
+
+#include <cstdlib>
+
+namespace quiche {
+
+const char* const DEFAULT_ALPN_PROTOCOLS = "hq-interop,hq-29,hq-28,hq-27,http/0.9";
+
+bool encodeAlpnProtocols(const std::string& list, std::string& wire) {
+    wire.clear();
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        size_t len = end - start;
+        if (len == 0 || len > 255) {
+            return false;
+        }
+        wire.push_back(static_cast<char>(len));
+        wire.append(list, start, len);
+        start = end + 1;
+    }
+    return true;
+}
+
+// ============================================================================
+// EngineConfigImpl Implementation
+// ============================================================================
+
+EngineConfigImpl::EngineConfigImpl(const ConfigMap& config)
+    : mConfig(config), mQuicheCfg(nullptr)
+{
+    if (!build() && mQuicheCfg) {
+        quiche_config_free(mQuicheCfg);
+        mQuicheCfg = nullptr;
+    }
+}
+
+EngineConfigImpl::~EngineConfigImpl() {
+    if (mQuicheCfg) {
+        quiche_config_free(mQuicheCfg);
+    }
+}
+
+bool EngineConfigImpl::build() {
+    mQuicheCfg = quiche_config_new(0xbabababa);
+    if (!mQuicheCfg) {
+        mLastError = "Failed to create QUIC config";
+        return false;
+    }
+
+    // Application protocols, most preferred first
+    std::string alpn_list = getConfigValue(ConfigKey::ALPN_PROTOCOLS, std::string(DEFAULT_ALPN_PROTOCOLS));
+    std::string alpn;
+    if (!encodeAlpnProtocols(alpn_list, alpn) ||
+        quiche_config_set_application_protos(mQuicheCfg, reinterpret_cast<const uint8_t*>(alpn.data()),
+                                             alpn.size()) < 0) {
+        mLastError = "Invalid ALPN_PROTOCOLS";
+        return false;
+    }
+
+    // Trusted CAs; loading and parsing the bundle is the expensive part
+    std::string ca_file = getConfigValue(ConfigKey::TLS_CA_FILE, std::string());
+    if (!ca_file.empty() &&
+        quiche_config_load_verify_locations_from_file(mQuicheCfg, ca_file.c_str()) < 0) {
+        mLastError = "Failed to load TLS_CA_FILE: " + ca_file;
+        return false;
+    }
+    quiche_config_verify_peer(mQuicheCfg, getConfigValue(ConfigKey::VERIFY_PEER, true));
+
+    // Transport parameters
+    quiche_config_set_max_idle_timeout(mQuicheCfg,
+        getConfigValue(ConfigKey::MAX_IDLE_TIMEOUT, static_cast<uint64_t>(5000)));
+
+    uint64_t max_udp_payload = getConfigValue(ConfigKey::MAX_UDP_PAYLOAD_SIZE, static_cast<uint64_t>(MAX_DATAGRAM_SIZE));
+    quiche_config_set_max_recv_udp_payload_size(mQuicheCfg, max_udp_payload);
+    quiche_config_set_max_send_udp_payload_size(mQuicheCfg, max_udp_payload);
+
+    quiche_config_set_initial_max_data(mQuicheCfg,
+        getConfigValue(ConfigKey::INITIAL_MAX_DATA, static_cast<uint64_t>(10000000)));
+    quiche_config_set_initial_max_stream_data_bidi_local(mQuicheCfg,
+        getConfigValue(ConfigKey::INITIAL_MAX_STREAM_DATA_BIDI_LOCAL, static_cast<uint64_t>(1000000)));
+    quiche_config_set_initial_max_stream_data_bidi_remote(mQuicheCfg,
+        getConfigValue(ConfigKey::INITIAL_MAX_STREAM_DATA_BIDI_REMOTE, static_cast<uint64_t>(1000000)));
+    quiche_config_set_initial_max_stream_data_uni(mQuicheCfg,
+        getConfigValue(ConfigKey::INITIAL_MAX_STREAM_DATA_UNI, static_cast<uint64_t>(1000000)));
+    quiche_config_set_initial_max_streams_bidi(mQuicheCfg,
+        getConfigValue(ConfigKey::INITIAL_MAX_STREAMS_BIDI, static_cast<uint64_t>(100)));
+    quiche_config_set_initial_max_streams_uni(mQuicheCfg,
+        getConfigValue(ConfigKey::INITIAL_MAX_STREAMS_UNI, static_cast<uint64_t>(100)));
+    quiche_config_set_disable_active_migration(mQuicheCfg,
+        getConfigValue(ConfigKey::DISABLE_ACTIVE_MIGRATION, true));
+
+    uint64_t max_pacing_rate = getConfigValue(ConfigKey::MAX_PACING_RATE, static_cast<uint64_t>(0));
+    if (max_pacing_rate > 0) {
+        quiche_config_set_max_pacing_rate(mQuicheCfg, max_pacing_rate);
+    }
+
+    // Allow 0-RTT when resuming a cached session
+    if (getConfigValue(ConfigKey::ENABLE_EARLY_DATA, false)) {
+        quiche_config_enable_early_data(mQuicheCfg);
+    }
+
+    // Enable SSL key logging if environment variable is set
+    if (getenv("SSLKEYLOGFILE")) {
+        quiche_config_log_keys(mQuicheCfg);
+    }
+
+    return true;
+}
+
+quiche_conn* EngineConfigImpl::connect(const char* server_name, const uint8_t* scid, size_t scid_len,
+                                       const struct sockaddr* local, socklen_t local_len,
+                                       const struct sockaddr* peer, socklen_t peer_len) {
+    std::lock_guard<std::mutex> lock(mConnectMutex);
+    return quiche_connect(server_name, scid, scid_len, local, local_len, peer, peer_len, mQuicheCfg);
+}
+
+// ============================================================================
+// EngineConfig Implementation
+// ============================================================================
+
+EngineConfig::EngineConfig(const ConfigMap& config)
+    : mPImpl(new EngineConfigImpl(config))
+{
+}
+
+EngineConfig::~EngineConfig() {
+    delete mPImpl;
+}
+
+bool EngineConfig::isValid() const {
+    return mPImpl->isValid();
+}
+
+std::string EngineConfig::getLastError() const {
+    return mPImpl->lastError();
+}
+
+const ConfigMap& EngineConfig::getConfig() const {
+    return mPImpl->config();
+}
+
+} // namespace quiche
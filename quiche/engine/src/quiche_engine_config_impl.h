@@ -0,0 +1,80 @@
+#ifndef __QUICHE_ENGINE_CONFIG_IMPL_H__
+#define __QUICHE_ENGINE_CONFIG_IMPL_H__
+
+#include <quiche_engine_config.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <quiche.h>
+}
+
+namespace quiche {
+
+// Default ALPN list offered by clients (comma separated, as in ALPN_PROTOCOLS)
+extern const char* const DEFAULT_ALPN_PROTOCOLS;
+
+// Encode "a,b,c" as ALPN wire format (length-prefixed names); false if a
+// name is empty or longer than 255 bytes
+bool encodeAlpnProtocols(const std::string& list, std::string& wire);
+
+// Engine config implementation class (PIMPL)
+class EngineConfigImpl {
+public:
+    explicit EngineConfigImpl(const ConfigMap& config);
+    ~EngineConfigImpl();
+
+    // Disable copy
+    EngineConfigImpl(const EngineConfigImpl&) = delete;
+    EngineConfigImpl& operator=(const EngineConfigImpl&) = delete;
+
+    bool isValid() const { return mQuicheCfg != nullptr; }
+    const std::string& lastError() const { return mLastError; }
+    const ConfigMap& config() const { return mConfig; }
+
+    uint64_t getConfigValue(ConfigKey key, uint64_t default_value) const {
+        auto it = mConfig.find(key);
+        if (it != mConfig.end() && it->second.type == ConfigValueType::UINT64) {
+            return it->second.uint_val;
+        }
+        return default_value;
+    }
+
+    bool getConfigValue(ConfigKey key, bool default_value) const {
+        auto it = mConfig.find(key);
+        if (it != mConfig.end() && it->second.type == ConfigValueType::BOOL) {
+            return it->second.bool_val;
+        }
+        return default_value;
+    }
+
+    std::string getConfigValue(ConfigKey key, const std::string& default_value) const {
+        auto it = mConfig.find(key);
+        if (it != mConfig.end() && it->second.type == ConfigValueType::STRING) {
+            return it->second.str_val;
+        }
+        return default_value;
+    }
+
+    // quiche_connect() on the shared config. quiche takes the config
+    // mutably, so engines on different loop threads take turns here.
+    quiche_conn* connect(const char* server_name, const uint8_t* scid, size_t scid_len,
+                         const struct sockaddr* local, socklen_t local_len,
+                         const struct sockaddr* peer, socklen_t peer_len);
+
+private:
+    ConfigMap mConfig;
+    quiche_config* mQuicheCfg;
+    std::string mLastError;
+    std::mutex mConnectMutex;  // C++ mutex (non-recursive)
+
+    bool build();
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_ENGINE_CONFIG_IMPL_H__
@@ -80,13 +80,34 @@ void QuicheEngineImpl::debugLog(const char* line, void* argp) {
 // Engine::Impl Constructor/Destructor
 // ============================================================================
 
-QuicheEngineImpl::QuicheEngineImpl(const std::string& h, const std::string& p, const ConfigMap& cfg)
+QuicheEngineImpl::QuicheEngineImpl(const std::string& h, const std::string& p, const ConfigMap& cfg,
+                                   std::shared_ptr<EngineRuntime> runtime,
+                                   struct ev_loop* external_loop)
     : mHost(h), mPort(p), mConfig(cfg),
-      mQuicheCfg(nullptr), mConn(nullptr),
-      mSock(-1), mLocalAddrLen(0), mPeerAddrLen(0),
-      mLoop(nullptr), mThreadStarted(false),
+      mConn(nullptr),
+      mSock(-1), mShareSocket(false), mEndpoint(nullptr), mLocalAddrLen(0), mPeerAddrLen(0),
+      mLoop(nullptr), mTimers(nullptr), mThreadStarted(false), mLoopThreadId(std::thread::id()),
+      mRuntime(runtime), mEventLoop(nullptr), mExternalLoop(external_loop),
+      mStarted(false), mWatchersAttached(false),
+      mCallbackDepth(0), mInFlush(false), mFlushPending(false),
+      mResolveStartedNs(0), mResolveTimeUs(0),
+      mAttemptDelayNs(0), mConnStartedNs(0),
+      mConnectTimeV4Us(0), mConnectTimeV6Us(0), mConnectAttempts(0),
+      mIdleTimeoutMs(0), mKeepAliveBaseNs(0), mKeepAliveIntervalNs(0),
+      mLastRecvNs(0), mLastKeepAliveNs(0), mKeepAliveAnswered(0), mJitterState(0),
+      mKeepAlivesSent(0), mKeepAliveIntervalMs(0),
+      mIoArenaBytes(0), mIoArenaHugePages(false),
+      mSchedulerWakeupNs(0), mSendQueueBytes(0), mWriteCmdBytes(0), mWriteCmds(0), mConnStats(),
+      mWritesExpired(0), mExpiredBytes(0),
+      mNextStreamId(0), mRpcStreamId(UINT64_MAX), mRpcCreditBlocked(false),
+      mRpcCompleted(0), mRpcFailed(0), mRpcActiveCount(0), mRpcQueuedCount(0), mRpcCreditStalls(0),
+      mSessionCacheSet(false), mEarlyDataBytes(0),
       mEventCallback(nullptr), mUserData(nullptr), mWrapper(nullptr),
-      mIsRunning(false), mIsConnected(false)
+      mEventBatchCallback(nullptr), mBatchUserData(nullptr),
+      mBatchSeq(1), mWritableBatched(false), mDispatchingBatch(false),
+      mIsRunning(false), mIsConnected(false),
+      mLowMemory(false), mLastIoNs(0), mLoopStackBytes(0),
+      mSlackNs(0), mCommandHoldNs(0)
 #if defined(__linux__)
       , mSendBufs(nullptr), mRecvBufs(nullptr), mSendMsgs(nullptr), mRecvMsgs(nullptr),
       mSendIovs(nullptr), mRecvIovs(nullptr), mSendInfos(nullptr), mRecvAddrs(nullptr)
@@ -97,57 +118,91 @@ QuicheEngineImpl::QuicheEngineImpl(const std::string& h, const std::string& p, c
     memset(&mLocalAddr, 0, sizeof(mLocalAddr));
     memset(&mPeerAddr, 0, sizeof(mPeerAddr));
 
-    // Allocate I/O buffers on heap
-#if defined(__linux__)
-    // Batch I/O buffers for Linux
-    mSendBufs = new uint8_t[BATCH_SIZE][MAX_DATAGRAM_SIZE];
-    mRecvBufs = new uint8_t[BATCH_SIZE][MAX_RECV_BUF_SIZE];
-    mSendMsgs = new struct mmsghdr[BATCH_SIZE];
-    mRecvMsgs = new struct mmsghdr[BATCH_SIZE];
-    mSendIovs = new struct iovec[BATCH_SIZE];
-    mRecvIovs = new struct iovec[BATCH_SIZE];
-    mSendInfos = new quiche_send_info[BATCH_SIZE];
-    mRecvAddrs = new struct sockaddr_storage[BATCH_SIZE];
-
-    // Initialize recv structures (can be reused)
-    for (int i = 0; i < BATCH_SIZE; i++) {
-        mRecvIovs[i].iov_base = mRecvBufs[i];
-        mRecvIovs[i].iov_len = MAX_RECV_BUF_SIZE;
-        memset(&mRecvMsgs[i], 0, sizeof(mRecvMsgs[i]));
-        mRecvMsgs[i].msg_hdr.msg_name = &mRecvAddrs[i];
-        mRecvMsgs[i].msg_hdr.msg_namelen = sizeof(mRecvAddrs[i]);
-        mRecvMsgs[i].msg_hdr.msg_iov = &mRecvIovs[i];
-        mRecvMsgs[i].msg_hdr.msg_iovlen = 1;
-    }
-#else
-    // Single packet buffers for macOS/iOS
-    mSendBuf = new uint8_t[MAX_DATAGRAM_SIZE];
-    mRecvBuf = new uint8_t[MAX_RECV_BUF_SIZE];
-#endif
-
     // Generate source connection ID (SCID)
     mScid = generateRandomHexString();
 
     // Initialize default stream ID (client-initiated bidirectional stream)
     mStreamId = 4;
 
+    // Engines created against a runtime share one of its loop threads
+    if (mRuntime) {
+        mEventLoop = mRuntime->impl()->acquireLoop(mHost + ":" + mPort);
+    }
+
+    // A dedicated loop serves one connection: nothing to share
+    mShareSocket = mEventLoop && getConfigValue(ConfigKey::SHARED_UDP_SOCKET, false);
+
+    // Standby profile: I/O buffers only while busy, bounded stream buffers
+    mLowMemory = getConfigValue(ConfigKey::LOW_MEMORY_MODE, false);
+    if (mLowMemory) {
+        mIoArenaPool = IoArenaPool::shared();
+    }
+
+    // Battery profile: a few milliseconds of latency for fewer wakeups
+    if (getConfigValue(ConfigKey::POWER_SAVE_MODE, false)) {
+        mSlackNs = getConfigValue(ConfigKey::TIMER_SLACK_MS, POWER_SAVE_SLACK_MS) * 1000000ULL;
+    }
+
+    // Events for an application thread instead of callbacks on the loop
+    uint64_t event_queue_size = getConfigValue(ConfigKey::EVENT_QUEUE_SIZE, static_cast<uint64_t>(0));
+    if (event_queue_size > 0) {
+        mEventQueue.reset(new EventQueue(static_cast<size_t>(event_queue_size)));
+    }
+
     // std::mutex default constructor - no initialization needed
 }
 
 QuicheEngineImpl::~QuicheEngineImpl() {
-    // Stop event mLoop if running
-    if (mIsRunning && mLoop) {
-        auto* cmd = new Command();
-        cmd->type = CommandType::STOP;
-        mCmdQueue.push(cmd);
-        ev_async_send(mLoop, &mAsyncWatcher);
+    // A lookup still running must not post to the loop destroyed below
+    if (mResolveWaiter) {
+        std::lock_guard<std::mutex> lock(mResolveWaiter->mutex);
+        mResolveWaiter->engine = nullptr;
+    }
+
+    if (mEventLoop) {
+        // Shared loop keeps running - just take our watchers off it
+        if (mStarted) {
+            mEventLoop->runSync([this]() { detachWatchers(); });
+        }
+        mRuntime->impl()->releaseLoop(mEventLoop);
+        mEventLoop = nullptr;
+        mLoop = nullptr;  // Owned by the runtime
+    } else if (mExternalLoop) {
+        // Destroyed on the caller's loop thread
+        detachWatchers();
+        mLoop = nullptr;  // Owned by the application
+    } else {
+        // Stop event mLoop if running
+        if (mIsRunning && mLoop) {
+            auto* cmd = new Command();
+            cmd->type = CommandType::STOP;
+            mCmdQueue.push(cmd);
+            ev_async_send(mLoop, &mAsyncWatcher);
+        }
 
+        // Join even if the loop already ended on its own (connection closed)
         if (mThreadStarted && mLoopThread.joinable()) {
-            mLoopThread.join();  // C++11 thread join (replaces pthread_join)
+            mLoopThread.join();
             mThreadStarted = false;
         }
     }
 
+    // Loop thread is gone - keep the latest session ticket for the next connect
+    saveSession();
+
+    // Calls still in the command queue, waiting for a stream or in flight
+    Command* pending;
+    while ((pending = mCmdQueue.pop()) != nullptr) {
+        if (pending->type == CommandType::RPC_CALL) {
+            mRpcQueued.push_back(pending->params.rpc.call);
+        }
+        delete pending;
+    }
+    failCalls("Engine destroyed");
+
+    // Drop writes that never got a chance to be sent
+    mScheduler.clear();
+
     // Destroy event loop
     if (mLoop) {
         ev_loop_destroy(mLoop);
@@ -160,10 +215,7 @@ QuicheEngineImpl::~QuicheEngineImpl() {
         mConn = nullptr;
     }
 
-    if (mQuicheCfg) {
-        quiche_config_free(mQuicheCfg);
-        mQuicheCfg = nullptr;
-    }
+    // mEngineConfig (possibly shared) goes away with its last engine
 
     // Close socket
     if (mSock >= 0) {
@@ -171,6 +223,22 @@ QuicheEngineImpl::~QuicheEngineImpl() {
         mSock = -1;
     }
 
+    for (PathSocket* path : mPathSockets) {
+        ::close(path->fd);
+        delete path;
+    }
+    mPathSockets.clear();
+
+    // Attempts still racing when the loop went away
+    for (ConnectAttempt* a : mAttempts) {
+        quiche_conn_free(a->conn);
+        if (a->fd >= 0) {
+            ::close(a->fd);
+        }
+        delete a;
+    }
+    mAttempts.clear();
+
     // Clean up stream buffers
     {
         std::lock_guard<std::mutex> lock(mStreamBuffersMutex);
@@ -180,20 +248,10 @@ QuicheEngineImpl::~QuicheEngineImpl() {
         mStreamBuffers.clear();
     }
 
-    // Free I/O buffers
-#if defined(__linux__)
-    delete[] mSendBufs;
-    delete[] mRecvBufs;
-    delete[] mSendMsgs;
-    delete[] mRecvMsgs;
-    delete[] mSendIovs;
-    delete[] mRecvIovs;
-    delete[] mSendInfos;
-    delete[] mRecvAddrs;
-#else
-    delete[] mSendBuf;
-    delete[] mRecvBuf;
-#endif
+    // I/O buffers go away with mIoArena, or back to the pool
+    if (mIoArenaPool) {
+        mIoArenaPool->release(std::move(mIoArena));
+    }
 
     // std::mutex destructor called automatically
 }
@@ -208,300 +266,848 @@ bool QuicheEngineImpl::setEventCallback(EventCallback callback, void* ud) {
     return true;
 }
 
-bool QuicheEngineImpl::setupConnection() {
-    // Resolve mHostname
-    struct addrinfo hints = {};
-    hints.ai_family = PF_UNSPEC;
-    hints.ai_socktype = SOCK_DGRAM;
-    hints.ai_protocol = IPPROTO_UDP;
-
-    struct addrinfo* peer;
-    if (getaddrinfo(mHost.c_str(), mPort.c_str(), &hints, &peer) != 0) {
-        mLastError = "Failed to resolve mHost: " + mHost;
+bool QuicheEngineImpl::setEventBatchCallback(EventBatchCallback callback, void* ud) {
+    if (mStarted) {
+        mLastError = "Event batch callback must be set before start()";
         return false;
     }
+    mEventBatchCallback = callback;
+    mBatchUserData = ud;
+    return true;
+}
 
-    // Save peer address
-    mPeerAddrLen = peer->ai_addrlen;
-    memcpy(&mPeerAddr, peer->ai_addr, peer->ai_addrlen);
+size_t QuicheEngineImpl::pollEvents(size_t max_events, int timeout_ms) {
+    if (!mEventQueue) {
+        return 0;
+    }
 
-    // Create socket
-    mSock = socket(peer->ai_family, SOCK_DGRAM, 0);
-    if (mSock < 0) {
-        mLastError = "Failed to create socket";
-        freeaddrinfo(peer);
-        return false;
+    // A second poller (or a handler polling again) gets nothing
+    std::unique_lock<std::mutex> lock(mPollMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return 0;
     }
 
-    // Protect against SIGPIPE on macOS/iOS
-#ifdef SO_NOSIGPIPE
-    int set = 1;
-    if (setsockopt(mSock, SOL_SOCKET, SO_NOSIGPIPE, &set, sizeof(set)) < 0) {
-        // Non-fatal, just log
-        std::cerr << "Warning: Failed to set SO_NOSIGPIPE" << std::endl;
+    if (mEventBatchCallback) {
+        // Pop into reused slots, then hand everything over in one call
+        if (mPollEvents.size() < max_events) {
+            mPollEvents.resize(max_events);
+        }
+        size_t count = 0;
+        while (count < max_events && mEventQueue->pop(mPollEvents[count], count == 0 ? timeout_ms : 0)) {
+            count++;
+        }
+        if (count == 0) {
+            return 0;
+        }
+
+        mPollRecords.clear();
+        for (size_t i = 0; i < count; i++) {
+            const QueuedEvent& ev = mPollEvents[i];
+            EventRecord record;
+            record.event = ev.event;
+            record.type = ev.data.type;
+            record.uint_val = ev.data.uint_val;
+            bool is_string = ev.data.type == EventDataType::STRING;
+            record.str_val = is_string ? ev.data.str_val.c_str() : nullptr;
+            record.str_len = is_string ? ev.data.str_val.size() : 0;
+            mPollRecords.push_back(record);
+        }
+        mEventBatchCallback(mWrapper, mPollRecords.data(), count, mBatchUserData);
+        return count;
     }
-#endif
 
-    // Make mSocket non-blocking
-    if (fcntl(mSock, F_SETFL, O_NONBLOCK) != 0) {
-        mLastError = "Failed to make mSocket non-blocking";
-        ::close(mSock);
-        mSock = -1;
-        freeaddrinfo(peer);
+    size_t delivered = 0;
+    QueuedEvent ev;
+    while (delivered < max_events && mEventQueue->pop(ev, delivered == 0 ? timeout_ms : 0)) {
+        delivered++;
+        if (mEventCallback) {
+            mEventCallback(mWrapper, ev.event, ev.data, mUserData);
+        }
+    }
+    return delivered;
+}
+
+bool QuicheEngineImpl::setEngineConfig(std::shared_ptr<EngineConfig> config) {
+    if (mStarted) {
+        mLastError = "Engine config must be set before start()";
         return false;
     }
+    if (config && !config->isValid()) {
+        mLastError = "Invalid engine config: " + config->getLastError();
+        return false;
+    }
+    mEngineConfig = config;
+    return true;
+}
 
-    // Create QUIC config
-    mQuicheCfg = quiche_config_new(0xbabababa);
-    if (!mQuicheCfg) {
-        mLastError = "Failed to create QUIC config";
-        ::close(mSock);
-        mSock = -1;
-        freeaddrinfo(peer);
+bool QuicheEngineImpl::setSessionCache(std::shared_ptr<SessionCache> cache) {
+    if (mStarted) {
+        mLastError = "Session cache must be set before start()";
         return false;
     }
+    mSessionCache = cache;
+    mSessionCacheSet = true;
+    return true;
+}
 
-    // Set application protocols
-    quiche_config_set_application_protos(mQuicheCfg,
-        (const uint8_t*)"\x0ahq-interop\x05hq-29\x05hq-28\x05hq-27\x08http/0.9", 38);
+void QuicheEngineImpl::resolveSessionCache() {
+    if (mSessionCacheSet) {
+        return;
+    }
 
-    // Apply configuration parameters from map
-    uint64_t max_idle_timeout = getConfigValue<uint64_t>(ConfigKey::MAX_IDLE_TIMEOUT, 5000);
-    quiche_config_set_max_idle_timeout(mQuicheCfg, max_idle_timeout);
+    std::string cache_file = getConfigValue(ConfigKey::SESSION_CACHE_FILE, std::string());
+    if (!cache_file.empty()) {
+        mSessionCache = MemorySessionCache::shared(cache_file);
+    } else if (mEngineConfig ? mEngineConfig->impl()->getConfigValue(ConfigKey::ENABLE_EARLY_DATA, false)
+                             : getConfigValue(ConfigKey::ENABLE_EARLY_DATA, false)) {
+        mSessionCache = MemorySessionCache::shared();
+    }
+}
 
-    uint64_t max_udp_payload = getConfigValue<uint64_t>(ConfigKey::MAX_UDP_PAYLOAD_SIZE, MAX_DATAGRAM_SIZE);
-    quiche_config_set_max_recv_udp_payload_size(mQuicheCfg, max_udp_payload);
-    quiche_config_set_max_send_udp_payload_size(mQuicheCfg, max_udp_payload);
+void QuicheEngineImpl::saveSession() {
+    if (!mSessionCache || !mConn) {
+        return;
+    }
 
-    uint64_t initial_max_data = getConfigValue<uint64_t>(ConfigKey::INITIAL_MAX_DATA, 10000000);
-    quiche_config_set_initial_max_data(mQuicheCfg, initial_max_data);
+    const uint8_t* session;
+    size_t session_len = 0;
+    quiche_conn_session(mConn, &session, &session_len);
+    if (session_len > 0) {
+        mSessionCache->store(sessionKey(), session, session_len);
+    }
+}
 
-    uint64_t stream_data_bidi_local = getConfigValue<uint64_t>(ConfigKey::INITIAL_MAX_STREAM_DATA_BIDI_LOCAL, 1000000);
-    quiche_config_set_initial_max_stream_data_bidi_local(mQuicheCfg, stream_data_bidi_local);
+bool QuicheEngineImpl::setupConfig() {
+    uint64_t attempt_delay_ms = getConfigValue(ConfigKey::CONNECTION_ATTEMPT_DELAY_MS, static_cast<uint64_t>(250));
+    if (attempt_delay_ms < 10) {
+        attempt_delay_ms = 10;
+    }
+    mAttemptDelayNs = attempt_delay_ms * 1000000ULL;
 
-    uint64_t stream_data_bidi_remote = getConfigValue<uint64_t>(ConfigKey::INITIAL_MAX_STREAM_DATA_BIDI_REMOTE, 1000000);
-    quiche_config_set_initial_max_stream_data_bidi_remote(mQuicheCfg, stream_data_bidi_remote);
+    // QUIC config: shared via setEngineConfig(), or built for this engine alone
+    if (!mEngineConfig) {
+        mEngineConfig = std::make_shared<EngineConfig>(mConfig);
+    }
+    if (!mEngineConfig->isValid()) {
+        mLastError = mEngineConfig->getLastError();
+        return false;
+    }
+    const EngineConfigImpl* conn_config = mEngineConfig->impl();
 
-    uint64_t stream_data_uni = getConfigValue<uint64_t>(ConfigKey::INITIAL_MAX_STREAM_DATA_UNI, 1000000);
-    quiche_config_set_initial_max_stream_data_uni(mQuicheCfg, stream_data_uni);
+    // Our own MAX_IDLE_TIMEOUT (or setIdleTimeout()) wins over a shared config's
+    mIdleTimeoutMs = getConfigValue(ConfigKey::MAX_IDLE_TIMEOUT,
+        conn_config->getConfigValue(ConfigKey::MAX_IDLE_TIMEOUT, static_cast<uint64_t>(5000)));
 
-    uint64_t max_streams_bidi = getConfigValue<uint64_t>(ConfigKey::INITIAL_MAX_STREAMS_BIDI, 100);
-    quiche_config_set_initial_max_streams_bidi(mQuicheCfg, max_streams_bidi);
+    uint64_t keep_alive_ms = getConfigValue(ConfigKey::KEEP_ALIVE_INTERVAL_MS, static_cast<uint64_t>(0));
+    if (keep_alive_ms > 0 && keep_alive_ms < MIN_KEEP_ALIVE_MS) {
+        keep_alive_ms = MIN_KEEP_ALIVE_MS;
+    }
+    mKeepAliveBaseNs = keep_alive_ms * 1000000ULL;
+    mKeepAliveIntervalNs = mKeepAliveBaseNs;
+    mKeepAliveIntervalMs.store(keep_alive_ms);
+    mJitterState = static_cast<uint32_t>(monotonicNowNs()) | 1;
+
+    // Cap the stream payload together with the congestion controller's pacing rate
+    uint64_t max_pacing_rate = conn_config->getConfigValue(ConfigKey::MAX_PACING_RATE, static_cast<uint64_t>(0));
+    if (max_pacing_rate > 0) {
+        mScheduler.setConnectionRate(max_pacing_rate, monotonicNowNs());
+    }
 
-    uint64_t max_streams_uni = getConfigValue<uint64_t>(ConfigKey::INITIAL_MAX_STREAMS_UNI, 100);
-    quiche_config_set_initial_max_streams_uni(mQuicheCfg, max_streams_uni);
+    return true;
+}
 
-    bool disable_migration = getConfigValue<bool>(ConfigKey::DISABLE_ACTIVE_MIGRATION, true);
-    quiche_config_set_disable_active_migration(mQuicheCfg, disable_migration);
+// ============================================================================
+// Resolution and Connection Setup (event loop thread only)
+// ============================================================================
 
-    // Enable SSL key logging if environment variable is set
-    if (getenv("SSLKEYLOGFILE")) {
-        quiche_config_log_keys(mQuicheCfg);
-    }
+bool QuicheEngineImpl::setupIoBuffers(std::string& error) {
+    // Runs on the loop thread, which first-touches (and so places) the pages
+    std::unique_ptr<IoArena> arena(new IoArena());
+#if defined(__linux__)
+    size_t send_bufs = arena->reserve<uint8_t[SEND_SLOT_SIZE]>(BATCH_SIZE);
+    size_t recv_bufs = arena->reserve<uint8_t[MAX_RECV_BUF_SIZE]>(BATCH_SIZE);
+    size_t send_msgs = arena->reserve<struct mmsghdr>(BATCH_SIZE);
+    size_t recv_msgs = arena->reserve<struct mmsghdr>(BATCH_SIZE);
+    size_t send_iovs = arena->reserve<struct iovec>(BATCH_SIZE);
+    size_t recv_iovs = arena->reserve<struct iovec>(BATCH_SIZE);
+    size_t send_infos = arena->reserve<quiche_send_info>(BATCH_SIZE);
+    size_t recv_addrs = arena->reserve<struct sockaddr_storage>(BATCH_SIZE);
+#else
+    // Single packet buffers for macOS/iOS
+    size_t send_buf = arena->reserve<uint8_t>(MAX_DATAGRAM_SIZE);
+    size_t recv_buf = arena->reserve<uint8_t>(MAX_RECV_BUF_SIZE);
+#endif
 
-    // Generate mConnection ID
-    uint8_t scid[LOCAL_CONN_ID_LEN];
-    int rng = open("/dev/urandom", O_RDONLY);
-    if (rng < 0) {
-        mLastError = "Failed to open /dev/urandom";
-        quiche_config_free(mQuicheCfg);
-        mQuicheCfg = nullptr;
-        ::close(mSock);
-        mSock = -1;
-        freeaddrinfo(peer);
-        return false;
+    // A pooled arena has the same layout (same size); otherwise map one.
+    // Pooled arenas move between engines, so IO_ARENA_* do not apply
+    std::unique_ptr<IoArena> pooled;
+    if (mIoArenaPool) {
+        pooled = mIoArenaPool->acquire(arena->size());
     }
-
-    ssize_t rand_len = ::read(rng, &scid, sizeof(scid));
-    ::close(rng);
-
-    if (rand_len < 0) {
-        mLastError = "Failed to generate mConnection ID";
-        quiche_config_free(mQuicheCfg);
-        mQuicheCfg = nullptr;
-        ::close(mSock);
-        mSock = -1;
-        freeaddrinfo(peer);
+    if (pooled) {
+        arena.swap(pooled);
+    } else if (!arena->allocate(mIoArenaPool ? IoArenaOptions() : ioArenaOptionsFromConfig(mConfig), error)) {
         return false;
     }
+    mIoArena.swap(arena);
 
-    // Get local address
-    mLocalAddrLen = sizeof(mLocalAddr);
-    if (getsockname(mSock, (struct sockaddr*)&mLocalAddr, &mLocalAddrLen) != 0) {
-        mLastError = "Failed to get local address";
-        quiche_config_free(mQuicheCfg);
-        mQuicheCfg = nullptr;
-        ::close(mSock);
-        mSock = -1;
-        freeaddrinfo(peer);
-        return false;
+#if defined(__linux__)
+    mSendBufs = mIoArena->get<uint8_t[SEND_SLOT_SIZE]>(send_bufs);
+    mRecvBufs = mIoArena->get<uint8_t[MAX_RECV_BUF_SIZE]>(recv_bufs);
+    mSendMsgs = mIoArena->get<struct mmsghdr>(send_msgs);
+    mRecvMsgs = mIoArena->get<struct mmsghdr>(recv_msgs);
+    mSendIovs = mIoArena->get<struct iovec>(send_iovs);
+    mRecvIovs = mIoArena->get<struct iovec>(recv_iovs);
+    mSendInfos = mIoArena->get<quiche_send_info>(send_infos);
+    mRecvAddrs = mIoArena->get<struct sockaddr_storage>(recv_addrs);
+
+    // Initialize recv structures (can be reused; a new arena is zeroed, a
+    // pooled one was set up the same way by its previous engine)
+    for (int i = 0; i < BATCH_SIZE; i++) {
+        mRecvIovs[i].iov_base = mRecvBufs[i];
+        mRecvIovs[i].iov_len = MAX_RECV_BUF_SIZE;
+        mRecvMsgs[i].msg_hdr.msg_name = &mRecvAddrs[i];
+        mRecvMsgs[i].msg_hdr.msg_namelen = sizeof(mRecvAddrs[i]);
+        mRecvMsgs[i].msg_hdr.msg_iov = &mRecvIovs[i];
+        mRecvMsgs[i].msg_hdr.msg_iovlen = 1;
     }
+#else
+    mSendBuf = mIoArena->get<uint8_t>(send_buf);
+    mRecvBuf = mIoArena->get<uint8_t>(recv_buf);
+#endif
 
-    // Create QUIC mConnection
-    mConn = quiche_connect(mHost.c_str(), scid, sizeof(scid),
-                         (struct sockaddr*)&mLocalAddr, mLocalAddrLen,
-                         peer->ai_addr, peer->ai_addrlen,
-                         mQuicheCfg);
+    mIoArenaHugePages = mIoArena->hugePages();
+    mIoArenaBytes = mIoArena->mappedSize();
+    return true;
+}
 
-    freeaddrinfo(peer);
+bool QuicheEngineImpl::acquireIoBuffers() {
+    mLastIoNs = monotonicNowNs();
+    if (mIoArena) {
+        return true;
+    }
 
-    if (!mConn) {
-        mLastError = "Failed to create QUIC mConnection";
-        quiche_config_free(mQuicheCfg);
-        mQuicheCfg = nullptr;
-        ::close(mSock);
-        mSock = -1;
+    std::string error;
+    if (!setupIoBuffers(error)) {
+        mLastError = error;
         return false;
     }
-
+    mIoIdleTimer.fire = ioIdleFired;
+    mIoIdleTimer.data = this;
+    mTimers->schedule(&mIoIdleTimer, laxDeadline(mLastIoNs + LOW_MEMORY_IO_IDLE_MS * 1000000ULL));
     return true;
 }
 
-void QuicheEngineImpl::flushEgress() {
-    // No locking needed - called only from event loop thread!
-
-    // Try to use sendmmsg for batch sending if available (Linux only)
+void QuicheEngineImpl::releaseIoBuffers() {
+    mIoArenaPool->release(std::move(mIoArena));
 #if defined(__linux__)
-    // Batch send multiple UDP packets in one syscall
-
-    // Use MSG_NOSIGNAL on Linux/Android to prevent SIGPIPE
-    int flags = 0;
-#ifdef MSG_NOSIGNAL
-    flags |= MSG_NOSIGNAL;
+    mSendBufs = nullptr;
+    mRecvBufs = nullptr;
+    mSendMsgs = nullptr;
+    mRecvMsgs = nullptr;
+    mSendIovs = nullptr;
+    mRecvIovs = nullptr;
+    mSendInfos = nullptr;
+    mRecvAddrs = nullptr;
+#else
+    mSendBuf = nullptr;
+    mRecvBuf = nullptr;
 #endif
+    mIoArenaBytes = 0;
+}
 
-    while (true) {
-        int batch_count = 0;
+void QuicheEngineImpl::ioIdleFired(TimerNode* node) {
+    QuicheEngineImpl* impl = static_cast<QuicheEngineImpl*>(node->data);
 
-        // Collect a batch of packets from quiche
-        for (int i = 0; i < BATCH_SIZE; i++) {
-            ssize_t written = quiche_conn_send(mConn, mSendBufs[i], MAX_DATAGRAM_SIZE, &mSendInfos[i]);
+    // Checked here rather than re-armed on every packet
+    uint64_t idle_until = impl->mLastIoNs + LOW_MEMORY_IO_IDLE_MS * 1000000ULL;
+    if (monotonicNowNs() < idle_until) {
+        impl->mTimers->schedule(&impl->mIoIdleTimer, impl->laxDeadline(idle_until));
+        return;
+    }
+    impl->releaseIoBuffers();
+}
 
-            if (written == QUICHE_ERR_DONE) {
-                break;
-            }
+void QuicheEngineImpl::beginConnect() {
+    std::string error;
+    // Standby profile: buffers are taken with the first packet instead
+    if (!mLowMemory && !mIoArena && !setupIoBuffers(error)) {
+        failConnect(error);
+        return;
+    }
 
-            if (written < 0) {
-                mLastError = "Failed to create packet";
-                return;
-            }
+    if (!mPresetPeers.empty()) {
+        connectTo(mPresetPeers);
+        return;
+    }
 
-            // Setup iovec for this packet
-            mSendIovs[i].iov_base = mSendBufs[i];
-            mSendIovs[i].iov_len = written;
+    std::vector<PeerAddress> peers;
+    uint64_t max_age_ms = getConfigValue(ConfigKey::DNS_CACHE_TTL_MS, static_cast<uint64_t>(60000));
+    if (max_age_ms > 0 &&
+        Resolver::shared().lookup(mHost, mPort, max_age_ms * 1000000ULL, peers)) {
+        connectTo(peers);
+        return;
+    }
 
-            // Setup msghdr for this packet
-            memset(&mSendMsgs[i], 0, sizeof(mSendMsgs[i]));
-            mSendMsgs[i].msg_hdr.msg_name = &mSendInfos[i].to;
-            mSendMsgs[i].msg_hdr.msg_namelen = mSendInfos[i].to_len;
-            mSendMsgs[i].msg_hdr.msg_iov = &mSendIovs[i];
-            mSendMsgs[i].msg_hdr.msg_iovlen = 1;
+    // getaddrinfo() blocks: resolve on the resolver pool, continue on RESOLVED
+    std::shared_ptr<ResolveWaiter> waiter = std::make_shared<ResolveWaiter>(this);
+    mResolveWaiter = waiter;
+    mResolveStartedNs = monotonicNowNs();
+
+    Resolver::shared().resolve(mHost, mPort,
+        [waiter](bool ok, const std::vector<PeerAddress>& result, const std::string& error) {
+            std::lock_guard<std::mutex> lock(waiter->mutex);
+            QuicheEngineImpl* engine = waiter->engine;
+            if (!engine) {
+                return;  // Engine destroyed while resolving
+            }
 
-            batch_count++;
-        }
+            waiter->ok = ok;
+            waiter->peers = result;
+            waiter->error = error;
 
-        // If we have packets to send, send them in a batch
-        if (batch_count > 0) {
-            int sent_count = sendmmsg(mSock, mSendMsgs, batch_count, flags);
-            if (sent_count < 0) {
-                // Ignore send errors for now
-            }
-        }
+            auto* cmd = new Command();
+            cmd->type = CommandType::RESOLVED;
+            engine->mCmdQueue.push(cmd);
+            ev_async_send(engine->mLoop, &engine->mAsyncWatcher);
+        });
+}
 
-        // If we didn't fill the batch, no more packets to send
-        if (batch_count < BATCH_SIZE) {
-            break;
-        }
+void QuicheEngineImpl::onResolved() {
+    std::shared_ptr<ResolveWaiter> waiter;
+    waiter.swap(mResolveWaiter);
+    if (!waiter) {
+        return;  // Closed while resolving
     }
-#else
-    // Fallback to single packet sendmsg for macOS/iOS and other platforms
 
-    // Use MSG_NOSIGNAL on Linux/Android to prevent SIGPIPE
-    int flags = 0;
-#ifdef MSG_NOSIGNAL
-    flags |= MSG_NOSIGNAL;
-#endif
+    bool ok;
+    std::vector<PeerAddress> peers;
+    std::string error;
+    {
+        std::lock_guard<std::mutex> lock(waiter->mutex);
+        ok = waiter->ok;
+        peers.swap(waiter->peers);
+        error = waiter->error;
+        waiter->engine = nullptr;
+    }
 
-    while (true) {
-        quiche_send_info send_info;
-        ssize_t written = quiche_conn_send(mConn, mSendBuf, MAX_DATAGRAM_SIZE, &send_info);
+    mResolveTimeUs.store((monotonicNowNs() - mResolveStartedNs) / 1000);
 
-        if (written == QUICHE_ERR_DONE) {
-            break;
-        }
+    if (!ok) {
+        failConnect(error);
+        return;
+    }
+    connectTo(peers);
+}
 
-        if (written < 0) {
-            mLastError = "Failed to create packet";
-            return;
-        }
+bool QuicheEngineImpl::connectTo(const std::vector<PeerAddress>& peers) {
+    // First address goes ahead; the others race it if it is slow (RFC 8305)
+    memcpy(&mPeerAddr, &peers[0].addr, peers[0].addr_len);
+    mPeerAddrLen = peers[0].addr_len;
 
-        // Use sendmsg for single packet send
-        struct iovec iov;
-        iov.iov_base = mSendBuf;
-        iov.iov_len = written;
+    if (getConfigValue(ConfigKey::ENABLE_HAPPY_EYEBALLS, true)) {
+        mPendingPeers.assign(peers.begin() + 1, peers.end());
+    }
 
-        struct msghdr msg;
-        memset(&msg, 0, sizeof(msg));
-        msg.msg_name = &send_info.to;
-        msg.msg_namelen = send_info.to_len;
-        msg.msg_iov = &iov;
-        msg.msg_iovlen = 1;
+    // Create socket (or join the loop's shared one)
+    if (!openTransport(mPeerAddr.ss_family, mSock, mEndpoint, mLocalAddr, mLocalAddrLen)) {
+        failConnect(mLastError);
+        return false;
+    }
 
-        ssize_t sent = sendmsg(mSock, &msg, flags);
-        if (sent != written) {
-            // Ignore send errors for now
+    // Create QUIC mConnection
+    mConn = newConnection(mLocalAddr, mLocalAddrLen, mPeerAddr, mPeerAddrLen);
+    if (!mConn) {
+        if (mSock >= 0) {
+            ::close(mSock);
+            mSock = -1;
         }
+        mEndpoint = nullptr;
+        failConnect(mLastError);
+        return false;
     }
-#endif
 
-    // Update mTimer
-    uint64_t timeout_ns = quiche_conn_timeout_as_nanos(mConn);
-    if (timeout_ns != UINT64_MAX) {
-        double timeout_sec = (double)timeout_ns / 1000000000.0;
-        ev_timer_stop(mLoop, &mTimer);
-        ev_timer_set(&mTimer, timeout_sec, 0.0);
-        ev_timer_start(mLoop, &mTimer);
+    mConnStartedNs = monotonicNowNs();
+    mConnectAttempts.store(1);
+
+    if (mEndpoint) {
+        mEndpoint->addConnection(mConn, &mRoute);
+    } else {
+        ev_io_set(&mIoWatcher, mSock, EV_READ);
+        ev_io_start(mLoop, &mIoWatcher);
     }
 
-    // Check if mConnection is established
-    if (quiche_conn_is_established(mConn) && !mIsConnected) {
-        mIsConnected = true;
+    // Send initial packet; writes queued meanwhile go out once allowed
+    flushEgress();
+    startRace();
+    return true;
+}
 
-        const uint8_t* app_proto;
-        size_t app_proto_len;
-        quiche_conn_application_proto(mConn, &app_proto, &app_proto_len);
+void QuicheEngineImpl::failConnect(const std::string& error) {
+    mLastError = error;
+    emitEvent(EngineEvent::ERROR, EventData(error));
+    onConnectionClosed();
+    stopLoop();
+}
 
-        if (mEventCallback) {
-            std::string proto(reinterpret_cast<const char*>(app_proto), app_proto_len);
-            EventData data = proto;
-            mEventCallback(nullptr, EngineEvent::CONNECTED, data, mUserData);
-        }
+bool QuicheEngineImpl::openUdpSocket(int family, int& fd, struct sockaddr_storage& local,
+                                     socklen_t& local_len) {
+    fd = socket(family, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        mLastError = "Failed to create socket";
+        return false;
     }
 
+    // Protect against SIGPIPE on macOS/iOS
+#ifdef SO_NOSIGPIPE
+    int set = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &set, sizeof(set)) < 0) {
+        // Non-fatal, just log
+        std::cerr << "Warning: Failed to set SO_NOSIGPIPE" << std::endl;
+    }
+#endif
+
+    // Make mSocket non-blocking
+    if (fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+        mLastError = "Failed to make mSocket non-blocking";
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    // Source address pinned by LOCAL_ADDRESS (port chosen by the OS)
+    std::string local_host = getConfigValue(ConfigKey::LOCAL_ADDRESS, std::string());
+    if (!local_host.empty() && !bindLocalAddress(fd, family, local_host)) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    // Get local address
+    local_len = sizeof(local);
+    if (getsockname(fd, (struct sockaddr*)&local, &local_len) != 0) {
+        mLastError = "Failed to get local address";
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    return true;
+}
+
+bool QuicheEngineImpl::bindLocalAddress(int fd, int family, const std::string& local_host) {
+    struct addrinfo hints = {};
+    hints.ai_family = family;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_protocol = IPPROTO_UDP;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST;
+
+    // Numeric only: this runs on the loop thread
+    struct addrinfo* local;
+    if (getaddrinfo(local_host.c_str(), "0", &hints, &local) != 0) {
+        mLastError = "LOCAL_ADDRESS " + local_host + " is not a numeric address of the peer's family";
+        return false;
+    }
+
+    int rc = bind(fd, local->ai_addr, local->ai_addrlen);
+    freeaddrinfo(local);
+    if (rc < 0) {
+        mLastError = "Failed to bind to LOCAL_ADDRESS " + local_host + ": " + strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool QuicheEngineImpl::openTransport(int family, int& fd, UdpEndpoint*& endpoint,
+                                     struct sockaddr_storage& local, socklen_t& local_len) {
+    endpoint = nullptr;
+    if (!mShareSocket) {
+        return openUdpSocket(family, fd, local, local_len);
+    }
+
+    UdpEndpoint& shared = mEventLoop->endpoint(family);
+    if (!shared.isOpen() &&
+        !shared.open(mLoop, family, LOCAL_CONN_ID_LEN, MAX_DATAGRAM_SIZE, MAX_RECV_BUF_SIZE,
+                     ioArenaOptionsFromConfig(mConfig), mLastError)) {
+        return false;
+    }
+
+    fd = -1;
+    endpoint = &shared;
+    memcpy(&local, &shared.localAddr(), shared.localAddrLen());
+    local_len = shared.localAddrLen();
+    return true;
+}
+
+quiche_conn* QuicheEngineImpl::newConnection(const struct sockaddr_storage& local, socklen_t local_len,
+                                             const struct sockaddr_storage& peer, socklen_t peer_len) {
+    // Generate mConnection ID
+    uint8_t scid[LOCAL_CONN_ID_LEN];
+    if (!generateConnectionId(scid, sizeof(scid))) {
+        mLastError = "Failed to generate mConnection ID";
+        return nullptr;
+    }
+
+    EngineConfigImpl* conn_config = mEngineConfig->impl();
+    quiche_conn* conn = conn_config->connect(mHost.c_str(), scid, sizeof(scid),
+                                             (const struct sockaddr*)&local, local_len,
+                                             (const struct sockaddr*)&peer, peer_len);
+    if (!conn) {
+        mLastError = "Failed to create QUIC mConnection";
+        return nullptr;
+    }
+
+    // A shared config carries its own idle timeout; ours overrides it locally
+    if (mIdleTimeoutMs != conn_config->getConfigValue(ConfigKey::MAX_IDLE_TIMEOUT, static_cast<uint64_t>(5000))) {
+        quiche_conn_set_max_idle_timeout(conn, mIdleTimeoutMs);
+    }
+
+    // Offer a cached session ticket; a stale one just falls back to a full handshake
+    if (mSessionCache) {
+        std::string session;
+        if (mSessionCache->load(sessionKey(), session) &&
+            quiche_conn_set_session(conn, reinterpret_cast<const uint8_t*>(session.data()),
+                                    session.size()) < 0) {
+            mSessionCache->remove(sessionKey());
+        }
+    }
+
+    return conn;
+}
+
+void QuicheEngineImpl::flushEgress() {
+    // Callbacks of this pass that write only flag mFlushPending: a second
+    // pass sends all of it. Anything still pending after that (the
+    // callbacks keep writing) goes out on the next loop iteration.
+    bool outer = !mInFlush;
+    mInFlush = true;
+    mFlushPending = false;
+    flushEgressOnce();
+    if (outer && mFlushPending && mConn) {
+        mFlushPending = false;
+        flushEgressOnce();
+    }
+    if (outer) {
+        mInFlush = false;
+        if (mFlushPending && mWatchersAttached) {
+            ev_async_send(mLoop, &mAsyncWatcher);
+        }
+        releaseDeadlines();
+        snapshotConnStats();
+    }
+}
+
+void QuicheEngineImpl::releaseDeadlines() {
+    if (!mConn || mStreamDeadlines.empty()) {
+        return;
+    }
+
+    // Streams delivered in time need no reset; their heap entries go stale
+    for (auto it = mStreamDeadlines.begin(); it != mStreamDeadlines.end();) {
+        if (mScheduler.queuedBytes(it->first) == 0 &&
+            quiche_conn_stream_send_complete(mConn, it->first)) {
+            it = mStreamDeadlines.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void QuicheEngineImpl::snapshotConnStats() {
+    if (!mConn) {
+        return;
+    }
+
+    EngineStats stats = {};
+    fillConnectionStats(mConn, stats);
+    stats.early_data_bytes = mEarlyDataBytes;
+
+    std::lock_guard<std::mutex> lock(mConnStatsMutex);
+    mConnStats = stats;
+}
+
+void QuicheEngineImpl::flushEgressOnce() {
+    // No locking needed - called only from event loop thread!
+
+    // Open streams for waiting calls, then move queued stream data into
+    // quiche before building packets
+    startQueuedCalls();
+    runScheduler();
+
+    bool sent = mEndpoint ? sendToEndpoint() : sendPackets();
+    if (!sent) {
+        return;
+    }
+
+    // Update mTimer (quiche timers and rate-limited sends share it;
+    // quiche_conn_on_timeout() ignores early wakeups)
+    uint64_t timeout_ns = quiche_conn_timeout_as_nanos(mConn);
+    if (mWatchersAttached) {
+        uint64_t now_ns = monotonicNowNs();
+        uint64_t deadline_ns = timeout_ns == UINT64_MAX ? 0 : now_ns + timeout_ns;
+        if (mSchedulerWakeupNs != 0 && (deadline_ns == 0 || mSchedulerWakeupNs < deadline_ns)) {
+            deadline_ns = mSchedulerWakeupNs;
+        }
+
+        // Far-off timeouts (idle timeout, long PTOs) do not need to be exact
+        if (deadline_ns > now_ns && deadline_ns - now_ns >= POWER_SAVE_LAX_TIMEOUT_NS) {
+            deadline_ns = laxDeadline(deadline_ns);
+        }
+
+        // An unchanged deadline (the common case per packet) stays in its wheel slot
+        if (deadline_ns == 0) {
+            mTimers->cancel(&mTimer);
+        } else {
+            mTimers->schedule(&mTimer, deadline_ns);
+        }
+    }
+
+    // Check if mConnection is established
+    if (quiche_conn_is_established(mConn) && !mIsConnected) {
+        mIsConnected = true;
+
+        // mConn won the race - the other attempts are no longer needed
+        recordConnectTime(mPeerAddr.ss_family, mConnStartedNs);
+        abandonAttempts();
+
+        const uint8_t* app_proto;
+        size_t app_proto_len;
+        quiche_conn_application_proto(mConn, &app_proto, &app_proto_len);
+
+        std::string proto(reinterpret_cast<const char*>(app_proto), app_proto_len);
+        emitEvent(EngineEvent::CONNECTED, EventData(proto));
+
+        // Spare connection IDs let either side move to a new path later
+        if (!mEngineConfig->impl()->getConfigValue(ConfigKey::DISABLE_ACTIVE_MIGRATION, true)) {
+            issueSourceConnectionIds();
+        }
+    }
+
+    // Path validation results and peer address changes
+    processPathEvents();
+
     // Check for readable streams and populate buffers
     if (mConn) {
         quiche_stream_iter* readable = quiche_conn_readable(mConn);
         uint64_t stream_id;
         while (quiche_stream_iter_next(readable, &stream_id)) {
-            // Read data from quiche into buffer (event loop thread only!)
-            readFromQuicheToBuffer(stream_id);
+            // Responses to call() complete their future instead
+            if (!mRpcActive.empty() && readCallResponse(stream_id)) {
+                continue;
+            }
 
-            // Notify application
-            if (mEventCallback) {
-                EventData data = stream_id;
-                mEventCallback(mWrapper, EngineEvent::STREAM_READABLE, data, mUserData);
+            // Read data from quiche into buffer (event loop thread only!).
+            // External loop: readStream() pulls straight from quiche instead
+            if (!mExternalLoop) {
+                readFromQuicheToBuffer(stream_id);
             }
+
+            // Notify application
+            emitEvent(EngineEvent::STREAM_READABLE, EventData(stream_id));
         }
         quiche_stream_iter_free(readable);
     }
 }
 
+bool QuicheEngineImpl::sendPackets() {
+    if (mLowMemory && !acquireIoBuffers()) {
+        return false;
+    }
+
+    // Try to use sendmmsg for batch sending if available (Linux only)
+#if defined(__linux__)
+    // Batch send multiple UDP packets in one syscall
+
+    // Use MSG_NOSIGNAL on Linux/Android to prevent SIGPIPE
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags |= MSG_NOSIGNAL;
+#endif
+
+    while (true) {
+        int batch_count = 0;
+
+        // Collect a batch of packets from quiche
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            ssize_t written = quiche_conn_send(mConn, mSendBufs[i], MAX_DATAGRAM_SIZE, &mSendInfos[i]);
+
+            if (written == QUICHE_ERR_DONE) {
+                break;
+            }
+
+            if (written < 0) {
+                mLastError = "Failed to create packet";
+                return false;
+            }
+
+            // Setup iovec for this packet
+            mSendIovs[i].iov_base = mSendBufs[i];
+            mSendIovs[i].iov_len = written;
+
+            // Setup msghdr for this packet
+            memset(&mSendMsgs[i], 0, sizeof(mSendMsgs[i]));
+            mSendMsgs[i].msg_hdr.msg_name = &mSendInfos[i].to;
+            mSendMsgs[i].msg_hdr.msg_namelen = mSendInfos[i].to_len;
+            mSendMsgs[i].msg_hdr.msg_iov = &mSendIovs[i];
+            mSendMsgs[i].msg_hdr.msg_iovlen = 1;
+
+            batch_count++;
+        }
+
+        // If we have packets to send, send them in a batch
+        // (one sendmmsg per run of packets leaving from the same local address)
+        int run_start = 0;
+        while (run_start < batch_count) {
+            int sock = socketForAddress(&mSendInfos[run_start].from, mSendInfos[run_start].from_len);
+            int run_end = run_start + 1;
+            while (run_end < batch_count &&
+                   socketForAddress(&mSendInfos[run_end].from, mSendInfos[run_end].from_len) == sock) {
+                run_end++;
+            }
+
+            int sent_count = sendmmsg(sock, &mSendMsgs[run_start], run_end - run_start, flags);
+            if (sent_count < 0) {
+                // Ignore send errors for now
+            }
+            run_start = run_end;
+        }
+
+        // If we didn't fill the batch, no more packets to send
+        if (batch_count < BATCH_SIZE) {
+            break;
+        }
+    }
+#else
+    // Fallback to single packet sendmsg for macOS/iOS and other platforms
+
+    // Use MSG_NOSIGNAL on Linux/Android to prevent SIGPIPE
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags |= MSG_NOSIGNAL;
+#endif
+
+    while (true) {
+        quiche_send_info send_info;
+        ssize_t written = quiche_conn_send(mConn, mSendBuf, MAX_DATAGRAM_SIZE, &send_info);
+
+        if (written == QUICHE_ERR_DONE) {
+            break;
+        }
+
+        if (written < 0) {
+            mLastError = "Failed to create packet";
+            return false;
+        }
+
+        // Use sendmsg for single packet send
+        struct iovec iov;
+        iov.iov_base = mSendBuf;
+        iov.iov_len = written;
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &send_info.to;
+        msg.msg_namelen = send_info.to_len;
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+
+        ssize_t sent = sendmsg(socketForAddress(&send_info.from, send_info.from_len), &msg, flags);
+        if (sent != written) {
+            // Ignore send errors for now
+        }
+    }
+#endif
+
+    return true;
+}
+
+bool QuicheEngineImpl::sendToEndpoint() {
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags |= MSG_NOSIGNAL;
+#endif
+
+    // Built in place in the endpoint's batch, sent with the other
+    // connections' packets before the loop blocks
+    while (true) {
+        uint8_t* slot = mEndpoint->sendSlot();
+        quiche_send_info send_info;
+        ssize_t written = quiche_conn_send(mConn, slot, MAX_DATAGRAM_SIZE, &send_info);
+
+        if (written == QUICHE_ERR_DONE) {
+            break;
+        }
+
+        if (written < 0) {
+            mLastError = "Failed to create packet";
+            return false;
+        }
+
+        // Probed and migrated paths keep their own sockets
+        int sock = socketForAddress(&send_info.from, send_info.from_len);
+        if (sock >= 0) {
+            if (sendto(sock, slot, written, flags,
+                       (const struct sockaddr*)&send_info.to, send_info.to_len) != written) {
+                // Ignore send errors, loss recovery retransmits
+            }
+            continue;
+        }
+
+        mEndpoint->commitSendSlot(written, &send_info.to, send_info.to_len);
+    }
+    return true;
+}
+
 void QuicheEngineImpl::recvCallback(EV_P_ ev_io* w, int revents) {
     (void)EV_A;
     (void)revents;
 
     QuicheEngineImpl* impl = static_cast<QuicheEngineImpl*>(w->data);
 
+    impl->mLastRecvNs = monotonicNowNs();
+    impl->receivePackets(impl->mConn, impl->mSock, &impl->mLocalAddr, impl->mLocalAddrLen);
+    impl->afterIngress();
+}
+
+void QuicheEngineImpl::pathRecvCallback(EV_P_ ev_io* w, int revents) {
+    (void)EV_A;
+    (void)revents;
+
+    PathSocket* path = static_cast<PathSocket*>(w->data);
+    QuicheEngineImpl* impl = path->engine;
+
+    impl->mLastRecvNs = monotonicNowNs();
+    impl->receivePackets(impl->mConn, path->fd, &path->local_addr, path->local_addr_len);
+    impl->afterIngress();
+}
+
+void QuicheEngineImpl::endpointDeliver(EndpointRoute* route, uint8_t* buf, size_t len,
+                                       const struct sockaddr_storage* from, socklen_t from_len) {
+    QuicheEngineImpl* impl = static_cast<QuicheEngineImpl*>(route->data);
+
+    impl->mLastRecvNs = monotonicNowNs();
+    quiche_recv_info recv_info = {
+        (struct sockaddr*)from,
+        from_len,
+        (struct sockaddr*)&impl->mLocalAddr,
+        impl->mLocalAddrLen,
+    };
+    if (quiche_conn_recv(impl->mConn, buf, len, &recv_info) < 0) {
+        // Ignore receive errors for this packet
+    }
+}
+
+void QuicheEngineImpl::endpointDrained(EndpointRoute* route) {
+    static_cast<QuicheEngineImpl*>(route->data)->afterIngress();
+}
+
+void QuicheEngineImpl::receivePackets(quiche_conn* conn, int sock,
+                                      const struct sockaddr_storage* local_addr,
+                                      socklen_t local_addr_len) {
+    if (mLowMemory && !acquireIoBuffers()) {
+        return;
+    }
+
     // Try to use recvmmsg for batch receiving if available (Linux only)
 #if defined(__linux__)
     // Batch receive multiple UDP packets in one syscall
@@ -509,33 +1115,33 @@ void QuicheEngineImpl::recvCallback(EV_P_ ev_io* w, int revents) {
     while (true) {
         // Reset msg_namelen for each batch
         for (int i = 0; i < BATCH_SIZE; i++) {
-            impl->mRecvMsgs[i].msg_hdr.msg_namelen = sizeof(impl->mRecvAddrs[i]);
+            mRecvMsgs[i].msg_hdr.msg_namelen = sizeof(mRecvAddrs[i]);
         }
 
         // Receive multiple packets at once
-        int num_msgs = recvmmsg(impl->mSock, impl->mRecvMsgs, BATCH_SIZE, 0, nullptr);
+        int num_msgs = recvmmsg(sock, mRecvMsgs, BATCH_SIZE, 0, nullptr);
 
         if (num_msgs < 0) {
             if (errno == EWOULDBLOCK || errno == EAGAIN) {
                 break;
             }
-            impl->mLastError = "Failed to receive packets";
+            mLastError = "Failed to receive packets";
             break;
         }
 
         // Process each received packet
         for (int i = 0; i < num_msgs; i++) {
-            ssize_t len = impl->mRecvMsgs[i].msg_len;
+            ssize_t len = mRecvMsgs[i].msg_len;
 
             quiche_recv_info recv_info = {
-                (struct sockaddr*)&impl->mRecvAddrs[i],
-                impl->mRecvMsgs[i].msg_hdr.msg_namelen,
-                (struct sockaddr*)&impl->mLocalAddr,
-                impl->mLocalAddrLen,
+                (struct sockaddr*)&mRecvAddrs[i],
+                mRecvMsgs[i].msg_hdr.msg_namelen,
+                (struct sockaddr*)local_addr,
+                local_addr_len,
             };
 
             // No locking needed - called only from event loop thread!
-            ssize_t done = quiche_conn_recv(impl->mConn, impl->mRecvBufs[i], len, &recv_info);
+            ssize_t done = quiche_conn_recv(conn, mRecvBufs[i], len, &recv_info);
 
             if (done < 0) {
                 // Ignore receive errors for this packet
@@ -551,84 +1157,87 @@ void QuicheEngineImpl::recvCallback(EV_P_ ev_io* w, int revents) {
     // Fallback to single packet recvmsg for macOS/iOS and other platforms
 
     while (true) {
-        struct sockaddr_storage mPeerAddr;
-        socklen_t mPeerAddrLen = sizeof(mPeerAddr);
+        struct sockaddr_storage peer_addr;
+        socklen_t peer_addr_len = sizeof(peer_addr);
 
         // Use recvmsg for single packet receive
         struct iovec iov;
-        iov.iov_base = impl->mRecvBuf;
+        iov.iov_base = mRecvBuf;
         iov.iov_len = MAX_RECV_BUF_SIZE;
 
         struct msghdr msg;
         memset(&msg, 0, sizeof(msg));
-        msg.msg_name = &mPeerAddr;
-        msg.msg_namelen = sizeof(mPeerAddr);
+        msg.msg_name = &peer_addr;
+        msg.msg_namelen = sizeof(peer_addr);
         msg.msg_iov = &iov;
         msg.msg_iovlen = 1;
 
-        ssize_t len = recvmsg(impl->mSock, &msg, 0);
+        ssize_t len = recvmsg(sock, &msg, 0);
 
         if (len < 0) {
             if (errno == EWOULDBLOCK || errno == EAGAIN) {
                 break;
             }
-            impl->mLastError = "Failed to receive packet";
+            mLastError = "Failed to receive packet";
             break;
         }
 
-        // Update mPeerAddrLen from msg.msg_namelen
-        mPeerAddrLen = msg.msg_namelen;
+        // Update peer_addr_len from msg.msg_namelen
+        peer_addr_len = msg.msg_namelen;
 
         quiche_recv_info recv_info = {
-            (struct sockaddr*)&mPeerAddr,
-            mPeerAddrLen,
-            (struct sockaddr*)&impl->mLocalAddr,
-            impl->mLocalAddrLen,
+            (struct sockaddr*)&peer_addr,
+            peer_addr_len,
+            (struct sockaddr*)local_addr,
+            local_addr_len,
         };
 
         // No locking needed - called only from event loop thread!
-        ssize_t done = quiche_conn_recv(impl->mConn, impl->mRecvBuf, len, &recv_info);
+        ssize_t done = quiche_conn_recv(conn, mRecvBuf, len, &recv_info);
 
         if (done < 0) {
             // Ignore receive errors
         }
     }
 #endif
+}
 
-    impl->flushEgress();
+void QuicheEngineImpl::afterIngress() {
+    flushEgress();
 
     // No locking needed - called only from event loop thread!
-    bool is_closed = quiche_conn_is_closed(impl->mConn);
+    bool is_closed = quiche_conn_is_closed(mConn);
 
-    if (is_closed) {
-        if (impl->mEventCallback) {
-            EventData data;  // Default to NONE type
-            impl->mEventCallback(nullptr, EngineEvent::CONNECTION_CLOSED, data, impl->mUserData);
-        }
-        ev_break(EV_A_ EVBREAK_ONE);
+    // Handshake failed: carry on with a racing attempt or the next address
+    if (is_closed && !mIsConnected && failOver()) {
+        return;
     }
-}
 
-void QuicheEngineImpl::timeoutCallback(EV_P_ ev_timer* w, int revents) {
-    (void)revents;
+    if (is_closed) {
+        onConnectionClosed();
+        stopLoop();
+        return;
+    }
 
-    QuicheEngineImpl* impl = static_cast<QuicheEngineImpl*>(w->data);
+    scheduleKeepAlive();
+}
+
+void QuicheEngineImpl::timerFired(TimerNode* node) {
+    QuicheEngineImpl* impl = static_cast<QuicheEngineImpl*>(node->data);
 
     // No locking needed - called only from event loop thread!
     quiche_conn_on_timeout(impl->mConn);
 
-    impl->flushEgress();
+    impl->afterIngress();
+}
 
-    // No locking needed - called only from event loop thread!
-    bool is_closed = quiche_conn_is_closed(impl->mConn);
+void QuicheEngineImpl::onConnectionClosed() {
+    // Keep the newest ticket (NewSessionTicket arrives after the handshake)
+    saveSession();
 
-    if (is_closed) {
-        if (impl->mEventCallback) {
-            EventData data;  // Default to NONE type
-            impl->mEventCallback(nullptr, EngineEvent::CONNECTION_CLOSED, data, impl->mUserData);
-        }
-        ev_break(EV_A_ EVBREAK_ONE);
-    }
+    failCalls("Connection closed");
+
+    emitEvent(EngineEvent::CONNECTION_CLOSED, EventData());
 }
 
 void QuicheEngineImpl::asyncCallback(EV_P_ ev_async* w, int revents) {
@@ -640,53 +1249,1102 @@ void QuicheEngineImpl::asyncCallback(EV_P_ ev_async* w, int revents) {
 }
 
 void QuicheEngineImpl::processCommands() {
+    bool need_flush = false;
+    size_t processed = 0;
+
     Command* cmd;
     while ((cmd = mCmdQueue.pop()) != nullptr) {
-        switch (cmd->type) {
-            case CommandType::WRITE: {
-                // No locking needed - called only from event loop thread!
-                if (mConn) {
-                    uint64_t error_code;
-                    ssize_t written = quiche_conn_stream_send(
-                        mConn,
-                        cmd->params.write.stream_id,
-                        cmd->params.write.data,
-                        cmd->params.write.len,
-                        cmd->params.write.fin,
-                        &error_code
-                    );
-
-                    if (written < 0) {
-                        std::cerr << "[ENGINE] Write failed: error_code=" << error_code << std::endl;
+        runCommand(cmd, need_flush);
+        processed++;
+    }
+
+    // Power save: writes arriving within the next slack window are
+    // collected by one timer instead of each waking the loop
+    if (mSlackNs != 0 && mWatchersAttached) {
+        if (processed > 0) {
+            uint64_t hold_ns = laxDeadline(monotonicNowNs() + mSlackNs);
+            mCommandHoldNs.store(hold_ns);
+            mCommandTimer.fire = commandTimerFired;
+            mCommandTimer.data = this;
+            mTimers->schedule(&mCommandTimer, hold_ns);
+        } else {
+            mCommandHoldNs.store(0);
+        }
+    }
+
+    // One egress pass for all writes drained from the queue (and for
+    // inline writes a callback left behind)
+    if ((need_flush || mFlushPending) && mConn) {
+        flushEgress();
+    }
+}
+
+void QuicheEngineImpl::submitCommand(Command* cmd) {
+    if (onLoopThread()) {
+        // Caller is on the loop thread: no queue, no wakeup
+        bool need_flush = false;
+        runCommand(cmd, need_flush);
+        if (need_flush) {
+            requestFlush();
+        }
+        return;
+    }
+
+    queueCommand(cmd);
+}
+
+void QuicheEngineImpl::queueCommand(Command* cmd) {
+    // Data commands may wait for the loop's command timer (power save);
+    // pushed before the check, so the timer finds it
+    bool lax = cmd->type == CommandType::WRITE || cmd->type == CommandType::STREAM_READ;
+    mCmdQueue.push(cmd);
+
+    if (lax && mSlackNs != 0 && monotonicNowNs() < mCommandHoldNs.load()) {
+        return;
+    }
+
+    if (mLoop) {
+        ev_async_send(mLoop, &mAsyncWatcher);
+    }
+}
+
+void QuicheEngineImpl::commandTimerFired(TimerNode* node) {
+    // Holds commands submitted up to now; re-arms while they keep coming
+    static_cast<QuicheEngineImpl*>(node->data)->processCommands();
+}
+
+bool QuicheEngineImpl::onLoopThread() const {
+    if (mExternalLoop) {
+        return true;  // The API is called from the caller's loop thread
+    }
+    if (mEventLoop) {
+        // Until attached, commands wait in the queue behind CONNECT
+        return mEventLoop->isInLoopThread() && mWatchersAttached;
+    }
+    return std::this_thread::get_id() == mLoopThreadId.load();
+}
+
+void QuicheEngineImpl::requestFlush() {
+    // Inside a callback: once, after it returned. Elsewhere on the loop
+    // thread (a coroutine resumed there, a task of the caller's loop): on
+    // the next loop iteration, as flushing here would run this engine's
+    // callbacks from inside the caller's write or read
+    mFlushPending = true;
+    if (mCallbackDepth > 0 || mInFlush) {
+        return;
+    }
+    if (mWatchersAttached) {
+        ev_async_send(mLoop, &mAsyncWatcher);
+    }
+}
+
+void QuicheEngineImpl::afterCallback() {
+    // Within flushEgress() its second pass picks the writes up
+    if (mCallbackDepth == 0 && !mInFlush && mFlushPending && mConn) {
+        flushEgress();
+    }
+}
+
+void QuicheEngineImpl::claimStreamId(uint64_t stream_id) {
+    // Streams the application picked itself are not handed out again
+    if ((stream_id & 0x3) == 0) {
+        uint64_t next = mNextStreamId.load();
+        while (stream_id >= next && !mNextStreamId.compare_exchange_weak(next, stream_id + 4)) {
+        }
+    }
+}
+
+ssize_t QuicheEngineImpl::sendInline(uint64_t stream_id, const uint8_t* data, size_t len, bool fin,
+                                     bool& complete) {
+    static const uint8_t kEmpty = 0;  // quiche wants a valid pointer for FIN-only sends
+
+    // Only where the scheduler would send the same bytes right away
+    complete = false;
+    if (!mConn || !quiche_conn_is_established(mConn) || !mScheduler.canBypass(stream_id)) {
+        return 0;
+    }
+
+    claimStreamId(stream_id);
+
+    uint64_t error_code;
+    ssize_t written = quiche_conn_stream_send(mConn, stream_id, len > 0 ? data : &kEmpty,
+                                              len, fin, &error_code);
+    if (written == QUICHE_ERR_DONE) {
+        return 0;  // No capacity: queue all of it
+    }
+    if (written < 0) {
+        mLastError = "Failed to write stream " + std::to_string(stream_id) +
+                     " (error " + std::to_string(written) + ")";
+        return -1;
+    }
+
+    complete = static_cast<size_t>(written) == len;
+    requestFlush();
+    return written;
+}
+
+void QuicheEngineImpl::runCommand(Command* cmd, bool& need_flush) {
+    switch (cmd->type) {
+        case CommandType::CONNECT: {
+            beginConnect();
+            break;
+        }
+
+        case CommandType::RESOLVED: {
+            onResolved();
+            break;
+        }
+
+        case CommandType::WRITE: {
+            uint64_t stream_id = cmd->params.write.stream_id;
+            claimStreamId(stream_id);
+
+            // Latest deadline of the stream; earlier heap entries go stale
+            if (cmd->params.write.deadline_ns != 0) {
+                mStreamDeadlines[stream_id] = cmd->params.write.deadline_ns;
+                mDeadlines.push(DeadlineEntry(cmd->params.write.deadline_ns, stream_id));
+                armDeadlineTimer();
+            }
+
+            // No locking needed - called only from event loop thread!
+            // The scheduler owns the command until quiche accepted all of it;
+            // writes made while resolving go out once the connection exists
+            size_t len = cmd->params.write.len;
+            mScheduler.enqueue(cmd);
+            cmd = nullptr;
+            need_flush = true;
+
+            // Counted by the scheduler mirror before it leaves the command
+            // count, so send_queue_bytes never dips to 0 in between
+            mSendQueueBytes.store(mScheduler.queuedBytes());
+            mWriteCmdBytes.fetch_sub(len);
+            mWriteCmds.fetch_sub(1);
+            break;
+        }
+
+        case CommandType::STREAM_SCHEDULE: {
+            mScheduler.setStreamParams(cmd->params.schedule.stream_id,
+                                       cmd->params.schedule.weight,
+                                       cmd->params.schedule.max_rate,
+                                       cmd->params.schedule.burst,
+                                       monotonicNowNs());
+            need_flush = true;
+            break;
+        }
+
+        case CommandType::CLOSE: {
+            // No locking needed - called only from event loop thread!
+            abandonAttempts();
+            if (mConn) {
+                // Hand over what capacity allows; the rest dies with the connection
+                runScheduler();
+                saveSession();
+                quiche_conn_close(
+                    mConn,
+                    true,
+                    cmd->params.close.error_code,
+                    reinterpret_cast<const uint8_t*>(cmd->params.close.reason),
+                    strlen(cmd->params.close.reason)
+                );
+                flushEgress();
+                need_flush = false;
+            } else if (mResolveWaiter) {
+                // Closed before the lookup finished: nothing was sent yet
+                {
+                    std::lock_guard<std::mutex> lock(mResolveWaiter->mutex);
+                    mResolveWaiter->engine = nullptr;
+                }
+                mResolveWaiter.reset();
+                onConnectionClosed();
+                stopLoop();
+            }
+            break;
+        }
+
+        case CommandType::STOP: {
+            stopLoop();
+            break;
+        }
+
+        case CommandType::SET_IDLE_TIMEOUT: {
+            applyIdleTimeout(cmd->params.idle.timeout_ms);
+            need_flush = true;
+            break;
+        }
+
+        case CommandType::PROBE_PATH: {
+            if (mConn) {
+                openPathSocket(cmd->params.path);
+                flushEgress();
+            }
+            break;
+        }
+
+        case CommandType::MIGRATE: {
+            if (mConn) {
+                migrateToValidatedPath();
+                flushEgress();
+            }
+            break;
+        }
+
+        case CommandType::RPC_CALL: {
+            if (mConn && quiche_conn_is_closed(mConn)) {
+                mRpcQueuedCount--;
+                finishCall(cmd->params.rpc.call, "Connection closed");
+                break;
+            }
+            // Started by flushEgress() once a stream is available
+            mRpcQueued.push_back(cmd->params.rpc.call);
+            need_flush = true;
+            break;
+        }
+
+        case CommandType::STREAM_READ: {
+            // Reading frees flow control credit: flush the window update
+            uint64_t stream_id = cmd->params.read.stream_id;
+            if (mConn && readFromQuicheToBuffer(stream_id) > 0) {
+                emitEvent(EngineEvent::STREAM_READABLE, EventData(stream_id));
+                need_flush = true;
+            }
+            break;
+        }
+    }
+
+    delete cmd;
+}
+
+// ============================================================================
+// Idle Timeout and Keep-Alive (event loop thread only)
+// ============================================================================
+
+void QuicheEngineImpl::applyIdleTimeout(uint64_t timeout_ms) {
+    mIdleTimeoutMs = timeout_ms;
+
+    // Racing attempts too, whichever of them wins
+    if (mConn) {
+        quiche_conn_set_max_idle_timeout(mConn, timeout_ms);
+    }
+    for (ConnectAttempt* a : mAttempts) {
+        quiche_conn_set_max_idle_timeout(a->conn, timeout_ms);
+    }
+
+    if (mIsConnected) {
+        scheduleKeepAlive();
+    }
+}
+
+uint64_t QuicheEngineImpl::effectiveIdleTimeoutNs() const {
+    // Like quiche: the smaller of both sides' non-zero values
+    uint64_t idle_ms = mIdleTimeoutMs;
+    quiche_transport_params peer;
+    if (mConn && quiche_conn_peer_transport_params(mConn, &peer) &&
+        peer.peer_max_idle_timeout > 0 &&
+        (idle_ms == 0 || peer.peer_max_idle_timeout < idle_ms)) {
+        idle_ms = peer.peer_max_idle_timeout;
+    }
+    return idle_ms * 1000000ULL;
+}
+
+void QuicheEngineImpl::scheduleKeepAlive() {
+    if (mKeepAliveBaseNs == 0 || !mIsConnected || !mConn) {
+        return;
+    }
+
+    mKeepAliveTimer.fire = keepAliveFired;
+    mKeepAliveTimer.data = this;
+
+    // Quiet time allowed: the adaptive interval, but always well before the
+    // idle deadline (a lost PING still gets a PTO retransmit in time)
+    uint64_t quiet_ns = mKeepAliveIntervalNs;
+    uint64_t idle_ns = effectiveIdleTimeoutNs();
+    if (idle_ns > 0 && quiet_ns > idle_ns / 10 * 7) {
+        quiet_ns = idle_ns / 10 * 7;
+    }
+
+    // Up to 10% earlier, so connections opened together do not ping together
+    mJitterState ^= mJitterState << 13;
+    mJitterState ^= mJitterState >> 17;
+    mJitterState ^= mJitterState << 5;
+    quiet_ns -= (quiet_ns / 10) * (mJitterState % 1024) / 1024;
+
+    uint64_t last = mLastRecvNs > mLastKeepAliveNs ? mLastRecvNs : mLastKeepAliveNs;
+    mTimers->schedule(&mKeepAliveTimer, laxDeadline(last + quiet_ns));
+}
+
+void QuicheEngineImpl::onNatRebinding() {
+    // The mapping did not last as long as our interval: ping twice as often
+    uint64_t floor_ns = MIN_KEEP_ALIVE_MS * 1000000ULL;
+    if (mKeepAliveIntervalNs > floor_ns) {
+        mKeepAliveIntervalNs = mKeepAliveIntervalNs / 2 > floor_ns ? mKeepAliveIntervalNs / 2 : floor_ns;
+        mKeepAliveIntervalMs.store(mKeepAliveIntervalNs / 1000000ULL);
+    }
+    mKeepAliveAnswered = 0;
+}
+
+void QuicheEngineImpl::keepAliveFired(TimerNode* node) {
+    QuicheEngineImpl* impl = static_cast<QuicheEngineImpl*>(node->data);
+    if (!impl->mConn || !impl->mIsConnected || quiche_conn_is_closed(impl->mConn)) {
+        return;
+    }
+
+    if (impl->mLastKeepAliveNs != 0) {
+        if (impl->mLastRecvNs < impl->mLastKeepAliveNs) {
+            // Nothing came back since the previous PING: treat the path as
+            // silently remapped, like a peer-visible rebinding
+            impl->onNatRebinding();
+        } else if (++impl->mKeepAliveAnswered >= 4 &&
+                   impl->mKeepAliveIntervalNs < impl->mKeepAliveBaseNs) {
+            // Stable for a while: creep back towards the configured interval
+            uint64_t grown = impl->mKeepAliveIntervalNs / 4 * 5;
+            impl->mKeepAliveIntervalNs = grown < impl->mKeepAliveBaseNs ? grown : impl->mKeepAliveBaseNs;
+            impl->mKeepAliveIntervalMs.store(impl->mKeepAliveIntervalNs / 1000000ULL);
+            impl->mKeepAliveAnswered = 0;
+        }
+    }
+
+    if (quiche_conn_send_ack_eliciting(impl->mConn) >= 0) {
+        impl->mLastKeepAliveNs = monotonicNowNs();
+        impl->mKeepAlivesSent++;
+    }
+
+    impl->flushEgress();
+    impl->scheduleKeepAlive();
+}
+
+// ============================================================================
+// Happy Eyeballs Connection Racing (event loop thread only)
+// ============================================================================
+
+void QuicheEngineImpl::startRace() {
+    mRaceTimer.fire = raceTimerFired;
+    mRaceTimer.data = this;
+
+    if (!mPendingPeers.empty() && !mIsConnected) {
+        mTimers->schedule(&mRaceTimer, monotonicNowNs() + mAttemptDelayNs);
+    }
+}
+
+ConnectAttempt* QuicheEngineImpl::startAttempt() {
+    while (!mPendingPeers.empty()) {
+        PeerAddress peer = mPendingPeers.front();
+        mPendingPeers.pop_front();
+
+        ConnectAttempt* a = new ConnectAttempt();
+        a->engine = this;
+        memcpy(&a->peer_addr, &peer.addr, peer.addr_len);
+        a->peer_addr_len = peer.addr_len;
+
+        if (!openTransport(peer.addr.ss_family, a->fd, a->endpoint,
+                           a->local_addr, a->local_addr_len)) {
+            delete a;
+            continue;  // e.g. no IPv6 on this host - try the next address
+        }
+
+        a->conn = newConnection(a->local_addr, a->local_addr_len, a->peer_addr, a->peer_addr_len);
+        if (!a->conn) {
+            if (a->fd >= 0) {
+                ::close(a->fd);
+            }
+            delete a;
+            continue;
+        }
+
+        a->started_ns = monotonicNowNs();
+        a->timer.fire = attemptTimerFired;
+        a->timer.data = a;
+        if (a->endpoint) {
+            a->route.deliver = attemptDeliver;
+            a->route.drained = attemptDrained;
+            a->route.data = a;
+            a->endpoint->addConnection(a->conn, &a->route);
+        } else {
+            ev_io_init(&a->watcher, attemptRecvCallback, a->fd, EV_READ);
+            a->watcher.data = a;
+            ev_io_start(mLoop, &a->watcher);
+        }
+
+        mAttempts.push_back(a);
+        mConnectAttempts.fetch_add(1);
+
+        flushAttempt(a);
+        return a;
+    }
+    return nullptr;
+}
+
+void QuicheEngineImpl::attemptProgress(ConnectAttempt* a) {
+    if (quiche_conn_is_established(a->conn) && !mIsConnected) {
+        // Won the race: it becomes the connection, CONNECTED fires from there
+        promoteAttempt(a);
+        afterIngress();
+        return;
+    }
+
+    flushAttempt(a);
+
+    if (quiche_conn_is_closed(a->conn)) {
+        dropAttempt(a, false);
+
+        // A failed attempt does not wait for the stagger timer
+        if (!mIsConnected && !mPendingPeers.empty()) {
+            startAttempt();
+        }
+    }
+}
+
+void QuicheEngineImpl::flushAttempt(ConnectAttempt* a) {
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags |= MSG_NOSIGNAL;
+#endif
+
+    // Handshake traffic only: a few packets, no batching needed
+    uint8_t out[MAX_DATAGRAM_SIZE];
+    while (true) {
+        uint8_t* buf = a->endpoint ? a->endpoint->sendSlot() : out;
+        quiche_send_info send_info;
+        ssize_t written = quiche_conn_send(a->conn, buf, MAX_DATAGRAM_SIZE, &send_info);
+        if (written < 0) {
+            break;  // QUICHE_ERR_DONE or a failed connection
+        }
+
+        if (a->endpoint) {
+            a->endpoint->commitSendSlot(written, &send_info.to, send_info.to_len);
+            continue;
+        }
+
+        if (sendto(a->fd, out, written, flags,
+                   (const struct sockaddr*)&send_info.to, send_info.to_len) != written) {
+            // Ignore send errors, loss recovery retransmits
+        }
+    }
+
+    uint64_t timeout_ns = quiche_conn_timeout_as_nanos(a->conn);
+    if (timeout_ns == UINT64_MAX) {
+        mTimers->cancel(&a->timer);
+    } else {
+        mTimers->schedule(&a->timer, monotonicNowNs() + timeout_ns);
+    }
+}
+
+void QuicheEngineImpl::dropAttempt(ConnectAttempt* a, bool send_close) {
+    if (send_close && !quiche_conn_is_closed(a->conn)) {
+        // Let the server free its state instead of waiting for the idle timeout
+        quiche_conn_close(a->conn, false, 0, reinterpret_cast<const uint8_t*>(""), 0);
+        flushAttempt(a);
+    }
+
+    mTimers->cancel(&a->timer);
+    if (a->endpoint) {
+        a->endpoint->removeRoutes(&a->route);
+    } else {
+        ev_io_stop(mLoop, &a->watcher);
+        ::close(a->fd);
+    }
+    quiche_conn_free(a->conn);
+
+    for (size_t i = 0; i < mAttempts.size(); i++) {
+        if (mAttempts[i] == a) {
+            mAttempts.erase(mAttempts.begin() + i);
+            break;
+        }
+    }
+    delete a;
+}
+
+void QuicheEngineImpl::promoteAttempt(ConnectAttempt* a) {
+    // Retire the current connection and its socket
+    if (mEndpoint) {
+        mEndpoint->removeRoutes(&mRoute);
+    } else {
+        ev_io_stop(mLoop, &mIoWatcher);
+    }
+    if (!quiche_conn_is_closed(mConn)) {
+        quiche_conn_close(mConn, false, 0, reinterpret_cast<const uint8_t*>(""), 0);
+        flushEgress();
+    }
+    quiche_conn_free(mConn);
+    if (mSock >= 0) {
+        ::close(mSock);
+    }
+
+    mConn = a->conn;
+    mSock = a->fd;
+    mEndpoint = a->endpoint;
+    memcpy(&mLocalAddr, &a->local_addr, a->local_addr_len);
+    mLocalAddrLen = a->local_addr_len;
+    memcpy(&mPeerAddr, &a->peer_addr, a->peer_addr_len);
+    mPeerAddrLen = a->peer_addr_len;
+    mConnStartedNs = a->started_ns;
+
+    // The attempt's socket and connection now belong to the engine
+    mTimers->cancel(&a->timer);
+    if (mEndpoint) {
+        mEndpoint->removeRoutes(&a->route);
+        mEndpoint->addConnection(mConn, &mRoute);
+    } else {
+        ev_io_stop(mLoop, &a->watcher);
+        ev_io_set(&mIoWatcher, mSock, EV_READ);
+        ev_io_start(mLoop, &mIoWatcher);
+    }
+    for (size_t i = 0; i < mAttempts.size(); i++) {
+        if (mAttempts[i] == a) {
+            mAttempts.erase(mAttempts.begin() + i);
+            break;
+        }
+    }
+    delete a;
+}
+
+bool QuicheEngineImpl::failOver() {
+    ConnectAttempt* next = mAttempts.empty() ? startAttempt() : mAttempts.front();
+    if (!next) {
+        return false;
+    }
+
+    promoteAttempt(next);
+    afterIngress();
+    return true;
+}
+
+void QuicheEngineImpl::abandonAttempts() {
+    mPendingPeers.clear();
+    if (mTimers) {
+        mTimers->cancel(&mRaceTimer);
+    }
+
+    while (!mAttempts.empty()) {
+        dropAttempt(mAttempts.back(), true);
+    }
+}
+
+void QuicheEngineImpl::recordConnectTime(int family, uint64_t started_ns) {
+    uint64_t elapsed_us = (monotonicNowNs() - started_ns) / 1000;
+    if (family == AF_INET6) {
+        mConnectTimeV6Us.store(elapsed_us);
+    } else {
+        mConnectTimeV4Us.store(elapsed_us);
+    }
+}
+
+void QuicheEngineImpl::raceTimerFired(TimerNode* node) {
+    QuicheEngineImpl* impl = static_cast<QuicheEngineImpl*>(node->data);
+    if (impl->mIsConnected) {
+        return;
+    }
+
+    // Next address; keep staggering while addresses are left
+    impl->startAttempt();
+    if (!impl->mPendingPeers.empty()) {
+        impl->mTimers->schedule(&impl->mRaceTimer, monotonicNowNs() + impl->mAttemptDelayNs);
+    }
+}
+
+void QuicheEngineImpl::attemptTimerFired(TimerNode* node) {
+    ConnectAttempt* a = static_cast<ConnectAttempt*>(node->data);
+
+    quiche_conn_on_timeout(a->conn);
+    a->engine->attemptProgress(a);
+}
+
+void QuicheEngineImpl::attemptRecvCallback(EV_P_ ev_io* w, int revents) {
+    (void)EV_A;
+    (void)revents;
+
+    ConnectAttempt* a = static_cast<ConnectAttempt*>(w->data);
+    QuicheEngineImpl* impl = a->engine;
+
+    impl->receivePackets(a->conn, a->fd, &a->local_addr, a->local_addr_len);
+    impl->attemptProgress(a);
+}
+
+void QuicheEngineImpl::attemptDeliver(EndpointRoute* route, uint8_t* buf, size_t len,
+                                      const struct sockaddr_storage* from, socklen_t from_len) {
+    ConnectAttempt* a = static_cast<ConnectAttempt*>(route->data);
+
+    quiche_recv_info recv_info = {
+        (struct sockaddr*)from,
+        from_len,
+        (struct sockaddr*)&a->local_addr,
+        a->local_addr_len,
+    };
+    if (quiche_conn_recv(a->conn, buf, len, &recv_info) < 0) {
+        // Ignore receive errors for this packet
+    }
+}
+
+void QuicheEngineImpl::attemptDrained(EndpointRoute* route) {
+    ConnectAttempt* a = static_cast<ConnectAttempt*>(route->data);
+    a->engine->attemptProgress(a);
+}
+
+// ============================================================================
+// Path Probing and Connection Migration (event loop thread only)
+// ============================================================================
+
+int QuicheEngineImpl::socketForAddress(const struct sockaddr_storage* from, socklen_t from_len) const {
+    (void)from_len;
+
+    for (PathSocket* path : mPathSockets) {
+        if (sameAddress(&path->local_addr, from)) {
+            return path->fd;
+        }
+    }
+    return mSock;
+}
+
+void QuicheEngineImpl::openPathSocket(const Command::PathData& path_data) {
+    std::string local = formatAddress(&path_data.local_addr, path_data.local_addr_len);
+
+    int fd = socket(path_data.local_addr.ss_family, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        mLastError = "Failed to create path socket";
+        emitEvent(EngineEvent::PATH_FAILED, EventData(local));
+        return;
+    }
+
+#ifdef SO_NOSIGPIPE
+    int set = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &set, sizeof(set));
+#endif
+
+    PathSocket* path = new PathSocket();
+    path->engine = this;
+    path->fd = fd;
+    path->local_addr_len = sizeof(path->local_addr);
+
+    if (fcntl(fd, F_SETFL, O_NONBLOCK) != 0 ||
+        bind(fd, (const struct sockaddr*)&path_data.local_addr, path_data.local_addr_len) < 0 ||
+        getsockname(fd, (struct sockaddr*)&path->local_addr, &path->local_addr_len) != 0) {
+        mLastError = "Failed to bind path socket to " + local;
+        ::close(fd);
+        delete path;
+        emitEvent(EngineEvent::PATH_FAILED, EventData(local));
+        return;
+    }
+
+    uint64_t seq;
+    int rc = quiche_conn_probe_path(mConn,
+                                    (struct sockaddr*)&path->local_addr, path->local_addr_len,
+                                    (struct sockaddr*)&mPeerAddr, mPeerAddrLen, &seq);
+    if (rc < 0) {
+        // QUICHE_ERR_OUT_OF_IDENTIFIERS: peer has not issued a spare connection ID
+        mLastError = "Failed to probe path from " + local + ": error " + std::to_string(rc);
+        ::close(fd);
+        delete path;
+        emitEvent(EngineEvent::PATH_FAILED, EventData(local));
+        return;
+    }
+
+    ev_io_init(&path->watcher, pathRecvCallback, fd, EV_READ);
+    path->watcher.data = path;
+    if (mWatchersAttached) {
+        ev_io_start(mLoop, &path->watcher);
+    }
+
+    mPathSockets.push_back(path);
+}
+
+void QuicheEngineImpl::closePathSocket(PathSocket* path) {
+    for (auto it = mPathSockets.begin(); it != mPathSockets.end(); ++it) {
+        if (*it == path) {
+            mPathSockets.erase(it);
+            break;
+        }
+    }
+
+    ev_io_stop(mLoop, &path->watcher);
+    ::close(path->fd);
+    delete path;
+}
+
+void QuicheEngineImpl::migrateToValidatedPath() {
+    // Most recent validated probe wins
+    PathSocket* target = nullptr;
+    for (PathSocket* path : mPathSockets) {
+        if (path->validated) {
+            target = path;
+        }
+    }
+
+    if (!target) {
+        mLastError = "No validated path to migrate to";
+        emitEvent(EngineEvent::PATH_FAILED, EventData());
+        return;
+    }
+
+    uint64_t seq;
+    int rc = quiche_conn_migrate(mConn,
+                                 (struct sockaddr*)&target->local_addr, target->local_addr_len,
+                                 (struct sockaddr*)&mPeerAddr, mPeerAddrLen, &seq);
+    if (rc < 0) {
+        mLastError = "Failed to migrate: error " + std::to_string(rc);
+        emitEvent(EngineEvent::PATH_FAILED,
+                  EventData(formatAddress(&target->local_addr, target->local_addr_len)));
+        return;
+    }
+
+    // Replace the connection ID retired by the migration
+    issueSourceConnectionIds();
+}
+
+void QuicheEngineImpl::processPathEvents() {
+    quiche_path_event* ev;
+    while ((ev = quiche_conn_path_event_next(mConn)) != nullptr) {
+        struct sockaddr_storage local;
+        socklen_t local_len = sizeof(local);
+        struct sockaddr_storage peer;
+        socklen_t peer_len = sizeof(peer);
+
+        switch (quiche_path_event_type(ev)) {
+            case QUICHE_PATH_EVENT_VALIDATED: {
+                quiche_path_event_validated(ev, &local, &local_len, &peer, &peer_len);
+                for (PathSocket* path : mPathSockets) {
+                    if (sameAddress(&path->local_addr, &local)) {
+                        path->validated = true;
                     }
+                }
+                emitEvent(EngineEvent::PATH_VALIDATED, EventData(formatAddress(&local, local_len)));
+                break;
+            }
 
-                    flushEgress();
+            case QUICHE_PATH_EVENT_FAILED_VALIDATION: {
+                quiche_path_event_failed_validation(ev, &local, &local_len, &peer, &peer_len);
+                for (PathSocket* path : mPathSockets) {
+                    if (sameAddress(&path->local_addr, &local)) {
+                        closePathSocket(path);
+                        break;
+                    }
                 }
+                emitEvent(EngineEvent::PATH_FAILED, EventData(formatAddress(&local, local_len)));
                 break;
             }
 
-            case CommandType::CLOSE: {
-                // No locking needed - called only from event loop thread!
-                if (mConn) {
-                    quiche_conn_close(
-                        mConn,
-                        true,
-                        cmd->params.close.error_code,
-                        reinterpret_cast<const uint8_t*>(cmd->params.close.reason),
-                        strlen(cmd->params.close.reason)
-                    );
-                    flushEgress();
+            case QUICHE_PATH_EVENT_CLOSED: {
+                // Abandoned probe path - the original socket stays until the engine goes away
+                quiche_path_event_closed(ev, &local, &local_len, &peer, &peer_len);
+                for (PathSocket* path : mPathSockets) {
+                    if (sameAddress(&path->local_addr, &local)) {
+                        closePathSocket(path);
+                        break;
+                    }
                 }
                 break;
             }
 
-            case CommandType::STOP: {
-                ev_break(mLoop, EVBREAK_ONE);
+            case QUICHE_PATH_EVENT_PEER_MIGRATED: {
+                quiche_path_event_peer_migrated(ev, &local, &local_len, &peer, &peer_len);
+                memcpy(&mPeerAddr, &peer, peer_len);
+                mPeerAddrLen = peer_len;
+                onNatRebinding();
+                emitEvent(EngineEvent::PEER_MIGRATED, EventData(formatAddress(&peer, peer_len)));
                 break;
             }
+
+            default:
+                // NEW and REUSED_SOURCE_CONNECTION_ID only matter to servers
+                break;
         }
 
-        delete cmd;
+        quiche_path_event_free(ev);
+    }
+}
+
+void QuicheEngineImpl::issueSourceConnectionIds() {
+    while (quiche_conn_scids_left(mConn) > 0) {
+        uint8_t scid[LOCAL_CONN_ID_LEN];
+        uint8_t reset_token[16];
+        if (!generateConnectionId(scid, sizeof(scid)) ||
+            !generateConnectionId(reset_token, sizeof(reset_token))) {
+            return;
+        }
+
+        uint64_t seq;
+        if (quiche_conn_new_scid(mConn, scid, sizeof(scid), reset_token, false, &seq) < 0) {
+            return;
+        }
+
+        // The peer may switch to it at any time
+        if (mEndpoint) {
+            mEndpoint->addRoute(scid, sizeof(scid), &mRoute);
+        }
+    }
+}
+
+void QuicheEngineImpl::emitEvent(EngineEvent event, const EventData& data) {
+    if (mEventQueue) {
+        if (event == EngineEvent::STREAM_READABLE) {
+            mEventQueue->pushReadable(data.uint_val);
+        } else {
+            mEventQueue->push(event, data);
+        }
+    } else if (mEventBatchCallback) {
+        batchEvent(event, data);
+    } else if (mEventCallback) {
+        mCallbackDepth++;
+        mEventCallback(mWrapper, event, data, mUserData);
+        mCallbackDepth--;
+        afterCallback();
+    }
+}
+
+void QuicheEngineImpl::batchEvent(EngineEvent event, const EventData& data) {
+    // Once per stream and once per connection-wide backlog drain per batch
+    if (event == EngineEvent::STREAM_READABLE) {
+        uint64_t& seq = mReadableBatch[data.uint_val];
+        if (seq == mBatchSeq) {
+            return;
+        }
+        seq = mBatchSeq;
+    } else if (event == EngineEvent::STREAM_WRITABLE) {
+        if (mWritableBatched) {
+            return;
+        }
+        mWritableBatched = true;
+    }
+
+    PendingEvent pending;
+    pending.event = event;
+    pending.type = data.type;
+    pending.uint_val = data.uint_val;
+    pending.str_offset = mBatchStrings.size();
+    pending.str_len = 0;
+    if (data.type == EventDataType::STRING) {
+        mBatchStrings.append(data.str_val);
+        mBatchStrings.push_back('\0');
+        pending.str_len = data.str_val.size();
+    }
+    mBatch.push_back(pending);
+
+    if (!ev_is_active(&mBatchWatcher)) {
+        ev_prepare_start(mLoop, &mBatchWatcher);
+    }
+
+    // The loop may stop before its next iteration
+    if (event == EngineEvent::CONNECTION_CLOSED) {
+        dispatchEventBatch();
+    }
+}
+
+void QuicheEngineImpl::dispatchEventBatch() {
+    // Events raised by the handler itself wait for the next batch
+    if (mBatch.empty() || mDispatchingBatch) {
+        return;
+    }
+    ev_prepare_stop(mLoop, &mBatchWatcher);
+
+    // Strings of this batch stay put while the handler adds to the next one
+    mBatchOutStrings.swap(mBatchStrings);
+    mBatchStrings.clear();
+    mBatchOut.clear();
+    for (const PendingEvent& pending : mBatch) {
+        EventRecord record;
+        record.event = pending.event;
+        record.type = pending.type;
+        record.uint_val = pending.uint_val;
+        record.str_val = pending.type == EventDataType::STRING ?
+            mBatchOutStrings.data() + pending.str_offset : nullptr;
+        record.str_len = pending.str_len;
+        mBatchOut.push_back(record);
+    }
+    mBatch.clear();
+
+    // Every entry is stale once the sequence moves on
+    mBatchSeq++;
+    mWritableBatched = false;
+    if (mReadableBatch.size() > 4096) {
+        mReadableBatch.clear();
+    }
+
+    mDispatchingBatch = true;
+    mCallbackDepth++;
+    mEventBatchCallback(mWrapper, mBatchOut.data(), mBatchOut.size(), mBatchUserData);
+    mCallbackDepth--;
+    mDispatchingBatch = false;
+    afterCallback();
+
+    // The handler closed the connection: the loop may not come back for it
+    if (!mBatch.empty() && mBatch.back().event == EngineEvent::CONNECTION_CLOSED) {
+        dispatchEventBatch();
+    }
+}
+
+void QuicheEngineImpl::batchCallback(EV_P_ ev_prepare* w, int revents) {
+    (void)EV_A;
+    (void)revents;
+
+    QuicheEngineImpl* impl = static_cast<QuicheEngineImpl*>(w->data);
+    impl->dispatchEventBatch();
+}
+
+void QuicheEngineImpl::runScheduler() {
+    // Before the handshake (and without 0-RTT keys) the peer's flow control
+    // limits are unknown - keep writes queued, in order
+    if (!mConn || (!quiche_conn_is_established(mConn) && !quiche_conn_is_in_early_data(mConn))) {
+        return;
+    }
+
+    // 0-RTT data must not go out on a connection that may still lose the race
+    if (!quiche_conn_is_established(mConn) && (!mAttempts.empty() || !mPendingPeers.empty())) {
+        return;
+    }
+
+    bool early_data = quiche_conn_is_in_early_data(mConn);
+    size_t written = mScheduler.run(mConn, monotonicNowNs(), mSchedulerWakeupNs);
+    if (early_data) {
+        mEarlyDataBytes += written;
+    }
+
+    // Backlog fully handed to quiche: writers waiting for room can go on
+    // (not while writes still wait in the command queue)
+    size_t queued = mScheduler.queuedBytes();
+    bool drained = queued == 0 && mSendQueueBytes.load() > 0 && mWriteCmdBytes.load() == 0;
+    mSendQueueBytes.store(queued);
+    if (drained) {
+        emitEvent(EngineEvent::STREAM_WRITABLE, EventData(static_cast<uint64_t>(0)));
+    }
+}
+
+void QuicheEngineImpl::armDeadlineTimer() {
+    if (!mWatchersAttached || mDeadlines.empty()) {
+        return;
+    }
+
+    mDeadlineTimer.fire = deadlineFired;
+    mDeadlineTimer.data = this;
+    if (!mDeadlineTimer.armed() || mDeadlines.top().first < mDeadlineTimer.deadline_ns) {
+        mTimers->schedule(&mDeadlineTimer, mDeadlines.top().first);
+    }
+}
+
+void QuicheEngineImpl::deadlineFired(TimerNode* node) {
+    QuicheEngineImpl* impl = static_cast<QuicheEngineImpl*>(node->data);
+
+    uint64_t now_ns = monotonicNowNs();
+    bool expired = false;
+    while (!impl->mDeadlines.empty() && impl->mDeadlines.top().first <= now_ns) {
+        DeadlineEntry entry = impl->mDeadlines.top();
+        impl->mDeadlines.pop();
+
+        // Skip entries replaced by a later write's deadline
+        auto it = impl->mStreamDeadlines.find(entry.second);
+        if (it == impl->mStreamDeadlines.end() || it->second != entry.first) {
+            continue;
+        }
+        impl->mStreamDeadlines.erase(it);
+        impl->expireStream(entry.second);
+        expired = true;
+    }
+
+    impl->armDeadlineTimer();
+    if (expired && impl->mConn) {
+        impl->flushEgress();  // RESET_STREAM frames
+    }
+}
+
+void QuicheEngineImpl::expireStream(uint64_t stream_id) {
+    size_t dropped = mScheduler.abortStream(stream_id);
+    mSendQueueBytes.store(mScheduler.queuedBytes());
+
+    // Everything up to the FIN acknowledged: delivered in time
+    if (dropped == 0 && (!mConn || quiche_conn_stream_send_complete(mConn, stream_id))) {
+        return;
+    }
+
+    bool in_quiche = mConn && quiche_conn_stream_capacity(mConn, stream_id) != QUICHE_ERR_INVALID_STREAM_STATE;
+
+    if (mConn) {
+        // Never handed to quiche: open it, so the peer still learns it was reset
+        if (!in_quiche) {
+            uint8_t none = 0;
+            uint64_t error_code;
+            quiche_conn_stream_send(mConn, stream_id, &none, 0, false, &error_code);
+        }
+        quiche_conn_stream_shutdown(mConn, stream_id, QUICHE_SHUTDOWN_WRITE, 0);
+    }
+
+    mWritesExpired++;
+    mExpiredBytes += dropped;
+}
+
+void QuicheEngineImpl::initWatchers() {
+    // Initialize IO watcher
+    ev_io_init(&mIoWatcher, recvCallback, mSock, EV_READ);
+    mIoWatcher.data = this;
+
+    // Connection timer lives in the loop's timer wheel
+    mTimer.fire = timerFired;
+    mTimer.data = this;
+
+    mRoute.deliver = endpointDeliver;
+    mRoute.drained = endpointDrained;
+    mRoute.data = this;
+    if (mEventLoop) {
+        mTimers = &mEventLoop->timers();
+    } else {
+        mOwnTimers.attach(mLoop);
+        mTimers = &mOwnTimers;
+    }
+
+    // Initialize async watcher
+    ev_async_init(&mAsyncWatcher, asyncCallback);
+    mAsyncWatcher.data = this;
+
+    // Batched events go out before the loop blocks (started on demand)
+    ev_prepare_init(&mBatchWatcher, batchCallback);
+    mBatchWatcher.data = this;
+}
+
+void QuicheEngineImpl::attachWatchers() {
+    // mIoWatcher is started by connectTo() once the socket exists
+    ev_async_start(mLoop, &mAsyncWatcher);
+    mWatchersAttached = true;
+
+    // A shared runtime loop counts its wakeups itself
+    if (mTimers == &mOwnTimers) {
+        mWakeups.attach(mLoop);
+    }
+
+    // Deadlines of writes made before start() (external loop)
+    armDeadlineTimer();
+}
+
+void QuicheEngineImpl::detachWatchers() {
+    if (!mWatchersAttached) {
+        return;
+    }
+
+    abandonAttempts();
+    if (mEndpoint) {
+        mEndpoint->removeRoutes(&mRoute);  // The shared socket stays with the loop
+    }
+    ev_io_stop(mLoop, &mIoWatcher);
+    for (PathSocket* path : mPathSockets) {
+        ev_io_stop(mLoop, &path->watcher);
+    }
+    mTimers->cancel(&mTimer);
+    mTimers->cancel(&mKeepAliveTimer);
+    mTimers->cancel(&mDeadlineTimer);
+    mTimers->cancel(&mIoIdleTimer);
+    mTimers->cancel(&mCommandTimer);
+    mCommandHoldNs.store(0);
+    if (mTimers == &mOwnTimers) {
+        mOwnTimers.detach();
+        mWakeups.detach();
+    }
+    ev_async_stop(mLoop, &mAsyncWatcher);
+    ev_prepare_stop(mLoop, &mBatchWatcher);
+    mWatchersAttached = false;
+}
+
+void QuicheEngineImpl::stopLoop() {
+    if (mEventLoop || mExternalLoop) {
+        // Loop is not ours: other engines or the application keep using it
+        detachWatchers();
+        mIsRunning = false;
+    } else {
+        ev_break(mLoop, EVBREAK_ONE);
     }
 }
 
@@ -694,26 +2352,76 @@ void QuicheEngineImpl::eventLoopThread(QuicheEngineImpl* impl) {
     // Set thread name for debugging and profiling (cross-platform)
     thread_utils::setCurrentThreadName("QuicEventLoop");
 
+    LoopThreadInfo info = applyLoopThreadConfig(impl->mConfig);
+    {
+        std::lock_guard<std::mutex> lock(impl->mLoopThreadInfoMutex);
+        impl->mLoopThreadInfo = info;
+    }
+
+    // Calls from the engine's callbacks run inline from here on
+    impl->mLoopThreadId.store(std::this_thread::get_id());
+
     // Run event loop
     ev_run(impl->mLoop, 0);
+    impl->mLoopThreadId.store(std::thread::id());
     impl->mIsRunning = false;
 }
 
 bool QuicheEngineImpl::start() {
-    if (mThreadStarted) {
+    if (mStarted) {
         mLastError = "Engine already running";
         return false;
     }
 
-    // Enable debug logging if requested
-    bool enable_debug = getConfigValue<bool>(ConfigKey::ENABLE_DEBUG_LOG, false);
-    if (enable_debug) {
-        quiche_enable_debug_logging(debugLog, nullptr);
+    // Enable debug logging if requested
+    bool enable_debug = getConfigValue(ConfigKey::ENABLE_DEBUG_LOG, false);
+    if (enable_debug) {
+        quiche_enable_debug_logging(debugLog, nullptr);
+    }
+
+    // Pick the session cache before connecting so a ticket can be offered
+    resolveSessionCache();
+
+    // Setup QUIC config; the connection is created on the loop thread
+    // once the peer address is known
+    if (!setupConfig()) {
+        return false;
+    }
+
+    if (mRuntime && !mEventLoop) {
+        mLastError = "Engine runtime has no running loop";
+        return false;
+    }
+
+    if (mExternalLoop) {
+        // Caller's loop: start() runs on its thread, the loop drives everything
+        mLoop = mExternalLoop;
+        initWatchers();
+        attachWatchers();
+        mIsRunning = true;
+        mStarted = true;
+
+        // Connect from the loop, so failures are reported as events there
+        pushConnect();
+        ev_async_send(mLoop, &mAsyncWatcher);
+        return true;
     }
 
-    // Setup mConnection
-    if (!setupConnection()) {
-        return false;
+    if (mEventLoop) {
+        // Shared runtime loop: watchers may only be started on the loop thread
+        mLoop = mEventLoop->loop();
+        initWatchers();
+        mIsRunning = true;
+        mStarted = true;
+
+        pushConnect();
+        mEventLoop->post([this]() {
+            attachWatchers();
+
+            // Connect, then pick up writes queued before attach
+            processCommands();
+        });
+        return true;
     }
 
     // Create event mLoop
@@ -723,39 +2431,59 @@ bool QuicheEngineImpl::start() {
         return false;
     }
 
-    // Initialize IO watcher
-    ev_io_init(&mIoWatcher, recvCallback, mSock, EV_READ);
-    ev_io_start(mLoop, &mIoWatcher);
-    mIoWatcher.data = this;
-
-    // Initialize mTimer
-    ev_init(&mTimer, timeoutCallback);
-    mTimer.data = this;
-
-    // Initialize async watcher
-    ev_async_init(&mAsyncWatcher, asyncCallback);
-    ev_async_start(mLoop, &mAsyncWatcher);
-    mAsyncWatcher.data = this;
+    initWatchers();
+    attachWatchers();
 
-    // Send initial packet
-    flushEgress();
+    // Resolution and the initial packet happen on the loop thread
+    pushConnect();
+    ev_async_send(mLoop, &mAsyncWatcher);
 
-    // Start event mLoop in background thread using C++11 std::thread
+    // Start event mLoop in background thread (small stack in the standby profile)
     mIsRunning = true;
-    try {
-        mLoopThread = std::thread(eventLoopThread, this);
-        mThreadStarted = true;
-    } catch (const std::system_error& e) {
-        mLastError = "Failed to create event loop thread: " + std::string(e.what());
+    std::string error;
+    size_t stack_size = mLowMemory ? LOW_MEMORY_LOOP_STACK : 0;
+    if (!mLoopThread.start([](void* impl) { eventLoopThread(static_cast<QuicheEngineImpl*>(impl)); },
+                           this, stack_size, error)) {
+        mLastError = "Failed to create event loop thread: " + error;
         mIsRunning = false;
         ev_loop_destroy(mLoop);
         mLoop = nullptr;
         return false;
     }
+    mThreadStarted = true;
+    mStarted = true;
+    mLoopStackBytes = mLoopThread.stackSize();
 
     return true;
 }
 
+void QuicheEngineImpl::pushConnect() {
+    // Ahead of any write the caller queues after start()
+    auto* cmd = new Command();
+    cmd->type = CommandType::CONNECT;
+    mCmdQueue.push(cmd);
+}
+
+bool QuicheEngineImpl::addPeerAddress(const struct sockaddr* addr, socklen_t addr_len) {
+    if (mStarted) {
+        mLastError = "Peer addresses must be added before start()";
+        return false;
+    }
+
+    if (!addr || addr_len == 0 || addr_len > sizeof(struct sockaddr_storage) ||
+        (addr->sa_family != AF_INET && addr->sa_family != AF_INET6)) {
+        mLastError = "Invalid peer address";
+        return false;
+    }
+
+    PeerAddress peer;
+    memset(&peer, 0, sizeof(peer));
+    memcpy(&peer.addr, addr, addr_len);
+    peer.addr_len = addr_len;
+    mPresetPeers.push_back(peer);
+    return true;
+}
+
 void QuicheEngineImpl::shutdown(uint64_t app_error, const std::string& reason) {
     // Send close command to event mLoop
     if (mIsRunning && mLoop) {
@@ -766,8 +2494,27 @@ void QuicheEngineImpl::shutdown(uint64_t app_error, const std::string& reason) {
         strncpy(cmd->params.close.reason, reason.c_str(), sizeof(cmd->params.close.reason) - 1);
         cmd->params.close.reason[sizeof(cmd->params.close.reason) - 1] = '\0';
 
-        mCmdQueue.push(cmd);
-        ev_async_send(mLoop, &mAsyncWatcher);
+        submitCommand(cmd);
+    }
+
+    if (mExternalLoop) {
+        // Cannot wait on our own thread: CONNECTION_CLOSED follows once the
+        // close is acknowledged (or times out) on the caller's loop
+        return;
+    }
+
+    if (mEventLoop) {
+        // Close on the shared loop and wait until our watchers are gone
+        if (mStarted) {
+            mEventLoop->runSync([this]() {
+                if (mWatchersAttached) {
+                    processCommands();
+                }
+                detachWatchers();
+            });
+        }
+        mIsRunning = false;
+        return;
     }
 
     // Break event mLoop
@@ -784,90 +2531,656 @@ void QuicheEngineImpl::shutdown(uint64_t app_error, const std::string& reason) {
     mIsRunning = false;
 }
 
-ssize_t QuicheEngineImpl::write(const uint8_t* data, size_t len, bool fin) {
-    if (!data || len > MAX_WRITE_DATA_SIZE) {
+ssize_t QuicheEngineImpl::write(const uint8_t* data, size_t len, bool fin, uint64_t deadline_ms) {
+    return writeStream(mStreamId, data, len, fin, deadline_ms);  // Use default stream ID
+}
+
+ssize_t QuicheEngineImpl::writeStream(uint64_t stream_id, const uint8_t* data, size_t len, bool fin,
+                                      uint64_t deadline_ms) {
+    // nullptr is fine for a FIN-only write (len 0, fin true)
+    if ((!data && len > 0) || len > MAX_WRITE_DATA_SIZE || (len == 0 && !fin)) {
         mLastError = "Invalid write parameters";
         return -1;
     }
 
-    auto* cmd = new Command();
-    cmd->type = CommandType::WRITE;
-    cmd->params.write.stream_id = mStreamId;  // Use default stream ID
-    memcpy(cmd->params.write.data, data, len);
-    cmd->params.write.len = len;
-    cmd->params.write.fin = fin;
+    // From a callback on the loop thread: straight into quiche when nothing
+    // is queued ahead; only what quiche does not take becomes a command.
+    // Writes of other threads (or held back by power save) still in the
+    // command queue come first: this one queues behind them
+    bool loop_thread = onLoopThread();
+    bool queued_ahead = loop_thread && mWriteCmds.load() > 0;
+    size_t sent = 0;
+    if (deadline_ms == 0 && loop_thread && !queued_ahead) {
+        bool complete;
+        ssize_t written = sendInline(stream_id, data, len, fin, complete);
+        if (written < 0) {
+            return -1;
+        }
+        if (complete) {
+            return static_cast<ssize_t>(len);
+        }
+        sent = static_cast<size_t>(written);
+    }
 
-    mCmdQueue.push(cmd);
+    auto* cmd = Command::newWrite(len - sent);
+    cmd->params.write.stream_id = stream_id;
+    if (len > sent) {
+        memcpy(cmd->params.write.data, data + sent, len - sent);
+    }
+    cmd->params.write.fin = fin;
+    cmd->params.write.deadline_ns = deadline_ms > 0 ? monotonicNowNs() + deadline_ms * 1000000ULL : 0;
 
-    if (mLoop) {
-        ev_async_send(mLoop, &mAsyncWatcher);
+    // Part of send_queue_bytes from now on, not only once the loop got it
+    mWriteCmdBytes.fetch_add(len - sent);
+    mWriteCmds.fetch_add(1);
+    if (queued_ahead) {
+        queueCommand(cmd);
+    } else {
+        submitCommand(cmd);
     }
 
     return static_cast<ssize_t>(len);
 }
 
 ssize_t QuicheEngineImpl::read(uint8_t* buf, size_t buf_len, bool& fin) {
+    return readStream(mStreamId, buf, buf_len, fin);  // Use default stream ID
+}
+
+ssize_t QuicheEngineImpl::readStream(uint64_t stream_id, uint8_t* buf, size_t buf_len, bool& fin) {
     if (!buf) {
         mLastError = "Invalid buffer";
         return -1;
     }
 
+    if (mExternalLoop) {
+        // Caller is on the loop thread: copy straight out of quiche
+        fin = false;
+        if (!mConn) {
+            return 0;
+        }
+
+        uint64_t error_code;
+        ssize_t read_len = quiche_conn_stream_recv(mConn, stream_id, buf, buf_len, &fin, &error_code);
+        if (read_len == QUICHE_ERR_DONE) {
+            return 0;
+        }
+        if (read_len < 0) {
+            mLastError = "Failed to read stream " + std::to_string(stream_id) +
+                         " (error " + std::to_string(read_len) + ")";
+            return -1;
+        }
+        return read_len;
+    }
+
     // Get stream buffer (no quiche calls - lock-free with respect to quiche!)
-    StreamReadBuffer* buffer = getOrCreateStreamBuffer(mStreamId);  // Use default stream ID
+    StreamReadBuffer* buffer = getOrCreateStreamBuffer(stream_id);
 
-    // Lock buffer access (not mConn - much lighter weight)
-    std::lock_guard<std::mutex> lock(buffer->mMutex);
+    bool resume = false;
+    ssize_t len = buffer->consume(buf, buf_len, fin, &resume);
+
+    if (onLoopThread()) {
+        // Buffer drained: the rest comes straight out of quiche, and the
+        // window update goes out with the next flush
+        size_t copied = static_cast<size_t>(len);
+        if (mConn && !fin && copied < buf_len && !buffer->hasData()) {
+            bool quiche_fin = false;
+            uint64_t error_code;
+            ssize_t read_len = quiche_conn_stream_recv(mConn, stream_id, buf + copied, buf_len - copied,
+                                                       &quiche_fin, &error_code);
+            if (read_len >= 0) {
+                copied += static_cast<size_t>(read_len);
+                fin = quiche_fin;
+                if (quiche_fin) {
+                    buffer->setFin();
+                }
+            } else if (read_len < 0 && read_len != QUICHE_ERR_DONE && copied == 0) {
+                mLastError = "Failed to read stream " + std::to_string(stream_id) +
+                             " (error " + std::to_string(read_len) + ")";
+                return -1;
+            }
+        }
+        if (copied > static_cast<size_t>(len) || resume) {
+            requestFlush();
+        }
+        return static_cast<ssize_t>(copied);
+    }
+
+    if (resume) {
+        // The rest of the stream is still in quiche, and flow control keeps
+        // the peer from sending more until the loop reads it
+        auto* cmd = new Command();
+        cmd->type = CommandType::STREAM_READ;
+        cmd->params.read.stream_id = stream_id;
+        submitCommand(cmd);
+    }
+    return len;
+}
+
+bool QuicheEngineImpl::setStreamSchedule(uint64_t stream_id, uint32_t weight,
+                                         uint64_t max_rate, uint64_t burst) {
+    if (weight == 0) {
+        mLastError = "Stream weight must be at least 1";
+        return false;
+    }
+
+    auto* cmd = new Command();
+    cmd->type = CommandType::STREAM_SCHEDULE;
+    cmd->params.schedule.stream_id = stream_id;
+    cmd->params.schedule.weight = weight;
+    cmd->params.schedule.max_rate = max_rate;
+    cmd->params.schedule.burst = burst;
+
+    submitCommand(cmd);
+
+    return true;
+}
+
+uint64_t QuicheEngineImpl::openStream() {
+    uint64_t stream_id = mNextStreamId.fetch_add(4);
+    if (stream_id == mStreamId) {
+        stream_id = mNextStreamId.fetch_add(4);  // Default stream of write()/read()
+    }
+    return stream_id;
+}
+
+std::future<RpcResponse> QuicheEngineImpl::call(const uint8_t* request, size_t len) {
+    RpcCall* call = mRpcPool.acquire();
+    std::future<RpcResponse> response = call->promise.get_future();
+    call->queued_ns = monotonicNowNs();
+    mRpcQueuedCount++;
+
+    if (!request && len > 0) {
+        mRpcQueuedCount--;
+        finishCall(call, "Invalid request");
+        return response;
+    }
+    if (!mIsRunning) {
+        mRpcQueuedCount--;
+        finishCall(call, "Engine not running");
+        return response;
+    }
+
+    // Copied here, so requests are not limited to one write command
+    call->request.assign(request, request + len);
+
+    auto* cmd = new Command();
+    cmd->type = CommandType::RPC_CALL;
+    cmd->params.rpc.call = call;
+
+    submitCommand(cmd);
+
+    return response;
+}
+
+RpcStats QuicheEngineImpl::getRpcStats() const {
+    RpcStats stats = {};
+    stats.calls_completed = mRpcCompleted.load();
+    stats.calls_failed = mRpcFailed.load();
+    stats.calls_active = mRpcActiveCount.load();
+    stats.calls_queued = mRpcQueuedCount.load();
+    stats.credit_stalls = mRpcCreditStalls.load();
+    mRpcLatency.snapshot(stats.latency_us);
+    return stats;
+}
+
+bool QuicheEngineImpl::probePath(const std::string& local_host, const std::string& local_port) {
+    if (!mIsRunning || !mLoop) {
+        mLastError = "Engine not running";
+        return false;
+    }
+
+    // Resolve on the calling thread; the loop thread only binds and probes
+    struct addrinfo hints = {};
+    hints.ai_family = mPeerAddr.ss_family;  // Same family as the current peer address
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_protocol = IPPROTO_UDP;
+    hints.ai_flags = AI_PASSIVE;
+
+    struct addrinfo* local;
+    if (getaddrinfo(local_host.empty() ? nullptr : local_host.c_str(), local_port.c_str(),
+                    &hints, &local) != 0) {
+        mLastError = "Failed to resolve local address: " + local_host;
+        return false;
+    }
+
+    auto* cmd = new Command();
+    cmd->type = CommandType::PROBE_PATH;
+    memcpy(&cmd->params.path.local_addr, local->ai_addr, local->ai_addrlen);
+    cmd->params.path.local_addr_len = local->ai_addrlen;
+    freeaddrinfo(local);
+
+    submitCommand(cmd);
+
+    return true;
+}
+
+bool QuicheEngineImpl::setIdleTimeout(uint64_t timeout_ms) {
+    if (!mStarted) {
+        // Not connected yet: becomes the transport parameter
+        mConfig[ConfigKey::MAX_IDLE_TIMEOUT] = ConfigValue(timeout_ms);
+        return true;
+    }
+
+    if (!mIsRunning || !mLoop) {
+        mLastError = "Engine not running";
+        return false;
+    }
+
+    auto* cmd = new Command();
+    cmd->type = CommandType::SET_IDLE_TIMEOUT;
+    cmd->params.idle.timeout_ms = timeout_ms;
+
+    submitCommand(cmd);
+
+    return true;
+}
+
+bool QuicheEngineImpl::migrate() {
+    if (!mIsRunning || !mLoop) {
+        mLastError = "Engine not running";
+        return false;
+    }
+
+    auto* cmd = new Command();
+    cmd->type = CommandType::MIGRATE;
+
+    submitCommand(cmd);
+
+    return true;
+}
+
+ssize_t StreamReadBuffer::consume(uint8_t* buf, size_t buf_len, bool& fin, bool* resume) {
+    // Lock buffer access (not the connection - much lighter weight)
+    std::lock_guard<std::mutex> lock(mMutex);
 
     // Calculate available data
-    size_t available = buffer->data.size() - buffer->read_offset;
+    size_t available = data.size() - read_offset;
 
     if (available == 0) {
         // No data available yet
-        fin = buffer->fin_received;
+        fin = fin_received;
         return 0;
     }
 
     // Copy data from buffer to output
     size_t to_read = (available < buf_len) ? available : buf_len;
-    memcpy(buf, buffer->data.data() + buffer->read_offset, to_read);
-    buffer->read_offset += to_read;
+    memcpy(buf, data.data() + read_offset, to_read);
+    read_offset += to_read;
 
     // Check if FIN received and all data consumed
-    fin = buffer->fin_received && (buffer->read_offset >= buffer->data.size());
+    fin = fin_received && (read_offset >= data.size());
+
+    // Drained: start over, so consumed data does not accumulate. A bounded
+    // buffer also gives its memory back
+    if (read_offset == data.size()) {
+        data.clear();
+        read_offset = 0;
+        if (limit > 0) {
+            std::vector<uint8_t>().swap(data);
+        }
+    }
+
+    if (throttled && data.size() - read_offset < limit) {
+        throttled = false;
+        if (resume) {
+            *resume = true;
+        }
+    }
 
     return static_cast<ssize_t>(to_read);
 }
 
 
 EngineStats QuicheEngineImpl::getStats() const {
-    EngineStats stats = {};
+    EngineStats stats;
+    {
+        // As of the last flush on the loop thread
+        std::lock_guard<std::mutex> lock(mConnStatsMutex);
+        stats = mConnStats;
+    }
+    stats.send_queue_bytes = mSendQueueBytes.load() + mWriteCmdBytes.load();
+
+    stats.connect_time_ipv4_us = mConnectTimeV4Us.load();
+    stats.connect_time_ipv6_us = mConnectTimeV6Us.load();
+    stats.connect_attempts = mConnectAttempts.load();
+    stats.resolve_time_us = mResolveTimeUs.load();
+    stats.keepalives_sent = mKeepAlivesSent.load();
+    stats.keepalive_interval_ms = mKeepAliveIntervalMs.load();
+    stats.io_arena_bytes = mIoArenaBytes.load();
+    stats.io_arena_huge_pages = mIoArenaHugePages.load();
+    stats.events_coalesced = mEventQueue ? mEventQueue->coalesced() : 0;
+    stats.event_queue_spills = mEventQueue ? mEventQueue->spilled() : 0;
+    stats.writes_expired = mWritesExpired.load();
+    stats.expired_bytes = mExpiredBytes.load();
+
+    // quiche's own connection and stream state is not included
+    size_t buffered = 0;
+    {
+        std::lock_guard<std::mutex> lock(mStreamBuffersMutex);
+        for (const auto& pair : mStreamBuffers) {
+            std::lock_guard<std::mutex> buffer_lock(pair.second->mMutex);
+            buffered += sizeof(StreamReadBuffer) + pair.second->data.capacity();
+        }
+    }
+    stats.resident_bytes = sizeof(QuicheEngineImpl) + mIoArenaBytes.load() + buffered +
+                           mSendQueueBytes.load();
+    stats.loop_stack_bytes = mLoopStackBytes.load();
 
-    // Note: getStats() is called from application thread, but mConn is only
-    // modified in event loop thread. Reading stats is generally safe, but
-    // for strict thread safety, we could add a command to get stats from
-    // event loop thread. For now, we accept this minor race condition.
+    const WakeupMeter& wakeups = mEventLoop ? mEventLoop->wakeups() : mWakeups;
+    stats.loop_wakeups = wakeups.total();
+    stats.wakeups_per_sec = wakeups.perSecond();
 
-    if (mConn) {
-        quiche_stats s;
-        quiche_conn_stats(mConn, &s);
-
-        stats.packets_sent = s.sent;
-        stats.packets_received = s.recv;
-        stats.bytes_sent = s.sent_bytes;
-        stats.bytes_received = s.recv_bytes;
-        stats.packets_lost = s.lost;
-
-        // Get path stats for RTT and CWND (from path 0)
-        if (s.paths_count > 0) {
-            quiche_path_stats ps;
-            if (quiche_conn_path_stats(mConn, 0, &ps) == 0) {
-                stats.rtt_ns = ps.rtt;
-                stats.cwnd = ps.cwnd;
+    return stats;
+}
+
+void fillConnectionStats(const quiche_conn* conn, EngineStats& stats) {
+    quiche_stats s;
+    quiche_conn_stats(conn, &s);
+
+    stats.packets_sent = s.sent;
+    stats.packets_received = s.recv;
+    stats.bytes_sent = s.sent_bytes;
+    stats.bytes_received = s.recv_bytes;
+    stats.packets_lost = s.lost;
+
+    // Get path stats for RTT and CWND (from path 0)
+    if (s.paths_count > 0) {
+        quiche_path_stats ps;
+        if (quiche_conn_path_stats(conn, 0, &ps) == 0) {
+            stats.rtt_ns = ps.rtt;
+            stats.cwnd = ps.cwnd;
+        }
+    }
+
+    stats.session_resumed = quiche_conn_is_resumed(conn);
+}
+
+IoArenaOptions ioArenaOptionsFromConfig(const ConfigMap& config) {
+    IoArenaOptions options;
+
+    auto it = config.find(ConfigKey::IO_ARENA_HUGE_PAGES);
+    if (it != config.end() && it->second.type == ConfigValueType::BOOL) {
+        options.huge_pages = it->second.bool_val;
+    }
+
+    // Like LOOP_NICE, -1 arrives as a wrapped uint64_t (ConfigValue(int))
+    it = config.find(ConfigKey::IO_ARENA_NUMA_NODE);
+    if (it != config.end() && it->second.type == ConfigValueType::UINT64) {
+        options.numa_node = static_cast<int>(static_cast<int64_t>(it->second.uint_val));
+    }
+    return options;
+}
+
+LoopThreadInfo applyLoopThreadConfig(const ConfigMap& config) {
+    LoopThreadInfo info;
+    std::string errors;
+    auto fail = [&errors](const std::string& what) {
+        errors += errors.empty() ? what : "; " + what;
+    };
+
+    auto it = config.find(ConfigKey::LOOP_CPU_AFFINITY);
+    if (it != config.end() && it->second.type == ConfigValueType::STRING &&
+        !it->second.str_val.empty()) {
+        std::vector<int> cpus;
+        if (!thread_utils::parseCpuList(it->second.str_val, cpus)) {
+            fail("Invalid LOOP_CPU_AFFINITY: " + it->second.str_val);
+        } else if (!thread_utils::setCurrentThreadAffinity(cpus)) {
+            fail("Failed to set CPU affinity " + it->second.str_val);
+        }
+    }
+
+    // Policy first: the priority range depends on it
+    bool has_policy = false;
+    thread_utils::SchedPolicy policy = thread_utils::SchedPolicy::OTHER;
+    it = config.find(ConfigKey::LOOP_SCHED_POLICY);
+    if (it != config.end() && it->second.type == ConfigValueType::STRING &&
+        !it->second.str_val.empty()) {
+        const std::string& name = it->second.str_val;
+        has_policy = true;
+        if (name == "fifo") {
+            policy = thread_utils::SchedPolicy::FIFO;
+        } else if (name == "rr") {
+            policy = thread_utils::SchedPolicy::RR;
+        } else if (name != "other") {
+            fail("Invalid LOOP_SCHED_POLICY: " + name);
+            has_policy = false;
+        }
+    }
+
+    // Negative nice values arrive as wrapped uint64_t (ConfigValue(int))
+    bool has_nice = false;
+    int nice_value = 0;
+    it = config.find(ConfigKey::LOOP_NICE);
+    if (it != config.end() && it->second.type == ConfigValueType::UINT64) {
+        has_nice = true;
+        nice_value = static_cast<int>(static_cast<int64_t>(it->second.uint_val));
+    }
+
+    if (has_policy || has_nice) {
+        if (!thread_utils::setSchedPolicy(policy, nice_value)) {
+            fail(std::string("Failed to set scheduling policy ") +
+                 thread_utils::schedPolicyName(policy) + " (nice " + std::to_string(nice_value) + ")");
+        }
+    }
+
+    it = config.find(ConfigKey::LOOP_SCHED_PRIORITY);
+    if (it != config.end() && it->second.type == ConfigValueType::UINT64) {
+        if (!thread_utils::setThreadPriority(static_cast<int>(it->second.uint_val))) {
+            fail("Failed to set priority " + std::to_string(it->second.uint_val));
+        }
+    }
+
+    // Power save: the kernel may defer the loop's timeouts to batch wakeups
+    it = config.find(ConfigKey::POWER_SAVE_MODE);
+    if (it != config.end() && it->second.type == ConfigValueType::BOOL && it->second.bool_val) {
+        uint64_t slack_ms = POWER_SAVE_SLACK_MS;
+        auto slack = config.find(ConfigKey::TIMER_SLACK_MS);
+        if (slack != config.end() && slack->second.type == ConfigValueType::UINT64) {
+            slack_ms = slack->second.uint_val;
+        }
+#if defined(__linux__)
+        if (slack_ms > 0 && !thread_utils::setCurrentThreadTimerSlack(slack_ms * 1000000ULL)) {
+            fail("Failed to set timer slack " + std::to_string(slack_ms) + "ms");
+        }
+#else
+        (void)slack_ms;  // Apple platforms coalesce timers on their own
+#endif
+    }
+
+    thread_utils::ThreadSchedInfo applied;
+    if (thread_utils::getCurrentThreadSchedInfo(applied)) {
+        info.cpus = thread_utils::formatCpuList(applied.cpus);
+        info.sched_policy = thread_utils::schedPolicyName(applied.policy);
+        info.sched_priority = applied.priority;
+        info.nice_value = applied.nice_value;
+        info.timer_slack_ns = applied.timer_slack_ns;
+    }
+    info.error = errors;
+    info.started = true;
+    return info;
+}
+
+std::string formatAddress(const struct sockaddr_storage* addr, socklen_t addr_len) {
+    char host[NI_MAXHOST];
+    char serv[NI_MAXSERV];
+    if (getnameinfo(reinterpret_cast<const struct sockaddr*>(addr), addr_len,
+                    host, sizeof(host), serv, sizeof(serv),
+                    NI_NUMERICHOST | NI_NUMERICSERV) != 0) {
+        return "";
+    }
+    return std::string(host) + ":" + serv;
+}
+
+bool sameAddress(const struct sockaddr_storage* a, const struct sockaddr_storage* b) {
+    if (a->ss_family != b->ss_family) {
+        return false;
+    }
+
+    if (a->ss_family == AF_INET) {
+        const struct sockaddr_in* a4 = reinterpret_cast<const struct sockaddr_in*>(a);
+        const struct sockaddr_in* b4 = reinterpret_cast<const struct sockaddr_in*>(b);
+        return a4->sin_port == b4->sin_port &&
+               a4->sin_addr.s_addr == b4->sin_addr.s_addr;
+    }
+
+    if (a->ss_family == AF_INET6) {
+        const struct sockaddr_in6* a6 = reinterpret_cast<const struct sockaddr_in6*>(a);
+        const struct sockaddr_in6* b6 = reinterpret_cast<const struct sockaddr_in6*>(b);
+        return a6->sin6_port == b6->sin6_port &&
+               memcmp(&a6->sin6_addr, &b6->sin6_addr, sizeof(a6->sin6_addr)) == 0;
+    }
+
+    return false;
+}
+
+bool generateConnectionId(uint8_t* cid, size_t len) {
+    int rng = open("/dev/urandom", O_RDONLY);
+    if (rng < 0) {
+        return false;
+    }
+
+    ssize_t rand_len = ::read(rng, cid, len);
+    ::close(rng);
+
+    return rand_len == static_cast<ssize_t>(len);
+}
+
+// ============================================================================
+// Request/Response Calls (event loop thread only)
+// ============================================================================
+
+void QuicheEngineImpl::startQueuedCalls() {
+    // Only on the connection that won: 0-RTT streams could die with a
+    // handshake that fails over to another address
+    if (mRpcQueued.empty() || !mConn || !quiche_conn_is_established(mConn)) {
+        return;
+    }
+
+    while (!mRpcQueued.empty()) {
+        // Out of stream credit: wait for MAX_STREAMS from the peer
+        if (quiche_conn_peer_streams_left_bidi(mConn) == 0) {
+            if (!mRpcCreditBlocked) {
+                mRpcCreditBlocked = true;
+                mRpcCreditStalls++;
+            }
+            return;
+        }
+        mRpcCreditBlocked = false;
+
+        // Open the stream right away (empty write), so the credit check
+        // above sees it even while the request waits in the scheduler
+        if (mRpcStreamId == UINT64_MAX) {
+            mRpcStreamId = openStream();
+        }
+        uint64_t stream_id = mRpcStreamId;
+        uint8_t none = 0;
+        uint64_t error_code;
+        ssize_t opened = quiche_conn_stream_send(mConn, stream_id, &none, 0, false, &error_code);
+        if (opened == QUICHE_ERR_STREAM_LIMIT) {
+            if (!mRpcCreditBlocked) {
+                mRpcCreditBlocked = true;
+                mRpcCreditStalls++;
             }
+            return;
+        }
+        mRpcStreamId = UINT64_MAX;
+        if (opened < 0) {
+            continue;  // Already finished by the application: try the next one
         }
+
+        RpcCall* call = mRpcQueued.front();
+        mRpcQueued.pop_front();
+        mRpcQueuedCount--;
+        call->stream_id = stream_id;
+        mRpcActive[stream_id] = call;
+        mRpcActiveCount++;
+
+        // Request with FIN, through the scheduler like any stream write
+        size_t offset = 0;
+        do {
+            size_t len = std::min(call->request.size() - offset, MAX_WRITE_DATA_SIZE);
+            auto* cmd = Command::newWrite(len);
+            cmd->params.write.stream_id = stream_id;
+            if (len > 0) {
+                memcpy(cmd->params.write.data, call->request.data() + offset, len);
+            }
+            offset += len;
+            cmd->params.write.fin = offset == call->request.size();
+            cmd->params.write.deadline_ns = 0;
+            mScheduler.enqueue(cmd);
+        } while (offset < call->request.size());
     }
+}
 
-    return stats;
+bool QuicheEngineImpl::readCallResponse(uint64_t stream_id) {
+    auto it = mRpcActive.find(stream_id);
+    if (it == mRpcActive.end()) {
+        return false;
+    }
+    RpcCall* call = it->second;
+
+    // Straight from quiche into the response, in 64KB steps
+    while (true) {
+        size_t used = call->response.size();
+        call->response.resize(used + MAX_WRITE_DATA_SIZE);
+
+        bool fin = false;
+        uint64_t error_code;
+        ssize_t read_len = quiche_conn_stream_recv(mConn, stream_id, call->response.data() + used,
+                                                   MAX_WRITE_DATA_SIZE, &fin, &error_code);
+        call->response.resize(used + (read_len > 0 ? static_cast<size_t>(read_len) : 0));
+
+        if (read_len == QUICHE_ERR_DONE) {
+            return true;
+        }
+        if (read_len < 0) {
+            mRpcActive.erase(it);
+            mRpcActiveCount--;
+            finishCall(call, read_len == QUICHE_ERR_STREAM_RESET
+                                 ? "Stream reset by peer (error " + std::to_string(error_code) + ")"
+                                 : "Failed to read response (error " + std::to_string(read_len) + ")");
+            return true;
+        }
+        if (fin) {
+            mRpcActive.erase(it);
+            mRpcActiveCount--;
+            finishCall(call, std::string());
+            return true;
+        }
+    }
+}
+
+void QuicheEngineImpl::finishCall(RpcCall* call, const std::string& error) {
+    RpcResponse response;
+    response.ok = error.empty();
+    response.data.swap(call->response);
+    response.error = error;
+    response.stream_id = call->stream_id;
+    response.latency_us = (monotonicNowNs() - call->queued_ns) / 1000;
+
+    if (response.ok) {
+        mRpcLatency.record(response.latency_us);
+        mRpcCompleted++;
+    } else {
+        mRpcFailed++;
+    }
+
+    call->promise.set_value(std::move(response));
+    mRpcPool.release(call);
+}
+
+void QuicheEngineImpl::failCalls(const std::string& error) {
+    for (RpcCall* call : mRpcQueued) {
+        mRpcQueuedCount--;
+        finishCall(call, error);
+    }
+    mRpcQueued.clear();
+
+    for (auto& pair : mRpcActive) {
+        mRpcActiveCount--;
+        finishCall(pair.second, error);
+    }
+    mRpcActive.clear();
 }
 
 // ============================================================================
@@ -884,37 +3197,58 @@ StreamReadBuffer* QuicheEngineImpl::getOrCreateStreamBuffer(uint64_t stream_id)
 
     // Create new buffer
     StreamReadBuffer* buffer = new StreamReadBuffer();
+    buffer->limit = mLowMemory ? LOW_MEMORY_STREAM_BUFFER : 0;
     mStreamBuffers[stream_id] = buffer;
 
     return buffer;
 }
 
-void QuicheEngineImpl::readFromQuicheToBuffer(uint64_t stream_id) {
+ssize_t QuicheEngineImpl::readFromQuicheToBuffer(uint64_t stream_id) {
     // This is called from event loop thread only - no mConn locking needed!
 
     StreamReadBuffer* buffer = getOrCreateStreamBuffer(stream_id);
 
-    // Read data from quiche into temporary buffer
-    uint8_t temp_buf[65536];
+    // Read straight into the buffer's tail (the application copies out
+    // under the same lock)
+    std::lock_guard<std::mutex> lock(buffer->mMutex);
+
+    // Drop the consumed front once it is at least half the buffer
+    if (buffer->read_offset > 0 && buffer->read_offset >= buffer->data.size() / 2) {
+        buffer->data.erase(buffer->data.begin(), buffer->data.begin() + buffer->read_offset);
+        buffer->read_offset = 0;
+    }
+
+    size_t room = MAX_STREAM_READ_SIZE;
+    if (buffer->limit > 0) {
+        size_t buffered = buffer->data.size() - buffer->read_offset;
+        if (buffered >= buffer->limit) {
+            // Leave the rest in quiche: its flow control holds the peer back
+            buffer->throttled = true;
+            return 0;
+        }
+        room = std::min(room, buffer->limit - buffered);
+    }
+
+    size_t used = buffer->data.size();
+    buffer->data.resize(used + room);
+
     bool local_fin = false;
     uint64_t error_code;
+    ssize_t read_len = quiche_conn_stream_recv(mConn, stream_id, buffer->data.data() + used,
+                                                room, &local_fin, &error_code);
 
-    ssize_t read_len = quiche_conn_stream_recv(mConn, stream_id, temp_buf,
-                                                sizeof(temp_buf), &local_fin, &error_code);
-
+    // Error or no data available
+    buffer->data.resize(used + (read_len > 0 ? static_cast<size_t>(read_len) : 0));
     if (read_len < 0) {
-        // Error or no data available
-        return;
+        return read_len;
     }
 
-    // Append to buffer
-    {
-        std::lock_guard<std::mutex> lock(buffer->mMutex);
-        buffer->data.insert(buffer->data.end(), temp_buf, temp_buf + read_len);
-        if (local_fin) {
-            buffer->fin_received = true;
-        }
+    if (local_fin) {
+        buffer->fin_received = true;
+    } else if (buffer->limit > 0 && buffer->data.size() - buffer->read_offset >= buffer->limit) {
+        buffer->throttled = true;
     }
+    return read_len;
 }
 
 // Generate random hex string for SCID (8 characters)
@@ -5,12 +5,26 @@
 
 #include <cstring>
 #include <memory>
+#include <new>
 #include <map>
+#include <atomic>
+#include <deque>
+#include <queue>
 #include <vector>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 
 #include "quiche_thread_utils.h"
+#include "quiche_engine_runtime_impl.h"
+#include "quiche_send_scheduler.h"
+#include "quiche_timer_wheel.h"
+#include "quiche_resolver.h"
+#include "quiche_io_arena.h"
+#include "quiche_udp_endpoint.h"
+#include "quiche_event_queue.h"
+#include "quiche_engine_config_impl.h"
+#include "quiche_rpc.h"
 
 extern "C" {
 #include <sys/types.h>
@@ -26,13 +40,33 @@ constexpr size_t LOCAL_CONN_ID_LEN = 16;
 constexpr size_t MAX_DATAGRAM_SIZE = 1350;
 constexpr size_t MAX_RECV_BUF_SIZE = 2048;  // Sufficient for receiving any UDP packet
 constexpr int BATCH_SIZE = 32;  // Batch size for recvmmsg/sendmmsg
+constexpr size_t SEND_SLOT_SIZE = alignToCacheLine(MAX_DATAGRAM_SIZE);  // Send buffer stride in the I/O arena
 constexpr size_t MAX_WRITE_DATA_SIZE = 65536;
+constexpr uint64_t MIN_KEEP_ALIVE_MS = 1000;  // Floor for configured and adaptive keep-alive
+constexpr size_t MAX_STREAM_READ_SIZE = 65536;  // Bytes moved from quiche per stream read
+
+// LOW_MEMORY_MODE profile
+constexpr size_t LOW_MEMORY_STREAM_BUFFER = 16384;    // Buffered bytes per stream before reads pause
+constexpr size_t LOW_MEMORY_LOOP_STACK = 256 * 1024;  // Dedicated loop thread stack
+constexpr uint64_t LOW_MEMORY_IO_IDLE_MS = 1000;      // I/O buffers go back to the pool after this
+
+// POWER_SAVE_MODE profile
+constexpr uint64_t POWER_SAVE_SLACK_MS = 10;                 // Default TIMER_SLACK_MS
+constexpr uint64_t POWER_SAVE_LAX_TIMEOUT_NS = 1000000000ULL;  // quiche timeouts this far out are rounded
 
 // Command types for thread-safe communication
 enum class CommandType {
     WRITE,
     CLOSE,
     STOP,
+    PROBE_PATH,
+    MIGRATE,
+    STREAM_SCHEDULE,
+    CONNECT,    // Resolve (or use preset addresses) and start the handshake
+    RESOLVED,   // Asynchronous lookup finished, result in mResolveWaiter
+    SET_IDLE_TIMEOUT,
+    RPC_CALL,   // Queue a call() until it can get a stream
+    STREAM_READ,  // Application drained a stream whose reads paused at its buffer limit
 };
 
 // Command structure
@@ -42,9 +76,10 @@ struct Command {
     // Write command data
     struct WriteData {
         uint64_t stream_id;
-        uint8_t data[MAX_WRITE_DATA_SIZE];
+        uint8_t* data;         // len bytes stored right after the Command (newWrite())
         size_t len;
         bool fin;
+        uint64_t deadline_ns;  // Reset the stream unless complete by then (0 = none)
     };
 
     // Close command data
@@ -53,14 +88,65 @@ struct Command {
         char reason[256];
     };
 
+    // Path command data (local address of the new path)
+    struct PathData {
+        struct sockaddr_storage local_addr;
+        socklen_t local_addr_len;
+    };
+
+    // Stream scheduling parameters
+    struct ScheduleData {
+        uint64_t stream_id;
+        uint32_t weight;
+        uint64_t max_rate;   // Bytes per second, 0 = unlimited
+        uint64_t burst;      // Bytes, 0 = default
+    };
+
+    // Local idle timeout
+    struct IdleData {
+        uint64_t timeout_ms;
+    };
+
+    // Request/response call (owned by the engine from submission on)
+    struct RpcData {
+        RpcCall* call;
+    };
+
+    // Stream to read again
+    struct ReadData {
+        uint64_t stream_id;
+    };
+
     union {
         WriteData write;
         CloseData close;
+        PathData path;
+        ScheduleData schedule;
+        IdleData idle;
+        RpcData rpc;
+        ReadData read;
     } params;
 
+    uint64_t conn_handle;  // Target connection (server engine only, 0 = all)
+
     Command* next;
 
-    Command() : next(nullptr) {}
+    Command() : conn_handle(0), next(nullptr) {}
+
+    // Write command with room for len bytes of payload in the same
+    // allocation, so a queued write costs its size rather than the largest
+    // write (released with delete like any command)
+    static Command* newWrite(size_t len) {
+        void* mem = ::operator new(sizeof(Command) + len);
+        Command* cmd = new (mem) Command();
+        cmd->type = CommandType::WRITE;
+        cmd->params.write.data = reinterpret_cast<uint8_t*>(cmd + 1);
+        cmd->params.write.len = len;
+        return cmd;
+    }
+
+    // Unsized, as newWrite() allocations are larger than sizeof(Command)
+    static void operator delete(void* ptr) { ::operator delete(ptr); }
 };
 
 // Command queue (thread-safe FIFO)
@@ -88,21 +174,104 @@ struct StreamReadBuffer {
     std::vector<uint8_t> data;
     size_t read_offset;
     bool fin_received;
+    size_t limit;      // Unread bytes the loop buffers at most (0 = unbounded)
+    bool throttled;    // Loop stopped reading at limit, data may wait in quiche
     std::mutex mMutex;  // C++ mutex (non-recursive)
 
-    StreamReadBuffer() : read_offset(0), fin_received(false) {}
+    StreamReadBuffer() : read_offset(0), fin_received(false), limit(0), throttled(false) {}
 
     ~StreamReadBuffer() = default;
 
+    // Copy out buffered data (application threads, takes mMutex). resume
+    // (optional) is set when a throttled stream has room again and the
+    // loop must be asked to read it.
+    ssize_t consume(uint8_t* buf, size_t buf_len, bool& fin, bool* resume = nullptr);
+
+    bool hasData() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return read_offset < data.size();
+    }
+
+    // The loop handed the end of the stream to the application directly
+    void setFin() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        fin_received = true;
+    }
+
     // Disable copy
     StreamReadBuffer(const StreamReadBuffer&) = delete;
     StreamReadBuffer& operator=(const StreamReadBuffer&) = delete;
 };
 
+// Additional UDP socket opened for a probed path (event loop thread only)
+struct PathSocket {
+    QuicheEngineImpl* engine;
+    int fd;
+    struct sockaddr_storage local_addr;
+    socklen_t local_addr_len;
+    ev_io watcher;
+    bool validated;
+
+    PathSocket() : engine(nullptr), fd(-1), local_addr_len(0), validated(false) {}
+};
+
+// Hand-off of an asynchronous lookup to the engine. The resolver thread
+// holds a reference; the engine clears `engine` before it goes away.
+struct ResolveWaiter {
+    std::mutex mutex;  // C++ mutex (non-recursive)
+    QuicheEngineImpl* engine;
+    bool ok;
+    std::vector<PeerAddress> peers;
+    std::string error;
+
+    explicit ResolveWaiter(QuicheEngineImpl* e) : engine(e), ok(false) {}
+};
+
+// Handshake racing mConn on another resolved address (RFC 8305). Promoted to
+// mConn/mSock if it completes first, closed otherwise (event loop thread only)
+struct ConnectAttempt {
+    QuicheEngineImpl* engine;
+    int fd;                  // -1 on a shared endpoint
+    UdpEndpoint* endpoint;   // Shared socket (SHARED_UDP_SOCKET), or nullptr
+    EndpointRoute route;
+    quiche_conn* conn;
+    struct sockaddr_storage local_addr;
+    socklen_t local_addr_len;
+    struct sockaddr_storage peer_addr;
+    socklen_t peer_addr_len;
+    uint64_t started_ns;
+    ev_io watcher;
+    TimerNode timer;
+
+    ConnectAttempt() : engine(nullptr), fd(-1), endpoint(nullptr), conn(nullptr),
+                       local_addr_len(0), peer_addr_len(0), started_ns(0) {}
+};
+
+// Fill EngineStats from quiche connection and path 0 statistics
+void fillConnectionStats(const quiche_conn* conn, EngineStats& stats);
+
+// Apply the LOOP_* config keys to the calling (event loop) thread and read
+// back what the OS granted; failures are reported in the result's error
+LoopThreadInfo applyLoopThreadConfig(const ConfigMap& config);
+
+// I/O arena backing from the IO_ARENA_* config keys
+IoArenaOptions ioArenaOptionsFromConfig(const ConfigMap& config);
+
+// Format a socket address as "ip:port" (empty string on failure)
+std::string formatAddress(const struct sockaddr_storage* addr, socklen_t addr_len);
+
+// Compare family, address and port of two socket addresses
+bool sameAddress(const struct sockaddr_storage* a, const struct sockaddr_storage* b);
+
+// Fill a connection ID (or reset token) with random bytes from /dev/urandom
+bool generateConnectionId(uint8_t* cid, size_t len);
+
 // Engine implementation class (PIMPL)
 class QuicheEngineImpl {
 public:
-    QuicheEngineImpl(const std::string& host, const std::string& port, const ConfigMap& config);
+    QuicheEngineImpl(const std::string& host, const std::string& port, const ConfigMap& config,
+                     std::shared_ptr<EngineRuntime> runtime = nullptr,
+                     struct ev_loop* external_loop = nullptr);
     ~QuicheEngineImpl();
 
     // Disable copy
@@ -112,15 +281,35 @@ public:
     // Public API implementation
     void setWrapper(QuicheEngine* w) { mWrapper = w; }
     bool setEventCallback(EventCallback callback, void* user_data);
-    ssize_t write(const uint8_t* data, size_t len, bool fin);
+    bool setEventBatchCallback(EventBatchCallback callback, void* user_data);
+    size_t pollEvents(size_t max_events, int timeout_ms);
+    bool setEngineConfig(std::shared_ptr<EngineConfig> config);
+    bool setSessionCache(std::shared_ptr<SessionCache> cache);
+    bool addPeerAddress(const struct sockaddr* addr, socklen_t addr_len);
+    ssize_t write(const uint8_t* data, size_t len, bool fin, uint64_t deadline_ms);
     ssize_t read(uint8_t* buf, size_t buf_len, bool& fin);
+    ssize_t writeStream(uint64_t stream_id, const uint8_t* data, size_t len, bool fin,
+                        uint64_t deadline_ms);
+    ssize_t readStream(uint64_t stream_id, uint8_t* buf, size_t buf_len, bool& fin);
+    bool setStreamSchedule(uint64_t stream_id, uint32_t weight, uint64_t max_rate, uint64_t burst);
+    uint64_t openStream();
+    std::future<RpcResponse> call(const uint8_t* request, size_t len);
+    RpcStats getRpcStats() const;
     bool start();
     void shutdown(uint64_t app_error, const std::string& reason);
     bool isConnected() const { return mIsConnected; }
     bool isRunning() const { return mIsRunning; }
     EngineStats getStats() const;
     std::string getLastError() const { return mLastError; }
+
+    LoopThreadInfo getLoopThreadInfo() const {
+        std::lock_guard<std::mutex> lock(mLoopThreadInfoMutex);
+        return mLoopThreadInfo;
+    }
     std::string getScid() const { return mScid; }
+    bool probePath(const std::string& local_host, const std::string& local_port);
+    bool migrate();
+    bool setIdleTimeout(uint64_t timeout_ms);
 
 private:
     // Configuration
@@ -129,11 +318,14 @@ private:
     ConfigMap mConfig;
 
     // QUIC objects (accessed only from event loop thread - no locking needed!)
-    quiche_config* mQuicheCfg;
+    std::shared_ptr<EngineConfig> mEngineConfig;  // quiche_config, possibly shared with other engines
     quiche_conn* mConn;
 
     // Network
-    int mSock;
+    int mSock;                // -1 while mEndpoint carries the connection
+    bool mShareSocket;        // SHARED_UDP_SOCKET on a runtime loop
+    UdpEndpoint* mEndpoint;   // The loop's shared socket, or nullptr
+    EndpointRoute mRoute;     // Our connection IDs on mEndpoint
     struct sockaddr_storage mLocalAddr;
     socklen_t mLocalAddrLen;
     struct sockaddr_storage mPeerAddr;
@@ -142,34 +334,185 @@ private:
     // Event loop
     struct ev_loop* mLoop;
     ev_io mIoWatcher;
-    ev_timer mTimer;
     ev_async mAsyncWatcher;
-    std::thread mLoopThread;  // C++11 thread (replaces pthread_t)
+    TimerNode mTimer;         // quiche timeout + scheduler wakeup
+    LoopTimer mOwnTimers;     // Timer wheel of the dedicated loop
+    LoopTimer* mTimers;       // mOwnTimers, or the shared loop's wheel
+    thread_utils::StackThread mLoopThread;  // Dedicated loop thread (stack size per profile)
     bool mThreadStarted;
+    std::atomic<std::thread::id> mLoopThreadId;  // Set while mLoopThread runs the loop
+
+    // Shared runtime loop (nullptr = dedicated loop thread owned by this engine)
+    std::shared_ptr<EngineRuntime> mRuntime;
+    EventLoop* mEventLoop;
+
+    // Caller's loop (external mode): API calls run inline on its thread
+    struct ev_loop* mExternalLoop;
+
+    bool mStarted;
+    bool mWatchersAttached;  // Watchers started on mLoop (event loop thread only)
+
+    // API calls made on the loop thread run inline; their flush waits until
+    // the application callback returns (once for all of them) or, outside
+    // callbacks, for the next loop iteration (event loop thread only)
+    unsigned mCallbackDepth;
+    bool mInFlush;
+    bool mFlushPending;
+
+    // Sockets of probed paths; mSock stays open for the original path
+    // (event loop thread only)
+    std::vector<PathSocket*> mPathSockets;
+
+    // Addresses from addPeerAddress() (skip DNS), and the pending lookup
+    std::vector<PeerAddress> mPresetPeers;
+    std::shared_ptr<ResolveWaiter> mResolveWaiter;
+    uint64_t mResolveStartedNs;
+    std::atomic<uint64_t> mResolveTimeUs;
+
+    // Happy eyeballs: addresses not tried yet, handshakes racing mConn and
+    // the stagger timer that starts the next one (event loop thread only)
+    std::deque<PeerAddress> mPendingPeers;
+    std::vector<ConnectAttempt*> mAttempts;
+    TimerNode mRaceTimer;
+    uint64_t mAttemptDelayNs;
+    uint64_t mConnStartedNs;   // When mConn's handshake began
+    std::atomic<uint64_t> mConnectTimeV4Us;
+    std::atomic<uint64_t> mConnectTimeV6Us;
+    std::atomic<size_t> mConnectAttempts;
+
+    // Keep-alive: PING before the idle timeout when nothing was received for
+    // a while; the interval shrinks after signs of NAT rebinding
+    // (event loop thread only, except the atomics read by getStats())
+    TimerNode mKeepAliveTimer;
+    uint64_t mIdleTimeoutMs;          // Local max_idle_timeout (0 = none)
+    uint64_t mKeepAliveBaseNs;        // Configured interval (0 = disabled)
+    uint64_t mKeepAliveIntervalNs;    // Current, adaptive interval
+    uint64_t mLastRecvNs;             // Last time mConn's sockets were readable
+    uint64_t mLastKeepAliveNs;        // Last PING sent
+    unsigned mKeepAliveAnswered;      // Consecutive keep-alives answered
+    uint32_t mJitterState;            // xorshift state for keep-alive jitter
+    std::atomic<size_t> mKeepAlivesSent;
+    std::atomic<uint64_t> mKeepAliveIntervalMs;
+    std::atomic<size_t> mIoArenaBytes;       // For getStats(): mIoArena is loop-thread state
+    std::atomic<bool> mIoArenaHugePages;
 
     // Command queue
     CommandQueue mCmdQueue;
 
+    // Queued stream writes, fed to quiche as capacity and rate limits allow.
+    // Holds writes issued before the handshake can carry stream data.
+    // (event loop thread only)
+    SendScheduler mScheduler;
+    uint64_t mSchedulerWakeupNs;          // 0 = not waiting on tokens
+    std::atomic<size_t> mSendQueueBytes;  // Mirror of mScheduler.queuedBytes() for getStats()
+    std::atomic<size_t> mWriteCmdBytes;   // In WRITE commands the loop has not taken yet
+    std::atomic<size_t> mWriteCmds;       // WRITE commands the loop has not taken yet
+
+    // quiche's connection stats, copied on the loop thread after each flush:
+    // getStats() must not touch mConn, which happy eyeballs frees and replaces
+    mutable std::mutex mConnStatsMutex;
+    EngineStats mConnStats;  // Connection fields only
+
+    // Write deadlines: stream -> deadline of its latest write with one
+    // (until the peer acknowledged the stream up to its FIN), and a
+    // min-heap of (deadline, stream) entries, stale ones skipped when
+    // popped (event loop thread only, except the atomics)
+    typedef std::pair<uint64_t, uint64_t> DeadlineEntry;
+    std::unordered_map<uint64_t, uint64_t> mStreamDeadlines;
+    std::priority_queue<DeadlineEntry, std::vector<DeadlineEntry>, std::greater<DeadlineEntry>> mDeadlines;
+    TimerNode mDeadlineTimer;
+    std::atomic<size_t> mWritesExpired;
+    std::atomic<size_t> mExpiredBytes;
+
+    // Next unused client bidi stream (openStream(), call(), raised past
+    // streams the application writes to; any thread)
+    std::atomic<uint64_t> mNextStreamId;
+
+    // Request/response calls: one client bidi stream per call, started in
+    // order while the peer grants stream credit (event loop thread only,
+    // except mRpcPool, mRpcLatency and the atomics read by getRpcStats())
+    RpcCallPool mRpcPool;
+    std::deque<RpcCall*> mRpcQueued;
+    std::unordered_map<uint64_t, RpcCall*> mRpcActive;  // Stream -> call
+    uint64_t mRpcStreamId;    // Reserved for the next call (UINT64_MAX = none)
+    bool mRpcCreditBlocked;
+    LatencyHistogram mRpcLatency;
+    std::atomic<size_t> mRpcCompleted;
+    std::atomic<size_t> mRpcFailed;
+    std::atomic<size_t> mRpcActiveCount;
+    std::atomic<size_t> mRpcQueuedCount;
+    std::atomic<size_t> mRpcCreditStalls;
+
+    // TLS session resumption
+    std::shared_ptr<SessionCache> mSessionCache;
+    bool mSessionCacheSet;     // Explicitly configured via setSessionCache()
+    size_t mEarlyDataBytes;    // Stream bytes accepted while in early data
+
     // Stream read buffers (populated by event loop thread)
     std::map<uint64_t, StreamReadBuffer*> mStreamBuffers;
-    std::mutex mStreamBuffersMutex;  // Protect map access (C++ mutex, non-recursive)
+    mutable std::mutex mStreamBuffersMutex;  // Protect map access (C++ mutex, non-recursive)
 
     // Callbacks
     EventCallback mEventCallback;
     void* mUserData;
     QuicheEngine* mWrapper;  // Pointer back to wrapper for event callbacks
+    std::unique_ptr<EventQueue> mEventQueue;  // EVENT_QUEUE_SIZE: delivered by pollEvents()
+    std::mutex mPollMutex;  // One pollEvents() caller at a time (C++ mutex, non-recursive)
+    std::vector<QueuedEvent> mPollEvents;   // pollEvents() batch (under mPollMutex)
+    std::vector<EventRecord> mPollRecords;
+
+    // Batched delivery: the events of one loop iteration, handed over by
+    // mBatchWatcher before the loop blocks (event loop thread only)
+    struct PendingEvent {
+        EngineEvent event;
+        EventDataType type;
+        uint64_t uint_val;
+        size_t str_offset;   // Into mBatchStrings
+        size_t str_len;
+    };
+    EventBatchCallback mEventBatchCallback;
+    void* mBatchUserData;
+    ev_prepare mBatchWatcher;
+    std::vector<PendingEvent> mBatch;
+    std::string mBatchStrings;              // NUL-separated string payloads
+    std::vector<EventRecord> mBatchOut;     // Array passed to the callback
+    std::string mBatchOutStrings;
+    std::unordered_map<uint64_t, uint64_t> mReadableBatch;  // Stream -> batch with its STREAM_READABLE
+    uint64_t mBatchSeq;
+    bool mWritableBatched;
+    bool mDispatchingBatch;
 
     // State
     bool mIsRunning;
     bool mIsConnected;
     std::string mLastError;
+
+    // Written by the dedicated loop thread once it started, read by any thread
+    mutable std::mutex mLoopThreadInfoMutex;
+    LoopThreadInfo mLoopThreadInfo;
     std::string mScid;  // Source Connection ID (8-char hex string)
     uint64_t mStreamId;  // Default stream ID for read/write operations
 
-    // I/O buffers (heap memory instead of static to reduce memory footprint)
+    // I/O buffers, carved from mIoArena on the loop thread by setupIoBuffers().
+    // LOW_MEMORY_MODE: the arena comes from mIoArenaPool on first I/O and
+    // goes back after LOW_MEMORY_IO_IDLE_MS without any
+    std::unique_ptr<IoArena> mIoArena;
+    bool mLowMemory;
+    std::shared_ptr<IoArenaPool> mIoArenaPool;
+    TimerNode mIoIdleTimer;
+    uint64_t mLastIoNs;
+    std::atomic<size_t> mLoopStackBytes;
+
+    // POWER_SAVE_MODE (mSlackNs 0 = off): lax timers fall due on multiples
+    // of mSlackNs. Once the loop drained commands, writes made before
+    // mCommandHoldNs do not wake it; mCommandTimer picks them up.
+    uint64_t mSlackNs;
+    std::atomic<uint64_t> mCommandHoldNs;
+    TimerNode mCommandTimer;
+    WakeupMeter mWakeups;  // Own loop only; a shared loop counts its own
 #if defined(__linux__)
     // Batch I/O buffers for Linux (using recvmmsg/sendmmsg)
-    uint8_t (*mSendBufs)[MAX_DATAGRAM_SIZE];     // Array of send buffers
+    uint8_t (*mSendBufs)[SEND_SLOT_SIZE];        // Array of send buffers
     uint8_t (*mRecvBufs)[MAX_RECV_BUF_SIZE];     // Array of recv buffers
     struct mmsghdr* mSendMsgs;                    // sendmmsg structures
     struct mmsghdr* mRecvMsgs;                    // recvmmsg structures
@@ -184,27 +527,109 @@ private:
 #endif
 
     // Helper methods
-    bool setupConnection();
+    bool setupIoBuffers(std::string& error);
+    bool acquireIoBuffers();   // LOW_MEMORY_MODE: before socket I/O
+    void releaseIoBuffers();
+    static void ioIdleFired(TimerNode* node);
+    static void commandTimerFired(TimerNode* node);
+    uint64_t laxDeadline(uint64_t deadline_ns) const { return roundDeadlineNs(deadline_ns, mSlackNs); }
+    bool setupConfig();
+    void beginConnect();
+    void onResolved();
+    bool connectTo(const std::vector<PeerAddress>& peers);
+    void failConnect(const std::string& error);
+    void pushConnect();
+    void applyIdleTimeout(uint64_t timeout_ms);
+    void scheduleKeepAlive();
+    void onNatRebinding();
+    uint64_t effectiveIdleTimeoutNs() const;
+    void initWatchers();
+    void attachWatchers();
+    void detachWatchers();
+    void stopLoop();
     void flushEgress();
+    void flushEgressOnce();
+    void snapshotConnStats();
+    void requestFlush();
+    void afterCallback();
+    bool sendPackets();      // Own socket(s): sendmmsg/sendmsg right away
+    bool sendToEndpoint();   // Shared socket: queued in the endpoint's batch
+    void receivePackets(quiche_conn* conn, int sock,
+                        const struct sockaddr_storage* local_addr, socklen_t local_addr_len);
+    void afterIngress();
+    int socketForAddress(const struct sockaddr_storage* from, socklen_t from_len) const;
+    void openPathSocket(const Command::PathData& path);
+    void closePathSocket(PathSocket* path);
+    void migrateToValidatedPath();
+    void processPathEvents();
+    void issueSourceConnectionIds();
+    void emitEvent(EngineEvent event, const EventData& data);
+    void batchEvent(EngineEvent event, const EventData& data);
+    void dispatchEventBatch();
     void processCommands();
+    void runCommand(Command* cmd, bool& need_flush);
+    void submitCommand(Command* cmd);
+    void queueCommand(Command* cmd);  // Always through mCmdQueue
+    bool onLoopThread() const;
+    void claimStreamId(uint64_t stream_id);
+    // Write from the loop thread straight into quiche when the scheduler
+    // holds nothing back. Returns the bytes accepted (complete: all of them
+    // and the FIN), -1 on a stream error
+    ssize_t sendInline(uint64_t stream_id, const uint8_t* data, size_t len, bool fin, bool& complete);
+    void runScheduler();
+    void armDeadlineTimer();
+    void expireStream(uint64_t stream_id);
+    void releaseDeadlines();
+    void startQueuedCalls();
+    bool readCallResponse(uint64_t stream_id);
+    void finishCall(RpcCall* call, const std::string& error);
+    void failCalls(const std::string& error);
+
+    // Happy eyeballs (event loop thread only)
+    bool openUdpSocket(int family, int& fd, struct sockaddr_storage& local, socklen_t& local_len);
+    bool bindLocalAddress(int fd, int family, const std::string& local_host);
+    bool openTransport(int family, int& fd, UdpEndpoint*& endpoint,
+                       struct sockaddr_storage& local, socklen_t& local_len);
+    quiche_conn* newConnection(const struct sockaddr_storage& local, socklen_t local_len,
+                               const struct sockaddr_storage& peer, socklen_t peer_len);
+    void startRace();
+    ConnectAttempt* startAttempt();
+    void attemptProgress(ConnectAttempt* a);
+    void flushAttempt(ConnectAttempt* a);
+    void dropAttempt(ConnectAttempt* a, bool send_close);
+    void promoteAttempt(ConnectAttempt* a);
+    bool failOver();
+    void abandonAttempts();
+    void recordConnectTime(int family, uint64_t started_ns);
+    void onConnectionClosed();
+    std::string sessionKey() const { return mHost + ":" + mPort; }
+    void resolveSessionCache();
+    void saveSession();
     StreamReadBuffer* getOrCreateStreamBuffer(uint64_t stream_id);
-    void readFromQuicheToBuffer(uint64_t stream_id);
+    ssize_t readFromQuicheToBuffer(uint64_t stream_id);
     std::string generateRandomHexString();  // Generate 8-char random hex string for SCID
 
     // Static callbacks
     static void eventLoopThread(QuicheEngineImpl* impl);  // C++11 thread function
     static void recvCallback(EV_P_ ev_io* w, int revents);
-    static void timeoutCallback(EV_P_ ev_timer* w, int revents);
+    static void pathRecvCallback(EV_P_ ev_io* w, int revents);
+    static void timerFired(TimerNode* node);
+    static void raceTimerFired(TimerNode* node);
+    static void attemptTimerFired(TimerNode* node);
+    static void keepAliveFired(TimerNode* node);
+    static void deadlineFired(TimerNode* node);
+    static void attemptRecvCallback(EV_P_ ev_io* w, int revents);
+    static void endpointDeliver(EndpointRoute* route, uint8_t* buf, size_t len,
+                                const struct sockaddr_storage* from, socklen_t from_len);
+    static void endpointDrained(EndpointRoute* route);
+    static void attemptDeliver(EndpointRoute* route, uint8_t* buf, size_t len,
+                               const struct sockaddr_storage* from, socklen_t from_len);
+    static void attemptDrained(EndpointRoute* route);
     static void asyncCallback(EV_P_ ev_async* w, int revents);
+    static void batchCallback(EV_P_ ev_prepare* w, int revents);
     static void debugLog(const char* line, void* argp);
 
-    // Config helper (C++11 compatible)
-    template<typename T>
-    T getConfigValue(ConfigKey key, T default_value) const {
-        return default_value;  // Generic version returns default
-    }
-
-    // Template specializations
+    // Config helpers (C++11 compatible, overloaded by value type)
     uint64_t getConfigValue(ConfigKey key, uint64_t default_value) const {
         auto it = mConfig.find(key);
         if (it != mConfig.end() && it->second.type == ConfigValueType::UINT64) {
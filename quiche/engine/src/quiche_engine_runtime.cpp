@@ -0,0 +1,109 @@
+// quiche_engine_runtime.cpp
+// Engine Runtime - shared event loop threads for many engines
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+
+#include "quiche_engine_runtime_impl.h"
+
+#include <functional>
+#include <iostream>
+#include <thread>
+
+namespace quiche {
+
+// ============================================================================
+// EngineRuntimeImpl Implementation
+// ============================================================================
+
+EngineRuntimeImpl::EngineRuntimeImpl(size_t num_loops, LoopAssignment assignment)
+    : mAssignment(assignment)
+{
+    if (num_loops == 0) {
+        num_loops = std::thread::hardware_concurrency();
+        if (num_loops == 0) {
+            num_loops = 1;
+        }
+    }
+
+    for (size_t i = 0; i < num_loops; i++) {
+        // Linux thread names are limited to 15 characters
+        std::unique_ptr<EventLoop> loop(new EventLoop("QuicLoop-" + std::to_string(i)));
+        if (!loop->start()) {
+            std::cerr << "[ENGINE] Failed to start runtime loop " << i << std::endl;
+            continue;
+        }
+        mLoops.push_back(std::move(loop));
+    }
+}
+
+EngineRuntimeImpl::~EngineRuntimeImpl() {
+    for (auto& loop : mLoops) {
+        if (loop->load() > 0) {
+            std::cerr << "[ENGINE] Runtime destroyed with " << loop->load()
+                      << " engine(s) still attached" << std::endl;
+        }
+        loop->stop();
+    }
+}
+
+EventLoop* EngineRuntimeImpl::acquireLoop(const std::string& key) {
+    if (mLoops.empty()) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mAssignMutex);
+
+    EventLoop* selected = mLoops[0].get();
+    if (mAssignment == LoopAssignment::HASH) {
+        size_t index = std::hash<std::string>()(key) % mLoops.size();
+        selected = mLoops[index].get();
+    } else {
+        for (auto& loop : mLoops) {
+            if (loop->load() < selected->load()) {
+                selected = loop.get();
+            }
+        }
+    }
+
+    selected->addLoad();
+    return selected;
+}
+
+void EngineRuntimeImpl::releaseLoop(EventLoop* loop) {
+    if (loop) {
+        loop->removeLoad();
+    }
+}
+
+std::vector<size_t> EngineRuntimeImpl::loopLoads() const {
+    std::vector<size_t> loads;
+    loads.reserve(mLoops.size());
+    for (const auto& loop : mLoops) {
+        loads.push_back(loop->load());
+    }
+    return loads;
+}
+
+// ============================================================================
+// EngineRuntime Public API - Delegates to Impl
+// ============================================================================
+
+EngineRuntime::EngineRuntime(size_t num_loops, LoopAssignment assignment)
+    : mPImpl(new EngineRuntimeImpl(num_loops, assignment))
+{
+}
+
+EngineRuntime::~EngineRuntime() {
+    delete mPImpl;
+}
+
+size_t EngineRuntime::loopCount() const {
+    return mPImpl->loopCount();
+}
+
+std::vector<size_t> EngineRuntime::loopLoads() const {
+    return mPImpl->loopLoads();
+}
+
+} // namespace quiche
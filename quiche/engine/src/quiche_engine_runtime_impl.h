@@ -0,0 +1,40 @@
+#ifndef __QUICHE_ENGINE_RUNTIME_IMPL_H__
+#define __QUICHE_ENGINE_RUNTIME_IMPL_H__
+
+#include <quiche_engine_runtime.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "quiche_event_loop.h"
+
+namespace quiche {
+
+// Runtime implementation class (PIMPL)
+class EngineRuntimeImpl {
+public:
+    EngineRuntimeImpl(size_t num_loops, LoopAssignment assignment);
+    ~EngineRuntimeImpl();
+
+    // Disable copy
+    EngineRuntimeImpl(const EngineRuntimeImpl&) = delete;
+    EngineRuntimeImpl& operator=(const EngineRuntimeImpl&) = delete;
+
+    // Pick a loop for a new engine and account for it
+    EventLoop* acquireLoop(const std::string& key);
+    void releaseLoop(EventLoop* loop);
+
+    size_t loopCount() const { return mLoops.size(); }
+    std::vector<size_t> loopLoads() const;
+
+private:
+    std::vector<std::unique_ptr<EventLoop>> mLoops;
+    LoopAssignment mAssignment;
+    std::mutex mAssignMutex;  // Serializes least-load selection
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_ENGINE_RUNTIME_IMPL_H__
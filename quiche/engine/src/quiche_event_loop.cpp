@@ -0,0 +1,198 @@
+// quiche_event_loop.cpp
+// Shared event loop thread with a cross-thread task queue
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+
+#include "quiche_event_loop.h"
+#include "quiche_thread_utils.h"
+
+#include <future>
+#include <system_error>
+
+namespace quiche {
+
+// ============================================================================
+// WakeupMeter Implementation
+// ============================================================================
+
+WakeupMeter::WakeupMeter()
+    : mLoop(nullptr), mTotal(0), mPrevNs(0), mPrevTotal(0), mCurNs(0), mCurTotal(0)
+{
+    ev_check_init(&mWatcher, checkCallback);
+    mWatcher.data = this;
+}
+
+void WakeupMeter::attach(struct ev_loop* loop) {
+    if (mLoop) {
+        return;
+    }
+    mLoop = loop;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCurNs = monotonicNowNs();
+        mCurTotal = mTotal.load(std::memory_order_relaxed);
+        mPrevNs = 0;
+    }
+
+    ev_check_start(mLoop, &mWatcher);
+    ev_unref(mLoop);  // Counting wakeups is no reason to keep running
+}
+
+void WakeupMeter::detach() {
+    if (!mLoop) {
+        return;
+    }
+    ev_ref(mLoop);
+    ev_check_stop(mLoop, &mWatcher);
+    mLoop = nullptr;
+}
+
+double WakeupMeter::perSecond() const {
+    uint64_t now_ns = monotonicNowNs();
+    uint64_t total = mTotal.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mPrevNs == 0 || now_ns <= mPrevNs) {
+        return 0.0;
+    }
+    return static_cast<double>(total - mPrevTotal) * 1000000000.0 / (now_ns - mPrevNs);
+}
+
+void WakeupMeter::checkCallback(EV_P_ ev_check* w, int revents) {
+    (void)EV_A;
+    (void)revents;
+
+    WakeupMeter* self = static_cast<WakeupMeter*>(w->data);
+    uint64_t total = self->mTotal.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    // New window once a second: a quiet loop is measured over its whole sleep
+    uint64_t now_ns = monotonicNowNs();
+    if (now_ns - self->mCurNs >= 1000000000ULL) {
+        std::lock_guard<std::mutex> lock(self->mMutex);
+        self->mPrevNs = self->mCurNs;
+        self->mPrevTotal = self->mCurTotal;
+        self->mCurNs = now_ns;
+        self->mCurTotal = total;
+    }
+}
+
+// ============================================================================
+// EventLoop Implementation
+// ============================================================================
+
+EventLoop::EventLoop(const std::string& thread_name)
+    : mThreadName(thread_name), mLoop(nullptr), mThreadId(std::thread::id()), mLoad(0)
+{
+    mLoop = ev_loop_new(EVFLAG_AUTO);
+    if (mLoop) {
+        // The task watcher also keeps ev_run() alive while no engine is attached
+        ev_async_init(&mTaskWatcher, taskCallback);
+        mTaskWatcher.data = this;
+        ev_async_start(mLoop, &mTaskWatcher);
+
+        mTimers.attach(mLoop);
+        mWakeups.attach(mLoop);
+    }
+}
+
+EventLoop::~EventLoop() {
+    stop();
+
+    if (mLoop) {
+        for (auto& endpoint : mEndpoints) {
+            endpoint.reset();  // Stops its watchers on mLoop
+        }
+        mTimers.detach();
+        mWakeups.detach();
+        ev_loop_destroy(mLoop);
+        mLoop = nullptr;
+    }
+}
+
+bool EventLoop::start() {
+    if (!mLoop || mThread.joinable()) {
+        return false;
+    }
+
+    try {
+        mThread = std::thread(threadMain, this);
+    } catch (const std::system_error&) {
+        return false;
+    }
+    return true;
+}
+
+void EventLoop::stop() {
+    if (!mThread.joinable()) {
+        return;
+    }
+
+    struct ev_loop* loop = mLoop;
+    post([loop]() { ev_break(loop, EVBREAK_ALL); });
+    mThread.join();
+}
+
+UdpEndpoint& EventLoop::endpoint(int family) {
+    std::unique_ptr<UdpEndpoint>& endpoint = mEndpoints[family == AF_INET6 ? 1 : 0];
+    if (!endpoint) {
+        endpoint.reset(new UdpEndpoint());
+    }
+    return *endpoint;
+}
+
+void EventLoop::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mTasksMutex);
+        mTasks.push_back(std::move(task));
+    }
+    ev_async_send(mLoop, &mTaskWatcher);
+}
+
+void EventLoop::runSync(const std::function<void()>& task) {
+    if (isInLoopThread() || !mThread.joinable()) {
+        task();
+        return;
+    }
+
+    std::promise<void> done;
+    std::future<void> waiter = done.get_future();
+    post([&task, &done]() {
+        task();
+        done.set_value();
+    });
+    waiter.wait();
+}
+
+void EventLoop::runTasks() {
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(mTasksMutex);
+        tasks.swap(mTasks);
+    }
+
+    for (auto& task : tasks) {
+        task();
+    }
+}
+
+void EventLoop::threadMain(EventLoop* self) {
+    // Before the first callback: runSync() from the loop runs inline
+    self->mThreadId.store(std::this_thread::get_id());
+    thread_utils::setCurrentThreadName(self->mThreadName);
+    ev_run(self->mLoop, 0);
+
+    // Tasks posted during shutdown still run (e.g. engine detach)
+    self->runTasks();
+    self->mThreadId.store(std::thread::id());
+}
+
+void EventLoop::taskCallback(EV_P_ ev_async* w, int revents) {
+    (void)EV_A;
+    (void)revents;
+
+    EventLoop* self = static_cast<EventLoop*>(w->data);
+    self->runTasks();
+}
+
+} // namespace quiche
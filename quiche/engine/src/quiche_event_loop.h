@@ -0,0 +1,117 @@
+#ifndef __QUICHE_EVENT_LOOP_H__
+#define __QUICHE_EVENT_LOOP_H__
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <ev.h>
+}
+
+#include "quiche_timer_wheel.h"
+#include "quiche_udp_endpoint.h"
+
+namespace quiche {
+
+// Wakeups of a libev loop (returns from its poll), counted by an ev_check
+// watcher that does not keep the loop alive. attach()/detach() on the loop
+// thread, the readers from any thread.
+class WakeupMeter {
+public:
+    WakeupMeter();
+
+    // Disable copy
+    WakeupMeter(const WakeupMeter&) = delete;
+    WakeupMeter& operator=(const WakeupMeter&) = delete;
+
+    void attach(struct ev_loop* loop);
+    void detach();
+
+    uint64_t total() const { return mTotal.load(std::memory_order_relaxed); }
+
+    // Average since the previous window began, at least a second ago (0
+    // until the first window is complete)
+    double perSecond() const;
+
+private:
+    struct ev_loop* mLoop;
+    ev_check mWatcher;
+    std::atomic<uint64_t> mTotal;
+
+    // Start of the previous and of the current window
+    mutable std::mutex mMutex;
+    uint64_t mPrevNs;
+    uint64_t mPrevTotal;
+    uint64_t mCurNs;
+    uint64_t mCurTotal;
+
+    static void checkCallback(EV_P_ ev_check* w, int revents);
+};
+
+// Event loop thread shared by several engines (EngineRuntime).
+// Watchers of attached engines may only be started/stopped on the loop
+// thread, so everything else is funneled through post().
+class EventLoop {
+public:
+    explicit EventLoop(const std::string& thread_name);
+    ~EventLoop();
+
+    // Disable copy
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    bool start();
+    void stop();
+
+    // Run task on the loop thread (thread-safe, FIFO)
+    void post(std::function<void()> task);
+
+    // Run task on the loop thread and wait for it (inline if already there)
+    void runSync(const std::function<void()>& task);
+
+    bool isInLoopThread() const { return std::this_thread::get_id() == mThreadId.load(); }
+    struct ev_loop* loop() const { return mLoop; }
+
+    // Connection timers of all engines on this loop (loop thread only)
+    LoopTimer& timers() { return mTimers; }
+
+    const WakeupMeter& wakeups() const { return mWakeups; }
+
+    // Shared client socket of an address family (loop thread only; created
+    // on first use, opened by the first engine that needs it)
+    UdpEndpoint& endpoint(int family);
+
+    // Number of engines currently assigned to this loop
+    size_t load() const { return mLoad.load(); }
+    void addLoad() { mLoad.fetch_add(1); }
+    void removeLoad() { mLoad.fetch_sub(1); }
+
+private:
+    std::string mThreadName;
+    struct ev_loop* mLoop;
+    ev_async mTaskWatcher;
+    LoopTimer mTimers;
+    WakeupMeter mWakeups;
+    std::unique_ptr<UdpEndpoint> mEndpoints[2];  // AF_INET, AF_INET6
+    std::thread mThread;
+    std::atomic<std::thread::id> mThreadId;  // Set by the loop thread while it runs
+
+    std::vector<std::function<void()>> mTasks;
+    std::mutex mTasksMutex;  // C++ mutex (non-recursive)
+
+    std::atomic<size_t> mLoad;
+
+    void runTasks();
+
+    static void threadMain(EventLoop* self);
+    static void taskCallback(EV_P_ ev_async* w, int revents);
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_EVENT_LOOP_H__
@@ -0,0 +1,163 @@
+// quiche_event_queue.cpp
+// Lock-free event hand-off from the event loop to an application thread
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+
+#include "quiche_event_queue.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace quiche {
+
+namespace {
+
+constexpr size_t MIN_CAPACITY = 16;
+constexpr size_t MAX_CAPACITY = 1 << 20;
+constexpr size_t MIN_SWEEP = 64;  // Coalescing entries kept before stale ones are swept
+
+size_t roundUpPow2(size_t n) {
+    size_t v = MIN_CAPACITY;
+    while (v < n && v < MAX_CAPACITY) {
+        v <<= 1;
+    }
+    return v;
+}
+
+} // namespace
+
+EventQueue::EventQueue(size_t capacity)
+    : mSlots(roundUpPow2(capacity)), mMask(mSlots.size() - 1), mHead(0), mTail(0),
+      mSpilling(false), mProduced(0), mConsumed(0), mSweepAt(MIN_SWEEP), mWaiters(0),
+      mCoalesced(0), mSpilled(0)
+{
+}
+
+// ============================================================================
+// Producer (event loop thread)
+// ============================================================================
+
+void EventQueue::push(EngineEvent event, const EventData& data) {
+    mProduced++;
+
+    // Once spilling, stay there until the consumer emptied the list (keeps order)
+    if (!mSpilling.load(std::memory_order_acquire)) {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHead.load(std::memory_order_acquire) < mSlots.size()) {
+            QueuedEvent& slot = mSlots[tail & mMask];
+            slot.event = event;
+            slot.data = data;
+            mTail.store(tail + 1, std::memory_order_release);
+            wake();
+            return;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mSpillMutex);
+        mSpill.emplace_back();
+        mSpill.back().event = event;
+        mSpill.back().data = data;
+        mSpilling.store(true, std::memory_order_release);
+    }
+    mSpilled.fetch_add(1, std::memory_order_relaxed);
+    wake();
+}
+
+void EventQueue::pushReadable(uint64_t stream_id) {
+    uint64_t consumed = mConsumed.load(std::memory_order_acquire);
+
+    // The pending event's handler has not started yet, so it will see this data too
+    auto it = mReadable.find(stream_id);
+    if (it != mReadable.end() && it->second > consumed) {
+        mCoalesced.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    push(EngineEvent::STREAM_READABLE, EventData(stream_id));
+    mReadable[stream_id] = mProduced;
+
+    // Forget delivered entries now and then (finished streams never come back)
+    if (mReadable.size() > mSweepAt) {
+        for (auto i = mReadable.begin(); i != mReadable.end(); ) {
+            if (i->second <= consumed) {
+                i = mReadable.erase(i);
+            } else {
+                ++i;
+            }
+        }
+        mSweepAt = std::max(MIN_SWEEP, mReadable.size() * 2);
+    }
+}
+
+void EventQueue::wake() {
+    // Pairs with the waiter count increment in pop(): either the waiter sees
+    // the new event, or we see the waiter
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mWaiters.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(mWaitMutex);
+        mWaitCond.notify_one();
+    }
+}
+
+// ============================================================================
+// Consumer (application thread)
+// ============================================================================
+
+bool EventQueue::tryPop(QueuedEvent& out) {
+    // Flag first: the producer fills the ring before it spills, so a set
+    // flag makes every older ring entry visible to the tail load below
+    bool spilling = mSpilling.load(std::memory_order_acquire);
+    size_t head = mHead.load(std::memory_order_relaxed);
+    if (head != mTail.load(std::memory_order_acquire)) {
+        QueuedEvent& slot = mSlots[head & mMask];
+        out.event = slot.event;
+        out.data = std::move(slot.data);
+        mHead.store(head + 1, std::memory_order_release);
+    } else if (spilling) {
+        // Ring drained: everything left is in the spill list, oldest first
+        std::lock_guard<std::mutex> lock(mSpillMutex);
+        if (mSpill.empty()) {
+            return false;
+        }
+        out = std::move(mSpill.front());
+        mSpill.pop_front();
+        if (mSpill.empty()) {
+            mSpilling.store(false, std::memory_order_release);
+        }
+    } else {
+        return false;
+    }
+
+    // Before the handler runs: data arriving from now on needs a new event
+    mConsumed.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+bool EventQueue::pop(QueuedEvent& out, int timeout_ms) {
+    if (tryPop(out)) {
+        return true;
+    }
+    if (timeout_ms <= 0) {
+        return false;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    std::unique_lock<std::mutex> lock(mWaitMutex);
+    mWaiters.fetch_add(1, std::memory_order_seq_cst);
+
+    bool popped = tryPop(out);
+    while (!popped) {
+        if (mWaitCond.wait_until(lock, deadline) == std::cv_status::timeout) {
+            popped = tryPop(out);
+            break;
+        }
+        popped = tryPop(out);
+    }
+
+    mWaiters.fetch_sub(1, std::memory_order_relaxed);
+    return popped;
+}
+
+} // namespace quiche
@@ -0,0 +1,90 @@
+#ifndef __QUICHE_EVENT_QUEUE_H__
+#define __QUICHE_EVENT_QUEUE_H__
+
+#include <quiche_engine.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "quiche_io_arena.h"
+
+namespace quiche {
+
+// One event waiting for pollEvents()
+struct QueuedEvent {
+    EngineEvent event;
+    EventData data;
+
+    QueuedEvent() : event(EngineEvent::ERROR) {}
+};
+
+// Event hand-off from the event loop thread to one application thread
+//
+// A single-producer/single-consumer ring: while it has room the loop never
+// blocks or takes a lock. When it is full, events spill into a locked list
+// until the consumer catches up (order is kept, nothing is dropped).
+// STREAM_READABLE is coalesced per stream: while one is still undelivered,
+// more data on that stream adds no event.
+class EventQueue {
+public:
+    explicit EventQueue(size_t capacity);  // Rounded up to a power of two
+
+    // Disable copy
+    EventQueue(const EventQueue&) = delete;
+    EventQueue& operator=(const EventQueue&) = delete;
+
+    // Producer side (event loop thread)
+    void push(EngineEvent event, const EventData& data);
+    void pushReadable(uint64_t stream_id);
+
+    // Consumer side (one thread at a time): take the oldest event, waiting
+    // up to timeout_ms for one if the queue is empty
+    bool pop(QueuedEvent& out, int timeout_ms);
+
+    size_t capacity() const { return mSlots.size(); }
+    size_t coalesced() const { return mCoalesced.load(std::memory_order_relaxed); }
+    size_t spilled() const { return mSpilled.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<QueuedEvent> mSlots;
+    size_t mMask;
+
+    // Consumer and producer indices on separate cache lines
+    std::atomic<size_t> mHead;
+    char mPadHead[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> mTail;
+    char mPadTail[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+
+    // Overflow, only touched once the ring is full
+    std::atomic<bool> mSpilling;
+    std::mutex mSpillMutex;  // C++ mutex (non-recursive)
+    std::deque<QueuedEvent> mSpill;
+
+    // STREAM_READABLE coalescing: sequence number of the undelivered event
+    // per stream (producer only), checked against mConsumed
+    uint64_t mProduced;
+    std::atomic<uint64_t> mConsumed;
+    std::unordered_map<uint64_t, uint64_t> mReadable;
+    size_t mSweepAt;
+
+    // Blocking pop
+    std::atomic<int> mWaiters;
+    std::mutex mWaitMutex;  // C++ mutex (non-recursive)
+    std::condition_variable mWaitCond;
+
+    std::atomic<size_t> mCoalesced;
+    std::atomic<size_t> mSpilled;
+
+    bool tryPop(QueuedEvent& out);
+    void wake();
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_EVENT_QUEUE_H__
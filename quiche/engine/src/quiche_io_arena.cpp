@@ -0,0 +1,188 @@
+// quiche_io_arena.cpp
+// Cache-line aligned packet I/O arena with optional huge page backing
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+
+#include "quiche_io_arena.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+extern "C" {
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+}
+
+namespace quiche {
+
+namespace {
+
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+constexpr int MPOL_PREFERRED_MODE = 1;  // <numaif.h> MPOL_PREFERRED, without libnuma
+
+// Huge page arenas all start 2MB-aligned, so the same slot of every arena
+// would map to the same cache sets. Their unused tail pays for staggering
+// the start by a page plus a line per arena.
+constexpr size_t COLOR_STEP = 4096 + CACHE_LINE_SIZE;
+constexpr size_t COLORS = 16;
+std::atomic<size_t> gNextColor(0);
+
+size_t roundUp(size_t n, size_t align) {
+    return (n + align - 1) / align * align;
+}
+
+void* mapAnonymous(size_t len, int extra_flags) {
+    void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+} // namespace
+
+IoArena::IoArena()
+    : mBase(nullptr), mMapBase(nullptr), mSize(0), mMapped(0), mHugePages(false), mNumaNode(-1)
+{
+}
+
+IoArena::~IoArena() {
+    if (mMapBase) {
+        munmap(mMapBase, mMapped);
+    }
+}
+
+bool IoArena::allocate(const IoArenaOptions& options, std::string& error) {
+    if (mMapBase) {
+        error = "I/O arena already allocated";
+        return false;
+    }
+    if (mSize == 0) {
+        error = "I/O arena is empty";
+        return false;
+    }
+
+#if defined(__linux__)
+    if (options.huge_pages) {
+        // Reserved hugetlbfs pages first: guaranteed, but usually not configured
+        size_t len = roundUp(mSize, HUGE_PAGE_SIZE);
+        void* p = mapAnonymous(len, MAP_HUGETLB);
+        if (p) {
+            mMapBase = p;
+            mMapped = len;
+            mHugePages = true;
+        } else {
+            // THP only backs 2MB-aligned ranges: over-map, then trim to alignment
+            p = mapAnonymous(len + HUGE_PAGE_SIZE, 0);
+            if (p) {
+                uintptr_t start = reinterpret_cast<uintptr_t>(p);
+                uintptr_t aligned = roundUp(start, HUGE_PAGE_SIZE);
+                if (aligned > start) {
+                    munmap(p, aligned - start);
+                }
+                size_t tail = (start + len + HUGE_PAGE_SIZE) - (aligned + len);
+                if (tail > 0) {
+                    munmap(reinterpret_cast<void*>(aligned + len), tail);
+                }
+                mMapBase = reinterpret_cast<void*>(aligned);
+                mMapped = len;
+                mHugePages = madvise(mMapBase, mMapped, MADV_HUGEPAGE) == 0;
+            }
+        }
+
+        if (mMapBase) {
+            size_t color = (gNextColor.fetch_add(1) % COLORS) * COLOR_STEP;
+            if (mSize + color > len) {
+                color = 0;
+            }
+            mBase = static_cast<uint8_t*>(mMapBase) + color;
+        }
+    }
+#endif
+
+    if (!mMapBase) {
+        long page = sysconf(_SC_PAGESIZE);
+        size_t len = roundUp(mSize, page > 0 ? static_cast<size_t>(page) : 4096);
+        void* p = mapAnonymous(len, 0);
+        if (!p) {
+            error = std::string("Failed to map I/O arena: ") + strerror(errno);
+            return false;
+        }
+        mMapBase = p;
+        mBase = static_cast<uint8_t*>(p);
+        mMapped = len;
+    }
+
+#if defined(__linux__)
+    // Bind before anything touches the pages; failure only loses locality
+    if (options.numa_node >= 0 && options.numa_node < 64) {
+        unsigned long mask = 1UL << options.numa_node;
+        if (syscall(SYS_mbind, mMapBase, mMapped, MPOL_PREFERRED_MODE, &mask,
+                    sizeof(mask) * 8, 0) == 0) {
+            mNumaNode = options.numa_node;
+        }
+    }
+#endif
+
+    return true;
+}
+
+// ============================================================================
+// IoArenaPool Implementation
+// ============================================================================
+
+IoArenaPool::IoArenaPool(size_t max_idle)
+    : mMaxIdle(max_idle)
+{
+}
+
+IoArenaPool::~IoArenaPool() {
+}
+
+std::unique_ptr<IoArena> IoArenaPool::acquire(size_t size) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (size_t i = mIdle.size(); i > 0; i--) {
+        if (mIdle[i - 1]->size() == size) {
+            std::unique_ptr<IoArena> arena = std::move(mIdle[i - 1]);
+            mIdle.erase(mIdle.begin() + (i - 1));
+            return arena;
+        }
+    }
+    return nullptr;
+}
+
+void IoArenaPool::release(std::unique_ptr<IoArena> arena) {
+    if (!arena || !arena->allocated()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mIdle.size() < mMaxIdle) {
+            mIdle.push_back(std::move(arena));
+            return;
+        }
+    }
+    // Full: arena is unmapped here, outside the lock
+}
+
+size_t IoArenaPool::idleCount() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mIdle.size();
+}
+
+std::shared_ptr<IoArenaPool> IoArenaPool::shared() {
+    static std::mutex pool_mutex;
+    static std::shared_ptr<IoArenaPool> pool;
+
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if (!pool) {
+        pool = std::make_shared<IoArenaPool>();
+    }
+    return pool;
+}
+
+} // namespace quiche
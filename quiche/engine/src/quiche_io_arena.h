@@ -0,0 +1,108 @@
+#ifndef __QUICHE_IO_ARENA_H__
+#define __QUICHE_IO_ARENA_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace quiche {
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+constexpr size_t alignToCacheLine(size_t n) {
+    return (n + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+}
+
+// How an IoArena is backed
+struct IoArenaOptions {
+    bool huge_pages;  // Try MAP_HUGETLB, then transparent huge pages
+    int numa_node;    // Prefer this NUMA node; -1 = first touch (the allocating thread's node)
+
+    IoArenaOptions() : huge_pages(false), numa_node(-1) {}
+};
+
+// One contiguous mapping holding a loop's packet I/O structures
+//
+// Regions are laid out with reserve() first, then allocate() maps the whole
+// arena at once and get() hands out the regions. Every region starts on its
+// own cache line, so headers written by sendmmsg()/recvmmsg() never share a
+// line with payload buffers. The memory is zeroed and is not touched by
+// allocate(): with numa_node = -1 the pages land on the node of the thread
+// that first writes them, so allocate on the loop thread.
+class IoArena {
+public:
+    IoArena();
+    ~IoArena();
+
+    // Disable copy
+    IoArena(const IoArena&) = delete;
+    IoArena& operator=(const IoArena&) = delete;
+
+    // Reserve count objects of T on a fresh cache line; returns the offset
+    // to pass to get(). T may be an array type (one buffer slot).
+    template<typename T>
+    size_t reserve(size_t count) {
+        size_t offset = mSize;
+        mSize += alignToCacheLine(sizeof(T) * count);
+        return offset;
+    }
+
+    bool allocate(const IoArenaOptions& options, std::string& error);
+
+    template<typename T>
+    T* get(size_t offset) const {
+        return reinterpret_cast<T*>(mBase + offset);
+    }
+
+    bool allocated() const { return mMapBase != nullptr; }
+    size_t size() const { return mSize; }           // Bytes reserved
+    size_t mappedSize() const { return mMapped; }   // Bytes mapped (page rounded)
+    bool hugePages() const { return mHugePages; }   // hugetlb mapping, or THP advised (kernel may still use 4k)
+    int numaNode() const { return mNumaNode; }      // Node the pages are bound to, -1 = first touch
+
+private:
+    uint8_t* mBase;
+    void* mMapBase;   // Start of the mapping (mBase may be colored past it)
+    size_t mSize;
+    size_t mMapped;
+    bool mHugePages;
+    int mNumaNode;
+};
+
+// Allocated arenas handed from engine to engine (LOW_MEMORY_MODE): an
+// engine takes one while it does I/O and returns it once idle, so mostly
+// idle engines share a few mappings. Arenas are matched by size(), which
+// identifies the layout; pooled arenas are plain pages (default options).
+// Thread-safe.
+class IoArenaPool {
+public:
+    explicit IoArenaPool(size_t max_idle = 16);
+    ~IoArenaPool();
+
+    // Disable copy
+    IoArenaPool(const IoArenaPool&) = delete;
+    IoArenaPool& operator=(const IoArenaPool&) = delete;
+
+    // An idle arena of this reserved size, nullptr if there is none
+    std::unique_ptr<IoArena> acquire(size_t size);
+
+    // Keep for reuse; unmapped right away once max_idle arenas are idle
+    void release(std::unique_ptr<IoArena> arena);
+
+    size_t idleCount() const;
+
+    // Process-wide pool (engines keep a reference)
+    static std::shared_ptr<IoArenaPool> shared();
+
+private:
+    mutable std::mutex mMutex;  // C++ mutex (non-recursive)
+    std::vector<std::unique_ptr<IoArena>> mIdle;
+    size_t mMaxIdle;
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_IO_ARENA_H__
@@ -0,0 +1,256 @@
+// quiche_message_stream.cpp
+// Message Stream - varint length-prefixed messages over one QUIC stream
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+
+#include <quiche_message_stream.h>
+
+#include <algorithm>
+#include <cstring>
+
+extern "C" {
+#include <quiche.h>
+}
+
+namespace quiche {
+
+namespace {
+
+// Largest single QuicheEngine::writeStream() call
+const size_t STREAM_WRITE_CHUNK = 65536;
+
+// Largest length a QUIC varint can carry (2^62 - 1)
+const uint64_t MAX_VARINT = (static_cast<uint64_t>(1) << 62) - 1;
+
+size_t varintLength(uint64_t value) {
+    if (value < 64) {
+        return 1;
+    }
+    if (value < 16384) {
+        return 2;
+    }
+    if (value < 1073741824) {
+        return 4;
+    }
+    return 8;
+}
+
+size_t roundUpPowerOfTwo(size_t value) {
+    size_t size = 64;
+    while (size < value) {
+        size <<= 1;
+    }
+    return size;
+}
+
+} // namespace
+
+// ============================================================================
+// MessageStream Implementation
+// ============================================================================
+
+MessageStream::MessageStream(QuicheEngine& engine, uint64_t stream_id,
+                             const MessageStreamOptions& options)
+    : MessageStream(
+          [&engine, stream_id](const uint8_t* data, size_t len, bool fin) {
+              return engine.writeStream(stream_id, data, len, fin);
+          },
+          [&engine, stream_id](uint8_t* buf, size_t buf_len, bool& fin) {
+              return engine.readStream(stream_id, buf, buf_len, fin);
+          },
+          options)
+{
+}
+
+MessageStream::MessageStream(StreamWriteFn write, StreamReadFn read,
+                             const MessageStreamOptions& options)
+    : mWrite(std::move(write)), mRead(std::move(read)), mOptions(options),
+      mHead(0), mTail(0), mFin(false), mReceiving(false)
+{
+    mBatch.reserve(mOptions.batch_bytes + 8);
+}
+
+// ============================================================================
+// Sending
+// ============================================================================
+
+bool MessageStream::send(const uint8_t* data, size_t len) {
+    if (failed()) {
+        return false;
+    }
+    if ((!data && len > 0) || len > MAX_VARINT) {
+        mLastError = "Invalid message";
+        return false;
+    }
+
+    size_t header_len = varintLength(len);
+    size_t offset = mBatch.size();
+    mBatch.resize(offset + header_len);
+    quiche_put_varint(mBatch.data() + offset, header_len, len);
+
+    if (len < mOptions.batch_bytes) {
+        mBatch.insert(mBatch.end(), data, data + len);
+        return mBatch.size() < mOptions.batch_bytes || flush();
+    }
+
+    // Large message: write the batch (ending in this header), then the
+    // payload straight from the caller's buffer
+    return flush() && writeAll(data, len, false);
+}
+
+bool MessageStream::flush(bool fin) {
+    if (failed()) {
+        return false;
+    }
+    if (mBatch.empty() && !fin) {
+        return true;
+    }
+
+    bool ok = writeAll(mBatch.data(), mBatch.size(), fin);
+    mBatch.clear();
+    return ok;
+}
+
+bool MessageStream::writeAll(const uint8_t* data, size_t len, bool fin) {
+    do {
+        size_t chunk = std::min(len, STREAM_WRITE_CHUNK);
+        bool last = chunk == len;
+        if (mWrite(chunk > 0 ? data : nullptr, chunk, fin && last) < 0) {
+            mLastError = "Stream write failed";
+            return false;
+        }
+        data += chunk;
+        len -= chunk;
+    } while (len > 0);
+    return true;
+}
+
+// ============================================================================
+// Receiving
+// ============================================================================
+
+size_t MessageStream::receive(const MessageHandler& handler, size_t max_messages) {
+    // Not re-entrant: the handler's span would move under it
+    if (failed() || mReceiving) {
+        return 0;
+    }
+    mReceiving = true;
+
+    if (mRing.empty()) {
+        grow(mOptions.receive_buffer);
+    }
+
+    size_t delivered = 0;
+    while (delivered < max_messages) {
+        size_t available = mTail - mHead;
+        size_t needed = 1;
+
+        if (available > 0) {
+            size_t mask = mRing.size() - 1;
+            size_t header_len = static_cast<size_t>(1) << (mRing[mHead & mask] >> 6);
+            needed = header_len;
+
+            if (available >= header_len) {
+                uint8_t header[8];
+                copyOut(mHead, header, header_len);
+                uint64_t len = 0;
+                quiche_get_varint(header, header_len, &len);
+                if (len > mOptions.max_message_size) {
+                    mLastError = "Message of " + std::to_string(len) + " bytes exceeds max_message_size";
+                    break;
+                }
+                needed = header_len + static_cast<size_t>(len);
+
+                if (available >= needed) {
+                    size_t start = (mHead + header_len) & mask;
+                    if (start + len <= mRing.size()) {
+                        handler(&mRing[start], static_cast<size_t>(len));
+                    } else {
+                        mStaging.resize(static_cast<size_t>(len));
+                        copyOut(mHead + header_len, mStaging.data(), mStaging.size());
+                        handler(mStaging.data(), mStaging.size());
+                    }
+                    mHead += needed;
+                    delivered++;
+                    continue;
+                }
+            }
+        } else {
+            // Empty: restart at the front so reads and messages wrap less
+            mHead = 0;
+            mTail = 0;
+        }
+
+        if (needed > mRing.size()) {
+            grow(needed);
+        }
+        if (!fill()) {
+            if (mFin && mHead != mTail && !failed()) {
+                mLastError = "Stream finished inside a message";
+            }
+            break;
+        }
+    }
+
+    mReceiving = false;
+    return failed() ? 0 : delivered;
+}
+
+bool MessageStream::fill() {
+    if (mFin || failed()) {
+        return false;
+    }
+
+    size_t size = mRing.size();
+    size_t total = 0;
+    while (mTail - mHead < size) {
+        size_t pos = mTail & (size - 1);
+        size_t room = std::min(size - pos, size - (mTail - mHead));
+        bool fin = false;
+        ssize_t len = mRead(&mRing[pos], room, fin);
+        if (len < 0) {
+            mLastError = "Stream read failed";
+            return false;
+        }
+        mTail += static_cast<size_t>(len);
+        total += static_cast<size_t>(len);
+        if (fin) {
+            mFin = true;
+            break;
+        }
+        if (static_cast<size_t>(len) < room) {
+            break;  // Drained for now
+        }
+    }
+    return total > 0;
+}
+
+void MessageStream::grow(size_t needed) {
+    size_t size = roundUpPowerOfTwo(std::max(needed, mRing.size()));
+    if (size == mRing.size()) {
+        return;
+    }
+
+    // Linearize what is buffered at the front of the new ring
+    std::vector<uint8_t> ring(size);
+    size_t used = mTail - mHead;
+    if (used > 0) {
+        copyOut(mHead, ring.data(), used);
+    }
+    mRing.swap(ring);
+    mHead = 0;
+    mTail = used;
+}
+
+void MessageStream::copyOut(size_t pos, uint8_t* out, size_t len) const {
+    size_t mask = mRing.size() - 1;
+    size_t start = pos & mask;
+    size_t first = std::min(len, mRing.size() - start);
+    memcpy(out, &mRing[start], first);
+    if (len > first) {
+        memcpy(out + first, &mRing[0], len - first);
+    }
+}
+
+} // namespace quiche
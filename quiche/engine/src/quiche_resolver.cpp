@@ -0,0 +1,161 @@
+// quiche_resolver.cpp
+// Asynchronous DNS resolution with a process-wide TTL cache
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+
+#include "quiche_resolver.h"
+#include "quiche_thread_utils.h"
+#include "quiche_timer_wheel.h"
+
+#include <cstring>
+#include <system_error>
+#include <thread>
+
+extern "C" {
+#include <netdb.h>
+#include <netinet/in.h>
+}
+
+namespace quiche {
+
+Resolver& Resolver::shared() {
+    // Never destroyed: pool threads may still be blocked in getaddrinfo() at exit
+    static Resolver* instance = new Resolver();
+    return *instance;
+}
+
+bool Resolver::lookup(const std::string& host, const std::string& port, uint64_t max_age_ns,
+                      std::vector<PeerAddress>& peers) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = mCache.find(cacheKey(host, port));
+    if (it == mCache.end() || monotonicNowNs() - it->second.resolved_ns > max_age_ns) {
+        return false;
+    }
+
+    peers = it->second.peers;
+    return true;
+}
+
+void Resolver::resolve(const std::string& host, const std::string& port, Callback done) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    std::vector<Callback>& waiters = mInFlight[cacheKey(host, port)];
+    waiters.push_back(done);
+    if (waiters.size() > 1) {
+        return;  // Same name already being resolved
+    }
+
+    Request request;
+    request.host = host;
+    request.port = port;
+    mQueue.push_back(request);
+
+    // Threads are started on demand and then stay around
+    if (mWorkers < POOL_SIZE) {
+        try {
+            std::thread(&Resolver::workerMain, this).detach();
+            mWorkers++;
+        } catch (const std::system_error&) {
+            // Existing workers still drain the queue
+        }
+    }
+    mCond.notify_one();
+}
+
+void Resolver::clear() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCache.clear();
+}
+
+void Resolver::workerMain() {
+    thread_utils::setCurrentThreadName("QuicResolver");
+
+    while (true) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCond.wait(lock, [this]() { return !mQueue.empty(); });
+            request = mQueue.front();
+            mQueue.pop_front();
+        }
+
+        std::vector<PeerAddress> peers;
+        std::string error;
+        bool ok = resolveNow(request.host, request.port, peers, error);
+
+        std::string key = cacheKey(request.host, request.port);
+        std::vector<Callback> waiters;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (ok) {
+                Entry& entry = mCache[key];
+                entry.peers = peers;
+                entry.resolved_ns = monotonicNowNs();
+            }
+            waiters.swap(mInFlight[key]);
+            mInFlight.erase(key);
+        }
+
+        // Outside the lock: callbacks may start new lookups
+        for (Callback& done : waiters) {
+            done(ok, peers, error);
+        }
+    }
+}
+
+bool Resolver::resolveNow(const std::string& host, const std::string& port,
+                          std::vector<PeerAddress>& peers, std::string& error) {
+    struct addrinfo hints = {};
+    hints.ai_family = PF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_protocol = IPPROTO_UDP;
+
+    struct addrinfo* result;
+    int rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
+    if (rc != 0) {
+        error = "Failed to resolve host " + host + ": " + gai_strerror(rc);
+        return false;
+    }
+
+    // Keep getaddrinfo's preference, but alternate address families so a
+    // broken family only costs one attempt delay
+    std::vector<PeerAddress> preferred;
+    std::vector<PeerAddress> other;
+    for (struct addrinfo* ai = result; ai; ai = ai->ai_next) {
+        if (ai->ai_addrlen > sizeof(struct sockaddr_storage)) {
+            continue;
+        }
+
+        PeerAddress peer;
+        memset(&peer, 0, sizeof(peer));
+        memcpy(&peer.addr, ai->ai_addr, ai->ai_addrlen);
+        peer.addr_len = ai->ai_addrlen;
+
+        if (ai->ai_family == result->ai_family) {
+            preferred.push_back(peer);
+        } else {
+            other.push_back(peer);
+        }
+    }
+    freeaddrinfo(result);
+
+    peers.clear();
+    for (size_t i = 0; i < preferred.size() || i < other.size(); i++) {
+        if (i < preferred.size()) {
+            peers.push_back(preferred[i]);
+        }
+        if (i < other.size()) {
+            peers.push_back(other[i]);
+        }
+    }
+
+    if (peers.empty()) {
+        error = "Failed to resolve host " + host + ": no usable address";
+        return false;
+    }
+    return true;
+}
+
+} // namespace quiche
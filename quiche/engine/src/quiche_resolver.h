@@ -0,0 +1,89 @@
+#ifndef __QUICHE_RESOLVER_H__
+#define __QUICHE_RESOLVER_H__
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/socket.h>
+}
+
+namespace quiche {
+
+// Resolved peer address (one happy eyeballs candidate)
+struct PeerAddress {
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+};
+
+// Process-wide asynchronous DNS resolver with a TTL cache (thread-safe)
+//
+// getaddrinfo() blocks, so lookups run on a small pool of resolver threads.
+// Concurrent requests for the same host:port share one lookup, and results
+// are cached for every engine in the process. getaddrinfo() does not expose
+// record TTLs; callers pass the maximum age they accept instead.
+class Resolver {
+public:
+    typedef std::function<void(bool ok, const std::vector<PeerAddress>& peers,
+                               const std::string& error)> Callback;
+
+    static constexpr size_t POOL_SIZE = 2;
+
+    static Resolver& shared();
+
+    // Cached addresses resolved no longer than max_age_ns ago
+    bool lookup(const std::string& host, const std::string& port, uint64_t max_age_ns,
+                std::vector<PeerAddress>& peers);
+
+    // Resolve on a pool thread and cache the result; done runs on that thread
+    void resolve(const std::string& host, const std::string& port, Callback done);
+
+    // Drop all cached results (e.g. after a network change)
+    void clear();
+
+    // Blocking getaddrinfo(), ordered for happy eyeballs: getaddrinfo's
+    // (RFC 6724) preference with address families interleaved
+    static bool resolveNow(const std::string& host, const std::string& port,
+                           std::vector<PeerAddress>& peers, std::string& error);
+
+private:
+    struct Entry {
+        std::vector<PeerAddress> peers;
+        uint64_t resolved_ns;
+    };
+
+    struct Request {
+        std::string host;
+        std::string port;
+    };
+
+    Resolver() : mWorkers(0) {}
+
+    // Disable copy
+    Resolver(const Resolver&) = delete;
+    Resolver& operator=(const Resolver&) = delete;
+
+    std::mutex mMutex;  // C++ mutex (non-recursive)
+    std::condition_variable mCond;
+    std::map<std::string, Entry> mCache;
+    std::map<std::string, std::vector<Callback>> mInFlight;  // Waiters per host:port
+    std::deque<Request> mQueue;
+    size_t mWorkers;
+
+    void workerMain();
+
+    static std::string cacheKey(const std::string& host, const std::string& port) {
+        return host + ":" + port;
+    }
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_RESOLVER_H__
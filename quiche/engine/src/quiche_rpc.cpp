@@ -0,0 +1,108 @@
+// quiche_rpc.cpp
+// Request/response calls - pooled call state and latency histogram
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+
+#include "quiche_rpc.h"
+
+namespace quiche {
+
+// ============================================================================
+// RpcCallPool Implementation
+// ============================================================================
+
+RpcCallPool::RpcCallPool(size_t max_idle)
+    : mMaxIdle(max_idle)
+{
+}
+
+RpcCallPool::~RpcCallPool() {
+    for (RpcCall* call : mFree) {
+        delete call;
+    }
+}
+
+RpcCall* RpcCallPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mFree.empty()) {
+            RpcCall* call = mFree.back();
+            mFree.pop_back();
+            return call;
+        }
+    }
+    return new RpcCall();
+}
+
+void RpcCallPool::release(RpcCall* call) {
+    // A promise is single-use; the buffers keep their capacity
+    call->promise = std::promise<RpcResponse>();
+    call->request.clear();
+    call->response.clear();
+    call->stream_id = 0;
+    call->queued_ns = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mFree.size() < mMaxIdle) {
+            mFree.push_back(call);
+            return;
+        }
+    }
+    delete call;
+}
+
+// ============================================================================
+// LatencyHistogram Implementation
+// ============================================================================
+
+LatencyHistogram::LatencyHistogram() {
+    for (size_t i = 0; i < BUCKETS; i++) {
+        mBuckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(uint64_t latency_us) {
+    size_t bucket = 0;
+    while (latency_us > 1 && bucket < BUCKETS - 1) {
+        latency_us >>= 1;
+        bucket++;
+    }
+    mBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::snapshot(uint64_t* buckets) const {
+    for (size_t i = 0; i < BUCKETS; i++) {
+        buckets[i] = mBuckets[i].load(std::memory_order_relaxed);
+    }
+}
+
+// ============================================================================
+// RpcStats
+// ============================================================================
+
+uint64_t RpcStats::latencyPercentileUs(double p) const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        total += latency_us[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(p * total);
+    if (rank >= total) {
+        rank = total - 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += latency_us[i];
+        if (seen > rank) {
+            return static_cast<uint64_t>(1) << (i + 1);  // Upper bound of the bucket
+        }
+    }
+    return static_cast<uint64_t>(1) << LATENCY_BUCKETS;
+}
+
+} // namespace quiche
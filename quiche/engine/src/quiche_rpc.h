@@ -0,0 +1,65 @@
+#ifndef __QUICHE_RPC_H__
+#define __QUICHE_RPC_H__
+
+#include <quiche_engine.h>
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <vector>
+
+namespace quiche {
+
+// State of one call() (from the pool; owned by the engine until completed)
+struct RpcCall {
+    std::promise<RpcResponse> promise;
+    std::vector<uint8_t> request;
+    std::vector<uint8_t> response;
+    uint64_t stream_id;
+    uint64_t queued_ns;    // call() time, latency is measured from here
+
+    RpcCall() : stream_id(0), queued_ns(0) {}
+};
+
+// Free list of RpcCall objects, so a call reuses the request buffer and
+// bookkeeping of an earlier one (thread-safe: call() acquires on the
+// application thread, the loop thread releases)
+class RpcCallPool {
+public:
+    explicit RpcCallPool(size_t max_idle = 256);
+    ~RpcCallPool();
+
+    // Disable copy
+    RpcCallPool(const RpcCallPool&) = delete;
+    RpcCallPool& operator=(const RpcCallPool&) = delete;
+
+    RpcCall* acquire();
+
+    // Back to the pool after its promise was satisfied
+    void release(RpcCall* call);
+
+private:
+    std::mutex mMutex;  // C++ mutex (non-recursive)
+    std::vector<RpcCall*> mFree;
+    size_t mMaxIdle;
+};
+
+// Latency histogram with power-of-two microsecond buckets (bucket i counts
+// [2^i, 2^(i+1)) us, bucket 0 also below 1us); one writer, any readers
+class LatencyHistogram {
+public:
+    static const size_t BUCKETS = RpcStats::LATENCY_BUCKETS;
+
+    LatencyHistogram();
+
+    void record(uint64_t latency_us);
+    void snapshot(uint64_t* buckets) const;
+
+private:
+    std::atomic<uint64_t> mBuckets[BUCKETS];
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_RPC_H__
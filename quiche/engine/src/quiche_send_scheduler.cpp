@@ -0,0 +1,312 @@
+// quiche_send_scheduler.cpp
+// Stream send scheduler - weighted round-robin with token bucket rate limits
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+
+#include "quiche_send_scheduler.h"
+#include "quiche_engine_impl.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace quiche {
+
+// ============================================================================
+// TokenBucket Implementation
+// ============================================================================
+
+void TokenBucket::configure(uint64_t rate_bps, uint64_t burst_bytes, uint64_t now_ns) {
+    rate = rate_bps;
+
+    // Default burst: 50ms worth of data, at least one full packet
+    burst = burst_bytes ? burst_bytes : rate_bps / 20;
+    if (burst < MAX_DATAGRAM_SIZE) {
+        burst = MAX_DATAGRAM_SIZE;
+    }
+
+    tokens = static_cast<double>(burst);
+    last_refill_ns = now_ns;
+}
+
+void TokenBucket::refill(uint64_t now_ns) {
+    if (rate == 0 || now_ns <= last_refill_ns) {
+        return;
+    }
+
+    tokens += static_cast<double>(rate) * (now_ns - last_refill_ns) / 1000000000.0;
+    if (tokens > static_cast<double>(burst)) {
+        tokens = static_cast<double>(burst);
+    }
+    last_refill_ns = now_ns;
+}
+
+size_t TokenBucket::available() const {
+    if (rate == 0) {
+        return SIZE_MAX;
+    }
+    return tokens > 0 ? static_cast<size_t>(tokens) : 0;
+}
+
+void TokenBucket::consume(size_t bytes) {
+    if (rate != 0) {
+        tokens -= static_cast<double>(bytes);
+    }
+}
+
+uint64_t TokenBucket::delayFor(size_t bytes) const {
+    if (rate == 0 || tokens >= static_cast<double>(bytes)) {
+        return 0;
+    }
+
+    double missing = static_cast<double>(bytes) - tokens;
+    return static_cast<uint64_t>(missing * 1000000000.0 / rate) + 1;
+}
+
+// ============================================================================
+// SendScheduler Implementation
+// ============================================================================
+
+SendScheduler::SendScheduler()
+    : mQueuedBytes(0)
+{
+}
+
+SendScheduler::~SendScheduler() {
+    clear();
+}
+
+void SendScheduler::enqueue(Command* cmd) {
+    StreamState& s = mStreams[cmd->params.write.stream_id];
+
+    Chunk chunk;
+    chunk.cmd = cmd;
+    chunk.offset = 0;
+    s.chunks.push_back(chunk);
+    s.queued += cmd->params.write.len;
+    mQueuedBytes += cmd->params.write.len;
+
+    if (!s.active) {
+        s.active = true;
+        mActive.push_back(cmd->params.write.stream_id);
+    }
+}
+
+void SendScheduler::setStreamParams(uint64_t stream_id, uint32_t weight,
+                                    uint64_t rate_bps, uint64_t burst_bytes, uint64_t now_ns) {
+    StreamState& s = mStreams[stream_id];
+    s.weight = weight > 0 ? weight : 1;
+    s.bucket.configure(rate_bps, burst_bytes, now_ns);
+}
+
+void SendScheduler::setConnectionRate(uint64_t rate_bps, uint64_t now_ns) {
+    mConnBucket.configure(rate_bps, 0, now_ns);
+}
+
+size_t SendScheduler::pacedSendSize(const StreamState& s) const {
+    return s.queued < MIN_PACED_SEND ? s.queued : MIN_PACED_SEND;
+}
+
+size_t SendScheduler::run(quiche_conn* conn, uint64_t now_ns, uint64_t& next_wakeup_ns) {
+    next_wakeup_ns = 0;
+    if (mActive.empty()) {
+        return 0;
+    }
+
+    mConnBucket.refill(now_ns);
+
+    // Hand quiche about what it can send before the next ACK; anything more
+    // just sits in quiche's stream buffers where our weights no longer apply
+    size_t run_budget = 2 * quiche_conn_send_quantum(conn);
+    if (run_budget < MIN_RUN_BUDGET) {
+        run_budget = MIN_RUN_BUDGET;
+    }
+
+    // Deficit round-robin: a stream gets weight * QUANTUM bytes per turn.
+    // Visit streams until one full rotation makes no progress.
+    size_t total = 0;
+    size_t idle_visits = 0;
+    bool last_in_turn = false;
+    while (!mActive.empty() && total < run_budget && idle_visits < mActive.size()) {
+        uint64_t stream_id = mActive.front();
+        mActive.pop_front();
+
+        auto it = mStreams.find(stream_id);
+        StreamState& s = it->second;
+
+        if (!s.in_turn) {
+            s.deficit = static_cast<size_t>(s.weight) * QUANTUM;
+            s.in_turn = true;
+        }
+        size_t budget = s.deficit < run_budget - total ? s.deficit : run_budget - total;
+
+        size_t chunks_before = s.chunks.size();
+        bool blocked = false;
+        size_t written = serviceStream(conn, stream_id, s, budget, now_ns, blocked);
+
+        s.deficit -= written < s.deficit ? written : s.deficit;
+        total += written;
+        if (written > 0 || s.chunks.size() != chunks_before) {
+            idle_visits = 0;
+        } else {
+            idle_visits++;
+        }
+
+        if (s.chunks.empty()) {
+            s.active = false;
+            s.in_turn = false;
+            last_in_turn = false;
+            // FIN sent or stream failed; a default stream has nothing worth
+            // keeping either, and without state its writes can bypass again
+            if (s.finished || (s.weight == 1 && s.bucket.rate == 0)) {
+                mStreams.erase(it);
+            }
+            continue;
+        }
+
+        // Turn ends once the quantum is spent; a blocked stream keeps the rest
+        if (s.deficit == 0) {
+            s.in_turn = false;
+        }
+        last_in_turn = s.in_turn;
+        mActive.push_back(stream_id);
+    }
+
+    // A full idle rotation (or the run budget) leaves the order as it was after
+    // the last stream that sent; if its turn is unfinished, it resumes first
+    // next time so connection-level blocking doesn't flatten the weights
+    if (last_in_turn && mActive.size() > 1) {
+        uint64_t stream_id = mActive.back();
+        mActive.pop_back();
+        mActive.push_front(stream_id);
+    }
+
+    // Wake up when the first token-limited stream can send a full packet
+    for (uint64_t stream_id : mActive) {
+        const StreamState& s = mStreams[stream_id];
+        size_t need = pacedSendSize(s);
+
+        uint64_t delay = s.bucket.delayFor(need);
+        uint64_t conn_delay = mConnBucket.delayFor(need);
+        if (conn_delay > delay) {
+            delay = conn_delay;
+        }
+
+        if (delay > 0 && (next_wakeup_ns == 0 || now_ns + delay < next_wakeup_ns)) {
+            next_wakeup_ns = now_ns + delay;
+        }
+    }
+
+    return total;
+}
+
+size_t SendScheduler::serviceStream(quiche_conn* conn, uint64_t stream_id, StreamState& s,
+                                    size_t budget, uint64_t now_ns, bool& blocked) {
+    static const uint8_t kEmpty = 0;  // quiche wants a valid pointer for FIN-only sends
+
+    s.bucket.refill(now_ns);
+
+    size_t written_total = 0;
+    while (!s.chunks.empty()) {
+        Chunk& chunk = s.chunks.front();
+        const Command::WriteData& wd = chunk.cmd->params.write;
+        size_t remaining = wd.len - chunk.offset;
+
+        size_t limit = remaining < budget ? remaining : budget;
+
+        size_t tokens = s.bucket.available();
+        if (mConnBucket.available() < tokens) {
+            tokens = mConnBucket.available();
+        }
+        if (remaining > 0 && tokens < pacedSendSize(s)) {
+            blocked = true;
+            break;
+        }
+        if (tokens < limit) {
+            limit = tokens;
+        }
+
+        if (remaining > 0 && limit == 0) {
+            blocked = true;  // Out of round budget
+            break;
+        }
+
+        bool fin = wd.fin && limit == remaining;
+        const uint8_t* data = remaining > 0 ? wd.data + chunk.offset : &kEmpty;
+
+        uint64_t error_code;
+        ssize_t written = quiche_conn_stream_send(conn, stream_id, data, limit, fin, &error_code);
+
+        if (written == QUICHE_ERR_DONE) {
+            blocked = true;  // No stream or connection capacity
+            break;
+        }
+
+        if (written < 0) {
+            // Stream reset/stopped by peer or invalid state: the data can never go out
+            std::cerr << "[ENGINE] Write failed on stream " << stream_id
+                      << ": error=" << written << " error_code=" << error_code << std::endl;
+            dropStream(s);
+            break;
+        }
+
+        size_t accepted = static_cast<size_t>(written);
+        chunk.offset += accepted;
+        s.queued -= accepted;
+        mQueuedBytes -= accepted;
+        s.bucket.consume(accepted);
+        mConnBucket.consume(accepted);
+        budget -= accepted;
+        written_total += accepted;
+
+        if (chunk.offset < wd.len || accepted < limit) {
+            blocked = true;  // Partial write: flow control, resume when capacity frees
+            break;
+        }
+
+        if (fin) {
+            s.finished = true;
+        }
+        delete chunk.cmd;
+        s.chunks.pop_front();
+    }
+
+    return written_total;
+}
+
+void SendScheduler::dropStream(StreamState& s) {
+    for (Chunk& chunk : s.chunks) {
+        size_t remaining = chunk.cmd->params.write.len - chunk.offset;
+        mQueuedBytes -= remaining;
+        delete chunk.cmd;
+    }
+    s.chunks.clear();
+    s.queued = 0;
+    s.finished = true;
+}
+
+size_t SendScheduler::abortStream(uint64_t stream_id) {
+    auto it = mStreams.find(stream_id);
+    if (it == mStreams.end()) {
+        return 0;
+    }
+
+    size_t dropped = it->second.queued;
+    dropStream(it->second);
+    if (it->second.active) {
+        mActive.erase(std::find(mActive.begin(), mActive.end(), stream_id));
+    }
+    mStreams.erase(it);
+    return dropped;
+}
+
+void SendScheduler::clear() {
+    for (auto& pair : mStreams) {
+        dropStream(pair.second);
+    }
+    mStreams.clear();
+    mActive.clear();
+    mQueuedBytes = 0;
+}
+
+} // namespace quiche
@@ -0,0 +1,124 @@
+#ifndef __QUICHE_SEND_SCHEDULER_H__
+#define __QUICHE_SEND_SCHEDULER_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <map>
+
+extern "C" {
+#include <quiche.h>
+}
+
+namespace quiche {
+
+struct Command;
+
+// Token bucket (bytes per second); rate 0 means unlimited
+struct TokenBucket {
+    uint64_t rate;
+    uint64_t burst;
+    double tokens;
+    uint64_t last_refill_ns;
+
+    TokenBucket() : rate(0), burst(0), tokens(0), last_refill_ns(0) {}
+
+    void configure(uint64_t rate_bps, uint64_t burst_bytes, uint64_t now_ns);
+    void refill(uint64_t now_ns);
+    size_t available() const;
+    void consume(size_t bytes);
+
+    // Time until at least `bytes` tokens are available
+    uint64_t delayFor(size_t bytes) const;
+};
+
+// Stream send scheduler (event loop thread only)
+//
+// Application writes are queued per stream and handed to
+// quiche_conn_stream_send() by deficit round-robin weighted by stream, each
+// stream limited by its own token bucket and all streams by an optional
+// connection-wide bucket. Partial writes stay queued until quiche frees
+// capacity, so no data is dropped on flow control.
+class SendScheduler {
+public:
+    static constexpr size_t QUANTUM = 16384;      // Bytes per weight unit per round
+    static constexpr size_t MIN_PACED_SEND = 1200; // Avoid tiny paced STREAM frames
+    static constexpr size_t MIN_RUN_BUDGET = 4 * QUANTUM;
+
+    SendScheduler();
+    ~SendScheduler();
+
+    // Disable copy
+    SendScheduler(const SendScheduler&) = delete;
+    SendScheduler& operator=(const SendScheduler&) = delete;
+
+    // Queue a WRITE command; the scheduler owns it from now on
+    void enqueue(Command* cmd);
+
+    // Weight (>= 1) and optional rate cap for one stream
+    void setStreamParams(uint64_t stream_id, uint32_t weight,
+                         uint64_t rate_bps, uint64_t burst_bytes, uint64_t now_ns);
+
+    // Cap on stream payload of the whole connection (0 = unlimited)
+    void setConnectionRate(uint64_t rate_bps, uint64_t now_ns);
+
+    // Feed quiche as far as capacity and tokens allow. Returns the number of
+    // stream bytes accepted; next_wakeup_ns is the absolute time at which
+    // rate-limited data can move again (0 if nothing is waiting on tokens).
+    size_t run(quiche_conn* conn, uint64_t now_ns, uint64_t& next_wakeup_ns);
+
+    // Drop a stream's queued data (stream reset); returns the bytes dropped
+    size_t abortStream(uint64_t stream_id);
+
+    bool empty() const { return mActive.empty(); }
+    size_t queuedBytes() const { return mQueuedBytes; }
+
+    // Bytes of stream_id not yet accepted by quiche
+    size_t queuedBytes(uint64_t stream_id) const {
+        auto it = mStreams.find(stream_id);
+        return it == mStreams.end() ? 0 : it->second.queued;
+    }
+
+    // Nothing queued and no weight or rate limit set for stream_id or the
+    // connection: its data can go to quiche directly, same as run() would
+    bool canBypass(uint64_t stream_id) const {
+        return mActive.empty() && mConnBucket.rate == 0 && mStreams.find(stream_id) == mStreams.end();
+    }
+
+    // Drop everything (connection gone)
+    void clear();
+
+private:
+    struct Chunk {
+        Command* cmd;
+        size_t offset;
+    };
+
+    struct StreamState {
+        std::deque<Chunk> chunks;
+        size_t queued;    // Bytes not yet accepted by quiche
+        uint32_t weight;
+        size_t deficit;
+        bool active;      // In mActive
+        bool in_turn;     // Holds an unfinished round-robin quantum
+        bool finished;    // FIN sent or stream failed - state can go
+        TokenBucket bucket;
+
+        StreamState() : queued(0), weight(1), deficit(0), active(false), in_turn(false), finished(false) {}
+    };
+
+    std::map<uint64_t, StreamState> mStreams;
+    std::deque<uint64_t> mActive;  // Round-robin order of streams with data
+    TokenBucket mConnBucket;
+    size_t mQueuedBytes;
+
+    // Returns bytes accepted; sets blocked when quiche or the buckets said stop
+    size_t serviceStream(quiche_conn* conn, uint64_t stream_id, StreamState& s,
+                         size_t budget, uint64_t now_ns, bool& blocked);
+    size_t pacedSendSize(const StreamState& s) const;
+    void dropStream(StreamState& s);
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_SEND_SCHEDULER_H__
@@ -0,0 +1,1275 @@
+// quiche_server_engine.cpp
+// QUIC Server Engine - accept, retry and connection table on one UDP socket
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+
+#include "quiche_server_engine_impl.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+
+extern "C" {
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>  // For IPPROTO_UDP on Android
+#include <sys/uio.h>      // For iovec (recvmsg/sendmsg)
+}
+
+namespace quiche {
+
+// ============================================================================
+// ServerConnectionImpl / ServerConnectionState Implementation
+// ============================================================================
+
+ServerConnectionImpl::~ServerConnectionImpl() {
+    std::lock_guard<std::mutex> lock(stream_buffers_mutex);
+    for (auto& pair : stream_buffers) {
+        delete pair.second;
+    }
+    stream_buffers.clear();
+}
+
+StreamReadBuffer* ServerConnectionImpl::getOrCreateStreamBuffer(uint64_t stream_id) {
+    std::lock_guard<std::mutex> lock(stream_buffers_mutex);
+
+    auto it = stream_buffers.find(stream_id);
+    if (it != stream_buffers.end()) {
+        return it->second;
+    }
+
+    StreamReadBuffer* buffer = new StreamReadBuffer();
+    stream_buffers[stream_id] = buffer;
+    return buffer;
+}
+
+ServerConnectionState::~ServerConnectionState() {
+    if (conn) {
+        quiche_conn_free(conn);
+        conn = nullptr;
+    }
+}
+
+void ServerConnectionState::snapshot() {
+    EngineStats current = {};
+    fillConnectionStats(conn, current);
+    current.send_queue_bytes = scheduler.queuedBytes();
+
+    std::lock_guard<std::mutex> lock(shared->snapshot_mutex);
+    shared->stats = current;
+    memcpy(&shared->peer_addr, &peer_addr, peer_addr_len);
+    shared->peer_addr_len = peer_addr_len;
+}
+
+// ============================================================================
+// ServerConnection Public API - Delegates to Impl
+// ============================================================================
+
+// Same default stream as QuicheEngine (client-initiated bidirectional stream)
+static const uint64_t DEFAULT_STREAM_ID = 4;
+
+ServerConnection::~ServerConnection() {
+    delete mPImpl;
+}
+
+ssize_t ServerConnection::write(const uint8_t* data, size_t len, bool fin) {
+    return writeStream(DEFAULT_STREAM_ID, data, len, fin);
+}
+
+ssize_t ServerConnection::read(uint8_t* buf, size_t buf_len, bool& fin) {
+    return readStream(DEFAULT_STREAM_ID, buf, buf_len, fin);
+}
+
+ssize_t ServerConnection::writeStream(uint64_t stream_id, const uint8_t* data, size_t len, bool fin) {
+    return mPImpl->server->connWrite(mPImpl, stream_id, data, len, fin);
+}
+
+ssize_t ServerConnection::readStream(uint64_t stream_id, uint8_t* buf, size_t buf_len, bool& fin) {
+    if (!buf) {
+        return -1;
+    }
+
+    StreamReadBuffer* buffer = mPImpl->getOrCreateStreamBuffer(stream_id);
+    return buffer->consume(buf, buf_len, fin);
+}
+
+bool ServerConnection::setStreamSchedule(uint64_t stream_id, uint32_t weight,
+                                         uint64_t max_rate, uint64_t burst) {
+    return mPImpl->server->connSchedule(mPImpl, stream_id, weight, max_rate, burst);
+}
+
+void ServerConnection::close(uint64_t app_error, const std::string& reason) {
+    mPImpl->server->connClose(mPImpl, app_error, reason);
+}
+
+bool ServerConnection::isConnected() const {
+    return mPImpl->connected.load();
+}
+
+EngineStats ServerConnection::getStats() const {
+    // As of the last flush of this connection
+    std::lock_guard<std::mutex> lock(mPImpl->snapshot_mutex);
+    return mPImpl->stats;
+}
+
+std::string ServerConnection::getPeerAddress() const {
+    std::lock_guard<std::mutex> lock(mPImpl->snapshot_mutex);
+    return formatAddress(&mPImpl->peer_addr, mPImpl->peer_addr_len);
+}
+
+std::string ServerConnection::getConnectionId() const {
+    const char hex_chars[] = "0123456789abcdef";
+    std::string result;
+    result.reserve(LOCAL_CONN_ID_LEN * 2);
+    for (size_t i = 0; i < LOCAL_CONN_ID_LEN; i++) {
+        result.push_back(hex_chars[mPImpl->cid[i] >> 4]);
+        result.push_back(hex_chars[mPImpl->cid[i] & 0x0F]);
+    }
+    return result;
+}
+
+// ============================================================================
+// QuicheServerEngineImpl Constructor/Destructor
+// ============================================================================
+
+QuicheServerEngineImpl::QuicheServerEngineImpl(const std::string& h, const std::string& p,
+                                               const ConfigMap& cfg)
+    : mHost(h), mPort(p), mConfig(cfg), mRetryEnabled(true), mMigrationEnabled(false),
+      mMaxConnections(0),
+      mQuicheCfg(nullptr), mSock(-1), mLocalAddrLen(0),
+      mLoop(nullptr), mThreadStarted(false), mLoopThreadId(std::thread::id()),
+      mNextHandleId(1), mConnCount(0),
+      mEventCallback(nullptr), mUserData(nullptr), mWrapper(nullptr),
+      mIsRunning(false),
+      mSendBufs(nullptr), mSendLens(nullptr), mSendAddrs(nullptr), mSendAddrLens(nullptr),
+      mSendCount(0)
+#if defined(__linux__)
+      , mRecvBufs(nullptr), mSendMsgs(nullptr), mRecvMsgs(nullptr),
+      mSendIovs(nullptr), mRecvIovs(nullptr), mRecvAddrs(nullptr)
+#else
+      , mRecvBuf(nullptr)
+#endif
+{
+    memset(&mLocalAddr, 0, sizeof(mLocalAddr));
+
+    mRetryEnabled = getConfigValue(ConfigKey::ENABLE_RETRY, true);
+    mMigrationEnabled = !getConfigValue(ConfigKey::DISABLE_ACTIVE_MIGRATION, true);
+    mMaxConnections = static_cast<size_t>(
+        getConfigValue(ConfigKey::MAX_CONNECTIONS, static_cast<uint64_t>(0)));
+}
+
+QuicheServerEngineImpl::~QuicheServerEngineImpl() {
+    // Stop event loop if running
+    if (mIsRunning && mLoop) {
+        auto* cmd = new Command();
+        cmd->type = CommandType::STOP;
+        mCmdQueue.push(cmd);
+        ev_async_send(mLoop, &mAsyncWatcher);
+    }
+
+    if (mThreadStarted && mLoopThread.joinable()) {
+        mLoopThread.join();
+        mThreadStarted = false;
+    }
+
+    // Free remaining connections without callbacks (application is going away)
+    for (auto& pair : mConnsByHandle) {
+        detachHandle(pair.second);
+        delete pair.second;
+    }
+    mConnsByHandle.clear();
+    mConnsByCid.clear();
+
+    if (mLoop) {
+        mTimers.detach();
+        ev_loop_destroy(mLoop);
+        mLoop = nullptr;
+    }
+
+    if (mQuicheCfg) {
+        quiche_config_free(mQuicheCfg);
+        mQuicheCfg = nullptr;
+    }
+
+    if (mSock >= 0) {
+        ::close(mSock);
+        mSock = -1;
+    }
+
+    // I/O buffers go away with mIoArena
+}
+
+// ============================================================================
+// QuicheServerEngineImpl Setup
+// ============================================================================
+
+bool QuicheServerEngineImpl::setEventCallback(ServerEventCallback callback, void* ud) {
+    mEventCallback = callback;
+    mUserData = ud;
+    return true;
+}
+
+bool QuicheServerEngineImpl::setupSocket() {
+    struct addrinfo hints = {};
+    hints.ai_family = PF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_protocol = IPPROTO_UDP;
+
+    struct addrinfo* local;
+    if (getaddrinfo(mHost.c_str(), mPort.c_str(), &hints, &local) != 0) {
+        mLastError = "Failed to resolve local address: " + mHost;
+        return false;
+    }
+
+    mSock = socket(local->ai_family, SOCK_DGRAM, 0);
+    if (mSock < 0) {
+        mLastError = "Failed to create socket";
+        freeaddrinfo(local);
+        return false;
+    }
+
+#ifdef SO_NOSIGPIPE
+    int set = 1;
+    if (setsockopt(mSock, SOL_SOCKET, SO_NOSIGPIPE, &set, sizeof(set)) < 0) {
+        std::cerr << "Warning: Failed to set SO_NOSIGPIPE" << std::endl;
+    }
+#endif
+
+    if (fcntl(mSock, F_SETFL, O_NONBLOCK) != 0 ||
+        bind(mSock, local->ai_addr, local->ai_addrlen) < 0) {
+        mLastError = "Failed to bind socket to " + mHost + ":" + mPort;
+        ::close(mSock);
+        mSock = -1;
+        freeaddrinfo(local);
+        return false;
+    }
+
+    freeaddrinfo(local);
+
+    mLocalAddrLen = sizeof(mLocalAddr);
+    if (getsockname(mSock, (struct sockaddr*)&mLocalAddr, &mLocalAddrLen) != 0) {
+        mLastError = "Failed to get local address";
+        ::close(mSock);
+        mSock = -1;
+        return false;
+    }
+
+    return true;
+}
+
+bool QuicheServerEngineImpl::setupConfig() {
+    mQuicheCfg = quiche_config_new(QUICHE_PROTOCOL_VERSION);
+    if (!mQuicheCfg) {
+        mLastError = "Failed to create QUIC config";
+        return false;
+    }
+
+    std::string cert_file = getConfigValue(ConfigKey::TLS_CERT_FILE, std::string("./cert.crt"));
+    std::string key_file = getConfigValue(ConfigKey::TLS_KEY_FILE, std::string("./cert.key"));
+    if (quiche_config_load_cert_chain_from_pem_file(mQuicheCfg, cert_file.c_str()) < 0 ||
+        quiche_config_load_priv_key_from_pem_file(mQuicheCfg, key_file.c_str()) < 0) {
+        mLastError = "Failed to load TLS certificate/key: " + cert_file + ", " + key_file;
+        quiche_config_free(mQuicheCfg);
+        mQuicheCfg = nullptr;
+        return false;
+    }
+
+    // Set application protocols
+    quiche_config_set_application_protos(mQuicheCfg,
+        (const uint8_t*)"\x0ahq-interop\x05hq-29\x05hq-28\x05hq-27\x08http/0.9", 38);
+
+    // Apply configuration parameters from map
+    quiche_config_set_max_idle_timeout(mQuicheCfg,
+        getConfigValue(ConfigKey::MAX_IDLE_TIMEOUT, static_cast<uint64_t>(5000)));
+
+    uint64_t max_udp_payload = getConfigValue(ConfigKey::MAX_UDP_PAYLOAD_SIZE,
+                                              static_cast<uint64_t>(MAX_DATAGRAM_SIZE));
+    quiche_config_set_max_recv_udp_payload_size(mQuicheCfg, max_udp_payload);
+    quiche_config_set_max_send_udp_payload_size(mQuicheCfg, max_udp_payload);
+
+    quiche_config_set_initial_max_data(mQuicheCfg,
+        getConfigValue(ConfigKey::INITIAL_MAX_DATA, static_cast<uint64_t>(10000000)));
+    quiche_config_set_initial_max_stream_data_bidi_local(mQuicheCfg,
+        getConfigValue(ConfigKey::INITIAL_MAX_STREAM_DATA_BIDI_LOCAL, static_cast<uint64_t>(1000000)));
+    quiche_config_set_initial_max_stream_data_bidi_remote(mQuicheCfg,
+        getConfigValue(ConfigKey::INITIAL_MAX_STREAM_DATA_BIDI_REMOTE, static_cast<uint64_t>(1000000)));
+    quiche_config_set_initial_max_stream_data_uni(mQuicheCfg,
+        getConfigValue(ConfigKey::INITIAL_MAX_STREAM_DATA_UNI, static_cast<uint64_t>(1000000)));
+    quiche_config_set_initial_max_streams_bidi(mQuicheCfg,
+        getConfigValue(ConfigKey::INITIAL_MAX_STREAMS_BIDI, static_cast<uint64_t>(100)));
+    quiche_config_set_initial_max_streams_uni(mQuicheCfg,
+        getConfigValue(ConfigKey::INITIAL_MAX_STREAMS_UNI, static_cast<uint64_t>(100)));
+    quiche_config_set_disable_active_migration(mQuicheCfg, !mMigrationEnabled);
+
+    uint64_t max_pacing_rate = getConfigValue(ConfigKey::MAX_PACING_RATE, static_cast<uint64_t>(0));
+    if (max_pacing_rate > 0) {
+        quiche_config_set_max_pacing_rate(mQuicheCfg, max_pacing_rate);
+    }
+
+    if (getConfigValue(ConfigKey::ENABLE_EARLY_DATA, false)) {
+        quiche_config_enable_early_data(mQuicheCfg);
+    }
+
+    if (getenv("SSLKEYLOGFILE")) {
+        quiche_config_log_keys(mQuicheCfg);
+    }
+
+    return true;
+}
+
+bool QuicheServerEngineImpl::setupIoBuffers() {
+    size_t send_bufs = mIoArena.reserve<uint8_t[SEND_SLOT_SIZE]>(BATCH_SIZE);
+    size_t send_lens = mIoArena.reserve<size_t>(BATCH_SIZE);
+    size_t send_addrs = mIoArena.reserve<struct sockaddr_storage>(BATCH_SIZE);
+    size_t send_addr_lens = mIoArena.reserve<socklen_t>(BATCH_SIZE);
+#if defined(__linux__)
+    size_t recv_bufs = mIoArena.reserve<uint8_t[MAX_RECV_BUF_SIZE]>(BATCH_SIZE);
+    size_t send_msgs = mIoArena.reserve<struct mmsghdr>(BATCH_SIZE);
+    size_t recv_msgs = mIoArena.reserve<struct mmsghdr>(BATCH_SIZE);
+    size_t send_iovs = mIoArena.reserve<struct iovec>(BATCH_SIZE);
+    size_t recv_iovs = mIoArena.reserve<struct iovec>(BATCH_SIZE);
+    size_t recv_addrs = mIoArena.reserve<struct sockaddr_storage>(BATCH_SIZE);
+#else
+    size_t recv_buf = mIoArena.reserve<uint8_t>(MAX_RECV_BUF_SIZE);
+#endif
+
+    // Mapped untouched here; the loop thread touches it first
+    if (!mIoArena.allocate(ioArenaOptionsFromConfig(mConfig), mLastError)) {
+        return false;
+    }
+
+    mSendBufs = mIoArena.get<uint8_t[SEND_SLOT_SIZE]>(send_bufs);
+    mSendLens = mIoArena.get<size_t>(send_lens);
+    mSendAddrs = mIoArena.get<struct sockaddr_storage>(send_addrs);
+    mSendAddrLens = mIoArena.get<socklen_t>(send_addr_lens);
+#if defined(__linux__)
+    mRecvBufs = mIoArena.get<uint8_t[MAX_RECV_BUF_SIZE]>(recv_bufs);
+    mSendMsgs = mIoArena.get<struct mmsghdr>(send_msgs);
+    mRecvMsgs = mIoArena.get<struct mmsghdr>(recv_msgs);
+    mSendIovs = mIoArena.get<struct iovec>(send_iovs);
+    mRecvIovs = mIoArena.get<struct iovec>(recv_iovs);
+    mRecvAddrs = mIoArena.get<struct sockaddr_storage>(recv_addrs);
+#else
+    mRecvBuf = mIoArena.get<uint8_t>(recv_buf);
+#endif
+    return true;
+}
+
+void QuicheServerEngineImpl::initRecvBuffers() {
+#if defined(__linux__)
+    // Recv structures are reused for every batch (the arena is zeroed)
+    for (int i = 0; i < BATCH_SIZE; i++) {
+        mRecvIovs[i].iov_base = mRecvBufs[i];
+        mRecvIovs[i].iov_len = MAX_RECV_BUF_SIZE;
+        mRecvMsgs[i].msg_hdr.msg_name = &mRecvAddrs[i];
+        mRecvMsgs[i].msg_hdr.msg_namelen = sizeof(mRecvAddrs[i]);
+        mRecvMsgs[i].msg_hdr.msg_iov = &mRecvIovs[i];
+        mRecvMsgs[i].msg_hdr.msg_iovlen = 1;
+    }
+#endif
+}
+
+bool QuicheServerEngineImpl::start() {
+    if (mThreadStarted) {
+        mLastError = "Server already running";
+        return false;
+    }
+
+    if (getConfigValue(ConfigKey::ENABLE_DEBUG_LOG, false)) {
+        quiche_enable_debug_logging([](const char* line, void*) {
+            std::cerr << "[QUICHE] " << line << std::endl;
+        }, nullptr);
+    }
+
+    if (!mIoArena.allocated() && !setupIoBuffers()) {
+        return false;
+    }
+
+    if (!setupSocket()) {
+        return false;
+    }
+
+    if (!setupConfig()) {
+        return false;
+    }
+
+    mLoop = ev_loop_new(EVFLAG_AUTO);
+    if (!mLoop) {
+        mLastError = "Failed to create event loop";
+        return false;
+    }
+
+    ev_io_init(&mIoWatcher, recvCallback, mSock, EV_READ);
+    mIoWatcher.data = this;
+    ev_io_start(mLoop, &mIoWatcher);
+
+    ev_async_init(&mAsyncWatcher, asyncCallback);
+    mAsyncWatcher.data = this;
+    ev_async_start(mLoop, &mAsyncWatcher);
+
+    // Connections that time out together are flushed in one batch
+    mTimers.attach(mLoop, timerSweepDone, this);
+
+    mIsRunning = true;
+    try {
+        mLoopThread = std::thread(eventLoopThread, this);
+        mThreadStarted = true;
+    } catch (const std::system_error& e) {
+        mLastError = "Failed to create event loop thread: " + std::string(e.what());
+        mIsRunning = false;
+        ev_loop_destroy(mLoop);
+        mLoop = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void QuicheServerEngineImpl::shutdown(uint64_t app_error, const std::string& reason) {
+    if (mIsRunning && mLoop) {
+        // Close every connection (handle 0), flush, then stop the loop
+        connClose(nullptr, app_error, reason);
+
+        auto* cmd = new Command();
+        cmd->type = CommandType::STOP;
+        mCmdQueue.push(cmd);
+        ev_async_send(mLoop, &mAsyncWatcher);
+    }
+
+    if (mThreadStarted && mLoopThread.joinable()) {
+        mLoopThread.join();
+        mThreadStarted = false;
+    }
+
+    mIsRunning = false;
+}
+
+void QuicheServerEngineImpl::eventLoopThread(QuicheServerEngineImpl* impl) {
+    thread_utils::setCurrentThreadName("QuicServerLoop");
+
+    LoopThreadInfo info = applyLoopThreadConfig(impl->mConfig);
+    {
+        std::lock_guard<std::mutex> lock(impl->mLoopThreadInfoMutex);
+        impl->mLoopThreadInfo = info;
+    }
+
+    // First touch of the I/O arena: after affinity, so the pages are local
+    impl->initRecvBuffers();
+
+    // Calls from the event handler run inline from here on
+    impl->mLoopThreadId.store(std::this_thread::get_id());
+
+    ev_run(impl->mLoop, 0);
+    impl->mLoopThreadId.store(std::thread::id());
+    impl->mIsRunning = false;
+}
+
+// ============================================================================
+// Connection Handle API (any thread -> command queue; the event handler's
+// writes run inline)
+// ============================================================================
+
+ssize_t QuicheServerEngineImpl::connWrite(ServerConnectionImpl* h, uint64_t stream_id,
+                                          const uint8_t* data, size_t len, bool fin) {
+    static const uint8_t kEmpty = 0;  // quiche wants a valid pointer for FIN-only sends
+
+    if ((!data && len > 0) || len > MAX_WRITE_DATA_SIZE || (len == 0 && !fin)) {
+        return -1;
+    }
+    if (h->closed.load()) {
+        return -1;
+    }
+
+    // From the event handler: straight into quiche when nothing is queued
+    // ahead, flushed once the current dispatch pass reaches the connection.
+    // Other threads only route by handle ID: the state may go at any time.
+    // Writes of other threads still in the command queue come first
+    ServerConnectionState* c = onLoopThread() && h->queued_writes.load() == 0 ? h->state : nullptr;
+    bool inline_write = c != nullptr;
+    size_t sent = 0;
+    if (inline_write) {
+        if (quiche_conn_is_established(c->conn) && c->scheduler.canBypass(stream_id)) {
+            uint64_t error_code;
+            ssize_t written = quiche_conn_stream_send(c->conn, stream_id, len > 0 ? data : &kEmpty,
+                                                      len, fin, &error_code);
+            if (written < 0 && written != QUICHE_ERR_DONE) {
+                return -1;
+            }
+            if (written >= 0) {
+                sent = static_cast<size_t>(written);
+                if (sent == len) {
+                    markDirty(c);
+                    return static_cast<ssize_t>(len);
+                }
+            }
+        }
+    }
+
+    auto* cmd = Command::newWrite(len - sent);
+    cmd->conn_handle = h->handle_id;
+    cmd->params.write.stream_id = stream_id;
+    if (len > sent) {
+        memcpy(cmd->params.write.data, data + sent, len - sent);
+    }
+    cmd->params.write.fin = fin;
+    cmd->params.write.deadline_ns = 0;
+
+    if (inline_write) {
+        c->scheduler.enqueue(cmd);
+        markDirty(c);
+        return static_cast<ssize_t>(len);
+    }
+
+    h->queued_writes.fetch_add(1);
+    mCmdQueue.push(cmd);
+    if (mLoop) {
+        ev_async_send(mLoop, &mAsyncWatcher);
+    }
+
+    return static_cast<ssize_t>(len);
+}
+
+bool QuicheServerEngineImpl::connSchedule(ServerConnectionImpl* h, uint64_t stream_id,
+                                          uint32_t weight, uint64_t max_rate, uint64_t burst) {
+    if (weight == 0 || h->closed.load()) {
+        return false;
+    }
+
+    auto* cmd = new Command();
+    cmd->type = CommandType::STREAM_SCHEDULE;
+    cmd->conn_handle = h->handle_id;
+    cmd->params.schedule.stream_id = stream_id;
+    cmd->params.schedule.weight = weight;
+    cmd->params.schedule.max_rate = max_rate;
+    cmd->params.schedule.burst = burst;
+
+    mCmdQueue.push(cmd);
+    if (mLoop) {
+        ev_async_send(mLoop, &mAsyncWatcher);
+    }
+
+    return true;
+}
+
+void QuicheServerEngineImpl::connClose(ServerConnectionImpl* h, uint64_t app_error,
+                                       const std::string& reason) {
+    if (h && h->closed.load()) {
+        return;
+    }
+
+    auto* cmd = new Command();
+    cmd->type = CommandType::CLOSE;
+    cmd->conn_handle = h ? h->handle_id : 0;
+    cmd->params.close.error_code = app_error;
+
+    strncpy(cmd->params.close.reason, reason.c_str(), sizeof(cmd->params.close.reason) - 1);
+    cmd->params.close.reason[sizeof(cmd->params.close.reason) - 1] = '\0';
+
+    mCmdQueue.push(cmd);
+    if (mLoop) {
+        ev_async_send(mLoop, &mAsyncWatcher);
+    }
+}
+
+void QuicheServerEngineImpl::processCommands() {
+    Command* cmd;
+    while ((cmd = mCmdQueue.pop()) != nullptr) {
+        switch (cmd->type) {
+            case CommandType::WRITE: {
+                // Stale handles (connection already gone) are dropped
+                auto it = mConnsByHandle.find(cmd->conn_handle);
+                if (it != mConnsByHandle.end()) {
+                    // The connection's scheduler owns the command from here
+                    it->second->shared->queued_writes.fetch_sub(1);
+                    it->second->scheduler.enqueue(cmd);
+                    cmd = nullptr;
+                    markDirty(it->second);
+                }
+                break;
+            }
+
+            case CommandType::STREAM_SCHEDULE: {
+                auto it = mConnsByHandle.find(cmd->conn_handle);
+                if (it != mConnsByHandle.end()) {
+                    it->second->scheduler.setStreamParams(cmd->params.schedule.stream_id,
+                                                          cmd->params.schedule.weight,
+                                                          cmd->params.schedule.max_rate,
+                                                          cmd->params.schedule.burst,
+                                                          monotonicNowNs());
+                    markDirty(it->second);
+                }
+                break;
+            }
+
+            case CommandType::CLOSE: {
+                const uint8_t* reason = reinterpret_cast<const uint8_t*>(cmd->params.close.reason);
+                size_t reason_len = strlen(cmd->params.close.reason);
+
+                // Queued writes get what capacity allows before the close goes out
+                if (cmd->conn_handle == 0) {
+                    for (auto& pair : mConnsByHandle) {
+                        flushConnection(pair.second);
+                        quiche_conn_close(pair.second->conn, true, cmd->params.close.error_code,
+                                          reason, reason_len);
+                        markDirty(pair.second);
+                    }
+                } else {
+                    auto it = mConnsByHandle.find(cmd->conn_handle);
+                    if (it != mConnsByHandle.end()) {
+                        flushConnection(it->second);
+                        quiche_conn_close(it->second->conn, true, cmd->params.close.error_code,
+                                          reason, reason_len);
+                        markDirty(it->second);
+                    }
+                }
+                break;
+            }
+
+            case CommandType::STOP: {
+                // Send whatever the preceding commands produced before leaving
+                processDirty();
+                ev_break(mLoop, EVBREAK_ONE);
+                break;
+            }
+
+            case CommandType::PROBE_PATH:
+            case CommandType::MIGRATE:
+                // Client-initiated only; the server follows the peer's path
+                break;
+
+            case CommandType::CONNECT:
+            case CommandType::RESOLVED:
+            case CommandType::SET_IDLE_TIMEOUT:
+            case CommandType::RPC_CALL:
+            case CommandType::STREAM_READ:
+                // Client-only
+                break;
+        }
+
+        delete cmd;
+    }
+
+    processDirty();
+}
+
+// ============================================================================
+// Packet Processing (event loop thread only)
+// ============================================================================
+
+void QuicheServerEngineImpl::recvCallback(EV_P_ ev_io* w, int revents) {
+    (void)EV_A;
+    (void)revents;
+
+    QuicheServerEngineImpl* impl = static_cast<QuicheServerEngineImpl*>(w->data);
+
+#if defined(__linux__)
+    // Batch receive multiple UDP packets in one syscall
+    while (true) {
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            impl->mRecvMsgs[i].msg_hdr.msg_namelen = sizeof(impl->mRecvAddrs[i]);
+        }
+
+        int num_msgs = recvmmsg(impl->mSock, impl->mRecvMsgs, BATCH_SIZE, 0, nullptr);
+        if (num_msgs < 0) {
+            if (errno != EWOULDBLOCK && errno != EAGAIN) {
+                impl->mLastError = "Failed to receive packets";
+            }
+            break;
+        }
+
+        for (int i = 0; i < num_msgs; i++) {
+            impl->handlePacket(impl->mRecvBufs[i], impl->mRecvMsgs[i].msg_len,
+                               &impl->mRecvAddrs[i], impl->mRecvMsgs[i].msg_hdr.msg_namelen);
+        }
+
+        if (num_msgs < BATCH_SIZE) {
+            break;
+        }
+    }
+#else
+    // Fallback to single packet recvmsg for macOS/iOS and other platforms
+    while (true) {
+        struct sockaddr_storage peer_addr;
+
+        struct iovec iov;
+        iov.iov_base = impl->mRecvBuf;
+        iov.iov_len = MAX_RECV_BUF_SIZE;
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &peer_addr;
+        msg.msg_namelen = sizeof(peer_addr);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+
+        ssize_t len = recvmsg(impl->mSock, &msg, 0);
+        if (len < 0) {
+            if (errno != EWOULDBLOCK && errno != EAGAIN) {
+                impl->mLastError = "Failed to receive packet";
+            }
+            break;
+        }
+
+        impl->handlePacket(impl->mRecvBuf, len, &peer_addr, msg.msg_namelen);
+    }
+#endif
+
+    // One dispatch + egress pass for every connection touched by this batch
+    impl->processDirty();
+}
+
+void QuicheServerEngineImpl::handlePacket(uint8_t* buf, size_t len,
+                                          struct sockaddr_storage* peer, socklen_t peer_len) {
+    uint8_t type;
+    uint32_t version;
+
+    uint8_t scid[QUICHE_MAX_CONN_ID_LEN];
+    size_t scid_len = sizeof(scid);
+
+    uint8_t dcid[QUICHE_MAX_CONN_ID_LEN];
+    size_t dcid_len = sizeof(dcid);
+
+    uint8_t odcid[QUICHE_MAX_CONN_ID_LEN];
+    size_t odcid_len = sizeof(odcid);
+
+    uint8_t token[MAX_TOKEN_LEN];
+    size_t token_len = sizeof(token);
+
+    int rc = quiche_header_info(buf, len, LOCAL_CONN_ID_LEN, &version,
+                                &type, scid, &scid_len, dcid, &dcid_len,
+                                token, &token_len);
+    if (rc < 0) {
+        return;  // Not a QUIC packet we can parse
+    }
+
+    ServerConnectionState* c = nullptr;
+    auto it = mConnsByCid.find(std::string(reinterpret_cast<const char*>(dcid), dcid_len));
+    if (it != mConnsByCid.end()) {
+        c = it->second;
+    }
+
+    if (!c) {
+        if (!quiche_version_is_supported(version)) {
+            ssize_t written = quiche_negotiate_version(scid, scid_len, dcid, dcid_len,
+                                                       sendSlot(), MAX_DATAGRAM_SIZE);
+            if (written > 0) {
+                commitSendSlot(written, peer, peer_len);
+            }
+            return;
+        }
+
+        // At capacity: drop before a Retry or any per-connection state, the
+        // client's retransmits find room once connections close
+        if (mMaxConnections > 0 && mConnCount.load() >= mMaxConnections) {
+            return;
+        }
+
+        const uint8_t* accept_odcid = nullptr;
+        size_t accept_odcid_len = 0;
+
+        if (mRetryEnabled) {
+            if (token_len == 0) {
+                // Stateless retry: no state is kept until the client proves its address
+                mintToken(dcid, dcid_len, peer, peer_len, token, &token_len);
+
+                uint8_t new_cid[LOCAL_CONN_ID_LEN];
+                if (!generateConnectionId(new_cid, sizeof(new_cid))) {
+                    return;
+                }
+
+                ssize_t written = quiche_retry(scid, scid_len, dcid, dcid_len,
+                                               new_cid, sizeof(new_cid),
+                                               token, token_len, version,
+                                               sendSlot(), MAX_DATAGRAM_SIZE);
+                if (written > 0) {
+                    commitSendSlot(written, peer, peer_len);
+                }
+                return;
+            }
+
+            if (!validateToken(token, token_len, peer, peer_len, odcid, &odcid_len)) {
+                return;  // Invalid address validation token
+            }
+
+            accept_odcid = odcid;
+            accept_odcid_len = odcid_len;
+        }
+
+        c = createConnection(dcid, dcid_len, accept_odcid, accept_odcid_len, peer, peer_len);
+        if (!c) {
+            return;
+        }
+    }
+
+    quiche_recv_info recv_info = {
+        (struct sockaddr*)peer,
+        peer_len,
+        (struct sockaddr*)&mLocalAddr,
+        mLocalAddrLen,
+    };
+
+    ssize_t done = quiche_conn_recv(c->conn, buf, len, &recv_info);
+    if (done < 0) {
+        // Ignore receive errors for this packet
+    }
+
+    markDirty(c);
+}
+
+ServerConnectionState* QuicheServerEngineImpl::createConnection(
+        const uint8_t* dcid, size_t dcid_len,
+        const uint8_t* odcid, size_t odcid_len,
+        struct sockaddr_storage* peer, socklen_t peer_len) {
+    ServerConnectionState* c = new ServerConnectionState(this);
+
+    // After a retry the client already uses our CID; otherwise pick a fresh one
+    // and keep routing the client's initial DCID until it switches over
+    if (mRetryEnabled && dcid_len == LOCAL_CONN_ID_LEN) {
+        memcpy(c->cid, dcid, LOCAL_CONN_ID_LEN);
+    } else if (!generateConnectionId(c->cid, LOCAL_CONN_ID_LEN)) {
+        delete c;
+        return nullptr;
+    } else {
+        c->table_keys.push_back(std::string(reinterpret_cast<const char*>(dcid), dcid_len));
+    }
+    c->table_keys.push_back(std::string(reinterpret_cast<const char*>(c->cid), LOCAL_CONN_ID_LEN));
+
+    c->conn = quiche_accept(c->cid, LOCAL_CONN_ID_LEN, odcid, odcid_len,
+                            (struct sockaddr*)&mLocalAddr, mLocalAddrLen,
+                            (struct sockaddr*)peer, peer_len,
+                            mQuicheCfg);
+    if (!c->conn) {
+        delete c;
+        return nullptr;
+    }
+
+    memcpy(&c->peer_addr, peer, peer_len);
+    c->peer_addr_len = peer_len;
+
+    uint64_t max_pacing_rate = getConfigValue(ConfigKey::MAX_PACING_RATE, static_cast<uint64_t>(0));
+    if (max_pacing_rate > 0) {
+        c->scheduler.setConnectionRate(max_pacing_rate, monotonicNowNs());
+    }
+
+    c->timer.fire = timerFired;
+    c->timer.data = c;
+
+    c->handle_id = mNextHandleId++;
+    c->shared = new ServerConnectionImpl(this, c->handle_id);
+    memcpy(c->shared->cid, c->cid, LOCAL_CONN_ID_LEN);
+    c->shared->state = c;
+    c->handle.reset(new ServerConnection(c->shared));
+    c->snapshot();
+
+    for (const std::string& key : c->table_keys) {
+        mConnsByCid[key] = c;
+    }
+    mConnsByHandle[c->handle_id] = c;
+    mConnCount.fetch_add(1);
+
+    return c;
+}
+
+void QuicheServerEngineImpl::markDirty(ServerConnectionState* c) {
+    if (!c->dirty) {
+        c->dirty = true;
+        mDirtyConns.push_back(c);
+    }
+}
+
+void QuicheServerEngineImpl::processDirty() {
+    // The handler's inline writes may dirty connections already done in
+    // this pass: repeat until none is left
+    while (!mDirtyConns.empty()) {
+        processDirtyOnce();
+    }
+
+    flushSendBatch();
+}
+
+void QuicheServerEngineImpl::processDirtyOnce() {
+    std::vector<ServerConnectionState*> dirty;
+    dirty.swap(mDirtyConns);
+
+    // Still dirty while processed: writes its handler makes go out with
+    // the flush below
+    for (ServerConnectionState* c : dirty) {
+        if (quiche_conn_is_established(c->conn) && !c->connected) {
+            c->connected = true;
+            c->shared->connected.store(true);
+
+            const uint8_t* app_proto;
+            size_t app_proto_len;
+            quiche_conn_application_proto(c->conn, &app_proto, &app_proto_len);
+            emitEvent(c, EngineEvent::CONNECTED,
+                      EventData(std::string(reinterpret_cast<const char*>(app_proto), app_proto_len)));
+        }
+
+        if (c->connected && mMigrationEnabled) {
+            updateConnectionIds(c);
+        }
+        processPathEvents(c);
+
+        readStreams(c);
+        flushConnection(c);
+        c->dirty = false;
+
+        if (quiche_conn_is_closed(c->conn)) {
+            destroyConnection(c, true);
+        }
+    }
+}
+
+void QuicheServerEngineImpl::updateConnectionIds(ServerConnectionState* c) {
+    // Forget CIDs the client retired (e.g. after moving to a new path)
+    const uint8_t* retired;
+    size_t retired_len;
+    while (quiche_conn_retired_scid_next(c->conn, &retired, &retired_len)) {
+        std::string key(reinterpret_cast<const char*>(retired), retired_len);
+        auto it = mConnsByCid.find(key);
+        if (it != mConnsByCid.end() && it->second == c) {
+            mConnsByCid.erase(it);
+        }
+        for (auto k = c->table_keys.begin(); k != c->table_keys.end(); ++k) {
+            if (*k == key) {
+                c->table_keys.erase(k);
+                break;
+            }
+        }
+    }
+
+    // Hand out spare CIDs so the client can probe and migrate
+    while (quiche_conn_scids_left(c->conn) > 0) {
+        uint8_t scid[LOCAL_CONN_ID_LEN];
+        uint8_t reset_token[16];
+        if (!generateConnectionId(scid, sizeof(scid)) ||
+            !generateConnectionId(reset_token, sizeof(reset_token))) {
+            return;
+        }
+
+        uint64_t seq;
+        if (quiche_conn_new_scid(c->conn, scid, sizeof(scid), reset_token, false, &seq) < 0) {
+            return;
+        }
+
+        std::string key(reinterpret_cast<const char*>(scid), sizeof(scid));
+        c->table_keys.push_back(key);
+        mConnsByCid[key] = c;
+    }
+}
+
+void QuicheServerEngineImpl::processPathEvents(ServerConnectionState* c) {
+    quiche_path_event* ev;
+    while ((ev = quiche_conn_path_event_next(c->conn)) != nullptr) {
+        if (quiche_path_event_type(ev) == QUICHE_PATH_EVENT_PEER_MIGRATED) {
+            struct sockaddr_storage local;
+            socklen_t local_len = sizeof(local);
+            struct sockaddr_storage peer;
+            socklen_t peer_len = sizeof(peer);
+            quiche_path_event_peer_migrated(ev, &local, &local_len, &peer, &peer_len);
+
+            memcpy(&c->peer_addr, &peer, peer_len);
+            c->peer_addr_len = peer_len;
+            c->snapshot();
+            emitEvent(c, EngineEvent::PEER_MIGRATED, EventData(formatAddress(&peer, peer_len)));
+        }
+
+        // NEW/VALIDATED paths are handled by quiche itself on the server side
+        quiche_path_event_free(ev);
+    }
+}
+
+void QuicheServerEngineImpl::readStreams(ServerConnectionState* c) {
+    uint8_t temp_buf[65536];
+
+    quiche_stream_iter* readable = quiche_conn_readable(c->conn);
+    uint64_t stream_id;
+    while (quiche_stream_iter_next(readable, &stream_id)) {
+        StreamReadBuffer* buffer = c->shared->getOrCreateStreamBuffer(stream_id);
+        bool got_data = false;
+
+        // Drain the stream: one STREAM_READABLE per stream per pass
+        while (true) {
+            bool fin = false;
+            uint64_t error_code;
+            ssize_t read_len = quiche_conn_stream_recv(c->conn, stream_id, temp_buf,
+                                                       sizeof(temp_buf), &fin, &error_code);
+            if (read_len < 0) {
+                break;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(buffer->mMutex);
+                buffer->data.insert(buffer->data.end(), temp_buf, temp_buf + read_len);
+                if (fin) {
+                    buffer->fin_received = true;
+                }
+            }
+            got_data = true;
+
+            if (fin || read_len == 0) {
+                break;
+            }
+        }
+
+        if (got_data) {
+            emitEvent(c, EngineEvent::STREAM_READABLE, EventData(stream_id));
+        }
+    }
+    quiche_stream_iter_free(readable);
+}
+
+void QuicheServerEngineImpl::flushConnection(ServerConnectionState* c) {
+    // Queued stream data first (held until the handshake allows stream data)
+    if (quiche_conn_is_established(c->conn) || quiche_conn_is_in_early_data(c->conn)) {
+        c->scheduler.run(c->conn, monotonicNowNs(), c->sched_wakeup_ns);
+    }
+
+    while (true) {
+        quiche_send_info send_info;
+        ssize_t written = quiche_conn_send(c->conn, sendSlot(), MAX_DATAGRAM_SIZE, &send_info);
+
+        if (written == QUICHE_ERR_DONE) {
+            break;
+        }
+
+        if (written < 0) {
+            mLastError = "Failed to create packet";
+            break;
+        }
+
+        commitSendSlot(written, &send_info.to, send_info.to_len);
+    }
+
+    // Rate-limited sends share the connection timer (early on_timeout is a no-op)
+    uint64_t timeout_ns = quiche_conn_timeout_as_nanos(c->conn);
+    uint64_t deadline_ns = timeout_ns == UINT64_MAX ? 0 : monotonicNowNs() + timeout_ns;
+    if (c->sched_wakeup_ns != 0 && (deadline_ns == 0 || c->sched_wakeup_ns < deadline_ns)) {
+        deadline_ns = c->sched_wakeup_ns;
+    }
+
+    // Re-arming to an unchanged deadline leaves the wheel untouched
+    if (deadline_ns == 0) {
+        mTimers.cancel(&c->timer);
+    } else {
+        mTimers.schedule(&c->timer, deadline_ns);
+    }
+
+    c->snapshot();
+}
+
+void QuicheServerEngineImpl::destroyConnection(ServerConnectionState* c, bool notify) {
+    if (notify) {
+        emitEvent(c, EngineEvent::CONNECTION_CLOSED, EventData());
+    }
+
+    // Dirtied again by a write from the handler
+    if (c->dirty) {
+        mDirtyConns.erase(std::remove(mDirtyConns.begin(), mDirtyConns.end(), c), mDirtyConns.end());
+    }
+
+    mTimers.cancel(&c->timer);
+
+    for (const std::string& key : c->table_keys) {
+        auto it = mConnsByCid.find(key);
+        if (it != mConnsByCid.end() && it->second == c) {
+            mConnsByCid.erase(it);
+        }
+    }
+    mConnsByHandle.erase(c->handle_id);
+    mConnCount.fetch_sub(1);
+
+    detachHandle(c);
+    delete c;
+}
+
+void QuicheServerEngineImpl::detachHandle(ServerConnectionState* c) {
+    // Retained handles outlive the connection: writes fail from now on,
+    // reads return what is buffered
+    c->shared->state = nullptr;
+    c->shared->connected.store(false);
+    c->shared->closed.store(true);
+    c->handle.reset();
+}
+
+void QuicheServerEngineImpl::timerFired(TimerNode* node) {
+    ServerConnectionState* c = static_cast<ServerConnectionState*>(node->data);
+
+    quiche_conn_on_timeout(c->conn);
+    c->server->markDirty(c);
+}
+
+void QuicheServerEngineImpl::timerSweepDone(void* ctx) {
+    // All expired connections of this sweep: one dispatch + sendmmsg pass
+    static_cast<QuicheServerEngineImpl*>(ctx)->processDirty();
+}
+
+void QuicheServerEngineImpl::asyncCallback(EV_P_ ev_async* w, int revents) {
+    (void)EV_A;
+    (void)revents;
+
+    QuicheServerEngineImpl* impl = static_cast<QuicheServerEngineImpl*>(w->data);
+    impl->processCommands();
+}
+
+void QuicheServerEngineImpl::emitEvent(ServerConnectionState* c, EngineEvent event,
+                                       const EventData& data) {
+    if (mEventCallback) {
+        mEventCallback(mWrapper, c ? c->handle.get() : nullptr, event, data, mUserData);
+    }
+}
+
+// ============================================================================
+// Batched Send (event loop thread only)
+// ============================================================================
+
+void QuicheServerEngineImpl::commitSendSlot(size_t len, const struct sockaddr_storage* to,
+                                            socklen_t to_len) {
+    mSendLens[mSendCount] = len;
+    memcpy(&mSendAddrs[mSendCount], to, to_len);
+    mSendAddrLens[mSendCount] = to_len;
+    mSendCount++;
+
+    if (mSendCount == BATCH_SIZE) {
+        flushSendBatch();
+    }
+}
+
+void QuicheServerEngineImpl::flushSendBatch() {
+    if (mSendCount == 0) {
+        return;
+    }
+
+    // Use MSG_NOSIGNAL on Linux/Android to prevent SIGPIPE
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags |= MSG_NOSIGNAL;
+#endif
+
+#if defined(__linux__)
+    for (int i = 0; i < mSendCount; i++) {
+        mSendIovs[i].iov_base = mSendBufs[i];
+        mSendIovs[i].iov_len = mSendLens[i];
+
+        memset(&mSendMsgs[i], 0, sizeof(mSendMsgs[i]));
+        mSendMsgs[i].msg_hdr.msg_name = &mSendAddrs[i];
+        mSendMsgs[i].msg_hdr.msg_namelen = mSendAddrLens[i];
+        mSendMsgs[i].msg_hdr.msg_iov = &mSendIovs[i];
+        mSendMsgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int sent_count = sendmmsg(mSock, mSendMsgs, mSendCount, flags);
+    if (sent_count < 0) {
+        // Ignore send errors for now (loss recovery retransmits)
+    }
+#else
+    for (int i = 0; i < mSendCount; i++) {
+        struct iovec iov;
+        iov.iov_base = mSendBufs[i];
+        iov.iov_len = mSendLens[i];
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &mSendAddrs[i];
+        msg.msg_namelen = mSendAddrLens[i];
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+
+        ssize_t sent = sendmsg(mSock, &msg, flags);
+        if (sent < 0) {
+            // Ignore send errors for now (loss recovery retransmits)
+        }
+    }
+#endif
+
+    mSendCount = 0;
+}
+
+// ============================================================================
+// Connection IDs and Address Validation Tokens
+// ============================================================================
+
+void QuicheServerEngineImpl::mintToken(const uint8_t* dcid, size_t dcid_len,
+                                       const struct sockaddr_storage* addr, socklen_t addr_len,
+                                       uint8_t* token, size_t* token_len) {
+    memcpy(token, "quiche", TOKEN_PREFIX_LEN);
+    memcpy(token + TOKEN_PREFIX_LEN, addr, addr_len);
+    memcpy(token + TOKEN_PREFIX_LEN + addr_len, dcid, dcid_len);
+
+    *token_len = TOKEN_PREFIX_LEN + addr_len + dcid_len;
+}
+
+bool QuicheServerEngineImpl::validateToken(const uint8_t* token, size_t token_len,
+                                           const struct sockaddr_storage* addr, socklen_t addr_len,
+                                           uint8_t* odcid, size_t* odcid_len) {
+    if (token_len < TOKEN_PREFIX_LEN || memcmp(token, "quiche", TOKEN_PREFIX_LEN) != 0) {
+        return false;
+    }
+
+    token += TOKEN_PREFIX_LEN;
+    token_len -= TOKEN_PREFIX_LEN;
+
+    if (token_len < addr_len || memcmp(token, addr, addr_len) != 0) {
+        return false;
+    }
+
+    token += addr_len;
+    token_len -= addr_len;
+
+    if (*odcid_len < token_len) {
+        return false;
+    }
+
+    memcpy(odcid, token, token_len);
+    *odcid_len = token_len;
+
+    return true;
+}
+
+// ============================================================================
+// QuicheServerEngine Public API - Delegates to Impl
+// ============================================================================
+
+QuicheServerEngine::QuicheServerEngine(const std::string& host, const std::string& port,
+                                       const ConfigMap& config)
+    : mPImpl(new QuicheServerEngineImpl(host, port, config))
+{
+    mPImpl->setWrapper(this);
+}
+
+QuicheServerEngine::~QuicheServerEngine() {
+    delete mPImpl;
+}
+
+bool QuicheServerEngine::setEventCallback(ServerEventCallback callback, void* user_data) {
+    return mPImpl->setEventCallback(callback, user_data);
+}
+
+bool QuicheServerEngine::start() {
+    return mPImpl->start();
+}
+
+void QuicheServerEngine::shutdown(uint64_t app_error, const std::string& reason) {
+    mPImpl->shutdown(app_error, reason);
+}
+
+bool QuicheServerEngine::isRunning() const {
+    return mPImpl->isRunning();
+}
+
+size_t QuicheServerEngine::connectionCount() const {
+    return mPImpl->connectionCount();
+}
+
+LoopThreadInfo QuicheServerEngine::getLoopThreadInfo() const {
+    return mPImpl->getLoopThreadInfo();
+}
+
+std::string QuicheServerEngine::getLastError() const {
+    return mPImpl->getLastError();
+}
+
+} // namespace quiche
@@ -0,0 +1,279 @@
+#ifndef __QUICHE_SERVER_ENGINE_IMPL_H__
+#define __QUICHE_SERVER_ENGINE_IMPL_H__
+
+#include <quiche_server_engine.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "quiche_engine_impl.h"
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <ev.h>
+#include <quiche.h>
+}
+
+namespace quiche {
+
+// Address validation token: "quiche" + peer address + original DCID.
+// Ported as-is from quiche's examples/server.c: the token is neither
+// encrypted nor authenticated, so anyone can forge one for an address they
+// spoof. Retry only makes an off-path attacker echo a token; it is not
+// address validation against an attacker who knows this format.
+constexpr size_t TOKEN_PREFIX_LEN = sizeof("quiche") - 1;
+constexpr size_t MAX_TOKEN_LEN = TOKEN_PREFIX_LEN + sizeof(struct sockaddr_storage) + QUICHE_MAX_CONN_ID_LEN;
+
+struct ServerConnectionState;
+
+// What a ServerConnection handle needs from any thread. The handle is
+// shared: the server drops its reference once the connection is gone,
+// shared_from_this() holders keep the handle (not the connection) alive.
+struct ServerConnectionImpl {
+    QuicheServerEngineImpl* server;
+    uint64_t handle_id;            // Command routing key (never reused; stale ones are dropped)
+    uint8_t cid[LOCAL_CONN_ID_LEN];
+    ServerConnectionState* state;  // Event loop thread only; nullptr once destroyed
+
+    std::atomic<bool> connected;
+    std::atomic<bool> closed;
+    std::atomic<size_t> queued_writes;  // WRITE commands still in the server's command queue
+
+    // Copied on the event loop thread after each flush and on migration
+    mutable std::mutex snapshot_mutex;
+    EngineStats stats;
+    struct sockaddr_storage peer_addr;
+    socklen_t peer_addr_len;
+
+    // Stream read buffers (populated by event loop thread)
+    std::map<uint64_t, StreamReadBuffer*> stream_buffers;
+    std::mutex stream_buffers_mutex;  // Protect map access (C++ mutex, non-recursive)
+
+    ServerConnectionImpl(QuicheServerEngineImpl* s, uint64_t id)
+        : server(s), handle_id(id), state(nullptr), connected(false), closed(false),
+          queued_writes(0), stats(), peer_addr_len(0) {}
+
+    ~ServerConnectionImpl();
+
+    // Disable copy
+    ServerConnectionImpl(const ServerConnectionImpl&) = delete;
+    ServerConnectionImpl& operator=(const ServerConnectionImpl&) = delete;
+
+    StreamReadBuffer* getOrCreateStreamBuffer(uint64_t stream_id);
+};
+
+// Per-connection state (owned by the server event loop thread)
+struct ServerConnectionState {
+    QuicheServerEngineImpl* server;
+    std::shared_ptr<ServerConnection> handle;  // Public handle passed to callbacks
+    ServerConnectionImpl* shared;              // handle's impl
+    uint64_t handle_id;
+
+    uint8_t cid[LOCAL_CONN_ID_LEN];
+    std::vector<std::string> table_keys;  // DCIDs routed to this connection
+    quiche_conn* conn;
+
+    struct sockaddr_storage peer_addr;
+    socklen_t peer_addr_len;
+
+    TimerNode timer;               // Entry in the server's timer wheel
+
+    SendScheduler scheduler;       // Queued stream writes
+    uint64_t sched_wakeup_ns;      // Rate-limited data waiting on tokens (0 = none)
+
+    bool connected;
+    bool dirty;                    // Needs event dispatch + egress flush
+
+    explicit ServerConnectionState(QuicheServerEngineImpl* s)
+        : server(s), shared(nullptr), handle_id(0), conn(nullptr),
+          peer_addr_len(0), sched_wakeup_ns(0), connected(false), dirty(false) {}
+
+    ~ServerConnectionState();
+
+    // Disable copy
+    ServerConnectionState(const ServerConnectionState&) = delete;
+    ServerConnectionState& operator=(const ServerConnectionState&) = delete;
+
+    // Copy stats and peer address into the handle
+    void snapshot();
+};
+
+// Server engine implementation class (PIMPL)
+class QuicheServerEngineImpl {
+public:
+    QuicheServerEngineImpl(const std::string& host, const std::string& port, const ConfigMap& config);
+    ~QuicheServerEngineImpl();
+
+    // Disable copy
+    QuicheServerEngineImpl(const QuicheServerEngineImpl&) = delete;
+    QuicheServerEngineImpl& operator=(const QuicheServerEngineImpl&) = delete;
+
+    // Public API implementation
+    void setWrapper(QuicheServerEngine* w) { mWrapper = w; }
+    bool setEventCallback(ServerEventCallback callback, void* user_data);
+    bool start();
+    void shutdown(uint64_t app_error, const std::string& reason);
+    bool isRunning() const { return mIsRunning; }
+    size_t connectionCount() const { return mConnCount.load(); }
+    std::string getLastError() const { return mLastError; }
+
+    LoopThreadInfo getLoopThreadInfo() const {
+        std::lock_guard<std::mutex> lock(mLoopThreadInfoMutex);
+        return mLoopThreadInfo;
+    }
+
+    // Connection handle API (any thread; only the loop thread may use h->state)
+    ssize_t connWrite(ServerConnectionImpl* h, uint64_t stream_id,
+                      const uint8_t* data, size_t len, bool fin);
+    bool connSchedule(ServerConnectionImpl* h, uint64_t stream_id,
+                      uint32_t weight, uint64_t max_rate, uint64_t burst);
+    void connClose(ServerConnectionImpl* h, uint64_t app_error, const std::string& reason);
+
+private:
+    // Configuration
+    std::string mHost;
+    std::string mPort;
+    ConfigMap mConfig;
+    bool mRetryEnabled;
+    bool mMigrationEnabled;  // !DISABLE_ACTIVE_MIGRATION: issue spare CIDs
+    size_t mMaxConnections;  // MAX_CONNECTIONS (0 = no limit)
+
+    quiche_config* mQuicheCfg;
+
+    // Network
+    int mSock;
+    struct sockaddr_storage mLocalAddr;
+    socklen_t mLocalAddrLen;
+
+    // Event loop
+    struct ev_loop* mLoop;
+    ev_io mIoWatcher;
+    ev_async mAsyncWatcher;
+    LoopTimer mTimers;  // Timeouts of all connections, one ev_timer
+    std::thread mLoopThread;
+    bool mThreadStarted;
+    std::atomic<std::thread::id> mLoopThreadId;  // Set while mLoopThread runs the loop
+
+    // Command queue
+    CommandQueue mCmdQueue;
+
+    // Connection table (event loop thread only)
+    std::unordered_map<std::string, ServerConnectionState*> mConnsByCid;
+    std::map<uint64_t, ServerConnectionState*> mConnsByHandle;
+    std::vector<ServerConnectionState*> mDirtyConns;
+    uint64_t mNextHandleId;
+    std::atomic<size_t> mConnCount;
+
+    // Callbacks
+    ServerEventCallback mEventCallback;
+    void* mUserData;
+    QuicheServerEngine* mWrapper;
+
+    // State
+    bool mIsRunning;
+    std::string mLastError;
+
+    // Written by the loop thread once it started, read by any thread
+    mutable std::mutex mLoopThreadInfoMutex;
+    LoopThreadInfo mLoopThreadInfo;
+
+    // I/O buffers, carved from mIoArena by setupIoBuffers()
+    IoArena mIoArena;
+
+    // Outgoing packets of all connections, flushed with one sendmmsg per batch
+    uint8_t (*mSendBufs)[SEND_SLOT_SIZE];
+    size_t* mSendLens;
+    struct sockaddr_storage* mSendAddrs;
+    socklen_t* mSendAddrLens;
+    int mSendCount;
+
+#if defined(__linux__)
+    // Batch I/O buffers for Linux (using recvmmsg/sendmmsg)
+    uint8_t (*mRecvBufs)[MAX_RECV_BUF_SIZE];
+    struct mmsghdr* mSendMsgs;
+    struct mmsghdr* mRecvMsgs;
+    struct iovec* mSendIovs;
+    struct iovec* mRecvIovs;
+    struct sockaddr_storage* mRecvAddrs;
+#else
+    // Single packet receive buffer for macOS/iOS (using recvmsg)
+    uint8_t* mRecvBuf;
+#endif
+
+    // Helper methods
+    bool setupIoBuffers();
+    void initRecvBuffers();
+    bool setupSocket();
+    bool setupConfig();
+    void handlePacket(uint8_t* buf, size_t len, struct sockaddr_storage* peer, socklen_t peer_len);
+    ServerConnectionState* createConnection(const uint8_t* dcid, size_t dcid_len,
+                                           const uint8_t* odcid, size_t odcid_len,
+                                           struct sockaddr_storage* peer, socklen_t peer_len);
+    bool onLoopThread() const { return std::this_thread::get_id() == mLoopThreadId.load(); }
+    void markDirty(ServerConnectionState* c);
+    void processDirty();
+    void processDirtyOnce();
+    void flushConnection(ServerConnectionState* c);
+    void updateConnectionIds(ServerConnectionState* c);
+    void processPathEvents(ServerConnectionState* c);
+    void readStreams(ServerConnectionState* c);
+    void destroyConnection(ServerConnectionState* c, bool notify);
+    void detachHandle(ServerConnectionState* c);
+    void processCommands();
+
+    uint8_t* sendSlot() { return mSendBufs[mSendCount]; }
+    void commitSendSlot(size_t len, const struct sockaddr_storage* to, socklen_t to_len);
+    void flushSendBatch();
+
+    static void mintToken(const uint8_t* dcid, size_t dcid_len,
+                          const struct sockaddr_storage* addr, socklen_t addr_len,
+                          uint8_t* token, size_t* token_len);
+    static bool validateToken(const uint8_t* token, size_t token_len,
+                              const struct sockaddr_storage* addr, socklen_t addr_len,
+                              uint8_t* odcid, size_t* odcid_len);
+
+    void emitEvent(ServerConnectionState* c, EngineEvent event, const EventData& data);
+
+    // Static callbacks
+    static void eventLoopThread(QuicheServerEngineImpl* impl);
+    static void recvCallback(EV_P_ ev_io* w, int revents);
+    static void timerFired(TimerNode* node);
+    static void timerSweepDone(void* ctx);
+    static void asyncCallback(EV_P_ ev_async* w, int revents);
+
+    // Config helpers
+    uint64_t getConfigValue(ConfigKey key, uint64_t default_value) const {
+        auto it = mConfig.find(key);
+        if (it != mConfig.end() && it->second.type == ConfigValueType::UINT64) {
+            return it->second.uint_val;
+        }
+        return default_value;
+    }
+
+    bool getConfigValue(ConfigKey key, bool default_value) const {
+        auto it = mConfig.find(key);
+        if (it != mConfig.end() && it->second.type == ConfigValueType::BOOL) {
+            return it->second.bool_val;
+        }
+        return default_value;
+    }
+
+    std::string getConfigValue(ConfigKey key, const std::string& default_value) const {
+        auto it = mConfig.find(key);
+        if (it != mConfig.end() && it->second.type == ConfigValueType::STRING) {
+            return it->second.str_val;
+        }
+        return default_value;
+    }
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_SERVER_ENGINE_IMPL_H__
@@ -0,0 +1,212 @@
+// quiche_session_cache.cpp
+// TLS session ticket cache (in-memory with optional file persistence)
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+
+#include <quiche_session_cache.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace quiche {
+
+namespace {
+
+// File layout: magic, then repeated [u32 key_len][key][u32 blob_len][blob]
+const char SESSION_FILE_MAGIC[4] = {'Q', 'S', 'C', '1'};
+constexpr uint32_t MAX_SESSION_FIELD_LEN = 1 << 20;  // Sanity bound for corrupt files
+
+// Minimum spacing between two rewrites of the file; changes in between are
+// written by the next store()/remove() after the interval, flush() or the
+// destructor
+constexpr int SESSION_SAVE_INTERVAL_MS = 5000;
+
+bool readField(std::ifstream& in, std::string& out) {
+    uint32_t len = 0;
+    if (!in.read(reinterpret_cast<char*>(&len), sizeof(len))) {
+        return false;
+    }
+    if (len > MAX_SESSION_FIELD_LEN) {
+        return false;
+    }
+    out.resize(len);
+    if (len > 0 && !in.read(&out[0], len)) {
+        return false;
+    }
+    return true;
+}
+
+void appendField(std::string& out, const std::string& field) {
+    uint32_t len = static_cast<uint32_t>(field.size());
+    out.append(reinterpret_cast<const char*>(&len), sizeof(len));
+    out.append(field);
+}
+
+bool writeAll(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+// ============================================================================
+// MemorySessionCache Implementation
+// ============================================================================
+
+MemorySessionCache::MemorySessionCache(const std::string& file_path)
+    : mFilePath(file_path), mDirty(false)
+{
+    if (!mFilePath.empty()) {
+        loadFromFile();
+    }
+}
+
+MemorySessionCache::~MemorySessionCache() {
+    flush();
+}
+
+bool MemorySessionCache::load(const std::string& key, std::string& session) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mEntries.find(key);
+    if (it == mEntries.end()) {
+        return false;
+    }
+    session = it->second;
+    return true;
+}
+
+void MemorySessionCache::store(const std::string& key, const uint8_t* session, size_t len) {
+    if (!session || len == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::string& entry = mEntries[key];
+    if (entry.size() == len && memcmp(entry.data(), session, len) == 0) {
+        return;  // Unchanged - skip the file rewrite
+    }
+    entry.assign(reinterpret_cast<const char*>(session), len);
+    markDirty();
+}
+
+void MemorySessionCache::remove(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mEntries.erase(key) > 0) {
+        markDirty();
+    }
+}
+
+void MemorySessionCache::flush() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mDirty) {
+        saveToFile();
+    }
+}
+
+size_t MemorySessionCache::size() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEntries.size();
+}
+
+std::shared_ptr<MemorySessionCache> MemorySessionCache::shared(const std::string& file_path) {
+    static std::mutex registry_mutex;
+    static std::map<std::string, std::shared_ptr<MemorySessionCache>> registry;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    std::shared_ptr<MemorySessionCache>& cache = registry[file_path];
+    if (!cache) {
+        cache = std::make_shared<MemorySessionCache>(file_path);
+    }
+    return cache;
+}
+
+void MemorySessionCache::loadFromFile() {
+    std::ifstream in(mFilePath.c_str(), std::ios::binary);
+    if (!in) {
+        return;  // No file yet
+    }
+
+    char magic[sizeof(SESSION_FILE_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) ||
+        memcmp(magic, SESSION_FILE_MAGIC, sizeof(magic)) != 0) {
+        std::cerr << "[ENGINE] Ignoring invalid session cache file: " << mFilePath << std::endl;
+        return;
+    }
+
+    std::string key;
+    std::string blob;
+    while (readField(in, key) && readField(in, blob)) {
+        mEntries[key] = blob;
+    }
+}
+
+void MemorySessionCache::markDirty() {
+    if (mFilePath.empty()) {
+        return;
+    }
+
+    mDirty = true;
+    auto now = std::chrono::steady_clock::now();
+    if (mLastSave.time_since_epoch().count() == 0 ||
+        now - mLastSave >= std::chrono::milliseconds(SESSION_SAVE_INTERVAL_MS)) {
+        saveToFile();
+    }
+}
+
+void MemorySessionCache::saveToFile() {
+    if (mFilePath.empty()) {
+        return;
+    }
+
+    // Tickets are resumption secrets: serialize once, write to an owner-only
+    // temporary file and rename so readers never see a torn file
+    std::string data(SESSION_FILE_MAGIC, sizeof(SESSION_FILE_MAGIC));
+    for (const auto& pair : mEntries) {
+        appendField(data, pair.first);
+        appendField(data, pair.second);
+    }
+
+    mDirty = false;
+    mLastSave = std::chrono::steady_clock::now();
+
+    std::string tmp_path = mFilePath + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        std::cerr << "[ENGINE] Failed to write session cache file: " << tmp_path << std::endl;
+        return;
+    }
+
+    bool written = writeAll(fd, data.data(), data.size());
+    if (::close(fd) != 0) {
+        written = false;
+    }
+    if (!written) {
+        std::cerr << "[ENGINE] Failed to write session cache file: " << tmp_path << std::endl;
+        std::remove(tmp_path.c_str());
+        return;
+    }
+
+    if (std::rename(tmp_path.c_str(), mFilePath.c_str()) != 0) {
+        std::cerr << "[ENGINE] Failed to replace session cache file: " << mFilePath << std::endl;
+        std::remove(tmp_path.c_str());
+    }
+}
+
+} // namespace quiche
@@ -1,15 +1,25 @@
 #include "quiche_thread_utils.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
+#include <system_error>
 
 // Platform-specific includes
 #if defined(PLATFORM_WINDOWS)
     #include <windows.h>
     #include <processthreadsapi.h>
 #elif defined(PLATFORM_LINUX) || defined(PLATFORM_ANDROID) || defined(PLATFORM_MACOS) || defined(PLATFORM_IOS)
+    #include <climits>
     #include <pthread.h>
+    #include <sched.h>
+    #include <unistd.h>
     #if defined(PLATFORM_LINUX) || defined(PLATFORM_ANDROID)
         #include <sys/prctl.h>
+        #include <sys/resource.h>
+        #include <sys/syscall.h>
+        #include <unistd.h>
+        #include <cerrno>
     #endif
 #endif
 
@@ -84,5 +94,340 @@ bool setThreadName(std::thread& thread, const std::string& name) {
 #endif
 }
 
+// ============================================================================
+// Affinity and Scheduling
+// ============================================================================
+
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_ANDROID) || defined(PLATFORM_MACOS) || defined(PLATFORM_IOS)
+namespace {
+
+int toPosixPolicy(SchedPolicy policy) {
+    switch (policy) {
+        case SchedPolicy::FIFO:
+            return SCHED_FIFO;
+        case SchedPolicy::RR:
+            return SCHED_RR;
+        case SchedPolicy::OTHER:
+        default:
+            return SCHED_OTHER;
+    }
+}
+
+SchedPolicy fromPosixPolicy(int policy) {
+    if (policy == SCHED_FIFO) {
+        return SchedPolicy::FIFO;
+    }
+    if (policy == SCHED_RR) {
+        return SchedPolicy::RR;
+    }
+    return SchedPolicy::OTHER;
+}
+
+} // namespace
+#endif
+
+bool setCurrentThreadAffinity(const std::vector<int>& cpus) {
+    if (cpus.empty()) {
+        return false;
+    }
+
+#if defined(PLATFORM_WINDOWS)
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus) {
+        if (cpu < 0 || cpu >= static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+            return false;
+        }
+        mask |= static_cast<DWORD_PTR>(1) << cpu;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+
+#elif defined(PLATFORM_LINUX) || defined(PLATFORM_ANDROID)
+    // pid 0 = the calling thread
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < 0 || cpu >= CPU_SETSIZE) {
+            return false;
+        }
+        CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+
+#else
+    // macOS/iOS only take affinity tags as hints, which cannot pin a thread
+    (void)cpus;
+    return false;
+#endif
+}
+
+bool setSchedPolicy(SchedPolicy policy, int nice_value) {
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_ANDROID) || defined(PLATFORM_MACOS) || defined(PLATFORM_IOS)
+    int posix_policy = toPosixPolicy(policy);
+
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = policy == SchedPolicy::OTHER ? 0 : sched_get_priority_min(posix_policy);
+    if (pthread_setschedparam(pthread_self(), posix_policy, &param) != 0) {
+        return false;
+    }
+
+    if (policy != SchedPolicy::OTHER) {
+        return true;
+    }
+
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_ANDROID)
+    // Linux keeps nice per thread (the tid is a valid PRIO_PROCESS target)
+    pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    return setpriority(PRIO_PROCESS, tid, nice_value) == 0;
+#else
+    // Nice is per process here - only the default is accepted
+    return nice_value == 0;
+#endif
+
+#else
+    // Windows has priority classes, not POSIX policies
+    (void)policy;
+    (void)nice_value;
+    return false;
+#endif
+}
+
+bool setThreadPriority(int priority) {
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_ANDROID) || defined(PLATFORM_MACOS) || defined(PLATFORM_IOS)
+    int posix_policy;
+    struct sched_param param;
+    if (pthread_getschedparam(pthread_self(), &posix_policy, &param) != 0) {
+        return false;
+    }
+
+    if (priority < sched_get_priority_min(posix_policy) ||
+        priority > sched_get_priority_max(posix_policy)) {
+        return false;
+    }
+
+    param.sched_priority = priority;
+    return pthread_setschedparam(pthread_self(), posix_policy, &param) == 0;
+
+#else
+    (void)priority;
+    return false;
+#endif
+}
+
+bool setCurrentThreadTimerSlack(uint64_t slack_ns) {
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_ANDROID)
+    if (slack_ns == 0) {
+        return false;
+    }
+    return prctl(PR_SET_TIMERSLACK, static_cast<unsigned long>(slack_ns), 0, 0, 0) == 0;
+#else
+    (void)slack_ns;
+    return false;
+#endif
+}
+
+bool getCurrentThreadSchedInfo(ThreadSchedInfo& info) {
+    info = ThreadSchedInfo();
+
+#if defined(PLATFORM_WINDOWS)
+    // Windows cannot read a thread's affinity without changing it
+    return true;
+
+#elif defined(PLATFORM_LINUX) || defined(PLATFORM_ANDROID) || defined(PLATFORM_MACOS) || defined(PLATFORM_IOS)
+    int posix_policy;
+    struct sched_param param;
+    if (pthread_getschedparam(pthread_self(), &posix_policy, &param) != 0) {
+        return false;
+    }
+    info.policy = fromPosixPolicy(posix_policy);
+    info.priority = param.sched_priority;
+
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_ANDROID)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                info.cpus.push_back(cpu);
+            }
+        }
+    }
+
+    // getpriority() may legitimately return -1
+    pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    errno = 0;
+    int nice_value = getpriority(PRIO_PROCESS, tid);
+    if (errno == 0) {
+        info.nice_value = nice_value;
+    }
+
+    int slack = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+    if (slack > 0) {
+        info.timer_slack_ns = static_cast<uint64_t>(slack);
+    }
+#endif
+    return true;
+
+#else
+    return false;
+#endif
+}
+
+StackThread::StackThread()
+    : mFn(nullptr), mArg(nullptr), mStackSize(0), mStarted(false)
+{
+}
+
+StackThread::~StackThread() {
+}
+
+#if defined(PLATFORM_WINDOWS)
+bool StackThread::start(void (*fn)(void*), void* arg, size_t stack_size, std::string& error) {
+    (void)stack_size;  // std::thread takes the default
+    mFn = fn;
+    mArg = arg;
+    try {
+        mThread = std::thread(fn, arg);
+    } catch (const std::system_error& e) {
+        error = e.what();
+        return false;
+    }
+    mStarted = true;
+    return true;
+}
+
+void StackThread::join() {
+    if (mStarted) {
+        mThread.join();
+        mStarted = false;
+    }
+}
+#else
+void* StackThread::threadMain(void* self) {
+    StackThread* thread = static_cast<StackThread*>(self);
+    thread->mFn(thread->mArg);
+    return nullptr;
+}
+
+bool StackThread::start(void (*fn)(void*), void* arg, size_t stack_size, std::string& error) {
+    pthread_attr_t attr;
+    if (pthread_attr_init(&attr) != 0) {
+        error = "pthread_attr_init failed";
+        return false;
+    }
+
+    if (stack_size > 0) {
+        long page = sysconf(_SC_PAGESIZE);
+        size_t page_size = page > 0 ? static_cast<size_t>(page) : 4096;
+        if (stack_size < static_cast<size_t>(PTHREAD_STACK_MIN)) {
+            stack_size = PTHREAD_STACK_MIN;
+        }
+        stack_size = (stack_size + page_size - 1) / page_size * page_size;
+        int rc = pthread_attr_setstacksize(&attr, stack_size);
+        if (rc != 0) {
+            pthread_attr_destroy(&attr);
+            error = std::string("pthread_attr_setstacksize: ") + strerror(rc);
+            return false;
+        }
+    }
+    size_t actual = 0;
+    if (pthread_attr_getstacksize(&attr, &actual) == 0) {
+        mStackSize = actual;
+    }
+
+    mFn = fn;
+    mArg = arg;
+    int rc = pthread_create(&mThread, &attr, threadMain, this);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        error = std::string("pthread_create: ") + strerror(rc);
+        return false;
+    }
+    mStarted = true;
+    return true;
+}
+
+void StackThread::join() {
+    if (mStarted) {
+        pthread_join(mThread, nullptr);
+        mStarted = false;
+    }
+}
+#endif
+
+bool parseCpuList(const std::string& text, std::vector<int>& cpus) {
+    cpus.clear();
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        std::string item = text.substr(pos, end - pos);
+        pos = end + 1;
+
+        // "N" or "N-M"
+        char* rest;
+        long first = strtol(item.c_str(), &rest, 10);
+        long last = first;
+        if (rest == item.c_str()) {
+            return false;
+        }
+        if (*rest == '-') {
+            const char* from = rest + 1;
+            last = strtol(from, &rest, 10);
+            if (rest == from) {
+                return false;
+            }
+        }
+        if (*rest != '\0' || first < 0 || last < first || last > 4095) {
+            return false;
+        }
+
+        for (long cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return !cpus.empty();
+}
+
+std::string formatCpuList(const std::vector<int>& cpus) {
+    std::string out;
+    size_t i = 0;
+    while (i < cpus.size()) {
+        // Collapse consecutive CPUs into a range
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            j++;
+        }
+
+        if (!out.empty()) {
+            out += ",";
+        }
+        out += std::to_string(cpus[i]);
+        if (j > i) {
+            out += "-" + std::to_string(cpus[j]);
+        }
+        i = j + 1;
+    }
+    return out;
+}
+
+const char* schedPolicyName(SchedPolicy policy) {
+    switch (policy) {
+        case SchedPolicy::FIFO:
+            return "fifo";
+        case SchedPolicy::RR:
+            return "rr";
+        case SchedPolicy::OTHER:
+        default:
+            return "other";
+    }
+}
+
 } // namespace thread_utils
 } // namespace quiche
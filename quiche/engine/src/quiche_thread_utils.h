@@ -1,8 +1,10 @@
 #ifndef __THREAD_UTILS_H__
 #define __THREAD_UTILS_H__
 
+#include <cstdint>
 #include <string>
 #include <thread>
+#include <vector>
 
 // Platform detection
 #if defined(_WIN32) || defined(_WIN64)
@@ -20,6 +22,10 @@
     #define PLATFORM_LINUX
 #endif
 
+#if !defined(PLATFORM_WINDOWS)
+    #include <pthread.h>
+#endif
+
 namespace quiche {
 namespace thread_utils {
 
@@ -47,6 +53,137 @@ bool setCurrentThreadName(const std::string& name);
  */
 bool setThreadName(std::thread& thread, const std::string& name);
 
+// Scheduling policy of a thread (POSIX SCHED_OTHER / SCHED_FIFO / SCHED_RR)
+enum class SchedPolicy {
+    OTHER,  // Time-sharing (default), tuned with nice
+    FIFO,   // Real-time, runs until it blocks or yields
+    RR,     // Real-time, round-robin among equal priorities
+};
+
+// Scheduling settings of a thread as reported by the OS
+struct ThreadSchedInfo {
+    std::vector<int> cpus;   // CPUs the thread may run on (empty = unknown)
+    SchedPolicy policy;      // Policies outside the enum report OTHER
+    int priority;            // Real-time priority (0 for OTHER)
+    int nice_value;          // Nice value (0 when the platform has none per thread)
+    uint64_t timer_slack_ns; // Linux timer slack (0 = unknown)
+
+    ThreadSchedInfo() : policy(SchedPolicy::OTHER), priority(0), nice_value(0), timer_slack_ns(0) {}
+};
+
+/**
+ * Restrict the calling thread to the given CPUs
+ *
+ * Platform support:
+ * - Linux/Android: sched_setaffinity
+ * - Windows: SetThreadAffinityMask (CPUs 0-63)
+ * - macOS/iOS: not supported (no thread pinning API)
+ *
+ * @param cpus CPU indices (must not be empty)
+ * @return true on success, false on failure
+ */
+bool setCurrentThreadAffinity(const std::vector<int>& cpus);
+
+/**
+ * Switch the calling thread's scheduling policy
+ *
+ * FIFO/RR start at the policy's minimum priority (see setThreadPriority) and
+ * usually need CAP_SYS_NICE or an RLIMIT_RTPRIO allowance. For OTHER, nice_value
+ * is applied as well (Linux/Android only; other platforms accept 0 only, as
+ * nice is per process there). Not supported on Windows.
+ *
+ * @param policy Scheduling policy
+ * @param nice_value Nice value for OTHER (-20..19, lower runs first)
+ * @return true on success, false on failure
+ */
+bool setSchedPolicy(SchedPolicy policy, int nice_value = 0);
+
+/**
+ * Set the real-time priority of the calling thread under its current policy
+ *
+ * @param priority Priority within sched_get_priority_min/max of a FIFO/RR
+ *                 policy (Linux: 1-99); must be 0 for OTHER
+ * @return true on success, false on failure
+ */
+bool setThreadPriority(int priority);
+
+/**
+ * Let the kernel delay the calling thread's timer expiries by up to
+ * slack_ns, so they can be served together with other wakeups
+ *
+ * - Linux/Android: prctl(PR_SET_TIMERSLACK)
+ * - Other platforms: not supported (macOS/iOS coalesce timers on their own)
+ *
+ * @param slack_ns Slack in nanoseconds (must not be 0: that restores the default)
+ * @return true on success, false on failure
+ */
+bool setCurrentThreadTimerSlack(uint64_t slack_ns);
+
+/**
+ * Read back the calling thread's affinity, policy, priority, nice value
+ * and timer slack
+ *
+ * @param info Filled with what the platform reports
+ * @return true on success, false on failure
+ */
+bool getCurrentThreadSchedInfo(ThreadSchedInfo& info);
+
+/**
+ * Joinable thread with a chosen stack size (std::thread has no way to set it)
+ *
+ * Platform support:
+ * - POSIX: pthread_attr_setstacksize (rounded up to PTHREAD_STACK_MIN and
+ *   the page size)
+ * - Windows: std::thread, the stack size is ignored
+ *
+ * Like std::thread, a started thread must be joined before destruction.
+ */
+class StackThread {
+public:
+    StackThread();
+    ~StackThread();
+
+    // Disable copy
+    StackThread(const StackThread&) = delete;
+    StackThread& operator=(const StackThread&) = delete;
+
+    /**
+     * Run fn(arg) on a new thread
+     *
+     * @param stack_size Stack bytes (0 = platform default)
+     * @param error Reason on failure
+     * @return true on success, false on failure
+     */
+    bool start(void (*fn)(void*), void* arg, size_t stack_size, std::string& error);
+
+    bool joinable() const { return mStarted; }
+    void join();
+
+    // Stack the thread was created with (0 if unknown)
+    size_t stackSize() const { return mStackSize; }
+
+private:
+#if defined(PLATFORM_WINDOWS)
+    std::thread mThread;
+#else
+    static void* threadMain(void* self);
+    pthread_t mThread;
+#endif
+    void (*mFn)(void*);
+    void* mArg;
+    size_t mStackSize;
+    bool mStarted;
+};
+
+// Parse a CPU list such as "2" or "0-3,6" (false on syntax error)
+bool parseCpuList(const std::string& text, std::vector<int>& cpus);
+
+// Format CPUs as a compact list ("0-3,6")
+std::string formatCpuList(const std::vector<int>& cpus);
+
+// "other", "fifo" or "rr"
+const char* schedPolicyName(SchedPolicy policy);
+
 } // namespace thread_utils
 } // namespace quiche
 
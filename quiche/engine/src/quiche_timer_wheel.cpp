@@ -0,0 +1,305 @@
+// quiche_timer_wheel.cpp
+// Hierarchical timer wheel shared by the connections of one event loop
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+
+#include "quiche_timer_wheel.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace quiche {
+
+uint64_t monotonicNowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+namespace {
+
+// Largest tick the wheel can hold (LEVELS * SLOT_BITS bits)
+constexpr uint64_t MAX_TICK = (1ULL << (TimerWheel::LEVELS * TimerWheel::SLOT_BITS)) - 1;
+
+inline unsigned highestBit(uint64_t v) {
+    return 63 - static_cast<unsigned>(__builtin_clzll(v));
+}
+
+inline unsigned lowestBit(uint64_t v) {
+    return static_cast<unsigned>(__builtin_ctzll(v));
+}
+
+} // namespace
+
+// ============================================================================
+// TimerWheel Implementation
+// ============================================================================
+
+TimerWheel::TimerWheel(uint64_t now_ns, unsigned tick_shift)
+    : mTickShift(tick_shift), mCurrentTick(0), mCount(0)
+{
+    // Every nanosecond deadline must fit in the wheel's tick range
+    if (mTickShift < 64 - LEVELS * SLOT_BITS) {
+        mTickShift = 64 - LEVELS * SLOT_BITS;
+    }
+    mCurrentTick = tickOf(now_ns);
+
+    memset(mSlots, 0, sizeof(mSlots));
+    memset(mOccupied, 0, sizeof(mOccupied));
+}
+
+void TimerWheel::schedule(TimerNode* node, uint64_t deadline_ns) {
+    // Round up so a timer never fires before its deadline
+    uint64_t mask = (1ULL << mTickShift) - 1;
+    uint64_t tick = deadline_ns > UINT64_MAX - mask ? MAX_TICK : tickOf(deadline_ns + mask);
+    if (tick < mCurrentTick) {
+        tick = mCurrentTick;
+    }
+    if (tick > MAX_TICK) {
+        tick = MAX_TICK;
+    }
+
+    node->deadline_ns = deadline_ns;
+    if (node->mArmed) {
+        if (node->mTick == tick) {
+            return;  // Same tick: nothing moves
+        }
+        unlink(node);
+    }
+
+    node->mTick = tick;
+    link(node);
+}
+
+void TimerWheel::cancel(TimerNode* node) {
+    if (node->mArmed) {
+        unlink(node);
+    }
+}
+
+void TimerWheel::link(TimerNode* node) {
+    // The level is the highest 6-bit digit in which the tick differs from now:
+    // the slot then turns (and cascades) before the tick is reached
+    uint64_t diff = node->mTick ^ mCurrentTick;
+    unsigned level = diff ? highestBit(diff) / SLOT_BITS : 0;
+    unsigned slot = static_cast<unsigned>(node->mTick >> (level * SLOT_BITS)) & (SLOTS - 1);
+
+    TimerNode*& head = mSlots[level][slot];
+    node->mLevel = static_cast<uint8_t>(level);
+    node->mSlot = static_cast<uint8_t>(slot);
+    node->mPrev = nullptr;
+    node->mNext = head;
+    if (head) {
+        head->mPrev = node;
+    }
+    head = node;
+
+    mOccupied[level] |= 1ULL << slot;
+    node->mArmed = true;
+    mCount++;
+}
+
+void TimerWheel::unlink(TimerNode* node) {
+    if (node->mPrev) {
+        node->mPrev->mNext = node->mNext;
+    } else {
+        mSlots[node->mLevel][node->mSlot] = node->mNext;
+        if (!node->mNext) {
+            mOccupied[node->mLevel] &= ~(1ULL << node->mSlot);
+        }
+    }
+    if (node->mNext) {
+        node->mNext->mPrev = node->mPrev;
+    }
+
+    node->mPrev = nullptr;
+    node->mNext = nullptr;
+    node->mArmed = false;
+    mCount--;
+}
+
+void TimerWheel::cascade(unsigned level, unsigned slot) {
+    TimerNode* node = mSlots[level][slot];
+    mSlots[level][slot] = nullptr;
+    mOccupied[level] &= ~(1ULL << slot);
+
+    while (node) {
+        TimerNode* next = node->mNext;
+        node->mArmed = false;
+        mCount--;
+        link(node);  // Lands on a lower level now that the wheel has turned
+        node = next;
+    }
+}
+
+uint64_t TimerWheel::nextEventTick() const {
+    // Timers of level n all lie in the current level n+1 slot, so the first
+    // level with an occupied slot ahead of the current position holds the
+    // next event (an expiry on level 0, a cascade above)
+    for (unsigned level = 0; level < LEVELS; level++) {
+        unsigned shift = level * SLOT_BITS;
+        unsigned index = static_cast<unsigned>(mCurrentTick >> shift) & (SLOTS - 1);
+        uint64_t ahead = mOccupied[level] & (~0ULL << index);
+        if (ahead) {
+            uint64_t base = (mCurrentTick >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+            uint64_t tick = base + (static_cast<uint64_t>(lowestBit(ahead)) << shift);
+            return tick > mCurrentTick ? tick : mCurrentTick;
+        }
+    }
+    return NO_DEADLINE;
+}
+
+uint64_t TimerWheel::nextDeadline() const {
+    uint64_t tick = nextEventTick();
+    return tick == NO_DEADLINE ? NO_DEADLINE : tick << mTickShift;
+}
+
+size_t TimerWheel::advance(uint64_t now_ns, std::vector<TimerNode*>& expired) {
+    uint64_t target = tickOf(now_ns);
+    size_t fired = 0;
+
+    // Jump from event to event instead of walking every tick
+    while (mCount > 0) {
+        uint64_t tick = nextEventTick();
+        if (tick > target) {
+            break;
+        }
+        mCurrentTick = tick;
+
+        // Bring down the slots that start at this tick, highest level first
+        for (unsigned level = LEVELS - 1; level > 0; level--) {
+            unsigned shift = level * SLOT_BITS;
+            if ((tick & ((1ULL << shift) - 1)) == 0) {
+                unsigned slot = static_cast<unsigned>(tick >> shift) & (SLOTS - 1);
+                if (mOccupied[level] & (1ULL << slot)) {
+                    cascade(level, slot);
+                }
+            }
+        }
+
+        unsigned slot = static_cast<unsigned>(tick) & (SLOTS - 1);
+        TimerNode* node = mSlots[0][slot];
+        mSlots[0][slot] = nullptr;
+        mOccupied[0] &= ~(1ULL << slot);
+        while (node) {
+            TimerNode* next = node->mNext;
+            node->mPrev = nullptr;
+            node->mNext = nullptr;
+            node->mArmed = false;
+            mCount--;
+            expired.push_back(node);
+            fired++;
+            node = next;
+        }
+    }
+
+    if (target > mCurrentTick) {
+        mCurrentTick = target;
+    }
+    return fired;
+}
+
+// ============================================================================
+// LoopTimer Implementation
+// ============================================================================
+
+LoopTimer::LoopTimer()
+    : mLoop(nullptr), mArmedNs(TimerWheel::NO_DEADLINE), mWheel(monotonicNowNs()),
+      mHook(nullptr), mHookCtx(nullptr), mInSweep(false)
+{
+    memset(&mWatcher, 0, sizeof(mWatcher));
+}
+
+LoopTimer::~LoopTimer() {
+    // The loop may already be gone; owners detach() while it is alive
+}
+
+void LoopTimer::attach(struct ev_loop* loop, SweepHook hook, void* ctx) {
+    mLoop = loop;
+    mHook = hook;
+    mHookCtx = ctx;
+
+    ev_init(&mWatcher, timerCallback);
+    mWatcher.data = this;
+}
+
+void LoopTimer::detach() {
+    if (mLoop) {
+        ev_timer_stop(mLoop, &mWatcher);
+    }
+    mArmedNs = TimerWheel::NO_DEADLINE;
+}
+
+void LoopTimer::schedule(TimerNode* node, uint64_t deadline_ns) {
+    mWheel.schedule(node, deadline_ns);
+
+    // Later deadlines are picked up when the current one fires
+    if (!mInSweep && deadline_ns < mArmedNs) {
+        rearm(monotonicNowNs());
+    }
+}
+
+void LoopTimer::cancel(TimerNode* node) {
+    mWheel.cancel(node);
+
+    if (mInSweep) {
+        // Expired but not fired yet: the owner may be going away
+        for (TimerNode*& pending : mExpired) {
+            if (pending == node) {
+                pending = nullptr;
+            }
+        }
+    } else if (mWheel.empty() && mArmedNs != TimerWheel::NO_DEADLINE) {
+        ev_timer_stop(mLoop, &mWatcher);
+        mArmedNs = TimerWheel::NO_DEADLINE;
+    }
+    // Otherwise an early wakeup just finds nothing to fire
+}
+
+void LoopTimer::rearm(uint64_t now_ns) {
+    uint64_t next = mWheel.nextDeadline();
+    if (next == mArmedNs || !mLoop) {
+        return;
+    }
+
+    ev_timer_stop(mLoop, &mWatcher);
+    mArmedNs = next;
+    if (next == TimerWheel::NO_DEADLINE) {
+        return;
+    }
+
+    double delay = next > now_ns ? (double)(next - now_ns) / 1000000000.0 : 0.0;
+    ev_timer_set(&mWatcher, delay, 0.0);
+    ev_timer_start(mLoop, &mWatcher);
+}
+
+void LoopTimer::timerCallback(EV_P_ ev_timer* w, int revents) {
+    (void)EV_A;
+    (void)revents;
+
+    LoopTimer* self = static_cast<LoopTimer*>(w->data);
+    self->mArmedNs = TimerWheel::NO_DEADLINE;
+
+    // One sweep for everything that expired
+    self->mExpired.clear();
+    self->mWheel.advance(monotonicNowNs(), self->mExpired);
+
+    self->mInSweep = true;
+    for (size_t i = 0; i < self->mExpired.size(); i++) {
+        TimerNode* node = self->mExpired[i];
+        if (node && node->fire) {
+            node->fire(node);
+        }
+    }
+    self->mExpired.clear();
+
+    // Timers re-armed by the hook are covered by the rearm below
+    if (self->mHook) {
+        self->mHook(self->mHookCtx);
+    }
+    self->mInSweep = false;
+
+    self->rearm(monotonicNowNs());
+}
+
+} // namespace quiche
@@ -0,0 +1,142 @@
+#ifndef __QUICHE_TIMER_WHEEL_H__
+#define __QUICHE_TIMER_WHEEL_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+extern "C" {
+#include <ev.h>
+}
+
+namespace quiche {
+
+// Monotonic clock in nanoseconds (all deadlines below use it)
+uint64_t monotonicNowNs();
+
+// Deadline moved up to the next multiple of slack_ns (0 = unchanged), so
+// lax timers of all engines on a loop fall due in the same wakeup
+inline uint64_t roundDeadlineNs(uint64_t deadline_ns, uint64_t slack_ns) {
+    if (slack_ns == 0 || deadline_ns > UINT64_MAX - slack_ns) {
+        return deadline_ns;
+    }
+    return (deadline_ns + slack_ns - 1) / slack_ns * slack_ns;
+}
+
+class TimerWheel;
+
+// Intrusive timer, embedded in the object it belongs to
+struct TimerNode {
+    uint64_t deadline_ns;          // Absolute, monotonicNowNs() clock
+    void (*fire)(TimerNode* node); // Called by LoopTimer when the deadline passed
+    void* data;
+
+    TimerNode() : deadline_ns(0), fire(nullptr), data(nullptr),
+                  mTick(0), mLevel(0), mSlot(0), mPrev(nullptr), mNext(nullptr), mArmed(false) {}
+
+    bool armed() const { return mArmed; }
+
+private:
+    friend class TimerWheel;
+
+    uint64_t mTick;
+    uint8_t mLevel;
+    uint8_t mSlot;
+    TimerNode* mPrev;
+    TimerNode* mNext;
+    bool mArmed;
+};
+
+// Hierarchical timer wheel (single thread)
+//
+// Deadlines are kept in nanoseconds and bucketed in ticks of 2^tick_shift ns:
+// LEVELS levels of 64 slots, level n covering 64^n ticks per slot. Timers
+// never fire before their deadline, at most one tick late. schedule(),
+// cancel() and re-arming to the same tick are O(1); timers move down one
+// level at a time as the wheel turns.
+class TimerWheel {
+public:
+    static constexpr unsigned SLOT_BITS = 6;
+    static constexpr unsigned SLOTS = 1u << SLOT_BITS;
+    static constexpr unsigned LEVELS = 8;
+    static constexpr unsigned DEFAULT_TICK_SHIFT = 16;  // ~65us ticks
+    static constexpr uint64_t NO_DEADLINE = UINT64_MAX;
+
+    explicit TimerWheel(uint64_t now_ns, unsigned tick_shift = DEFAULT_TICK_SHIFT);
+
+    // Disable copy
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // Arm or re-arm a timer. Cheap when the deadline stays within the same tick.
+    void schedule(TimerNode* node, uint64_t deadline_ns);
+    void cancel(TimerNode* node);
+
+    // Move time forward to now_ns, appending every expired timer to expired
+    // (they are disarmed). Returns the number of timers appended.
+    size_t advance(uint64_t now_ns, std::vector<TimerNode*>& expired);
+
+    // Earliest time at which advance() has work to do (NO_DEADLINE if empty).
+    // May be earlier than the next deadline when a slot has to cascade.
+    uint64_t nextDeadline() const;
+
+    size_t size() const { return mCount; }
+    bool empty() const { return mCount == 0; }
+
+private:
+    unsigned mTickShift;
+    uint64_t mCurrentTick;  // All timers at ticks < mCurrentTick have fired
+    size_t mCount;
+
+    TimerNode* mSlots[LEVELS][SLOTS];
+    uint64_t mOccupied[LEVELS];  // Bit per non-empty slot
+
+    uint64_t tickOf(uint64_t ns) const { return ns >> mTickShift; }
+    uint64_t nextEventTick() const;
+    void link(TimerNode* node);
+    void unlink(TimerNode* node);
+    void cascade(unsigned level, unsigned slot);
+};
+
+// TimerWheel driven by one ev_timer on a libev loop (loop thread only).
+// Expired timers are fired in one sweep, then the optional sweep hook runs
+// so owners can batch the follow-up work (e.g. one egress flush).
+class LoopTimer {
+public:
+    typedef void (*SweepHook)(void* ctx);
+
+    LoopTimer();
+    ~LoopTimer();
+
+    // Disable copy
+    LoopTimer(const LoopTimer&) = delete;
+    LoopTimer& operator=(const LoopTimer&) = delete;
+
+    void attach(struct ev_loop* loop, SweepHook hook = nullptr, void* ctx = nullptr);
+    void detach();
+
+    // Arm/re-arm/cancel; the ev_timer is only touched when the earliest
+    // deadline of the wheel moves earlier
+    void schedule(TimerNode* node, uint64_t deadline_ns);
+    void cancel(TimerNode* node);
+
+    size_t size() const { return mWheel.size(); }
+
+private:
+    struct ev_loop* mLoop;
+    ev_timer mWatcher;
+    uint64_t mArmedNs;  // Deadline the ev_timer is set for (NO_DEADLINE = stopped)
+    TimerWheel mWheel;
+    std::vector<TimerNode*> mExpired;
+    SweepHook mHook;
+    void* mHookCtx;
+    bool mInSweep;  // Firing expired timers; rearm once at the end
+
+    void rearm(uint64_t now_ns);
+
+    static void timerCallback(EV_P_ ev_timer* w, int revents);
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_TIMER_WHEEL_H__
@@ -0,0 +1,357 @@
+// quiche_udp_endpoint.cpp
+// Shared client UDP socket with connection ID demultiplexing
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+
+#include "quiche_udp_endpoint.h"
+
+#include <cerrno>
+#include <cstring>
+
+extern "C" {
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <quiche.h>
+}
+
+namespace quiche {
+
+namespace {
+
+// quiche_header_info() fails if the token does not fit; a token cannot be
+// larger than the datagram carrying it (MAX_RECV_BUF_SIZE)
+constexpr size_t MAX_DATAGRAM_TOKEN_LEN = 2048;
+
+} // namespace
+
+UdpEndpoint::UdpEndpoint()
+    : mLoop(nullptr), mFd(-1), mLocalAddrLen(0), mCidLen(0),
+      mSendStride(0), mRecvStride(0), mSendBase(nullptr), mRecvBase(nullptr),
+      mSendLens(nullptr), mSendAddrs(nullptr), mSendAddrLens(nullptr), mRecvAddrs(nullptr),
+#if defined(__linux__)
+      mSendMsgs(nullptr), mRecvMsgs(nullptr), mSendIovs(nullptr), mRecvIovs(nullptr),
+#endif
+      mSendCount(0)
+{
+    memset(&mLocalAddr, 0, sizeof(mLocalAddr));
+}
+
+UdpEndpoint::~UdpEndpoint() {
+    close();
+}
+
+bool UdpEndpoint::open(struct ev_loop* loop, int family, size_t cid_len, size_t max_send_size,
+                       size_t max_recv_size, const IoArenaOptions& arena_options,
+                       std::string& error) {
+    if (mFd >= 0) {
+        error = "UDP endpoint already open";
+        return false;
+    }
+
+    if (!mArena.allocated() && !setupBuffers(max_send_size, max_recv_size, arena_options, error)) {
+        return false;
+    }
+
+    int fd = socket(family, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        error = std::string("Failed to create shared socket: ") + strerror(errno);
+        return false;
+    }
+
+#ifdef SO_NOSIGPIPE
+    int set = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &set, sizeof(set));
+#endif
+
+    // Wildcard bind: every connection sees the same local address
+    struct sockaddr_storage any;
+    memset(&any, 0, sizeof(any));
+    any.ss_family = family;
+    socklen_t any_len = family == AF_INET6 ? sizeof(struct sockaddr_in6)
+                                           : sizeof(struct sockaddr_in);
+
+    mLocalAddrLen = sizeof(mLocalAddr);
+    if (fcntl(fd, F_SETFL, O_NONBLOCK) != 0 ||
+        bind(fd, (const struct sockaddr*)&any, any_len) < 0 ||
+        getsockname(fd, (struct sockaddr*)&mLocalAddr, &mLocalAddrLen) != 0) {
+        error = std::string("Failed to bind shared socket: ") + strerror(errno);
+        ::close(fd);
+        return false;
+    }
+
+    mLoop = loop;
+    mFd = fd;
+    mCidLen = cid_len;
+
+    ev_io_init(&mIoWatcher, recvCallback, mFd, EV_READ);
+    mIoWatcher.data = this;
+    ev_io_start(mLoop, &mIoWatcher);
+
+    ev_prepare_init(&mFlushWatcher, prepareCallback);
+    mFlushWatcher.data = this;
+    ev_prepare_start(mLoop, &mFlushWatcher);
+    return true;
+}
+
+void UdpEndpoint::close() {
+    if (mFd < 0) {
+        return;
+    }
+
+    flush();
+    ev_io_stop(mLoop, &mIoWatcher);
+    ev_prepare_stop(mLoop, &mFlushWatcher);
+    ::close(mFd);
+    mFd = -1;
+
+    for (auto& pair : mRoutes) {
+        pair.second->cids.clear();
+        pair.second->pending = false;
+    }
+    mRoutes.clear();
+    mPending.clear();
+}
+
+bool UdpEndpoint::setupBuffers(size_t max_send_size, size_t max_recv_size,
+                               const IoArenaOptions& arena_options, std::string& error) {
+    mSendStride = alignToCacheLine(max_send_size);
+    mRecvStride = alignToCacheLine(max_recv_size);
+
+    size_t send_bufs = mArena.reserve<uint8_t>(mSendStride * ENDPOINT_BATCH_SIZE);
+    size_t recv_bufs = mArena.reserve<uint8_t>(mRecvStride * ENDPOINT_BATCH_SIZE);
+    size_t send_lens = mArena.reserve<size_t>(ENDPOINT_BATCH_SIZE);
+    size_t send_addrs = mArena.reserve<struct sockaddr_storage>(ENDPOINT_BATCH_SIZE);
+    size_t send_addr_lens = mArena.reserve<socklen_t>(ENDPOINT_BATCH_SIZE);
+    size_t recv_addrs = mArena.reserve<struct sockaddr_storage>(ENDPOINT_BATCH_SIZE);
+#if defined(__linux__)
+    size_t send_msgs = mArena.reserve<struct mmsghdr>(ENDPOINT_BATCH_SIZE);
+    size_t recv_msgs = mArena.reserve<struct mmsghdr>(ENDPOINT_BATCH_SIZE);
+    size_t send_iovs = mArena.reserve<struct iovec>(ENDPOINT_BATCH_SIZE);
+    size_t recv_iovs = mArena.reserve<struct iovec>(ENDPOINT_BATCH_SIZE);
+#endif
+    if (!mArena.allocate(arena_options, error)) {
+        return false;
+    }
+
+    mSendBase = mArena.get<uint8_t>(send_bufs);
+    mRecvBase = mArena.get<uint8_t>(recv_bufs);
+    mSendLens = mArena.get<size_t>(send_lens);
+    mSendAddrs = mArena.get<struct sockaddr_storage>(send_addrs);
+    mSendAddrLens = mArena.get<socklen_t>(send_addr_lens);
+    mRecvAddrs = mArena.get<struct sockaddr_storage>(recv_addrs);
+#if defined(__linux__)
+    mSendMsgs = mArena.get<struct mmsghdr>(send_msgs);
+    mRecvMsgs = mArena.get<struct mmsghdr>(recv_msgs);
+    mSendIovs = mArena.get<struct iovec>(send_iovs);
+    mRecvIovs = mArena.get<struct iovec>(recv_iovs);
+
+    // Recv structures are reused for every batch (the arena is zeroed)
+    for (int i = 0; i < ENDPOINT_BATCH_SIZE; i++) {
+        mRecvIovs[i].iov_base = mRecvBase + i * mRecvStride;
+        mRecvIovs[i].iov_len = max_recv_size;
+        mRecvMsgs[i].msg_hdr.msg_name = &mRecvAddrs[i];
+        mRecvMsgs[i].msg_hdr.msg_namelen = sizeof(mRecvAddrs[i]);
+        mRecvMsgs[i].msg_hdr.msg_iov = &mRecvIovs[i];
+        mRecvMsgs[i].msg_hdr.msg_iovlen = 1;
+    }
+#endif
+    return true;
+}
+
+// ============================================================================
+// Routing
+// ============================================================================
+
+void UdpEndpoint::addConnection(const quiche_conn* conn, EndpointRoute* route) {
+    const uint8_t* id;
+    size_t id_len;
+    quiche_conn_source_id(conn, &id, &id_len);
+    addRoute(id, id_len, route);
+}
+
+void UdpEndpoint::addRoute(const uint8_t* cid, size_t cid_len, EndpointRoute* route) {
+    std::string key(reinterpret_cast<const char*>(cid), cid_len);
+    mRoutes[key] = route;
+    route->cids.push_back(key);
+}
+
+void UdpEndpoint::removeRoutes(EndpointRoute* route) {
+    for (const std::string& cid : route->cids) {
+        auto it = mRoutes.find(cid);
+        if (it != mRoutes.end() && it->second == route) {
+            mRoutes.erase(it);
+        }
+    }
+    route->cids.clear();
+
+    if (route->pending) {
+        for (EndpointRoute*& p : mPending) {
+            if (p == route) {
+                p = nullptr;
+            }
+        }
+        route->pending = false;
+    }
+}
+
+void UdpEndpoint::dispatch(uint8_t* buf, size_t len, const struct sockaddr_storage* from,
+                           socklen_t from_len) {
+    uint32_t version;
+    uint8_t type;
+    uint8_t scid[QUICHE_MAX_CONN_ID_LEN];
+    size_t scid_len = sizeof(scid);
+    uint8_t dcid[QUICHE_MAX_CONN_ID_LEN];
+    size_t dcid_len = sizeof(dcid);
+    uint8_t token[MAX_DATAGRAM_TOKEN_LEN];  // Retry/NEW_TOKEN tokens from any server
+    size_t token_len = sizeof(token);
+
+    if (quiche_header_info(buf, len, mCidLen, &version, &type, scid, &scid_len,
+                           dcid, &dcid_len, token, &token_len) < 0) {
+        return;  // Not QUIC
+    }
+
+    auto it = mRoutes.find(std::string(reinterpret_cast<const char*>(dcid), dcid_len));
+    if (it == mRoutes.end()) {
+        return;  // Connection already gone (or a stray datagram)
+    }
+
+    EndpointRoute* route = it->second;
+    route->deliver(route, buf, len, from, from_len);
+    if (!route->pending) {
+        route->pending = true;
+        mPending.push_back(route);
+    }
+}
+
+void UdpEndpoint::drainPending() {
+    // Index loop: drained() may remove routes (entries become nullptr)
+    for (size_t i = 0; i < mPending.size(); i++) {
+        EndpointRoute* route = mPending[i];
+        if (!route) {
+            continue;
+        }
+        route->pending = false;
+        mPending[i] = nullptr;
+        route->drained(route);
+    }
+    mPending.clear();
+}
+
+// ============================================================================
+// Packet I/O (loop thread)
+// ============================================================================
+
+void UdpEndpoint::receive() {
+#if defined(__linux__)
+    while (mFd >= 0) {
+        for (int i = 0; i < ENDPOINT_BATCH_SIZE; i++) {
+            mRecvMsgs[i].msg_hdr.msg_namelen = sizeof(mRecvAddrs[i]);
+        }
+
+        int num_msgs = recvmmsg(mFd, mRecvMsgs, ENDPOINT_BATCH_SIZE, 0, nullptr);
+        if (num_msgs <= 0) {
+            break;  // EAGAIN, or an error the next readiness will report again
+        }
+
+        for (int i = 0; i < num_msgs; i++) {
+            dispatch(mRecvBase + i * mRecvStride, mRecvMsgs[i].msg_len,
+                     &mRecvAddrs[i], mRecvMsgs[i].msg_hdr.msg_namelen);
+        }
+
+        // Connections react (and queue replies) once per batch, not per packet
+        drainPending();
+
+        if (num_msgs < ENDPOINT_BATCH_SIZE) {
+            break;
+        }
+    }
+#else
+    while (mFd >= 0) {
+        struct iovec iov;
+        iov.iov_base = mRecvBase;
+        iov.iov_len = mRecvStride;
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &mRecvAddrs[0];
+        msg.msg_namelen = sizeof(mRecvAddrs[0]);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+
+        ssize_t len = recvmsg(mFd, &msg, 0);
+        if (len < 0) {
+            break;
+        }
+        dispatch(mRecvBase, len, &mRecvAddrs[0], msg.msg_namelen);
+    }
+    drainPending();
+#endif
+}
+
+void UdpEndpoint::commitSendSlot(size_t len, const struct sockaddr_storage* to, socklen_t to_len) {
+    mSendLens[mSendCount] = len;
+    memcpy(&mSendAddrs[mSendCount], to, to_len);
+    mSendAddrLens[mSendCount] = to_len;
+    mSendCount++;
+
+    if (mSendCount == ENDPOINT_BATCH_SIZE) {
+        flush();
+    }
+}
+
+void UdpEndpoint::flush() {
+    if (mSendCount == 0) {
+        return;
+    }
+
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags |= MSG_NOSIGNAL;
+#endif
+
+#if defined(__linux__)
+    for (int i = 0; i < mSendCount; i++) {
+        mSendIovs[i].iov_base = mSendBase + i * mSendStride;
+        mSendIovs[i].iov_len = mSendLens[i];
+
+        memset(&mSendMsgs[i], 0, sizeof(mSendMsgs[i]));
+        mSendMsgs[i].msg_hdr.msg_name = &mSendAddrs[i];
+        mSendMsgs[i].msg_hdr.msg_namelen = mSendAddrLens[i];
+        mSendMsgs[i].msg_hdr.msg_iov = &mSendIovs[i];
+        mSendMsgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    if (sendmmsg(mFd, mSendMsgs, mSendCount, flags) < 0) {
+        // Ignore send errors, loss recovery retransmits
+    }
+#else
+    for (int i = 0; i < mSendCount; i++) {
+        if (sendto(mFd, mSendBase + i * mSendStride, mSendLens[i], flags,
+                   (const struct sockaddr*)&mSendAddrs[i], mSendAddrLens[i]) < 0) {
+            // Ignore send errors, loss recovery retransmits
+        }
+    }
+#endif
+    mSendCount = 0;
+}
+
+void UdpEndpoint::recvCallback(EV_P_ ev_io* w, int revents) {
+    (void)EV_A;
+    (void)revents;
+
+    // Replies leave from prepareCallback(), batched with other sources
+    static_cast<UdpEndpoint*>(w->data)->receive();
+}
+
+void UdpEndpoint::prepareCallback(EV_P_ ev_prepare* w, int revents) {
+    (void)EV_A;
+    (void)revents;
+
+    // Timers and commands of all connections queued packets this iteration
+    static_cast<UdpEndpoint*>(w->data)->flush();
+}
+
+} // namespace quiche
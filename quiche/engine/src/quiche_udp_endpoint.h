@@ -0,0 +1,125 @@
+#ifndef __QUICHE_UDP_ENDPOINT_H__
+#define __QUICHE_UDP_ENDPOINT_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <ev.h>
+}
+
+#include "quiche_io_arena.h"
+
+struct quiche_conn;
+
+namespace quiche {
+
+constexpr int ENDPOINT_BATCH_SIZE = 64;  // recvmmsg/sendmmsg batch shared by all routes
+
+// Receiver of the packets addressed to one or more connection IDs
+//
+// deliver() runs per datagram; drained() runs once per receive burst for
+// every route that got at least one datagram (ingress is done: flush,
+// check for close). drained() may remove any route, including its own.
+struct EndpointRoute {
+    void (*deliver)(EndpointRoute* route, uint8_t* buf, size_t len,
+                    const struct sockaddr_storage* from, socklen_t from_len);
+    void (*drained)(EndpointRoute* route);
+    void* data;
+
+    // Endpoint state
+    std::vector<std::string> cids;
+    bool pending;
+
+    EndpointRoute() : deliver(nullptr), drained(nullptr), data(nullptr), pending(false) {}
+};
+
+// One unconnected UDP socket shared by many client connections on a loop
+//
+// Incoming datagrams are routed by destination connection ID (all local
+// IDs are fixed length, so short headers parse too). Outgoing datagrams of
+// all connections are queued and leave in one sendmmsg() per batch, at the
+// latest before the loop blocks again. Loop thread only.
+class UdpEndpoint {
+public:
+    UdpEndpoint();
+    ~UdpEndpoint();
+
+    // Disable copy
+    UdpEndpoint(const UdpEndpoint&) = delete;
+    UdpEndpoint& operator=(const UdpEndpoint&) = delete;
+
+    // Bind an ephemeral port of the given family and start receiving
+    bool open(struct ev_loop* loop, int family, size_t cid_len, size_t max_send_size,
+              size_t max_recv_size, const IoArenaOptions& arena_options, std::string& error);
+    void close();
+
+    bool isOpen() const { return mFd >= 0; }
+    int family() const { return mLocalAddr.ss_family; }
+    const struct sockaddr_storage& localAddr() const { return mLocalAddr; }
+    socklen_t localAddrLen() const { return mLocalAddrLen; }
+
+    // Route packets for the connection's current source ID / another ID
+    void addConnection(const quiche_conn* conn, EndpointRoute* route);
+    void addRoute(const uint8_t* cid, size_t cid_len, EndpointRoute* route);
+
+    // Forget every ID of route (safe from within drained())
+    void removeRoutes(EndpointRoute* route);
+
+    // Build a datagram in place: write at most max_send_size bytes to
+    // sendSlot(), then commit it. A full batch is sent right away.
+    uint8_t* sendSlot() { return mSendBase + mSendCount * mSendStride; }
+    void commitSendSlot(size_t len, const struct sockaddr_storage* to, socklen_t to_len);
+    void flush();
+
+    size_t routeCount() const { return mRoutes.size(); }
+
+private:
+    struct ev_loop* mLoop;
+    int mFd;
+    struct sockaddr_storage mLocalAddr;
+    socklen_t mLocalAddrLen;
+    size_t mCidLen;
+
+    ev_io mIoWatcher;
+    ev_prepare mFlushWatcher;  // Sends what is queued before the loop blocks
+
+    std::unordered_map<std::string, EndpointRoute*> mRoutes;  // Connection ID -> route
+    std::vector<EndpointRoute*> mPending;  // Routes to drain after this burst
+
+    // Packet I/O structures, carved from mArena
+    IoArena mArena;
+    size_t mSendStride;
+    size_t mRecvStride;
+    uint8_t* mSendBase;
+    uint8_t* mRecvBase;
+    size_t* mSendLens;
+    struct sockaddr_storage* mSendAddrs;
+    socklen_t* mSendAddrLens;
+    struct sockaddr_storage* mRecvAddrs;
+#if defined(__linux__)
+    struct mmsghdr* mSendMsgs;
+    struct mmsghdr* mRecvMsgs;
+    struct iovec* mSendIovs;
+    struct iovec* mRecvIovs;
+#endif
+    int mSendCount;
+
+    bool setupBuffers(size_t max_send_size, size_t max_recv_size,
+                      const IoArenaOptions& arena_options, std::string& error);
+    void receive();
+    void dispatch(uint8_t* buf, size_t len, const struct sockaddr_storage* from, socklen_t from_len);
+    void drainPending();
+
+    static void recvCallback(EV_P_ ev_io* w, int revents);
+    static void prepareCallback(EV_P_ ev_prepare* w, int revents);
+};
+
+} // namespace quiche
+
+#endif // __QUICHE_UDP_ENDPOINT_H__
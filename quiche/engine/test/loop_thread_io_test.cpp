@@ -0,0 +1,174 @@
+// loop_thread_io_test.cpp
+// writeStream()/readStream() called on the loop thread outside any engine
+// callback (as a coroutine resumed on a shared loop does) must not run the
+// engine's callbacks from inside the call, and the data must still flow
+//
+// Copyright (C) 2025, Cloudflare, Inc.
+// All rights reserved.
+//
+// Build: cargo build --release --features ffi && make test
+// Run:   ./build/loop_thread_io_test (from quiche/engine)
+
+#include <quiche_engine.h>
+#include <quiche_server_engine.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <ev.h>
+
+using namespace quiche;
+
+namespace {
+
+const char* PORT = "14437";
+const uint64_t STREAM_ID = 4;
+const int MESSAGES = 32;
+
+struct Client {
+    QuicheEngine* engine;
+    struct ev_loop* loop;
+    ev_timer tick;
+    ev_timer deadline;
+
+    bool in_api;        // Inside writeStream()/readStream() called from tick
+    int reentered;      // Callbacks that ran while in_api was set
+    int sent;
+    std::string expected;
+    std::string echoed;
+    bool fin;
+    bool closed;
+
+    Client() : engine(nullptr), loop(nullptr), in_api(false), reentered(0),
+               sent(0), fin(false), closed(false) {}
+};
+
+void onClientEvent(QuicheEngine* engine, EngineEvent event, const EventData&, void* user_data) {
+    Client* client = static_cast<Client*>(user_data);
+    if (client->in_api) {
+        client->reentered++;
+    }
+
+    switch (event) {
+        case EngineEvent::CONNECTED:
+            // From here on the API is driven by the timer, not by callbacks
+            ev_timer_start(client->loop, &client->tick);
+            break;
+
+        case EngineEvent::CONNECTION_CLOSED:
+            client->closed = true;
+            ev_break(client->loop, EVBREAK_ALL);
+            break;
+
+        case EngineEvent::ERROR:
+            fprintf(stderr, "engine error: %s\n", engine->getLastError().c_str());
+            break;
+
+        default:
+            break;
+    }
+}
+
+// Loop thread, outside every engine callback
+void onTick(struct ev_loop*, ev_timer* w, int) {
+    Client* client = static_cast<Client*>(w->data);
+
+    client->in_api = true;
+    if (client->sent < MESSAGES) {
+        std::string message = "message " + std::to_string(client->sent) + ";";
+        bool last = client->sent + 1 == MESSAGES;
+        if (client->engine->writeStream(STREAM_ID, reinterpret_cast<const uint8_t*>(message.data()),
+                                        message.size(), last) == static_cast<ssize_t>(message.size())) {
+            client->expected += message;
+            client->sent++;
+        }
+    }
+
+    uint8_t buf[4096];
+    bool fin = false;
+    ssize_t len;
+    while ((len = client->engine->readStream(STREAM_ID, buf, sizeof(buf), fin)) > 0) {
+        client->echoed.append(reinterpret_cast<const char*>(buf), static_cast<size_t>(len));
+    }
+    client->in_api = false;
+
+    if (fin) {
+        client->fin = true;
+        ev_timer_stop(client->loop, &client->tick);
+        client->engine->shutdown();
+    }
+}
+
+void onDeadline(struct ev_loop* loop, ev_timer*, int) {
+    fprintf(stderr, "timed out\n");
+    ev_break(loop, EVBREAK_ALL);
+}
+
+}  // namespace
+
+int main() {
+    // Echo server on its own loop thread
+    ConfigMap server_config;
+    server_config[ConfigKey::TLS_CERT_FILE] = "../quic-demo/certs/cert.crt";
+    server_config[ConfigKey::TLS_KEY_FILE] = "../quic-demo/certs/cert.key";
+    server_config[ConfigKey::ENABLE_RETRY] = false;
+
+    QuicheServerEngine server("127.0.0.1", PORT, server_config);
+    server.setEventCallback([](QuicheServerEngine*, ServerConnection* conn, EngineEvent event,
+                               const EventData& event_data, void*) {
+        if (event != EngineEvent::STREAM_READABLE) {
+            return;
+        }
+        uint8_t buf[4096];
+        bool fin = false;
+        ssize_t len;
+        while ((len = conn->readStream(event_data.uint_val, buf, sizeof(buf), fin)) > 0 || fin) {
+            conn->writeStream(event_data.uint_val, buf, len > 0 ? static_cast<size_t>(len) : 0, fin);
+            if (fin) {
+                break;
+            }
+        }
+    });
+    if (!server.start()) {
+        fprintf(stderr, "server start failed: %s\n", server.getLastError().c_str());
+        return 1;
+    }
+
+    // Client on this thread's loop
+    Client client;
+    client.loop = ev_loop_new(EVFLAG_AUTO);
+
+    ConfigMap config;
+    config[ConfigKey::VERIFY_PEER] = false;
+    config[ConfigKey::ENABLE_HAPPY_EYEBALLS] = false;
+
+    {
+        QuicheEngine engine(client.loop, "127.0.0.1", PORT, config);
+        client.engine = &engine;
+        engine.setEventCallback(onClientEvent, &client);
+
+        ev_timer_init(&client.tick, onTick, 0.0, 0.005);
+        client.tick.data = &client;
+        ev_timer_init(&client.deadline, onDeadline, 10.0, 0.0);
+        ev_timer_start(client.loop, &client.deadline);
+
+        if (!engine.start()) {
+            fprintf(stderr, "client start failed: %s\n", engine.getLastError().c_str());
+            return 1;
+        }
+        ev_run(client.loop, 0);
+
+        ev_timer_stop(client.loop, &client.tick);
+        ev_timer_stop(client.loop, &client.deadline);
+    }
+    ev_loop_destroy(client.loop);
+    server.shutdown();
+
+    bool ok = client.reentered == 0 && client.fin && client.echoed == client.expected &&
+              client.sent == MESSAGES;
+    printf("sent=%d echoed=%zu/%zu fin=%d reentered=%d closed=%d: %s\n",
+           client.sent, client.echoed.size(), client.expected.size(), client.fin,
+           client.reentered, client.closed, ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -441,6 +441,11 @@ int64_t quiche_conn_stream_writable_next(quiche_conn *conn);
 // Returns true if all the data has been read from the specified stream.
 bool quiche_conn_stream_finished(const quiche_conn *conn, uint64_t stream_id);
 
+// Returns true if all the data written to the specified stream, including
+// the fin flag, was acknowledged by the peer. Collected streams are
+// complete; streams that were reset, stopped or never opened are not.
+bool quiche_conn_stream_send_complete(const quiche_conn *conn, uint64_t stream_id);
+
 typedef struct quiche_stream_iter quiche_stream_iter;
 
 // Returns an iterator over streams that have outstanding data to read.
@@ -13,6 +13,7 @@
 #include <chrono>
 #include <atomic>
 #include <algorithm>
+#include <vector>
 
 using namespace quiche;
 
@@ -84,57 +85,38 @@ static void dataSendingThread() {
 
     std::cout << "✓ Starting data transmission (200KB per second for 5 seconds)..." << std::endl;
 
-    // Prepare 200KB data buffer
-    const size_t CHUNK_SIZE = 200 * 1024;  // 200KB per second
-    std::vector<uint8_t> data(CHUNK_SIZE);
+    // Pace stream 4 on the event loop thread instead of sleeping here
+    const uint64_t RATE = 200 * 1024;  // 200KB per second
+    const size_t TOTAL_SIZE = 5 * RATE;
+    global_engine->setStreamSchedule(4, 1, RATE);
+
+    // Prepare data buffer
+    const size_t MAX_CHUNK = 65536;  // 64KB per write() call
+    std::vector<uint8_t> data(MAX_CHUNK);
 
     // Fill with pattern data
-    for (size_t i = 0; i < CHUNK_SIZE; i++) {
+    for (size_t i = 0; i < MAX_CHUNK; i++) {
         data[i] = static_cast<uint8_t>(i % 256);
     }
 
     uint64_t total_sent = 0;
-    int count = 0;
-
-    // Send data every second for 5 seconds
-    while (!should_stop.load() && count < 5) {
-        auto start = std::chrono::steady_clock::now();
-
-        // Send 200KB on stream 4, in chunks
-        if (global_engine) {
-            size_t sent_this_round = 0;
-            const size_t MAX_CHUNK = 65536;  // 64KB chunks
-
-            for (size_t offset = 0; offset < data.size(); offset += MAX_CHUNK) {
-                size_t chunk_size = std::min(MAX_CHUNK, data.size() - offset);
-
-                ssize_t written = global_engine->write(data.data() + offset, chunk_size, false);
-
-                if (written > 0) {
-                    sent_this_round += written;
-                    total_sent += written;
-                } else if (written < 0) {
-                    std::cerr << "✗ Failed to send chunk at offset " << offset << std::endl;
-                    break;
-                }
 
-                // Small delay between chunks
-                std::this_thread::sleep_for(std::chrono::milliseconds(5));
-            }
+    // Queue everything at once; the engine's scheduler releases it at RATE
+    for (size_t offset = 0; offset < TOTAL_SIZE && !should_stop.load(); offset += MAX_CHUNK) {
+        size_t chunk_size = std::min(MAX_CHUNK, TOTAL_SIZE - offset);
 
-            count++;
-            std::cout << "✓ Sent " << sent_this_round << " bytes in round " << count
-                     << " (total sent: " << total_sent << " bytes)" << std::endl;
+        ssize_t written = global_engine->write(data.data(), chunk_size, false);
+        if (written < 0) {
+            std::cerr << "✗ Failed to queue chunk at offset " << offset << std::endl;
+            break;
         }
+        total_sent += written;
+    }
 
-        // Wait for 1 second
-        auto end = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-        auto remaining = std::chrono::milliseconds(1000) - elapsed;
-
-        if (remaining.count() > 0) {
-            std::this_thread::sleep_for(remaining);
-        }
+    // Wait until the scheduler has handed everything to quiche (writes
+    // count toward send_queue_bytes as soon as write() returns)
+    while (!should_stop.load() && global_engine->getStats().send_queue_bytes > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
     std::cout << "✓ Data transmission completed. Total sent: " << total_sent << " bytes" << std::endl;
@@ -247,6 +229,7 @@ int main(int argc, char* argv[]) {
     config[ConfigKey::INITIAL_MAX_STREAMS_UNI] = static_cast<uint64_t>(100);     // 100 streams
     config[ConfigKey::DISABLE_ACTIVE_MIGRATION] = true;                          // Disable migration
     config[ConfigKey::ENABLE_DEBUG_LOG] = false;                                 // Debug logging off
+    config[ConfigKey::EVENT_QUEUE_SIZE] = static_cast<uint64_t>(256);            // Handle events on the main thread
 
     try {
         // Initialize engine with configuration map
@@ -275,7 +258,8 @@ int main(int argc, char* argv[]) {
         // Wait for completion or timeout
         auto start_time = std::chrono::steady_clock::now();
         while (!should_stop.load()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            // Event handlers print with std::endl - keep them off the loop thread
+            engine.pollEvents(64, 100);
 
             auto elapsed = std::chrono::steady_clock::now() - start_time;
             if (std::chrono::duration_cast<std::chrono::seconds>(elapsed).count() > 15) {
@@ -384,7 +384,22 @@ fn build_cpp_engine() {
     build
         .file("engine/src/quiche_engine_api.cpp")
         .file("engine/src/quiche_engine_impl.cpp")
-        .file("engine/src/quiche_thread_utils.cpp");
+        .file("engine/src/quiche_thread_utils.cpp")
+        .file("engine/src/quiche_session_cache.cpp")
+        .file("engine/src/quiche_event_loop.cpp")
+        .file("engine/src/quiche_engine_runtime.cpp")
+        .file("engine/src/quiche_server_engine.cpp")
+        .file("engine/src/quiche_send_scheduler.cpp")
+        .file("engine/src/quiche_timer_wheel.cpp")
+        .file("engine/src/quiche_resolver.cpp")
+        .file("engine/src/quiche_io_arena.cpp")
+        .file("engine/src/quiche_udp_endpoint.cpp")
+        .file("engine/src/quiche_event_queue.cpp")
+        .file("engine/src/quiche_engine_config.cpp")
+        .file("engine/src/quiche_message_stream.cpp")
+        .file("engine/src/quiche_rpc.cpp")
+        .file("engine/src/quiche_connection_pool.cpp")
+        .file("engine/src/quiche_bonded_engine.cpp");
 
     // Platform-specific configuration
     match target_os.as_str() {
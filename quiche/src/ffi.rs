@@ -971,6 +971,13 @@ pub extern "C" fn quiche_conn_stream_finished(
     conn.stream_finished(stream_id)
 }
 
+#[no_mangle]
+pub extern "C" fn quiche_conn_stream_send_complete(
+    conn: &Connection, stream_id: u64,
+) -> bool {
+    conn.stream_send_complete(stream_id)
+}
+
 #[no_mangle]
 pub extern "C" fn quiche_conn_readable(conn: &Connection) -> *mut StreamIter {
     Box::into_raw(Box::new(conn.readable()))
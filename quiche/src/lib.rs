@@ -5955,6 +5955,28 @@ impl<F: BufFactory> Connection<F> {
         stream.recv.is_fin()
     }
 
+    /// Returns true if all the data written to the specified stream, up to
+    /// and including the `fin` flag, was acknowledged by the peer.
+    ///
+    /// A stream whose send side is still open, whose `fin` was not
+    /// acknowledged yet, or that was reset (see [`stream_shutdown()`]) or
+    /// stopped by the peer is not complete. Streams that were already
+    /// collected are complete; streams that were never opened are not.
+    ///
+    /// [`stream_shutdown()`]: struct.Connection.html#method.stream_shutdown
+    #[inline]
+    pub fn stream_send_complete(&self, stream_id: u64) -> bool {
+        let stream = match self.streams.get(stream_id) {
+            Some(v) => v,
+
+            None => return self.streams.is_collected(stream_id),
+        };
+
+        !stream.send.is_shutdown() &&
+            !stream.send.is_stopped() &&
+            stream.send.is_complete()
+    }
+
     /// Returns the number of bidirectional streams that can be created
     /// before the peer's stream count limit is reached.
     ///
@@ -3959,6 +3959,60 @@ fn stream_zero_length_non_fin(
     assert!(r.next().is_none());
 }
 
+#[rstest]
+fn stream_send_complete(
+    #[values("cubic", "bbr2", "bbr2_gcongestion")] cc_algorithm_name: &str,
+) {
+    let mut buf = [0; 65535];
+    let mut b = [0; 15];
+
+    let mut pipe = test_utils::Pipe::new(cc_algorithm_name).unwrap();
+    assert_eq!(pipe.handshake(), Ok(()));
+
+    // Never opened.
+    assert!(!pipe.client.stream_send_complete(0));
+
+    // Data acked, but the send side is still open.
+    assert_eq!(pipe.client.stream_send(0, b"hello", false), Ok(5));
+    assert_eq!(pipe.advance(), Ok(()));
+    assert!(!pipe.client.stream_send_complete(0));
+
+    // Fin sent, not acked yet.
+    assert_eq!(pipe.client.stream_send(0, b", world", true), Ok(7));
+    let (len, _) = pipe.client.send(&mut buf).unwrap();
+    assert!(!pipe.client.stream_send_complete(0));
+
+    // Fin acked, while the server's side of the stream is still open.
+    assert_eq!(pipe.server_recv(&mut buf[..len]), Ok(len));
+    assert_eq!(pipe.advance(), Ok(()));
+    assert!(pipe.client.stream_send_complete(0));
+    assert_eq!(pipe.client.streams.len(), 1);
+
+    // Collected once both sides finished.
+    assert_eq!(pipe.server.stream_recv(0, &mut b), Ok((12, true)));
+    assert_eq!(pipe.server.stream_send(0, b"", true), Ok(0));
+    assert_eq!(pipe.advance(), Ok(()));
+    assert_eq!(pipe.client.stream_recv(0, &mut b), Ok((0, true)));
+    assert_eq!(pipe.advance(), Ok(()));
+    assert_eq!(pipe.client.streams.len(), 0);
+    assert!(pipe.client.stream_send_complete(0));
+
+    // Reset: never complete, even once the RESET_STREAM is acked.
+    assert_eq!(pipe.client.stream_send(4, b"hello", false), Ok(5));
+    assert_eq!(pipe.advance(), Ok(()));
+    assert_eq!(pipe.client.stream_shutdown(4, Shutdown::Write, 42), Ok(()));
+    assert!(!pipe.client.stream_send_complete(4));
+    assert_eq!(pipe.advance(), Ok(()));
+    assert!(!pipe.client.stream_send_complete(4));
+
+    // Stopped by the peer.
+    assert_eq!(pipe.client.stream_send(8, b"hello", false), Ok(5));
+    assert_eq!(pipe.advance(), Ok(()));
+    assert_eq!(pipe.server.stream_shutdown(8, Shutdown::Read, 42), Ok(()));
+    assert_eq!(pipe.advance(), Ok(()));
+    assert!(!pipe.client.stream_send_complete(8));
+}
+
 #[rstest]
 /// Tests that completed streams are garbage collected.
 fn collect_streams(